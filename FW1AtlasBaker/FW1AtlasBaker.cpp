@@ -0,0 +1,404 @@
+// FW1AtlasBaker.cpp
+
+// Command-line tool that draws a fixed set of glyphs into a glyph-atlas and saves it in the glyph cache format.
+// Load the file with IFW1GlyphProvider::LoadGlyphCache and call IFW1GlyphProvider::SetStaticGlyphAtlas,
+// and no glyph is rasterized at runtime.
+
+#define NOMINMAX
+#include <D3D11.h>
+#include <DWrite.h>
+#include <cstdio>
+#include <cwchar>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "../FW1FontWrapper/Source/FW1FontWrapper.h"
+
+#pragma comment(lib, "d3d11.lib")
+
+
+#define SAFE_RELEASE(pObject) { if(pObject) { (pObject)->Release(); (pObject) = NULL; } }
+
+
+namespace {
+
+
+// A font to bake, matched by family name in the system font collection
+struct BakeFont {
+	std::wstring			familyName;
+	DWRITE_FONT_WEIGHT		fontWeight;
+	DWRITE_FONT_STYLE		fontStyle;
+};
+
+
+// Options from the command line
+struct BakeOptions {
+	std::wstring			outputFileName;
+	std::vector<BakeFont>	fonts;
+	std::vector<FLOAT>		fontSizes;
+	std::vector<UINT32>		codePoints;
+	UINT					fontFlags;
+	FLOAT					distanceFieldSize;
+};
+
+
+// Print command-line usage
+void printUsage() {
+	wprintf(
+		L"Usage: FW1AtlasBaker <output file> [options]\n"
+		L"\n"
+		L"  -font <family>[:bold][:italic]  Font family to bake, can be repeated\n"
+		L"  -size <size>                    Font size to bake, can be repeated\n"
+		L"  -range <first>-<last>           Hexadecimal range of code points, can be repeated\n"
+		L"  -chars <text>                   Characters to bake, can be repeated\n"
+		L"  -aliased                        Bake glyphs without anti-aliasing, for text drawn with FW1_ALIASED\n"
+		L"  -distancefield <size>           Bake signed distance fields drawn at this size\n"
+		L"\n"
+		L"Every character is baked in every font at every size.\n"
+		L"The fonts must be installed, and the same font files must be installed where the atlas is loaded.\n"
+	);
+}
+
+
+// Add the code points of a UTF-16 string
+void addCharacters(const WCHAR *pszCharacters, std::vector<UINT32> &codePoints) {
+	for(const WCHAR *pChar = pszCharacters; *pChar != 0; ++pChar) {
+		UINT32 codePoint = *pChar;
+		
+		if(codePoint >= 0xd800 && codePoint < 0xdc00 && pChar[1] >= 0xdc00 && pChar[1] < 0xe000) {
+			codePoint = 0x10000 + ((codePoint - 0xd800) << 10) + (pChar[1] - 0xdc00);
+			++pChar;
+		}
+		
+		codePoints.push_back(codePoint);
+	}
+}
+
+
+// Add a range of code points written as two hexadecimal numbers
+bool addRange(const WCHAR *pszRange, std::vector<UINT32> &codePoints) {
+	WCHAR *pEnd;
+	
+	unsigned long first = wcstoul(pszRange, &pEnd, 16);
+	if(pEnd == pszRange || *pEnd != L'-')
+		return false;
+	
+	const WCHAR *pszLast = pEnd + 1;
+	unsigned long last = wcstoul(pszLast, &pEnd, 16);
+	if(pEnd == pszLast || *pEnd != 0 || last < first || last > 0x10ffff)
+		return false;
+	
+	for(unsigned long codePoint = first; codePoint <= last; ++codePoint)
+		codePoints.push_back(static_cast<UINT32>(codePoint));
+	
+	return true;
+}
+
+
+// Parse a font argument, the family name optionally followed by :bold and :italic
+BakeFont parseFont(const WCHAR *pszFont) {
+	BakeFont font;
+	font.familyName = pszFont;
+	font.fontWeight = DWRITE_FONT_WEIGHT_NORMAL;
+	font.fontStyle = DWRITE_FONT_STYLE_NORMAL;
+	
+	for(;;) {
+		size_t separator = font.familyName.rfind(L':');
+		if(separator == std::wstring::npos)
+			break;
+		
+		std::wstring modifier = font.familyName.substr(separator + 1);
+		if(modifier == L"bold")
+			font.fontWeight = DWRITE_FONT_WEIGHT_BOLD;
+		else if(modifier == L"italic")
+			font.fontStyle = DWRITE_FONT_STYLE_ITALIC;
+		else
+			break;
+		
+		font.familyName.erase(separator);
+	}
+	
+	return font;
+}
+
+
+// Parse the command line
+bool parseCommandLine(int argc, WCHAR *argv[], BakeOptions &options) {
+	if(argc < 2)
+		return false;
+	
+	options.outputFileName = argv[1];
+	options.fontFlags = 0;
+	options.distanceFieldSize = 0.0f;
+	
+	for(int i = 2; i < argc; ++i) {
+		std::wstring option = argv[i];
+		
+		if(option == L"-aliased") {
+			options.fontFlags |= FW1_ALIASED;
+			continue;
+		}
+		
+		// All other options take a value
+		if(i + 1 >= argc) {
+			wprintf(L"Missing value for %s\n", option.c_str());
+			return false;
+		}
+		const WCHAR *pszValue = argv[++i];
+		
+		if(option == L"-font") {
+			options.fonts.push_back(parseFont(pszValue));
+		}
+		else if(option == L"-size") {
+			FLOAT fontSize = static_cast<FLOAT>(_wtof(pszValue));
+			if(fontSize <= 0.0f) {
+				wprintf(L"Invalid font size: %s\n", pszValue);
+				return false;
+			}
+			options.fontSizes.push_back(fontSize);
+		}
+		else if(option == L"-range") {
+			if(!addRange(pszValue, options.codePoints)) {
+				wprintf(L"Invalid range: %s\n", pszValue);
+				return false;
+			}
+		}
+		else if(option == L"-chars") {
+			addCharacters(pszValue, options.codePoints);
+		}
+		else if(option == L"-distancefield") {
+			options.distanceFieldSize = static_cast<FLOAT>(_wtof(pszValue));
+			if(options.distanceFieldSize <= 0.0f) {
+				wprintf(L"Invalid distance-field size: %s\n", pszValue);
+				return false;
+			}
+		}
+		else {
+			wprintf(L"Unknown option: %s\n", option.c_str());
+			return false;
+		}
+	}
+	
+	if(options.fonts.empty() || options.fontSizes.empty() || options.codePoints.empty()) {
+		wprintf(L"At least one font, size and character is required\n");
+		return false;
+	}
+	
+	return true;
+}
+
+
+// Create a device to draw the atlas with, falling back to WARP if there is no hardware device
+HRESULT createDevice(ID3D11Device **ppDevice, ID3D11DeviceContext **ppContext) {
+	HRESULT hResult = D3D11CreateDevice(
+		NULL,
+		D3D_DRIVER_TYPE_HARDWARE,
+		NULL,
+		0,
+		NULL,
+		0,
+		D3D11_SDK_VERSION,
+		ppDevice,
+		NULL,
+		ppContext
+	);
+	if(FAILED(hResult)) {
+		hResult = D3D11CreateDevice(
+			NULL,
+			D3D_DRIVER_TYPE_WARP,
+			NULL,
+			0,
+			NULL,
+			0,
+			D3D11_SDK_VERSION,
+			ppDevice,
+			NULL,
+			ppContext
+		);
+	}
+	
+	return hResult;
+}
+
+
+// Create a font-face from the system font collection
+HRESULT createFontFace(IDWriteFontCollection *pFontCollection, const BakeFont &font, IDWriteFontFace **ppFontFace) {
+	UINT32 familyIndex;
+	BOOL exists;
+	
+	HRESULT hResult = pFontCollection->FindFamilyName(font.familyName.c_str(), &familyIndex, &exists);
+	if(FAILED(hResult)) {
+	}
+	else if(!exists) {
+		hResult = E_FAIL;
+	}
+	else {
+		IDWriteFontFamily *pFontFamily;
+		
+		hResult = pFontCollection->GetFontFamily(familyIndex, &pFontFamily);
+		if(FAILED(hResult)) {
+		}
+		else {
+			IDWriteFont *pFont;
+			
+			hResult = pFontFamily->GetFirstMatchingFont(font.fontWeight, DWRITE_FONT_STRETCH_NORMAL, font.fontStyle, &pFont);
+			if(FAILED(hResult)) {
+			}
+			else {
+				hResult = pFont->CreateFontFace(ppFontFace);
+				
+				pFont->Release();
+			}
+			
+			pFontFamily->Release();
+		}
+	}
+	
+	return hResult;
+}
+
+
+// Draw every character of a font at every size into the atlas
+// Returns the number of characters the font has no glyph for
+UINT bakeFontFace(IFW1GlyphProvider *pGlyphProvider, IDWriteFontFace *pFontFace, const BakeOptions &options) {
+	std::vector<UINT16> glyphIndices(options.codePoints.size());
+	if(FAILED(pFontFace->GetGlyphIndices(&options.codePoints[0], static_cast<UINT32>(options.codePoints.size()), &glyphIndices[0])))
+		return static_cast<UINT>(options.codePoints.size());
+	
+	UINT missingCount = 0;
+	for(size_t i = 0; i < glyphIndices.size(); ++i) {
+		if(glyphIndices[i] == 0)
+			++missingCount;
+	}
+	
+	// The font default-glyph is inserted with each glyph-map, and stands in for missing characters
+	for(size_t i = 0; i < options.fontSizes.size(); ++i) {
+		const void *pGlyphMap = pGlyphProvider->GetGlyphMapFromFont(pFontFace, options.fontSizes[i], options.fontFlags);
+		if(pGlyphMap == NULL)
+			continue;
+		
+		for(size_t j = 0; j < glyphIndices.size(); ++j) {
+			if(glyphIndices[j] != 0)
+				pGlyphProvider->GetAtlasIdFromGlyphIndex(pGlyphMap, glyphIndices[j], pFontFace, options.fontFlags | FW1_NOGLYPHBUDGET);
+		}
+	}
+	
+	return missingCount;
+}
+
+
+// Draw the glyphs of all fonts and save the atlas
+HRESULT bakeAtlas(ID3D11Device *pDevice, ID3D11DeviceContext *pContext, const BakeOptions &options) {
+	IFW1Factory *pFW1Factory;
+	
+	HRESULT hResult = FW1CreateFactory(FW1_VERSION, &pFW1Factory);
+	if(FAILED(hResult)) {
+		wprintf(L"FW1CreateFactory failed\n");
+	}
+	else {
+		// Use the same atlas settings as IFW1Factory::CreateFontWrapper does at runtime, or the file won't load
+		IFW1FontWrapper *pFontWrapper;
+		
+		hResult = pFW1Factory->CreateFontWrapper(pDevice, options.fonts[0].familyName.c_str(), &pFontWrapper);
+		if(FAILED(hResult)) {
+			wprintf(L"CreateFontWrapper failed\n");
+		}
+		else {
+			IFW1GlyphProvider *pGlyphProvider;
+			
+			hResult = pFontWrapper->GetGlyphProvider(&pGlyphProvider);
+			if(FAILED(hResult)) {
+				wprintf(L"GetGlyphProvider failed\n");
+			}
+			else {
+				if(options.distanceFieldSize > 0.0f)
+					hResult = pGlyphProvider->SetDistanceFieldSize(options.distanceFieldSize);
+				
+				IDWriteFontCollection *pFontCollection = NULL;
+				if(SUCCEEDED(hResult))
+					hResult = pGlyphProvider->GetDWriteFontCollection(&pFontCollection);
+				if(FAILED(hResult)) {
+					wprintf(L"Failed to set up the glyph provider\n");
+				}
+				else {
+					for(size_t i = 0; i < options.fonts.size() && SUCCEEDED(hResult); ++i) {
+						IDWriteFontFace *pFontFace;
+						
+						hResult = createFontFace(pFontCollection, options.fonts[i], &pFontFace);
+						if(FAILED(hResult)) {
+							wprintf(L"Font not found: %s\n", options.fonts[i].familyName.c_str());
+						}
+						else {
+							UINT missingCount = bakeFontFace(pGlyphProvider, pFontFace, options);
+							if(missingCount > 0)
+								wprintf(L"%s has no glyph for %u characters\n", options.fonts[i].familyName.c_str(), missingCount);
+							
+							pFontFace->Release();
+						}
+					}
+					
+					if(SUCCEEDED(hResult)) {
+						hResult = pGlyphProvider->SaveGlyphCache(pContext, options.outputFileName.c_str());
+						if(FAILED(hResult)) {
+							wprintf(L"Failed to write %s\n", options.outputFileName.c_str());
+						}
+						else {
+							IFW1GlyphAtlas *pGlyphAtlas;
+							
+							if(SUCCEEDED(pGlyphProvider->GetGlyphAtlas(&pGlyphAtlas))) {
+								wprintf(
+									L"Baked %u glyphs in %u sheets to %s\n",
+									pGlyphAtlas->GetTotalGlyphCount(),
+									pGlyphAtlas->GetSheetCount(),
+									options.outputFileName.c_str()
+								);
+								
+								pGlyphAtlas->Release();
+							}
+						}
+					}
+					
+					pFontCollection->Release();
+				}
+				
+				pGlyphProvider->Release();
+			}
+			
+			pFontWrapper->Release();
+		}
+		
+		pFW1Factory->Release();
+	}
+	
+	return hResult;
+}
+
+
+}// namespace
+
+
+// Entry point
+int wmain(int argc, WCHAR *argv[]) {
+	BakeOptions options;
+	if(!parseCommandLine(argc, argv, options)) {
+		printUsage();
+		return 1;
+	}
+	
+	ID3D11Device *pDevice = NULL;
+	ID3D11DeviceContext *pContext = NULL;
+	
+	HRESULT hResult = createDevice(&pDevice, &pContext);
+	if(FAILED(hResult)) {
+		wprintf(L"D3D11CreateDevice failed\n");
+	}
+	else {
+		hResult = bakeAtlas(pDevice, pContext, options);
+	}
+	
+	SAFE_RELEASE(pContext);
+	SAFE_RELEASE(pDevice);
+	
+	return SUCCEEDED(hResult) ? 0 : 1;
+}
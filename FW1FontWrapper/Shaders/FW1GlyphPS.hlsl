@@ -0,0 +1,42 @@
+// FW1GlyphPS.hlsl
+// Pixel shader for glyphs, coverage from the atlas times the glyph color
+// FW1_CLIP: discard pixels outside the clip rect
+// FW1_TEXTUREARRAY: sample a texture-array atlas
+// FW1_DISTANCEFIELD: antialias a distance-field atlas using screen-space derivatives of the distance
+
+SamplerState sampler0 : register(s0);
+#ifdef FW1_TEXTUREARRAY
+Texture2DArray<float> tex0 : register(t0);
+#else
+Texture2D<float> tex0 : register(t0);
+#endif
+
+struct PSIn {
+	float4 Position : SV_Position;
+	float4 GlyphColor : COLOR;
+#ifdef FW1_TEXTUREARRAY
+	float3 TexCoord : TEXCOORD;
+#else
+	float2 TexCoord : TEXCOORD;
+#endif
+#ifdef FW1_CLIP
+	float4 ClipDistance : CLIPDISTANCE;
+#endif
+};
+
+float4 PS(PSIn Input) : SV_Target {
+#ifdef FW1_CLIP
+	clip(Input.ClipDistance);
+	
+#endif
+	float a = tex0.Sample(sampler0, Input.TexCoord);
+#ifdef FW1_DISTANCEFIELD
+	float w = max(0.7f * fwidth(a), 0.001f);
+	a = smoothstep(0.5f - w, 0.5f + w, a);
+#endif
+	
+	if(a == 0.0f)
+		discard;
+	
+	return (a * Input.GlyphColor.a) * float4(Input.GlyphColor.rgb, 1.0f);
+}
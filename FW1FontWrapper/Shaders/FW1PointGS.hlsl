@@ -0,0 +1,85 @@
+// FW1PointGS.hlsl
+// Geometry shader constructing glyph quads from point input and the atlas coord buffer
+// FW1_CLIP: clip against the clip rect with SV_ClipDistance
+// FW1_TEXTUREARRAY: read glyph coords from the row of the slice in the atlas coord texture
+
+cbuffer ShaderConstants : register(b0) {
+	float4x4 TransformMatrix : packoffset(c0);
+#ifdef FW1_CLIP
+	float4 ClipRect : packoffset(c4);
+#endif
+};
+
+#ifdef FW1_TEXTUREARRAY
+Texture2D<float4> tex0 : register(t0);
+#define GLYPHTEXCOORD(uv) float3(uv, slice)
+#else
+Buffer<float4> tex0 : register(t0);
+#define GLYPHTEXCOORD(uv) uv
+#endif
+
+#ifdef FW1_CLIP
+#define GLYPHCLIPDISTANCE(pos) Output.ClipDistance = ClipRect + float4(pos, -pos)
+#else
+#define GLYPHCLIPDISTANCE(pos)
+#endif
+
+struct GSIn {
+	float3 PositionIndex : POSITIONINDEX;
+	float4 GlyphColor : GLYPHCOLOR;
+};
+
+struct GSOut {
+	float4 Position : SV_Position;
+	float4 GlyphColor : COLOR;
+#ifdef FW1_TEXTUREARRAY
+	float3 TexCoord : TEXCOORD;
+#else
+	float2 TexCoord : TEXCOORD;
+#endif
+#ifdef FW1_CLIP
+	float4 ClipDistance : SV_ClipDistance;
+#endif
+};
+
+[maxvertexcount(4)]
+void GS(point GSIn Input[1], inout TriangleStream<GSOut> TriStream) {
+	const float2 basePosition = Input[0].PositionIndex.xy;
+	const uint glyphIndex = asuint(Input[0].PositionIndex.z);
+	
+#ifdef FW1_TEXTUREARRAY
+	const float slice = glyphIndex >> 16;
+	float4 texCoords = tex0.Load(uint3((glyphIndex & 0xffff)*2, glyphIndex >> 16, 0));
+	float4 offsets = tex0.Load(uint3((glyphIndex & 0xffff)*2+1, glyphIndex >> 16, 0));
+#else
+	float4 texCoords = tex0.Load(uint2(glyphIndex*2, 0));
+	float4 offsets = tex0.Load(uint2(glyphIndex*2+1, 0));
+#endif
+	
+	GSOut Output;
+	Output.GlyphColor = Input[0].GlyphColor;
+	
+	float4 positions = basePosition.xyxy + offsets;
+	
+	Output.Position = mul(TransformMatrix, float4(positions.xy, 0.0f, 1.0f));
+	Output.TexCoord = GLYPHTEXCOORD(texCoords.xy);
+	GLYPHCLIPDISTANCE(positions.xy);
+	TriStream.Append(Output);
+	
+	Output.Position = mul(TransformMatrix, float4(positions.zy, 0.0f, 1.0f));
+	Output.TexCoord = GLYPHTEXCOORD(texCoords.zy);
+	GLYPHCLIPDISTANCE(positions.zy);
+	TriStream.Append(Output);
+	
+	Output.Position = mul(TransformMatrix, float4(positions.xw, 0.0f, 1.0f));
+	Output.TexCoord = GLYPHTEXCOORD(texCoords.xw);
+	GLYPHCLIPDISTANCE(positions.xw);
+	TriStream.Append(Output);
+	
+	Output.Position = mul(TransformMatrix, float4(positions.zw, 0.0f, 1.0f));
+	Output.TexCoord = GLYPHTEXCOORD(texCoords.zw);
+	GLYPHCLIPDISTANCE(positions.zw);
+	TriStream.Append(Output);
+	
+	TriStream.RestartStrip();
+}
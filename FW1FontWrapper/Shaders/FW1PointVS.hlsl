@@ -0,0 +1,11 @@
+// FW1PointVS.hlsl
+// Vertex shader passing glyph points on to the geometry shader
+
+struct GSIn {
+	float3 PositionIndex : POSITIONINDEX;
+	float4 GlyphColor : GLYPHCOLOR;
+};
+
+GSIn VS(GSIn Input) {
+	return Input;
+}
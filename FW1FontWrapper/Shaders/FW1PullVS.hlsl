@@ -0,0 +1,73 @@
+// FW1PullVS.hlsl
+// Vertex shader expanding glyph quads from the vertex ID, reading glyph vertices and coords from buffers
+// Each glyph is six vertices, corners 0 1 2 1 3 2 of its quad, with corner bit 0 for the right edge and bit 1 for the bottom edge
+// FW1_CLIP: pass the distances to the clip rect on to the pixel shader
+// FW1_TEXTUREARRAY: read glyph coords from the row of the slice in the atlas coord texture
+
+cbuffer ShaderConstants : register(b0) {
+	float4x4 TransformMatrix : packoffset(c0);
+#ifdef FW1_CLIP
+	float4 ClipRect : packoffset(c4);
+#endif
+};
+
+#ifdef FW1_TEXTUREARRAY
+Texture2D<float4> tex0 : register(t0);
+#else
+Buffer<float4> tex0 : register(t0);
+#endif
+Buffer<uint4> glyphVertices : register(t1);
+
+struct VSOut {
+	float4 Position : SV_Position;
+	float4 GlyphColor : COLOR;
+#ifdef FW1_TEXTUREARRAY
+	float3 TexCoord : TEXCOORD;
+#else
+	float2 TexCoord : TEXCOORD;
+#endif
+#ifdef FW1_CLIP
+	float4 ClipDistance : CLIPDISTANCE;
+#endif
+};
+
+VSOut VS(uint VertexID : SV_VertexID) {
+	const uint glyph = VertexID / 6;
+	const uint corner = (0xb64 >> ((VertexID - glyph * 6) * 2)) & 3;
+	
+	const uint4 glyphVertex = glyphVertices.Load(glyph);
+	const float2 basePosition = asfloat(glyphVertex.xy);
+	const uint glyphIndex = glyphVertex.z;
+	
+#ifdef FW1_TEXTUREARRAY
+	float4 texCoords = tex0.Load(uint3((glyphIndex & 0xffff)*2, glyphIndex >> 16, 0));
+	float4 offsets = tex0.Load(uint3((glyphIndex & 0xffff)*2+1, glyphIndex >> 16, 0));
+#else
+	float4 texCoords = tex0.Load(glyphIndex*2);
+	float4 offsets = tex0.Load(glyphIndex*2+1);
+#endif
+	
+	const bool right = (corner & 1) != 0;
+	const bool bottom = (corner & 2) != 0;
+	float2 position = basePosition + float2(right ? offsets.z : offsets.x, bottom ? offsets.w : offsets.y);
+	float2 texCoord = float2(right ? texCoords.z : texCoords.x, bottom ? texCoords.w : texCoords.y);
+	
+	VSOut Output;
+	Output.Position = mul(TransformMatrix, float4(position, 0.0f, 1.0f));
+	Output.GlyphColor = float4(
+		glyphVertex.w & 0xff,
+		(glyphVertex.w >> 8) & 0xff,
+		(glyphVertex.w >> 16) & 0xff,
+		glyphVertex.w >> 24
+	) / 255.0f;
+#ifdef FW1_TEXTUREARRAY
+	Output.TexCoord = float3(texCoord, glyphIndex >> 16);
+#else
+	Output.TexCoord = texCoord;
+#endif
+#ifdef FW1_CLIP
+	Output.ClipDistance = ClipRect + float4(position, -position);
+#endif
+	
+	return Output;
+}
@@ -0,0 +1,47 @@
+// FW1QuadVS.hlsl
+// Vertex shader for glyph quads with four vertices each
+// FW1_CLIP: pass the distances to the clip rect on to the pixel shader
+// FW1_TEXTUREARRAY: take the atlas slice from the texcoord
+
+cbuffer ShaderConstants : register(b0) {
+	float4x4 TransformMatrix : packoffset(c0);
+#ifdef FW1_CLIP
+	float4 ClipRect : packoffset(c4);
+#endif
+};
+
+struct VSIn {
+	float4 Position : POSITION;
+	float4 GlyphColor : GLYPHCOLOR;
+};
+
+struct VSOut {
+	float4 Position : SV_Position;
+	float4 GlyphColor : COLOR;
+#ifdef FW1_TEXTUREARRAY
+	float3 TexCoord : TEXCOORD;
+#else
+	float2 TexCoord : TEXCOORD;
+#endif
+#ifdef FW1_CLIP
+	float4 ClipDistance : CLIPDISTANCE;
+#endif
+};
+
+VSOut VS(VSIn Input) {
+	VSOut Output;
+	
+	Output.Position = mul(TransformMatrix, float4(Input.Position.xy, 0.0f, 1.0f));
+	Output.GlyphColor = Input.GlyphColor;
+#ifdef FW1_TEXTUREARRAY
+	float slice = floor((Input.Position.w + 1.0f) * 0.25f);
+	Output.TexCoord = float3(Input.Position.z, Input.Position.w - slice * 4.0f, slice);
+#else
+	Output.TexCoord = Input.Position.zw;
+#endif
+#ifdef FW1_CLIP
+	Output.ClipDistance = ClipRect + float4(Input.Position.xy, -Input.Position.xy);
+#endif
+	
+	return Output;
+}
@@ -94,6 +94,31 @@ class CFW1Factory : public IFW1Factory {
 			UINT32 Color,
 			IFW1ColorRGBA **ppColor
 		);
+		virtual HRESULT STDMETHODCALLTYPE CreateStaticGeometry(
+			ID3D11Device *pDevice,
+			IFW1GlyphAtlas *pGlyphAtlas,
+			const FW1_VERTEXDATA *pVertexData,
+			UINT Flags,
+			IFW1StaticGeometry **ppStaticGeometry
+		);
+		virtual HRESULT STDMETHODCALLTYPE CreateTextureArrayGlyphAtlas(
+			ID3D11Device *pDevice,
+			UINT GlyphSheetWidth,
+			UINT GlyphSheetHeight,
+			UINT MaxGlyphCountPerSheet,
+			UINT MipLevels,
+			UINT SliceCount,
+			IFW1GlyphAtlas **ppGlyphAtlas
+		);
+		virtual HRESULT STDMETHODCALLTYPE CreateOutlineRenderTarget(
+			UINT RenderTargetWidth,
+			UINT RenderTargetHeight,
+			IFW1DWriteRenderTarget **ppRenderTarget
+		);
+		virtual HRESULT STDMETHODCALLTYPE CreateStateTracker(
+			ID3D11DeviceContext *pContext,
+			IFW1StateTracker **ppStateTracker
+		);
 	
 	// Public functions
 	public:
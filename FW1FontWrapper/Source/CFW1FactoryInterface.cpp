@@ -11,9 +11,12 @@
 #include "CFW1TextGeometry.h"
 #include "CFW1GlyphProvider.h"
 #include "CFW1DWriteRenderTarget.h"
+#include "CFW1OutlineRenderTarget.h"
 #include "CFW1GlyphAtlas.h"
 #include "CFW1GlyphSheet.h"
 #include "CFW1ColorRGBA.h"
+#include "CFW1StaticGeometry.h"
+#include "CFW1StateTracker.h"
 
 
 namespace FW1FontWrapper {
@@ -118,20 +121,36 @@ HRESULT STDMETHODCALLTYPE CFW1Factory::CreateFontWrapper(
 			// Create glyph atlas
 			IFW1GlyphAtlas *pGlyphAtlas;
 			
-			hResult = CreateGlyphAtlas(
-				pDevice,
-				pCreateParams->GlyphSheetWidth,
-				pCreateParams->GlyphSheetHeight,
-				(pCreateParams->DisableGeometryShader == FALSE) ? TRUE : FALSE,
-				TRUE,
-				pCreateParams->MaxGlyphCountPerSheet,
-				pCreateParams->SheetMipLevels,
-				4096,
-				&pGlyphAtlas
-			);
+			if(pCreateParams->TextureArraySize > 0) {
+				hResult = CreateTextureArrayGlyphAtlas(
+					pDevice,
+					pCreateParams->GlyphSheetWidth,
+					pCreateParams->GlyphSheetHeight,
+					pCreateParams->MaxGlyphCountPerSheet,
+					pCreateParams->SheetMipLevels,
+					pCreateParams->TextureArraySize,
+					&pGlyphAtlas
+				);
+			}
+			else {
+				hResult = CreateGlyphAtlas(
+					pDevice,
+					pCreateParams->GlyphSheetWidth,
+					pCreateParams->GlyphSheetHeight,
+					TRUE,
+					TRUE,
+					pCreateParams->MaxGlyphCountPerSheet,
+					pCreateParams->SheetMipLevels,
+					4096,
+					&pGlyphAtlas
+				);
+			}
 			if(FAILED(hResult)) {
 			}
 			else {
+				if(pCreateParams->CompressGlyphSheets != FALSE && pCreateParams->TextureArraySize == 0)
+					pGlyphAtlas->SetSheetCompression(TRUE);
+				
 				// Create glyph provider
 				IFW1GlyphProvider *pGlyphProvider;
 				
@@ -146,6 +165,12 @@ HRESULT STDMETHODCALLTYPE CFW1Factory::CreateFontWrapper(
 				if(FAILED(hResult)) {
 				}
 				else {
+					pGlyphProvider->SetFontSizeStep(pCreateParams->FontSizeStep);
+					if(pCreateParams->OutlineRasterizer != FALSE)
+						pGlyphProvider->SetOutlineRasterizer(TRUE);
+					if(pCreateParams->DistanceFieldSize > 0.0f && pDevice->GetFeatureLevel() >= D3D_FEATURE_LEVEL_10_0)
+						pGlyphProvider->SetDistanceFieldSize(pCreateParams->DistanceFieldSize);
+					
 					// Create glyph vertex drawer
 					IFW1GlyphVertexDrawer *pGlyphVertexDrawer;
 					
@@ -445,7 +470,8 @@ HRESULT STDMETHODCALLTYPE CFW1Factory::CreateGlyphAtlas(
 		(AllowOversizedGlyph != FALSE),
 		MaxGlyphCountPerSheet,
 		MipLevels,
-		MaxGlyphSheetCount
+		MaxGlyphSheetCount,
+		0
 	);
 	if(FAILED(hResult)) {
 		pGlyphAtlas->Release();
@@ -484,7 +510,10 @@ HRESULT STDMETHODCALLTYPE CFW1Factory::CreateGlyphSheet(
 		(HardwareCoordBuffer != FALSE),
 		(AllowOversizedGlyph != FALSE),
 		MaxGlyphCount,
-		MipLevels
+		MipLevels,
+		NULL,
+		NULL,
+		0
 	);
 	if(FAILED(hResult)) {
 		pGlyphSheet->Release();
@@ -521,4 +550,120 @@ HRESULT STDMETHODCALLTYPE CFW1Factory::CreateColor(UINT32 Color, IFW1ColorRGBA *
 }
 
 
+// Create static geometry
+HRESULT STDMETHODCALLTYPE CFW1Factory::CreateStaticGeometry(
+	ID3D11Device *pDevice,
+	IFW1GlyphAtlas *pGlyphAtlas,
+	const FW1_VERTEXDATA *pVertexData,
+	UINT Flags,
+	IFW1StaticGeometry **ppStaticGeometry
+) {
+	if(ppStaticGeometry == NULL)
+		return E_INVALIDARG;
+	
+	CFW1StaticGeometry *pStaticGeometry = new CFW1StaticGeometry;
+	HRESULT hResult = pStaticGeometry->initStaticGeometry(this, pDevice, pGlyphAtlas, pVertexData, Flags);
+	if(FAILED(hResult)) {
+		pStaticGeometry->Release();
+		setErrorString(L"initStaticGeometry failed");
+	}
+	else {
+		*ppStaticGeometry = pStaticGeometry;
+		
+		hResult = S_OK;
+	}
+	
+	return hResult;
+}
+
+
+// Create glyph atlas with the sheets stored in a texture array
+HRESULT STDMETHODCALLTYPE CFW1Factory::CreateTextureArrayGlyphAtlas(
+	ID3D11Device *pDevice,
+	UINT GlyphSheetWidth,
+	UINT GlyphSheetHeight,
+	UINT MaxGlyphCountPerSheet,
+	UINT MipLevels,
+	UINT SliceCount,
+	IFW1GlyphAtlas **ppGlyphAtlas
+) {
+	if(ppGlyphAtlas == NULL || SliceCount == 0)
+		return E_INVALIDARG;
+	
+	CFW1GlyphAtlas *pGlyphAtlas = new CFW1GlyphAtlas;
+	HRESULT hResult = pGlyphAtlas->initGlyphAtlas(
+		this,
+		pDevice,
+		GlyphSheetWidth,
+		GlyphSheetHeight,
+		true,
+		false,
+		MaxGlyphCountPerSheet,
+		MipLevels,
+		SliceCount,
+		SliceCount
+	);
+	if(FAILED(hResult)) {
+		pGlyphAtlas->Release();
+		setErrorString(L"initGlyphAtlas failed");
+	}
+	else {
+		*ppGlyphAtlas = pGlyphAtlas;
+		
+		hResult = S_OK;
+	}
+	
+	return hResult;
+}
+
+
+// Create outline render target
+HRESULT STDMETHODCALLTYPE CFW1Factory::CreateOutlineRenderTarget(
+	UINT RenderTargetWidth,
+	UINT RenderTargetHeight,
+	IFW1DWriteRenderTarget **ppRenderTarget
+) {
+	if(ppRenderTarget == NULL)
+		return E_INVALIDARG;
+	
+	CFW1OutlineRenderTarget *pRenderTarget = new CFW1OutlineRenderTarget;
+	HRESULT hResult = pRenderTarget->initRenderTarget(this, RenderTargetWidth, RenderTargetHeight);
+	if(FAILED(hResult)) {
+		pRenderTarget->Release();
+		setErrorString(L"initRenderTarget failed");
+	}
+	else {
+		*ppRenderTarget = pRenderTarget;
+		
+		hResult = S_OK;
+	}
+	
+	return hResult;
+}
+
+
+// Create state tracker
+HRESULT STDMETHODCALLTYPE CFW1Factory::CreateStateTracker(
+	ID3D11DeviceContext *pContext,
+	IFW1StateTracker **ppStateTracker
+) {
+	if(ppStateTracker == NULL)
+		return E_INVALIDARG;
+	
+	CFW1StateTracker *pStateTracker = new CFW1StateTracker;
+	HRESULT hResult = pStateTracker->initStateTracker(this, pContext);
+	if(FAILED(hResult)) {
+		pStateTracker->Release();
+		setErrorString(L"initStateTracker failed");
+	}
+	else {
+		*ppStateTracker = pStateTracker;
+		
+		hResult = S_OK;
+	}
+	
+	return hResult;
+}
+
+
 }// namespace FW1FontWrapper
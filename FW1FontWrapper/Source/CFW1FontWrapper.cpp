@@ -21,6 +21,10 @@ CFW1FontWrapper::CFW1FontWrapper() :
 	
 	m_pGlyphRenderStates(NULL),
 	m_pGlyphVertexDrawer(NULL),
+	m_vertexPulling(false),
+	
+	m_pStateTracker(NULL),
+	m_pStateTrackerContext(NULL),
 	
 	m_defaultTextInited(false),
 	m_pDefaultTextFormat(NULL)
@@ -43,6 +47,8 @@ CFW1FontWrapper::~CFW1FontWrapper() {
 	SAFE_RELEASE(m_pGlyphRenderStates);
 	SAFE_RELEASE(m_pGlyphVertexDrawer);
 	
+	SAFE_RELEASE(m_pStateTracker);
+	
 	while(!m_textRenderers.empty()) {
 		m_textRenderers.top()->Release();
 		m_textRenderers.pop();
@@ -102,6 +108,12 @@ HRESULT CFW1FontWrapper::initFontWrapper(
 	pGlyphVertexDrawer->AddRef();
 	m_pGlyphVertexDrawer = pGlyphVertexDrawer;
 	
+	// Without a geometry shader, quads are expanded in the vertex shader if it can read the glyph coords
+	m_vertexPulling =
+		m_featureLevel >= D3D_FEATURE_LEVEL_10_0 &&
+		m_pGlyphRenderStates->HasVertexPullingShader() != FALSE &&
+		m_pGlyphAtlas->HasCoordBuffers() != FALSE;
+	
 	// Create default text format for strings, if provided
 	if(pDefaultFontParams->pszFontFamily != NULL && pDefaultFontParams->pszFontFamily[0] != 0) {
 		IDWriteTextFormat *pTextFormat;
@@ -130,23 +142,40 @@ HRESULT CFW1FontWrapper::initFontWrapper(
 }
 
 
+// Get the length of a NULL-terminated string
+UINT32 CFW1FontWrapper::getStringLength(const WCHAR *pszString) {
+	UINT32 stringLength = 0;
+	while(pszString[stringLength] != 0)
+		++stringLength;
+	
+	return stringLength;
+}
+
+
+// Set the glyph render states, through the state tracker when drawing on its context
+// Restoring state puts back what the tracker knew, so the tracker is only used when the states are left bound
+void CFW1FontWrapper::setRenderStates(ID3D11DeviceContext *pContext, UINT flags) {
+	if(m_pStateTracker != NULL && pContext == m_pStateTrackerContext && (flags & FW1_RESTORESTATE) == 0)
+		m_pGlyphRenderStates->SetTrackedStates(m_pStateTracker, flags);
+	else
+		m_pGlyphRenderStates->SetStates(pContext, flags);
+}
+
+
 // Create text layout from string
 IDWriteTextLayout* CFW1FontWrapper::createTextLayout(
-	const WCHAR *pszString,
+	const WCHAR *pString,
+	UINT32 stringLength,
 	const WCHAR *pszFontFamily,
 	FLOAT fontSize,
 	const FW1_RECTF *pLayoutRect,
 	UINT flags
 ) {
 	if(m_defaultTextInited) {
-		UINT32 stringLength = 0;
-		while(pszString[stringLength] != 0)
-			++stringLength;
-		
 		// Create DWrite text layout for the string
 		IDWriteTextLayout *pTextLayout;
 		HRESULT hResult = m_pDWriteFactory->CreateTextLayout(
-			pszString,
+			pString,
 			stringLength,
 			m_pDefaultTextFormat,
 			pLayoutRect->Right - pLayoutRect->Left,
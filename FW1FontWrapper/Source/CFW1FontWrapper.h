@@ -113,6 +113,40 @@ class CFW1FontWrapper : public CFW1Object<IFW1FontWrapper> {
 		);
 		
 		virtual void STDMETHODCALLTYPE Flush(ID3D11DeviceContext *pContext);
+		
+		virtual HRESULT STDMETHODCALLTYPE CreateStaticGeometry(
+			IFW1TextGeometry *pGeometry,
+			IFW1StaticGeometry **ppStaticGeometry
+		);
+		virtual void STDMETHODCALLTYPE DrawStaticGeometry(
+			ID3D11DeviceContext *pContext,
+			IFW1StaticGeometry *pStaticGeometry,
+			const FW1_RECTF *pClipRect,
+			const FLOAT *pTransformMatrix,
+			UINT Flags
+		);
+		
+		virtual HRESULT STDMETHODCALLTYPE SetStateTracker(IFW1StateTracker *pStateTracker);
+		
+		virtual FW1_RECTF STDMETHODCALLTYPE MeasureStringN(
+			const WCHAR *pString,
+			UINT32 StringLength,
+			const WCHAR *pszFontFamily,
+			FLOAT FontSize,
+			const FW1_RECTF *pLayoutRect,
+			UINT Flags
+		);
+		virtual void STDMETHODCALLTYPE AnalyzeStringN(
+			ID3D11DeviceContext *pContext,
+			const WCHAR *pString,
+			UINT32 StringLength,
+			const WCHAR *pszFontFamily,
+			FLOAT FontSize,
+			const FW1_RECTF *pLayoutRect,
+			UINT32 Color,
+			UINT Flags,
+			IFW1TextGeometry *pTextGeometry
+		);
 	
 	// Public functions
 	public:
@@ -133,8 +167,13 @@ class CFW1FontWrapper : public CFW1Object<IFW1FontWrapper> {
 	private:
 		virtual ~CFW1FontWrapper();
 		
+		static UINT32 getStringLength(const WCHAR *pszString);
+		
+		void setRenderStates(ID3D11DeviceContext *pContext, UINT flags);
+		
 		IDWriteTextLayout* createTextLayout(
-			const WCHAR *pszString,
+			const WCHAR *pString,
+			UINT32 stringLength,
 			const WCHAR *pszFontFamily,
 			FLOAT fontSize,
 			const FW1_RECTF *pLayoutRect,
@@ -154,6 +193,10 @@ class CFW1FontWrapper : public CFW1Object<IFW1FontWrapper> {
 		
 		IFW1GlyphRenderStates			*m_pGlyphRenderStates;
 		IFW1GlyphVertexDrawer			*m_pGlyphVertexDrawer;
+		bool							m_vertexPulling;
+		
+		IFW1StateTracker				*m_pStateTracker;
+		ID3D11DeviceContext				*m_pStateTrackerContext;// Held by the tracker, only compared with
 		
 		CRITICAL_SECTION				m_textRenderersCriticalSection;
 		std::stack<IFW1TextRenderer*>	m_textRenderers;
@@ -224,7 +224,7 @@ void STDMETHODCALLTYPE CFW1FontWrapper::DrawString(
 	const FLOAT *pTransformMatrix,
 	UINT Flags
 ) {
-	IDWriteTextLayout *pTextLayout = createTextLayout(pszString, pszFontFamily, FontSize, pLayoutRect, Flags);
+	IDWriteTextLayout *pTextLayout = createTextLayout(pszString, getStringLength(pszString), pszFontFamily, FontSize, pLayoutRect, Flags);
 	if(pTextLayout != NULL) {
 		// Draw
 		DrawTextLayout(
@@ -250,10 +250,23 @@ FW1_RECTF STDMETHODCALLTYPE CFW1FontWrapper::MeasureString(
 	FLOAT FontSize,
 	const FW1_RECTF *pLayoutRect,
 	UINT Flags
+) {
+	return MeasureStringN(pszString, getStringLength(pszString), pszFontFamily, FontSize, pLayoutRect, Flags);
+}
+
+
+// Measure text of known length
+FW1_RECTF STDMETHODCALLTYPE CFW1FontWrapper::MeasureStringN(
+	const WCHAR *pString,
+	UINT32 StringLength,
+	const WCHAR *pszFontFamily,
+	FLOAT FontSize,
+	const FW1_RECTF *pLayoutRect,
+	UINT Flags
 ) {
 	FW1_RECTF stringRect = {pLayoutRect->Left, pLayoutRect->Top, pLayoutRect->Left, pLayoutRect->Top};
 	
-	IDWriteTextLayout *pTextLayout = createTextLayout(pszString, pszFontFamily, FontSize, pLayoutRect, Flags);
+	IDWriteTextLayout *pTextLayout = createTextLayout(pString, StringLength, pszFontFamily, FontSize, pLayoutRect, Flags);
 	if(pTextLayout != NULL) {
 		// Get measurements
 		DWRITE_OVERHANG_METRICS overhangMetrics;
@@ -283,7 +296,23 @@ void STDMETHODCALLTYPE CFW1FontWrapper::AnalyzeString(
 	UINT Flags,
 	IFW1TextGeometry *pTextGeometry
 ) {
-	IDWriteTextLayout *pTextLayout = createTextLayout(pszString, pszFontFamily, FontSize, pLayoutRect, Flags);
+	AnalyzeStringN(pContext, pszString, getStringLength(pszString), pszFontFamily, FontSize, pLayoutRect, Color, Flags, pTextGeometry);
+}
+
+
+// Create geometry from a string of known length
+void STDMETHODCALLTYPE CFW1FontWrapper::AnalyzeStringN(
+	ID3D11DeviceContext *pContext,
+	const WCHAR *pString,
+	UINT32 StringLength,
+	const WCHAR *pszFontFamily,
+	FLOAT FontSize,
+	const FW1_RECTF *pLayoutRect,
+	UINT32 Color,
+	UINT Flags,
+	IFW1TextGeometry *pTextGeometry
+) {
+	IDWriteTextLayout *pTextLayout = createTextLayout(pString, StringLength, pszFontFamily, FontSize, pLayoutRect, Flags);
 	if(pTextLayout != NULL) {
 		AnalyzeTextLayout(
 			pContext,
@@ -356,10 +385,24 @@ void STDMETHODCALLTYPE CFW1FontWrapper::DrawGeometry(
 	const FLOAT *pTransformMatrix,
 	UINT Flags
 ) {
-	FW1_VERTEXDATA vertexData = pGeometry->GetGlyphVerticesTemp();
+	// Texture-array atlases draw the vertices in the order they were added
+	Flags &= ~(FW1_TEXTUREARRAY | FW1_DISTANCEFIELD | FW1_VERTEXPULLING);
+	if(m_pGlyphAtlas->GetTextureArraySize() > 0)
+		Flags |= FW1_TEXTUREARRAY;
+	if(m_pGlyphProvider->GetDistanceFieldSize() > 0.0f)
+		Flags |= FW1_DISTANCEFIELD;
+	
+	FW1_VERTEXDATA vertexData;
+	if((Flags & FW1_TEXTUREARRAY) != 0)
+		vertexData = pGeometry->GetGlyphVerticesUnsortedTemp();
+	else
+		vertexData = pGeometry->GetGlyphVerticesTemp();
+	
 	if(vertexData.TotalVertexCount > 0 || (Flags & FW1_RESTORESTATE) == 0) {
 		if(m_featureLevel < D3D_FEATURE_LEVEL_10_0 || m_pGlyphRenderStates->HasGeometryShader() == FALSE)
 			Flags |= FW1_NOGEOMETRYSHADER;
+		if((Flags & FW1_NOGEOMETRYSHADER) != 0 && m_vertexPulling)
+			Flags |= FW1_VERTEXPULLING;
 		
 		// Save state
 		CFW1StateSaver stateSaver;
@@ -371,7 +414,7 @@ void STDMETHODCALLTYPE CFW1FontWrapper::DrawGeometry(
 		
 		// Set shaders etc.
 		if((Flags & FW1_STATEPREPARED) == 0)
-			m_pGlyphRenderStates->SetStates(pContext, Flags);
+			setRenderStates(pContext, Flags);
 		if((Flags & FW1_CONSTANTSPREPARED) == 0)
 			m_pGlyphRenderStates->UpdateShaderConstants(pContext, pClipRect, pTransformMatrix);
 		
@@ -392,4 +435,98 @@ void STDMETHODCALLTYPE CFW1FontWrapper::Flush(ID3D11DeviceContext *pContext) {
 }
 
 
+// Create static geometry from a text geometry
+HRESULT STDMETHODCALLTYPE CFW1FontWrapper::CreateStaticGeometry(
+	IFW1TextGeometry *pGeometry,
+	IFW1StaticGeometry **ppStaticGeometry
+) {
+	if(pGeometry == NULL || ppStaticGeometry == NULL)
+		return E_INVALIDARG;
+	
+	// Store in the same format DrawGeometry would use
+	UINT flags = 0;
+	if(m_featureLevel < D3D_FEATURE_LEVEL_10_0 || m_pGlyphRenderStates->HasGeometryShader() == FALSE)
+		flags |= FW1_NOGEOMETRYSHADER;
+	if(m_pGlyphAtlas->GetTextureArraySize() > 0)
+		flags |= FW1_TEXTUREARRAY;
+	if(m_pGlyphProvider->GetDistanceFieldSize() > 0.0f)
+		flags |= FW1_DISTANCEFIELD;
+	
+	FW1_VERTEXDATA vertexData;
+	if((flags & FW1_TEXTUREARRAY) != 0)
+		vertexData = pGeometry->GetGlyphVerticesUnsortedTemp();
+	else
+		vertexData = pGeometry->GetGlyphVerticesTemp();
+	
+	return m_pFW1Factory->CreateStaticGeometry(m_pDevice, m_pGlyphAtlas, &vertexData, flags, ppStaticGeometry);
+}
+
+
+// Draw static geometry
+void STDMETHODCALLTYPE CFW1FontWrapper::DrawStaticGeometry(
+	ID3D11DeviceContext *pContext,
+	IFW1StaticGeometry *pStaticGeometry,
+	const FW1_RECTF *pClipRect,
+	const FLOAT *pTransformMatrix,
+	UINT Flags
+) {
+	if(pStaticGeometry == NULL)
+		return;
+	
+	// The states must match the format the geometry was stored in
+	// Static geometry holds indexed quads or points, never vertices for the vertex shader to expand
+	Flags &= ~(FW1_NOGEOMETRYSHADER | FW1_TEXTUREARRAY | FW1_DISTANCEFIELD | FW1_VERTEXPULLING);
+	Flags |= pStaticGeometry->GetFlags() & (FW1_NOGEOMETRYSHADER | FW1_TEXTUREARRAY | FW1_DISTANCEFIELD);
+	
+	// States prepared by DrawGeometry are for vertex pulling when there is no geometry shader, which quads can not use
+	if((Flags & FW1_NOGEOMETRYSHADER) != 0 && m_vertexPulling)
+		Flags &= ~FW1_STATEPREPARED;
+	
+	// Save state
+	CFW1StateSaver stateSaver;
+	bool restoreState = false;
+	if((Flags & FW1_RESTORESTATE) != 0) {
+		if(SUCCEEDED(stateSaver.saveCurrentState(pContext)))
+			restoreState = true;
+	}
+	
+	// Set shaders etc.
+	if((Flags & FW1_STATEPREPARED) == 0)
+		setRenderStates(pContext, Flags);
+	if((Flags & FW1_CONSTANTSPREPARED) == 0)
+		m_pGlyphRenderStates->UpdateShaderConstants(pContext, pClipRect, pTransformMatrix);
+	
+	// Draw glyphs
+	UINT temp = pStaticGeometry->DrawGeometry(pContext, Flags, 0xffffffff);
+	temp;
+	
+	// Restore state
+	if(restoreState)
+		stateSaver.restoreSavedState();
+}
+
+
+// Set state tracker
+HRESULT STDMETHODCALLTYPE CFW1FontWrapper::SetStateTracker(IFW1StateTracker *pStateTracker) {
+	ID3D11DeviceContext *pContext = NULL;
+	if(pStateTracker != NULL) {
+		HRESULT hResult = pStateTracker->GetDeviceContext(&pContext);
+		if(FAILED(hResult))
+			return hResult;
+		
+		// The tracker keeps the context alive
+		pContext->Release();
+		
+		pStateTracker->AddRef();
+	}
+	
+	if(m_pStateTracker != NULL)
+		m_pStateTracker->Release();
+	m_pStateTracker = pStateTracker;
+	m_pStateTrackerContext = pContext;
+	
+	return S_OK;
+}
+
+
 }// namespace FW1FontWrapper
@@ -4,6 +4,8 @@
 
 #include "CFW1GlyphAtlas.h"
 
+#include "CFW1GlyphSheet.h"
+
 #define SAFE_RELEASE(pObject) { if(pObject) { (pObject)->Release(); (pObject) = NULL; } }
 
 
@@ -19,12 +21,22 @@ CFW1GlyphAtlas::CFW1GlyphAtlas() :
 	m_allowOversizedGlyph(false),
 	m_maxGlyphCount(0),
 	m_mipLevelCount(0),
+	m_compressSheets(false),
 	
 	m_glyphSheets(0),
 	m_sheetCount(0),
 	m_maxSheetCount(0),
 	m_currentSheetIndex(0),
-	m_flushedSheetIndex(0)
+	m_flushedSheetIndex(0),
+	m_removalCount(0),
+	
+	m_textureArraySize(0),
+	m_textureArrayMemory(0),
+	m_pArrayTextureSRV(NULL),
+	m_pArrayCoordSRV(NULL),
+	
+	m_lastFlushBytes(0),
+	m_totalFlushBytes(0)
 {
 	InitializeCriticalSection(&m_glyphSheetsCriticalSection);
 }
@@ -38,6 +50,9 @@ CFW1GlyphAtlas::~CFW1GlyphAtlas() {
 		m_glyphSheets[i]->Release();
 	delete[] m_glyphSheets;
 	
+	SAFE_RELEASE(m_pArrayTextureSRV);
+	SAFE_RELEASE(m_pArrayCoordSRV);
+	
 	DeleteCriticalSection(&m_glyphSheetsCriticalSection);
 }
 
@@ -52,7 +67,8 @@ HRESULT CFW1GlyphAtlas::initGlyphAtlas(
 	bool allowOversizedGlyph,
 	UINT maxGlyphCount,
 	UINT mipLevelCount,
-	UINT maxSheetCount
+	UINT maxSheetCount,
+	UINT textureArraySize
 ) {
 	HRESULT hResult = initBaseObject(pFW1Factory);
 	if(FAILED(hResult))
@@ -74,6 +90,14 @@ HRESULT CFW1GlyphAtlas::initGlyphAtlas(
 	m_maxSheetCount = 4096;
 	if(maxSheetCount > 0 && maxSheetCount < 655536)
 		m_maxSheetCount = maxSheetCount;
+	
+	// A texture-array atlas allocates all its sheets up front
+	if(textureArraySize > 0) {
+		hResult = createTextureArray(textureArraySize);
+		if(FAILED(hResult))
+			return hResult;
+	}
+	
 	m_glyphSheets = new IFW1GlyphSheet* [m_maxSheetCount];
 	
 	// Default glyph
@@ -94,8 +118,152 @@ HRESULT CFW1GlyphAtlas::initGlyphAtlas(
 }
 
 
+// Create the texture array and coord texture shared by all sheets
+HRESULT CFW1GlyphAtlas::createTextureArray(UINT textureArraySize) {
+	if(m_pDevice->GetFeatureLevel() < D3D_FEATURE_LEVEL_10_0)
+		return E_FAIL;
+	
+	// Resolve the sheet defaults here, as every slice must match the array
+	if(m_sheetWidth == 0)
+		m_sheetWidth = 512;
+	if(m_sheetHeight == 0)
+		m_sheetHeight = 512;
+	if(m_maxGlyphCount == 0)
+		m_maxGlyphCount = 2048;
+	m_maxGlyphCount = std::min(m_maxGlyphCount, 4096U);// Two texels per glyph in a coord texture row
+	m_mipLevelCount = std::max(std::min(m_mipLevelCount, 5U), 1U);
+	
+	// Glyphs are looked up by slice in the geometry shader, and oversized glyphs could not be expanded on the CPU
+	m_hardwareCoordBuffer = true;
+	m_allowOversizedGlyph = false;
+	
+	m_textureArraySize = std::min(textureArraySize, static_cast<UINT>(D3D11_REQ_TEXTURE2D_ARRAY_AXIS_DIMENSION));
+	m_maxSheetCount = m_textureArraySize;
+	
+	// Create texture array
+	D3D11_TEXTURE2D_DESC textureDesc;
+	ID3D11Texture2D *pTexture;
+	
+	ZeroMemory(&textureDesc, sizeof(textureDesc));
+	textureDesc.Width = m_sheetWidth;
+	textureDesc.Height = m_sheetHeight;
+	textureDesc.ArraySize = m_textureArraySize;
+	textureDesc.Format = DXGI_FORMAT_R8_UNORM;
+	textureDesc.SampleDesc.Count = 1;
+	textureDesc.Usage = D3D11_USAGE_DEFAULT;
+	textureDesc.MipLevels = m_mipLevelCount;
+	textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	
+	HRESULT hResult = m_pDevice->CreateTexture2D(&textureDesc, NULL, &pTexture);
+	if(FAILED(hResult)) {
+		m_lastError = L"Failed to create glyph sheet texture array";
+	}
+	else {
+		D3D11_SHADER_RESOURCE_VIEW_DESC textureSRVDesc;
+		ID3D11ShaderResourceView *pTextureSRV;
+		
+		// Always an array view, even with a single slice
+		ZeroMemory(&textureSRVDesc, sizeof(textureSRVDesc));
+		textureSRVDesc.Format = DXGI_FORMAT_R8_UNORM;
+		textureSRVDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+		textureSRVDesc.Texture2DArray.MostDetailedMip = 0;
+		textureSRVDesc.Texture2DArray.MipLevels = m_mipLevelCount;
+		textureSRVDesc.Texture2DArray.FirstArraySlice = 0;
+		textureSRVDesc.Texture2DArray.ArraySize = m_textureArraySize;
+		
+		hResult = m_pDevice->CreateShaderResourceView(pTexture, &textureSRVDesc, &pTextureSRV);
+		if(FAILED(hResult)) {
+			m_lastError = L"Failed to create shader resource view for glyph sheet texture array";
+		}
+		else {
+			// Create coord texture, with one row of glyph coords per slice
+			D3D11_TEXTURE2D_DESC coordDesc;
+			ID3D11Texture2D *pCoordTexture;
+			
+			ZeroMemory(&coordDesc, sizeof(coordDesc));
+			coordDesc.Width = m_maxGlyphCount * 2;// Two float4 per glyphcoords
+			coordDesc.Height = m_textureArraySize;
+			coordDesc.ArraySize = 1;
+			coordDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+			coordDesc.SampleDesc.Count = 1;
+			coordDesc.Usage = D3D11_USAGE_DEFAULT;
+			coordDesc.MipLevels = 1;
+			coordDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+			
+			hResult = m_pDevice->CreateTexture2D(&coordDesc, NULL, &pCoordTexture);
+			if(FAILED(hResult)) {
+				m_lastError = L"Failed to create glyph coord texture";
+			}
+			else {
+				ID3D11ShaderResourceView *pCoordSRV;
+				
+				hResult = m_pDevice->CreateShaderResourceView(pCoordTexture, NULL, &pCoordSRV);
+				if(FAILED(hResult)) {
+					m_lastError = L"Failed to create shader resource view for glyph coord texture";
+				}
+				else {
+					// Success
+					m_pArrayTextureSRV = pTextureSRV;
+					m_pArrayCoordSRV = pCoordSRV;
+					
+					UINT64 mipSize = static_cast<UINT64>(m_sheetWidth) * m_sheetHeight;
+					for(UINT i=0; i < m_mipLevelCount; ++i) {
+						m_textureArrayMemory += mipSize;
+						mipSize >>= 2;
+					}
+					m_textureArrayMemory *= m_textureArraySize;
+					m_textureArrayMemory += static_cast<UINT64>(m_maxGlyphCount) * sizeof(FW1_GLYPHCOORDS) * m_textureArraySize;
+					
+					hResult = S_OK;
+				}
+				
+				pCoordTexture->Release();
+			}
+			
+			if(FAILED(hResult))
+				pTextureSRV->Release();
+		}
+		
+		pTexture->Release();
+	}
+	
+	return hResult;
+}
+
+
 // Create new glyph sheet
 HRESULT CFW1GlyphAtlas::createGlyphSheet(IFW1GlyphSheet **ppGlyphSheet) {
+	// Texture-array sheets are created for the next free slice, under the sheet lock, see InsertGlyph
+	if(m_textureArraySize > 0) {
+		if(m_sheetCount >= m_textureArraySize)
+			return E_FAIL;
+		
+		CFW1GlyphSheet *pArraySheet = new CFW1GlyphSheet;
+		HRESULT hResult = pArraySheet->initGlyphSheet(
+			m_pFW1Factory,
+			m_pDevice,
+			m_sheetWidth,
+			m_sheetHeight,
+			true,
+			false,
+			m_maxGlyphCount,
+			m_mipLevelCount,
+			m_pArrayTextureSRV,
+			m_pArrayCoordSRV,
+			m_sheetCount
+		);
+		if(FAILED(hResult)) {
+			pArraySheet->Release();
+		}
+		else {
+			*ppGlyphSheet = pArraySheet;
+			
+			hResult = S_OK;
+		}
+		
+		return hResult;
+	}
+	
 	IFW1GlyphSheet *pGlyphSheet;
 	HRESULT hResult = m_pFW1Factory->CreateGlyphSheet(
 		m_pDevice,
@@ -110,6 +278,10 @@ HRESULT CFW1GlyphAtlas::createGlyphSheet(IFW1GlyphSheet **ppGlyphSheet) {
 	if(FAILED(hResult)) {
 	}
 	else {
+		// Sheets the size doesn't suit stay uncompressed
+		if(m_compressSheets)
+			pGlyphSheet->SetCompression(TRUE);
+		
 		*ppGlyphSheet = pGlyphSheet;
 		
 		hResult = S_OK;
@@ -119,4 +291,13 @@ HRESULT CFW1GlyphAtlas::createGlyphSheet(IFW1GlyphSheet **ppGlyphSheet) {
 }
 
 
+// Get the device memory used by a sheet texture
+UINT64 CFW1GlyphAtlas::getSheetMemory(IFW1GlyphSheet *pGlyphSheet) {
+	FW1_GLYPHSHEETDESC desc;
+	pGlyphSheet->GetDesc(&desc);
+	
+	return desc.TextureBytes;
+}
+
+
 }// namespace FW1FontWrapper
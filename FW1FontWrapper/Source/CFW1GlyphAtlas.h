@@ -34,6 +34,27 @@ class CFW1GlyphAtlas : public CFW1Object<IFW1GlyphAtlas> {
 		);
 		virtual UINT STDMETHODCALLTYPE InsertSheet(IFW1GlyphSheet *pGlyphSheet);
 		virtual void STDMETHODCALLTYPE Flush(ID3D11DeviceContext *pContext);
+		
+		virtual UINT64 STDMETHODCALLTYPE GetMemoryUsage();
+		virtual UINT STDMETHODCALLTYPE RemoveSheets(
+			const UINT *pSheetIndices,
+			UINT IndexCount,
+			UINT64 BytesToFree,
+			UINT *pSheetRemap
+		);
+		virtual UINT STDMETHODCALLTYPE GetRemovalCount();
+		
+		virtual UINT STDMETHODCALLTYPE GetTextureArraySize();
+		virtual UINT64 STDMETHODCALLTYPE GetFlushBytes(UINT64 *pLastFlushBytes);
+		virtual UINT STDMETHODCALLTYPE InsertGlyphAlias(UINT GlyphAtlasId, FLOAT Scale);
+		virtual UINT STDMETHODCALLTYPE InsertSheetContents(
+			const void *pPixels,
+			UINT RowCount,
+			const FW1_GLYPHCOORDS *pGlyphCoords,
+			UINT GlyphCount
+		);
+		virtual HRESULT STDMETHODCALLTYPE SetSheetCompression(BOOL Compress);
+		virtual BOOL STDMETHODCALLTYPE HasCoordBuffers();
 	
 	// Public functions
 	public:
@@ -48,17 +69,23 @@ class CFW1GlyphAtlas : public CFW1Object<IFW1GlyphAtlas> {
 			bool allowOversizedTexture,
 			UINT maxGlyphCountPerSheet,
 			UINT mipLevelCount,
-			UINT maxSheetCount
+			UINT maxSheetCount,
+			UINT textureArraySize
 		);
 	
 	// Internal functions
 	private:
 		virtual ~CFW1GlyphAtlas();
 		
+		HRESULT createTextureArray(UINT textureArraySize);
 		HRESULT createGlyphSheet(IFW1GlyphSheet **ppGlyphSheet);
+		UINT insertSheet(IFW1GlyphSheet *pGlyphSheet);
+		static UINT64 getSheetMemory(IFW1GlyphSheet *pGlyphSheet);
 	
 	// Internal data
 	private:
+		std::wstring				m_lastError;
+		
 		ID3D11Device				*m_pDevice;
 		UINT						m_sheetWidth;
 		UINT						m_sheetHeight;
@@ -66,12 +93,22 @@ class CFW1GlyphAtlas : public CFW1Object<IFW1GlyphAtlas> {
 		bool						m_allowOversizedGlyph;
 		UINT						m_maxGlyphCount;
 		UINT						m_mipLevelCount;
+		bool						m_compressSheets;
 		
 		IFW1GlyphSheet				**m_glyphSheets;
 		UINT						m_sheetCount;
 		UINT						m_maxSheetCount;
 		UINT						m_currentSheetIndex;
 		UINT						m_flushedSheetIndex;
+		UINT						m_removalCount;
+		
+		UINT						m_textureArraySize;
+		UINT64						m_textureArrayMemory;
+		ID3D11ShaderResourceView	*m_pArrayTextureSRV;
+		ID3D11ShaderResourceView	*m_pArrayCoordSRV;
+		
+		UINT64						m_lastFlushBytes;
+		UINT64						m_totalFlushBytes;
 		
 		CRITICAL_SECTION			m_glyphSheetsCriticalSection;
 };
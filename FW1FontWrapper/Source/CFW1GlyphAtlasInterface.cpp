@@ -119,11 +119,15 @@ UINT STDMETHODCALLTYPE CFW1GlyphAtlas::InsertGlyph(
 	
 	// Try to create a new glyph sheet on failure
 	if(glyphIndex == 0xffffffff && m_sheetCount < m_maxSheetCount) {
+		// A texture-array sheet writes to the slice matching its index, so no other sheet may be inserted in between
+		if(m_textureArraySize > 0)
+			EnterCriticalSection(&m_glyphSheetsCriticalSection);
+		
 		IFW1GlyphSheet *pGlyphSheet;
 		if(SUCCEEDED(createGlyphSheet(&pGlyphSheet))) {
 			glyphIndex = pGlyphSheet->InsertGlyph(pGlyphMetrics, pGlyphData, RowPitch, PixelStride);
 			
-			UINT newSheetIndex = InsertSheet(pGlyphSheet);
+			UINT newSheetIndex = insertSheet(pGlyphSheet);
 			if(newSheetIndex != 0xffffffff)
 				sheetIndex = newSheetIndex;
 			else
@@ -131,6 +135,9 @@ UINT STDMETHODCALLTYPE CFW1GlyphAtlas::InsertGlyph(
 			
 			pGlyphSheet->Release();
 		}
+		
+		if(m_textureArraySize > 0)
+			LeaveCriticalSection(&m_glyphSheetsCriticalSection);
 	}
 	
 	if(glyphIndex == 0xffffffff)
@@ -142,6 +149,16 @@ UINT STDMETHODCALLTYPE CFW1GlyphAtlas::InsertGlyph(
 
 // Insert glyph sheets
 UINT STDMETHODCALLTYPE CFW1GlyphAtlas::InsertSheet(IFW1GlyphSheet *pGlyphSheet) {
+	// Sheets in a texture-array atlas must be slices of its texture array
+	if(m_textureArraySize > 0)
+		return 0xffffffff;
+	
+	return insertSheet(pGlyphSheet);
+}
+
+
+// Insert a sheet at the end of the sheet array
+UINT CFW1GlyphAtlas::insertSheet(IFW1GlyphSheet *pGlyphSheet) {
 	if(pGlyphSheet == NULL)
 		return 0xffffffff;
 	
@@ -189,8 +206,209 @@ void STDMETHODCALLTYPE CFW1GlyphAtlas::Flush(ID3D11DeviceContext *pContext) {
 	
 	LeaveCriticalSection(&m_glyphSheetsCriticalSection);
 	
-	for(UINT i=first; i < end; ++i)
+	UINT64 flushBytes = 0;
+	for(UINT i=first; i < end; ++i) {
 		m_glyphSheets[i]->Flush(pContext);
+		
+		FW1_GLYPHSHEETDESC desc;
+		m_glyphSheets[i]->GetDesc(&desc);
+		flushBytes += desc.LastFlushBytes;
+	}
+	
+	EnterCriticalSection(&m_glyphSheetsCriticalSection);
+	m_lastFlushBytes = flushBytes;
+	m_totalFlushBytes += flushBytes;
+	LeaveCriticalSection(&m_glyphSheetsCriticalSection);
+}
+
+
+// Get memory used by all sheet textures
+UINT64 STDMETHODCALLTYPE CFW1GlyphAtlas::GetMemoryUsage() {
+	// All slices of a texture array are allocated at creation
+	if(m_textureArraySize > 0)
+		return m_textureArrayMemory;
+	
+	UINT64 total = 0;
+	
+	EnterCriticalSection(&m_glyphSheetsCriticalSection);
+	for(UINT i=0; i < m_sheetCount; ++i)
+		total += getSheetMemory(m_glyphSheets[i]);
+	LeaveCriticalSection(&m_glyphSheetsCriticalSection);
+	
+	return total;
+}
+
+
+// Remove sheets and compact the sheet array
+UINT STDMETHODCALLTYPE CFW1GlyphAtlas::RemoveSheets(
+	const UINT *pSheetIndices,
+	UINT IndexCount,
+	UINT64 BytesToFree,
+	UINT *pSheetRemap
+) {
+	if(pSheetRemap == NULL || (pSheetIndices == NULL && IndexCount > 0))
+		return 0;
+	
+	EnterCriticalSection(&m_glyphSheetsCriticalSection);
+	
+	for(UINT i=0; i < m_sheetCount; ++i)
+		pSheetRemap[i] = i;
+	
+	// Mark sheets for removal, sheet 0 holds the default glyph and only closed and flushed sheets are static
+	UINT removedCount = 0;
+	UINT64 freedBytes = 0;
+	
+	// The index of a texture-array sheet is its slice, so those sheets can never be moved
+	if(m_textureArraySize > 0)
+		IndexCount = 0;
+	
+	for(UINT i=0; i < IndexCount && freedBytes < BytesToFree; ++i) {
+		UINT sheetIndex = pSheetIndices[i];
+		if(sheetIndex == 0 || sheetIndex >= m_flushedSheetIndex || pSheetRemap[sheetIndex] == 0xffffffff)
+			continue;
+		
+		pSheetRemap[sheetIndex] = 0xffffffff;
+		freedBytes += getSheetMemory(m_glyphSheets[sheetIndex]);
+		++removedCount;
+	}
+	
+	// Release removed sheets and move the others down
+	if(removedCount > 0) {
+		UINT newSheetCount = 0;
+		
+		for(UINT i=0; i < m_sheetCount; ++i) {
+			if(pSheetRemap[i] == 0xffffffff)
+				m_glyphSheets[i]->Release();
+			else {
+				m_glyphSheets[newSheetCount] = m_glyphSheets[i];
+				pSheetRemap[i] = newSheetCount;
+				++newSheetCount;
+			}
+		}
+		
+		// All removed sheets were before the open range
+		m_sheetCount = newSheetCount;
+		m_currentSheetIndex -= removedCount;
+		m_flushedSheetIndex -= removedCount;
+		
+		++m_removalCount;
+	}
+	
+	LeaveCriticalSection(&m_glyphSheetsCriticalSection);
+	
+	return removedCount;
+}
+
+
+// Get number of sheet removals
+UINT STDMETHODCALLTYPE CFW1GlyphAtlas::GetRemovalCount() {
+	return m_removalCount;
+}
+
+
+// Get number of texture array slices
+UINT STDMETHODCALLTYPE CFW1GlyphAtlas::GetTextureArraySize() {
+	return m_textureArraySize;
+}
+
+
+// Get the number of bytes uploaded by flushing the sheets
+UINT64 STDMETHODCALLTYPE CFW1GlyphAtlas::GetFlushBytes(UINT64 *pLastFlushBytes) {
+	EnterCriticalSection(&m_glyphSheetsCriticalSection);
+	UINT64 totalFlushBytes = m_totalFlushBytes;
+	if(pLastFlushBytes != NULL)
+		*pLastFlushBytes = m_lastFlushBytes;
+	LeaveCriticalSection(&m_glyphSheetsCriticalSection);
+	
+	return totalFlushBytes;
+}
+
+
+// Insert a glyph reusing the image of another glyph at a different scale
+UINT STDMETHODCALLTYPE CFW1GlyphAtlas::InsertGlyphAlias(UINT GlyphAtlasId, FLOAT Scale) {
+	UINT sheetIndex = GlyphAtlasId >> 16;
+	IFW1GlyphSheet *pGlyphSheet = NULL;
+	
+	EnterCriticalSection(&m_glyphSheetsCriticalSection);
+	if(sheetIndex < m_sheetCount) {
+		pGlyphSheet = m_glyphSheets[sheetIndex];
+		pGlyphSheet->AddRef();
+	}
+	LeaveCriticalSection(&m_glyphSheetsCriticalSection);
+	
+	if(pGlyphSheet == NULL)
+		return 0xffffffff;
+	
+	UINT glyphIndex = pGlyphSheet->InsertGlyphAlias(GlyphAtlasId & 0xffff, Scale);
+	pGlyphSheet->Release();
+	
+	if(glyphIndex == 0xffffffff)
+		return 0xffffffff;
+	
+	// The sheet may be closed and already flushed, flush it again so the new coords reach the device
+	EnterCriticalSection(&m_glyphSheetsCriticalSection);
+	if(sheetIndex < m_flushedSheetIndex)
+		m_flushedSheetIndex = sheetIndex;
+	LeaveCriticalSection(&m_glyphSheetsCriticalSection);
+	
+	return (sheetIndex << 16) | glyphIndex;
+}
+
+
+// Add a new sheet filled with saved glyphs
+UINT STDMETHODCALLTYPE CFW1GlyphAtlas::InsertSheetContents(
+	const void *pPixels,
+	UINT RowCount,
+	const FW1_GLYPHCOORDS *pGlyphCoords,
+	UINT GlyphCount
+) {
+	UINT sheetIndex = 0xffffffff;
+	
+	// As in InsertGlyph, no other sheet may be inserted between creating a texture-array sheet and inserting it
+	if(m_textureArraySize > 0)
+		EnterCriticalSection(&m_glyphSheetsCriticalSection);
+	
+	IFW1GlyphSheet *pGlyphSheet;
+	if(m_sheetCount < m_maxSheetCount && SUCCEEDED(createGlyphSheet(&pGlyphSheet))) {
+		HRESULT hResult = pGlyphSheet->SetSheetContents(pPixels, RowCount, pGlyphCoords, GlyphCount);
+		if(SUCCEEDED(hResult))
+			sheetIndex = insertSheet(pGlyphSheet);
+		
+		pGlyphSheet->Release();
+	}
+	
+	if(m_textureArraySize > 0)
+		LeaveCriticalSection(&m_glyphSheetsCriticalSection);
+	
+	return sheetIndex;
+}
+
+
+// Compress sheets once they are closed
+HRESULT STDMETHODCALLTYPE CFW1GlyphAtlas::SetSheetCompression(BOOL Compress) {
+	if(m_textureArraySize > 0)
+		return E_FAIL;
+	
+	EnterCriticalSection(&m_glyphSheetsCriticalSection);
+	
+	m_compressSheets = (Compress != FALSE);
+	
+	// Sheets already static keep their texture
+	for(UINT i=0; i < m_sheetCount; ++i)
+		m_glyphSheets[i]->SetCompression(Compress);
+	
+	LeaveCriticalSection(&m_glyphSheetsCriticalSection);
+	
+	return S_OK;
+}
+
+
+// Check whether the sheets have coord buffers for the shaders
+BOOL STDMETHODCALLTYPE CFW1GlyphAtlas::HasCoordBuffers() {
+	if(m_hardwareCoordBuffer && m_pDevice->GetFeatureLevel() >= D3D_FEATURE_LEVEL_10_0)
+		return TRUE;
+	
+	return FALSE;
 }
 
 
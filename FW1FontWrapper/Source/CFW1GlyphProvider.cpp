@@ -18,12 +18,41 @@ CFW1GlyphProvider::CFW1GlyphProvider() :
 	m_maxGlyphWidth(0),
 	m_maxGlyphHeight(0),
 	
-	m_pFontCollection(NULL)
+	m_pFontCollection(NULL),
+	
+	m_currentFrame(0),
+	
+	m_pGlyphMapCache(0),
+	
+	m_fontSizeStep(0.0f),
+	m_rasterizedGlyphCount(0),
+	m_scaledGlyphCount(0),
+	m_scaledGlyphArea(0),
+	
+	m_distanceFieldSize(0.0f),
+	m_distanceFieldSpread(0),
+	
+	m_pendingPrewarmCount(0),
+	
+	m_maxGlyphsPerFrame(0),
+	m_maxMicrosecondsPerFrame(0),
+	m_frameGlyphCount(0),
+	m_frameGlyphTicks(0),
+	m_tickFrequency(1),
+	m_deferredDrawnCount(0),
+	
+	m_staticGlyphAtlas(false),
+	m_outlineRasterizer(false)
 {
 	InitializeCriticalSection(&m_renderTargetsCriticalSection);
 	InitializeCriticalSection(&m_glyphMapsCriticalSection);
 	InitializeCriticalSection(&m_fontsCriticalSection);
 	InitializeCriticalSection(&m_insertGlyphCriticalSection);
+	InitializeCriticalSection(&m_deferredGlyphsCriticalSection);
+	
+	LARGE_INTEGER frequency;
+	if(QueryPerformanceFrequency(&frequency) && frequency.QuadPart > 0)
+		m_tickFrequency = frequency.QuadPart;
 }
 
 
@@ -42,17 +71,25 @@ CFW1GlyphProvider::~CFW1GlyphProvider() {
 	for(size_t i=0; i < m_fonts.size(); ++i)
 		SAFE_RELEASE(m_fonts[i].pFontFace);
 	
-	for(FontMap::iterator it = m_fontMap.begin(); it != m_fontMap.end(); ++it) {
-		GlyphMap *glyphMap = (*it).second;
-		
-		delete[] glyphMap->glyphs;
-		delete glyphMap;
+	for(size_t i=0; i < m_deferredGlyphs.size(); ++i)
+		SAFE_RELEASE(m_deferredGlyphs[i].pFontFace);
+	
+	for(FontMap::iterator it = m_fontMap.begin(); it != m_fontMap.end(); ++it)
+		deleteGlyphMap((*it).second);
+	
+	GlyphMapCache *cache = m_pGlyphMapCache;
+	if(cache != 0)
+		m_retiredGlyphMapCaches.push_back(cache);
+	for(size_t i=0; i < m_retiredGlyphMapCaches.size(); ++i) {
+		delete[] m_retiredGlyphMapCaches[i]->entries;
+		delete m_retiredGlyphMapCaches[i];
 	}
 	
 	DeleteCriticalSection(&m_renderTargetsCriticalSection);
 	DeleteCriticalSection(&m_glyphMapsCriticalSection);
 	DeleteCriticalSection(&m_fontsCriticalSection);
 	DeleteCriticalSection(&m_insertGlyphCriticalSection);
+	DeleteCriticalSection(&m_deferredGlyphsCriticalSection);
 }
 
 
@@ -125,7 +162,13 @@ UINT CFW1GlyphProvider::getFontIndexFromFontFace(IDWriteFontFace *pFontFace) {
 				FontInfo &fontInfo = m_fonts[i];
 				
 				if(fontInfo.uniqueName == uniqueName) {
+					// A font loaded from a glyph cache is only used if its font files are unchanged
+					if(fontInfo.pFontFace == NULL && fontInfo.fileHash != getFontFileHash(pFontFace))
+						continue;
+					
 					pOldFontFace = fontInfo.pFontFace;
+					if(pOldFontFace != NULL)
+						uncacheFontFace(pOldFontFace);
 					fontInfo.pFontFace = pFontFace;
 					fontIndex = static_cast<UINT>(i);
 					break;
@@ -138,6 +181,7 @@ UINT CFW1GlyphProvider::getFontIndexFromFontFace(IDWriteFontFace *pFontFace) {
 				
 				fontInfo.pFontFace = pFontFace;
 				fontInfo.uniqueName = uniqueName;
+				fontInfo.fileHash = 0;
 				
 				fontIndex = static_cast<UINT>(m_fonts.size());
 				m_fonts.push_back(fontInfo);
@@ -232,10 +276,91 @@ std::wstring CFW1GlyphProvider::getUniqueNameFromFontFace(IDWriteFontFace *pFont
 }
 
 
+// Hash the keys, sizes and last write times of the files of a font-face, to tell when a font file has changed
+UINT64 CFW1GlyphProvider::getFontFileHash(IDWriteFontFace *pFontFace) {
+	UINT64 hash = 14695981039346656037ULL;
+	
+	UINT32 fileCount = 0;
+	HRESULT hResult = pFontFace->GetFiles(&fileCount, NULL);
+	if(FAILED(hResult) || fileCount == 0)
+		return hash;
+	
+	std::vector<IDWriteFontFile*> fontFiles(fileCount, NULL);
+	hResult = pFontFace->GetFiles(&fileCount, &fontFiles[0]);
+	if(FAILED(hResult))
+		return hash;
+	
+	for(UINT32 i=0; i < fileCount; ++i) {
+		IDWriteFontFile *pFontFile = fontFiles[i];
+		
+		// Size and last write time, left 0 when the file loader can't tell
+		UINT64 fileInfo[2] = {0, 0};
+		
+		const void *pReferenceKey;
+		UINT32 referenceKeySize;
+		hResult = pFontFile->GetReferenceKey(&pReferenceKey, &referenceKeySize);
+		if(SUCCEEDED(hResult)) {
+			hash = hashBytes(hash, pReferenceKey, referenceKeySize);
+			
+			IDWriteFontFileLoader *pFontFileLoader;
+			hResult = pFontFile->GetLoader(&pFontFileLoader);
+			if(SUCCEEDED(hResult)) {
+				IDWriteFontFileStream *pFontFileStream;
+				hResult = pFontFileLoader->CreateStreamFromKey(pReferenceKey, referenceKeySize, &pFontFileStream);
+				if(SUCCEEDED(hResult)) {
+					if(FAILED(pFontFileStream->GetFileSize(&fileInfo[0])))
+						fileInfo[0] = 0;
+					if(FAILED(pFontFileStream->GetLastWriteTime(&fileInfo[1])))
+						fileInfo[1] = 0;
+					
+					pFontFileStream->Release();
+				}
+				
+				pFontFileLoader->Release();
+			}
+		}
+		
+		hash = hashBytes(hash, fileInfo, sizeof(fileInfo));
+		
+		pFontFile->Release();
+	}
+	
+	UINT32 faceIndex = pFontFace->GetIndex();
+	hash = hashBytes(hash, &faceIndex, sizeof(faceIndex));
+	
+	return hash;
+}
+
+
+// Add bytes to a 64-bit FNV-1a hash
+UINT64 CFW1GlyphProvider::hashBytes(UINT64 hash, const void *pData, SIZE_T size) {
+	const UINT8 *bytes = static_cast<const UINT8*>(pData);
+	
+	for(SIZE_T i=0; i < size; ++i) {
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+	
+	return hash;
+}
+
+
 // Render and insert new glyph into a glyph-map
 UINT CFW1GlyphProvider::insertNewGlyph(GlyphMap *glyphMap, UINT16 glyphIndex, IDWriteFontFace *pFontFace) {
 	UINT glyphAtlasId = 0xffffffff;
 	
+	// Reuse the glyph image of the snapped size if possible
+	// Distance-field atlases must not fall back to a coverage image at the exact size
+	if(glyphMap->sourceGlyphMap != 0) {
+		glyphAtlasId = insertScaledGlyph(glyphMap, glyphIndex, pFontFace);
+		if(glyphAtlasId != 0xffffffff || m_distanceFieldSize > 0.0f)
+			return glyphAtlasId;
+	}
+	
+	// A static atlas only holds the glyphs it was loaded with
+	if(m_staticGlyphAtlas)
+		return glyphAtlasId;
+	
 	// Get a render target
 	IFW1DWriteRenderTarget *pRenderTarget = NULL;
 	
@@ -250,12 +375,22 @@ UINT CFW1GlyphProvider::insertNewGlyph(GlyphMap *glyphMap, UINT16 glyphIndex, ID
 	
 	if(pRenderTarget == NULL) {
 		IFW1DWriteRenderTarget *pNewRenderTarget;
-		HRESULT hResult = m_pFW1Factory->CreateDWriteRenderTarget(
-			m_pDWriteFactory,
-			m_maxGlyphWidth,
-			m_maxGlyphHeight,
-			&pNewRenderTarget
-		);
+		HRESULT hResult;
+		if(m_outlineRasterizer) {
+			hResult = m_pFW1Factory->CreateOutlineRenderTarget(
+				m_maxGlyphWidth,
+				m_maxGlyphHeight,
+				&pNewRenderTarget
+			);
+		}
+		else {
+			hResult = m_pFW1Factory->CreateDWriteRenderTarget(
+				m_pDWriteFactory,
+				m_maxGlyphWidth,
+				m_maxGlyphHeight,
+				&pNewRenderTarget
+			);
+		}
 		if(FAILED(hResult)) {
 		}
 		else {
@@ -284,19 +419,36 @@ UINT CFW1GlyphProvider::insertNewGlyph(GlyphMap *glyphMap, UINT16 glyphIndex, ID
 		if(FAILED(hResult)) {
 		}
 		else {
+			// Convert to a distance field before taking the lock
+			std::vector<UINT8> fieldPixels;
+			if(m_distanceFieldSize > 0.0f && glyphData.Metrics.Width > 0 && glyphData.Metrics.Height > 0) {
+				FW1_GLYPHMETRICS fieldMetrics;
+				createDistanceField(glyphData, fieldPixels, fieldMetrics);
+				
+				glyphData.Metrics = fieldMetrics;
+				glyphData.pGlyphPixels = &fieldPixels[0];
+				glyphData.RowPitch = fieldMetrics.Width;
+				glyphData.PixelStride = 1;
+			}
+			
 			// Insert into the atlas and the glyph-map
 			EnterCriticalSection(&m_insertGlyphCriticalSection);
 			
-			glyphAtlasId = glyphMap->glyphs[glyphIndex];
-			if(glyphAtlasId == 0xffffffff) {
+			GlyphPage *page = getGlyphPage(glyphMap, glyphIndex, true);
+			
+			if(page != 0)
+				glyphAtlasId = page->glyphs[glyphIndex & (GlyphPageSize - 1)];
+			if(page != 0 && glyphAtlasId == 0xffffffff) {
 				glyphAtlasId = m_pGlyphAtlas->InsertGlyph(
 					&glyphData.Metrics,
 					glyphData.pGlyphPixels,
 					glyphData.RowPitch,
 					glyphData.PixelStride
 				);
-				if(glyphAtlasId != 0xffffffff)
-					glyphMap->glyphs[glyphIndex] = glyphAtlasId;
+				if(glyphAtlasId != 0xffffffff) {
+					page->glyphs[glyphIndex & (GlyphPageSize - 1)] = glyphAtlasId;
+					++m_rasterizedGlyphCount;
+				}
 			}
 			
 			LeaveCriticalSection(&m_insertGlyphCriticalSection);
@@ -312,4 +464,872 @@ UINT CFW1GlyphProvider::insertNewGlyph(GlyphMap *glyphMap, UINT16 glyphIndex, ID
 }
 
 
+// Insert a glyph into a scaled glyph-map, as an alias of the glyph in the source glyph-map
+UINT CFW1GlyphProvider::insertScaledGlyph(GlyphMap *glyphMap, UINT16 glyphIndex, IDWriteFontFace *pFontFace) {
+	GlyphMap *sourceGlyphMap = glyphMap->sourceGlyphMap;
+	
+	UINT sourceAtlasId = getGlyphAtlasId(sourceGlyphMap, glyphIndex);
+	if(sourceAtlasId == 0xffffffff)
+		sourceAtlasId = insertNewGlyph(sourceGlyphMap, glyphIndex, pFontFace);
+	if(sourceAtlasId == 0xffffffff)
+		return 0xffffffff;
+	
+	UINT glyphAtlasId = 0xffffffff;
+	
+	EnterCriticalSection(&m_insertGlyphCriticalSection);
+	
+	GlyphPage *page = getGlyphPage(glyphMap, glyphIndex, true);
+	if(page != 0) {
+		glyphAtlasId = page->glyphs[glyphIndex & (GlyphPageSize - 1)];
+		if(glyphAtlasId == 0xffffffff) {
+			glyphAtlasId = m_pGlyphAtlas->InsertGlyphAlias(sourceAtlasId, glyphMap->sourceScale);
+			if(glyphAtlasId != 0xffffffff) {
+				page->glyphs[glyphIndex & (GlyphPageSize - 1)] = glyphAtlasId;
+				
+				// Count the atlas area the glyph would have taken at its exact size
+				++m_scaledGlyphCount;
+				const FW1_GLYPHCOORDS *glyphCoords = m_pGlyphAtlas->GetGlyphCoords(glyphAtlasId >> 16);
+				if(glyphCoords != NULL) {
+					const FW1_GLYPHCOORDS &coords = glyphCoords[glyphAtlasId & 0xffff];
+					m_scaledGlyphArea += static_cast<UINT64>(
+						(coords.PositionRight - coords.PositionLeft) * (coords.PositionBottom - coords.PositionTop)
+					);
+				}
+			}
+		}
+	}
+	
+	LeaveCriticalSection(&m_insertGlyphCriticalSection);
+	
+	return glyphAtlasId;
+}
+
+
+// Snap a font size to the nearest multiple of the font size step
+FLOAT CFW1GlyphProvider::snapFontSize(FLOAT fontSize) {
+	FLOAT fontSizeStep = m_fontSizeStep;
+	if(fontSizeStep <= 0.0f || !(fontSize > 0.0f))
+		return fontSize;
+	
+	FLOAT snappedSize = floor(fontSize / fontSizeStep + 0.5f) * fontSizeStep;
+	if(snappedSize < fontSizeStep)
+		snappedSize = fontSizeStep;
+	
+	// Sizes already on a step are kept, rather than replaced by a rounding error away
+	if(fabs(snappedSize - fontSize) <= fontSize * 0.0001f)
+		return fontSize;
+	
+	return snappedSize;
+}
+
+
+// Convert a coverage glyph image to a signed distance field, padded by the spread on every side
+void CFW1GlyphProvider::createDistanceField(
+	const FW1_GLYPHIMAGEDATA &glyphData,
+	std::vector<UINT8> &fieldPixels,
+	FW1_GLYPHMETRICS &fieldMetrics
+) {
+	const UINT spread = m_distanceFieldSpread;
+	const UINT width = glyphData.Metrics.Width + 2 * spread;
+	const UINT height = glyphData.Metrics.Height + 2 * spread;
+	const UINT pixelCount = width * height;
+	
+	std::vector<FLOAT> coverage(pixelCount, 0.0f);
+	for(UINT y=0; y < glyphData.Metrics.Height; ++y) {
+		const UINT8 *src = static_cast<const UINT8*>(glyphData.pGlyphPixels) + y * glyphData.RowPitch;
+		FLOAT *dst = &coverage[(y + spread) * width + spread];
+		
+		for(UINT x=0; x < glyphData.Metrics.Width; ++x)
+			dst[x] = static_cast<FLOAT>(src[x * glyphData.PixelStride]) / 255.0f;
+	}
+	
+	// Squared distances from each pixel to the nearest pixel inside and outside the glyph
+	const FLOAT farAway = 1e20f;
+	std::vector<FLOAT> toInside(pixelCount);
+	std::vector<FLOAT> toOutside(pixelCount);
+	for(UINT i=0; i < pixelCount; ++i) {
+		bool inside = (coverage[i] >= 0.5f);
+		toInside[i] = inside ? 0.0f : farAway;
+		toOutside[i] = inside ? farAway : 0.0f;
+	}
+	distanceTransform(&toInside[0], width, height);
+	distanceTransform(&toOutside[0], width, height);
+	
+	// Signed distance to the edge, positive inside, with the edge at 0.5 and the spread at 0 and 1
+	fieldPixels.resize(pixelCount);
+	const FLOAT scale = 0.5f / static_cast<FLOAT>(spread);
+	for(UINT i=0; i < pixelCount; ++i) {
+		FLOAT distance;
+		if(coverage[i] >= 0.5f)
+			distance = sqrt(toOutside[i]) - 0.5f;
+		else
+			distance = 0.5f - sqrt(toInside[i]);
+		
+		// Pixels on the edge know where it crosses them from their coverage
+		if(fabs(distance) <= 0.5f && coverage[i] > 0.0f && coverage[i] < 1.0f)
+			distance = coverage[i] - 0.5f;
+		
+		FLOAT value = 0.5f + distance * scale;
+		if(value < 0.0f)
+			value = 0.0f;
+		else if(value > 1.0f)
+			value = 1.0f;
+		fieldPixels[i] = static_cast<UINT8>(value * 255.0f + 0.5f);
+	}
+	
+	fieldMetrics.OffsetX = glyphData.Metrics.OffsetX - static_cast<FLOAT>(spread);
+	fieldMetrics.OffsetY = glyphData.Metrics.OffsetY - static_cast<FLOAT>(spread);
+	fieldMetrics.Width = width;
+	fieldMetrics.Height = height;
+}
+
+
+// Exact squared euclidean distance transform of a grid, in place, by transforming the columns and then the rows
+void CFW1GlyphProvider::distanceTransform(FLOAT *grid, UINT width, UINT height) {
+	UINT maxLength = std::max(width, height);
+	std::vector<FLOAT> f(maxLength);
+	std::vector<FLOAT> z(maxLength + 1);
+	std::vector<UINT> v(maxLength);
+	
+	for(UINT x=0; x < width; ++x)
+		distanceTransformLine(grid + x, height, width, &f[0], &z[0], &v[0]);
+	for(UINT y=0; y < height; ++y)
+		distanceTransformLine(grid + y * width, width, 1, &f[0], &z[0], &v[0]);
+}
+
+
+// One-dimensional squared distance transform as the lower envelope of parabolas (Felzenszwalb and Huttenlocher)
+void CFW1GlyphProvider::distanceTransformLine(FLOAT *line, UINT count, UINT stride, FLOAT *f, FLOAT *z, UINT *v) {
+	for(UINT q=0; q < count; ++q)
+		f[q] = line[q * stride];
+	
+	// Find the parabolas in the lower envelope, and where each takes over from the previous
+	UINT k = 0;
+	v[0] = 0;
+	z[0] = -FLT_MAX;
+	z[1] = FLT_MAX;
+	for(UINT q=1; q < count; ++q) {
+		FLOAT fq = f[q] + static_cast<FLOAT>(q * q);
+		FLOAT s;
+		for(;;) {
+			UINT p = v[k];
+			s = (fq - (f[p] + static_cast<FLOAT>(p * p))) / static_cast<FLOAT>(2 * (q - p));
+			if(s > z[k] || k == 0)
+				break;
+			--k;
+		}
+		
+		++k;
+		v[k] = q;
+		z[k] = s;
+		z[k+1] = FLT_MAX;
+	}
+	
+	// Sample the envelope
+	k = 0;
+	for(UINT q=0; q < count; ++q) {
+		while(z[k+1] < static_cast<FLOAT>(q))
+			++k;
+		
+		FLOAT d = static_cast<FLOAT>(q) - static_cast<FLOAT>(v[k]);
+		line[q * stride] = d * d + f[v[k]];
+	}
+}
+
+
+// Draw the glyphs of a prewarm task into the atlas
+void CFW1GlyphProvider::prewarmGlyphs(const PrewarmTask *task) {
+	if(task->codePoints.empty())
+		return;
+	
+	std::vector<UINT16> glyphIndices(task->codePoints.size());
+	HRESULT hResult = task->pFontFace->GetGlyphIndices(
+		&task->codePoints[0],
+		static_cast<UINT32>(task->codePoints.size()),
+		&glyphIndices[0]
+	);
+	if(FAILED(hResult)) {
+	}
+	else {
+		const void *glyphMap = GetGlyphMapFromFont(task->pFontFace, task->fontSize, task->fontFlags);
+		
+		// Glyphs already in the glyph-map are skipped without drawing, and the frame's glyph budget is left to the render thread
+		for(size_t i=0; i < glyphIndices.size(); ++i) {
+			UINT glyphAtlasId = GetAtlasIdFromGlyphIndex(
+				glyphMap,
+				glyphIndices[i],
+				task->pFontFace,
+				task->fontFlags | FW1_NOGLYPHBUDGET
+			);
+			glyphAtlasId;
+		}
+	}
+}
+
+
+// Worker thread entry point for a prewarm task
+DWORD WINAPI CFW1GlyphProvider::prewarmThreadProc(LPVOID pParam) {
+	PrewarmTask *task = static_cast<PrewarmTask*>(pParam);
+	CFW1GlyphProvider *pGlyphProvider = task->pGlyphProvider;
+	
+	pGlyphProvider->prewarmGlyphs(task);
+	
+	task->pFontFace->Release();
+	delete task;
+	
+	InterlockedDecrement(&pGlyphProvider->m_pendingPrewarmCount);
+	pGlyphProvider->Release();
+	
+	return 0;
+}
+
+
+// Check if the glyphs drawn in the current frame have used up either budget
+bool CFW1GlyphProvider::isGlyphBudgetUsedUp() {
+	if(m_maxGlyphsPerFrame > 0 && static_cast<UINT>(m_frameGlyphCount) >= m_maxGlyphsPerFrame)
+		return true;
+	
+	if(m_maxMicrosecondsPerFrame > 0) {
+		LONGLONG budgetTicks = static_cast<LONGLONG>(m_maxMicrosecondsPerFrame) * m_tickFrequency / 1000000;
+		if(m_frameGlyphTicks >= budgetTicks)
+			return true;
+	}
+	
+	return false;
+}
+
+
+// Insert a new glyph and charge the time it took to the frame's glyph budget
+UINT CFW1GlyphProvider::insertBudgetedGlyph(GlyphMap *glyphMap, UINT16 glyphIndex, IDWriteFontFace *pFontFace) {
+	LARGE_INTEGER startTime;
+	QueryPerformanceCounter(&startTime);
+	
+	UINT glyphAtlasId = insertNewGlyph(glyphMap, glyphIndex, pFontFace);
+	
+	LARGE_INTEGER endTime;
+	QueryPerformanceCounter(&endTime);
+	
+	InterlockedIncrement(&m_frameGlyphCount);
+	InterlockedExchangeAdd64(&m_frameGlyphTicks, endTime.QuadPart - startTime.QuadPart);
+	
+	return glyphAtlasId;
+}
+
+
+// Queue a glyph to be drawn in a later frame, unless it is already queued
+void CFW1GlyphProvider::deferGlyph(GlyphMap *glyphMap, UINT16 glyphIndex, IDWriteFontFace *pFontFace) {
+	EnterCriticalSection(&m_deferredGlyphsCriticalSection);
+	
+	if(m_deferredGlyphKeys.insert(std::make_pair(glyphMap, glyphIndex)).second) {
+		DeferredGlyph deferredGlyph;
+		deferredGlyph.glyphMap = glyphMap;
+		deferredGlyph.glyphIndex = glyphIndex;
+		deferredGlyph.pFontFace = pFontFace;
+		pFontFace->AddRef();
+		
+		m_deferredGlyphs.push_back(deferredGlyph);
+	}
+	
+	LeaveCriticalSection(&m_deferredGlyphsCriticalSection);
+}
+
+
+// Draw queued glyphs, oldest first, until the budget for the frame is used up
+void CFW1GlyphProvider::drawDeferredGlyphs() {
+	while(!isGlyphBudgetUsedUp()) {
+		DeferredGlyph deferredGlyph;
+		
+		EnterCriticalSection(&m_deferredGlyphsCriticalSection);
+		bool empty = m_deferredGlyphs.empty();
+		if(!empty) {
+			deferredGlyph = m_deferredGlyphs.front();
+			m_deferredGlyphs.pop_front();
+		}
+		LeaveCriticalSection(&m_deferredGlyphsCriticalSection);
+		
+		if(empty)
+			break;
+		
+		EnterCriticalSection(&m_deferredGlyphsCriticalSection);
+		m_deferredGlyphKeys.erase(std::make_pair(deferredGlyph.glyphMap, deferredGlyph.glyphIndex));
+		LeaveCriticalSection(&m_deferredGlyphsCriticalSection);
+		
+		// Draw as if requested by text, so a glyph that fails gets the fallback glyph and one that was drawn meanwhile is skipped
+		UINT glyphAtlasId = GetAtlasIdFromGlyphIndex(
+			deferredGlyph.glyphMap,
+			deferredGlyph.glyphIndex,
+			deferredGlyph.pFontFace,
+			0
+		);
+		glyphAtlasId;
+		
+		InterlockedIncrement(&m_deferredDrawnCount);
+		
+		deferredGlyph.pFontFace->Release();
+	}
+}
+
+
+// Serialise the fonts, sheets and glyph-maps as a glyph cache
+void CFW1GlyphProvider::writeGlyphCache(ID3D11DeviceContext *pContext, std::vector<UINT8> &cacheData) {
+	EnterCriticalSection(&m_insertGlyphCriticalSection);
+	EnterCriticalSection(&m_glyphMapsCriticalSection);
+	EnterCriticalSection(&m_fontsCriticalSection);
+	
+	UINT sheetCount = m_pGlyphAtlas->GetSheetCount();
+	
+	FW1_GLYPHSHEETDESC firstSheetDesc;
+	ZeroMemory(&firstSheetDesc, sizeof(firstSheetDesc));
+	IFW1GlyphSheet *pFirstSheet;
+	if(SUCCEEDED(m_pGlyphAtlas->GetSheet(0, &pFirstSheet)))
+		pFirstSheet->GetDesc(&firstSheetDesc);
+	
+	GlyphCacheHeader header;
+	ZeroMemory(&header, sizeof(header));
+	header.magic = GlyphCacheMagic;
+	header.version = GlyphCacheVersion;
+	header.sheetWidth = firstSheetDesc.Width;
+	header.sheetHeight = firstSheetDesc.Height;
+	header.mipLevelCount = firstSheetDesc.MipLevels;
+	header.distanceFieldSize = m_distanceFieldSize;
+	header.fontCount = static_cast<UINT>(m_fonts.size());
+	header.sheetCount = sheetCount;
+	header.glyphMapCount = static_cast<UINT>(m_fontMap.size());
+	writeCacheData(cacheData, &header, sizeof(header));
+	
+	// Fonts, with a hash of their files to check the glyphs against when loaded
+	for(size_t i=0; i < m_fonts.size(); ++i) {
+		const FontInfo &fontInfo = m_fonts[i];
+		
+		GlyphCacheFont font;
+		ZeroMemory(&font, sizeof(font));
+		font.fileHash = (fontInfo.pFontFace != NULL) ? getFontFileHash(fontInfo.pFontFace) : fontInfo.fileHash;
+		font.nameLength = static_cast<UINT>(fontInfo.uniqueName.size());
+		writeCacheData(cacheData, &font, sizeof(font));
+		
+		if(font.nameLength > 0)
+			writeCacheData(cacheData, fontInfo.uniqueName.c_str(), font.nameLength * sizeof(WCHAR));
+	}
+	
+	// Sheets, with only the rows that hold glyphs
+	// A sheet of another size or one that can't be read is stored empty, so the sheet indices stay the same
+	std::vector<UINT8> pixels(header.sheetWidth * header.sheetHeight);
+	for(UINT i=0; i < sheetCount; ++i) {
+		GlyphCacheSheet sheet;
+		ZeroMemory(&sheet, sizeof(sheet));
+		
+		IFW1GlyphSheet *pGlyphSheet = NULL;
+		HRESULT hResult = m_pGlyphAtlas->GetSheet(i, &pGlyphSheet);
+		if(SUCCEEDED(hResult) && !pixels.empty()) {
+			FW1_GLYPHSHEETDESC desc;
+			pGlyphSheet->GetDesc(&desc);
+			
+			if(desc.Width == header.sheetWidth && desc.Height == header.sheetHeight) {
+				hResult = pGlyphSheet->GetSheetPixels(pContext, &pixels[0]);
+				if(SUCCEEDED(hResult)) {
+					sheet.glyphCount = desc.GlyphCount;
+					sheet.rowCount = desc.PackedHeight;
+				}
+			}
+		}
+		
+		writeCacheData(cacheData, &sheet, sizeof(sheet));
+		if(sheet.glyphCount > 0)
+			writeCacheData(cacheData, pGlyphSheet->GetGlyphCoords(), sheet.glyphCount * sizeof(FW1_GLYPHCOORDS));
+		if(sheet.rowCount > 0)
+			writeCacheData(cacheData, &pixels[0], sheet.rowCount * header.sheetWidth);
+	}
+	
+	// Glyph-maps, numbered in map order so a scaled glyph-map can refer to its source
+	std::map<const GlyphMap*, UINT> glyphMapNumbers;
+	for(FontMap::iterator it = m_fontMap.begin(); it != m_fontMap.end(); ++it) {
+		UINT glyphMapNumber = static_cast<UINT>(glyphMapNumbers.size());
+		glyphMapNumbers[(*it).second] = glyphMapNumber;
+	}
+	
+	std::vector<GlyphCacheEntry> entries;
+	for(FontMap::iterator it = m_fontMap.begin(); it != m_fontMap.end(); ++it) {
+		const GlyphMap *glyphMap = (*it).second;
+		
+		// Only mapped glyphs are stored, deferred glyphs are drawn again when next used
+		entries.clear();
+		for(UINT i=0; i < glyphMap->pageCount; ++i) {
+			const GlyphPage *page = glyphMap->pages[i];
+			if(page == 0)
+				continue;
+			
+			for(UINT j=0; j < GlyphPageSize; ++j) {
+				if(page->glyphs[j] == 0xffffffff)
+					continue;
+				
+				GlyphCacheEntry entry;
+				entry.glyphIndex = (i << GlyphPageShift) + j;
+				entry.glyphAtlasId = page->glyphs[j];
+				entries.push_back(entry);
+			}
+		}
+		
+		GlyphCacheGlyphMap cachedGlyphMap;
+		ZeroMemory(&cachedGlyphMap, sizeof(cachedGlyphMap));
+		cachedGlyphMap.fontIndex = (*it).first.first;
+		cachedGlyphMap.fontSize = glyphMap->fontSize;
+		cachedGlyphMap.fontFlags = glyphMap->fontFlags;
+		cachedGlyphMap.sourceGlyphMap = 0xffffffff;
+		if(glyphMap->sourceGlyphMap != 0)
+			cachedGlyphMap.sourceGlyphMap = glyphMapNumbers[glyphMap->sourceGlyphMap];
+		cachedGlyphMap.sourceScale = glyphMap->sourceScale;
+		cachedGlyphMap.glyphCount = glyphMap->glyphCount;
+		cachedGlyphMap.entryCount = static_cast<UINT>(entries.size());
+		writeCacheData(cacheData, &cachedGlyphMap, sizeof(cachedGlyphMap));
+		
+		if(!entries.empty())
+			writeCacheData(cacheData, &entries[0], entries.size() * sizeof(GlyphCacheEntry));
+	}
+	
+	LeaveCriticalSection(&m_fontsCriticalSection);
+	LeaveCriticalSection(&m_glyphMapsCriticalSection);
+	LeaveCriticalSection(&m_insertGlyphCriticalSection);
+}
+
+
+// Restore the sheets, fonts and glyph-maps of a glyph cache, the whole cache is checked before anything is added
+HRESULT CFW1GlyphProvider::readGlyphCache(const UINT8 *pCacheData, UINT64 cacheSize) {
+	const UINT8 *pPosition = pCacheData;
+	const UINT8 *pEnd = pCacheData + static_cast<SIZE_T>(cacheSize);
+	
+	GlyphCacheHeader header;
+	const UINT8 *pHeader = readCacheData(&pPosition, pEnd, sizeof(header));
+	if(pHeader == NULL)
+		return E_FAIL;
+	memcpy(&header, pHeader, sizeof(header));
+	
+	if(header.magic != GlyphCacheMagic || header.version != GlyphCacheVersion)
+		return E_FAIL;
+	
+	// Saved sheets can only be used by an atlas with sheets of the same size, and glyphs of the same kind
+	IFW1GlyphSheet *pFirstSheet;
+	HRESULT hResult = m_pGlyphAtlas->GetSheet(0, &pFirstSheet);
+	if(FAILED(hResult))
+		return hResult;
+	
+	FW1_GLYPHSHEETDESC firstSheetDesc;
+	pFirstSheet->GetDesc(&firstSheetDesc);
+	
+	if(header.sheetWidth != firstSheetDesc.Width || header.sheetHeight != firstSheetDesc.Height)
+		return E_FAIL;
+	if(header.mipLevelCount != firstSheetDesc.MipLevels || header.distanceFieldSize != m_distanceFieldSize)
+		return E_FAIL;
+	
+	// Fonts
+	std::vector<FontInfo> fonts;
+	for(UINT i=0; i < header.fontCount; ++i) {
+		GlyphCacheFont font;
+		const UINT8 *pFont = readCacheData(&pPosition, pEnd, sizeof(font));
+		if(pFont == NULL)
+			return E_FAIL;
+		memcpy(&font, pFont, sizeof(font));
+		
+		if(font.nameLength == 0 || font.nameLength > 0xffff)
+			return E_FAIL;
+		const UINT8 *pName = readCacheData(&pPosition, pEnd, font.nameLength * sizeof(WCHAR));
+		if(pName == NULL)
+			return E_FAIL;
+		
+		FontInfo fontInfo;
+		fontInfo.pFontFace = NULL;
+		fontInfo.uniqueName.resize(font.nameLength);
+		memcpy(&fontInfo.uniqueName[0], pName, font.nameLength * sizeof(WCHAR));
+		fontInfo.fileHash = font.fileHash;
+		fonts.push_back(fontInfo);
+	}
+	
+	// Sheets
+	std::vector<GlyphCacheSheet> sheets;
+	std::vector<const UINT8*> sheetGlyphCoords;
+	std::vector<const UINT8*> sheetPixels;
+	for(UINT i=0; i < header.sheetCount; ++i) {
+		GlyphCacheSheet sheet;
+		const UINT8 *pSheet = readCacheData(&pPosition, pEnd, sizeof(sheet));
+		if(pSheet == NULL)
+			return E_FAIL;
+		memcpy(&sheet, pSheet, sizeof(sheet));
+		
+		if(sheet.glyphCount > 0xffff || sheet.rowCount > header.sheetHeight)
+			return E_FAIL;
+		const UINT8 *pGlyphCoords = readCacheData(&pPosition, pEnd, sheet.glyphCount * sizeof(FW1_GLYPHCOORDS));
+		const UINT8 *pPixels = readCacheData(&pPosition, pEnd, sheet.rowCount * header.sheetWidth);
+		if(pGlyphCoords == NULL || pPixels == NULL)
+			return E_FAIL;
+		
+		// Each glyph image must start inside the sheet and within the saved rows, with its edges in order
+		// The tests are written so that NaN coords fail them
+		for(UINT j=0; j < sheet.glyphCount; ++j) {
+			FW1_GLYPHCOORDS coords;
+			memcpy(&coords, pGlyphCoords + j * sizeof(FW1_GLYPHCOORDS), sizeof(coords));
+			
+			if(!(coords.TexCoordLeft >= 0.0f && coords.TexCoordLeft < 1.0f && coords.TexCoordLeft <= coords.TexCoordRight))
+				return E_FAIL;
+			if(!(coords.TexCoordTop >= 0.0f && coords.TexCoordTop <= coords.TexCoordBottom))
+				return E_FAIL;
+			if(!(coords.TexCoordTop * static_cast<FLOAT>(header.sheetHeight) < static_cast<FLOAT>(sheet.rowCount)))
+				return E_FAIL;
+		}
+		
+		sheets.push_back(sheet);
+		sheetGlyphCoords.push_back(pGlyphCoords);
+		sheetPixels.push_back(pPixels);
+	}
+	
+	// Glyph-maps
+	std::vector<GlyphCacheGlyphMap> cachedGlyphMaps;
+	std::vector<const UINT8*> cachedEntries;
+	for(UINT i=0; i < header.glyphMapCount; ++i) {
+		GlyphCacheGlyphMap cachedGlyphMap;
+		const UINT8 *pGlyphMap = readCacheData(&pPosition, pEnd, sizeof(cachedGlyphMap));
+		if(pGlyphMap == NULL)
+			return E_FAIL;
+		memcpy(&cachedGlyphMap, pGlyphMap, sizeof(cachedGlyphMap));
+		
+		if(cachedGlyphMap.fontIndex >= fonts.size() || !(cachedGlyphMap.fontSize > 0.0f))
+			return E_FAIL;
+		if(cachedGlyphMap.glyphCount > 0x10000 || cachedGlyphMap.entryCount > cachedGlyphMap.glyphCount)
+			return E_FAIL;
+		if(cachedGlyphMap.sourceGlyphMap != 0xffffffff && cachedGlyphMap.sourceGlyphMap >= header.glyphMapCount)
+			return E_FAIL;
+		const UINT8 *pEntries = readCacheData(&pPosition, pEnd, cachedGlyphMap.entryCount * sizeof(GlyphCacheEntry));
+		if(pEntries == NULL)
+			return E_FAIL;
+		
+		cachedGlyphMaps.push_back(cachedGlyphMap);
+		cachedEntries.push_back(pEntries);
+	}
+	
+	EnterCriticalSection(&m_insertGlyphCriticalSection);
+	EnterCriticalSection(&m_glyphMapsCriticalSection);
+	
+	hResult = E_FAIL;
+	if(m_fontMap.empty()) {
+		// Add the sheets, atlas IDs of their glyphs are remapped to the new sheet indices
+		std::vector<UINT> sheetRemap(sheets.size(), 0xffffffff);
+		std::vector<FW1_GLYPHCOORDS> glyphCoords;
+		for(size_t i=0; i < sheets.size(); ++i) {
+			const GlyphCacheSheet &sheet = sheets[i];
+			if(sheet.glyphCount == 0)
+				continue;
+			
+			glyphCoords.resize(sheet.glyphCount);
+			memcpy(&glyphCoords[0], sheetGlyphCoords[i], sheet.glyphCount * sizeof(FW1_GLYPHCOORDS));
+			
+			sheetRemap[i] = m_pGlyphAtlas->InsertSheetContents(sheetPixels[i], sheet.rowCount, &glyphCoords[0], sheet.glyphCount);
+		}
+		
+		// Add the fonts without font-faces, or use a font added earlier under the same name if its files are unchanged
+		std::vector<UINT> fontRemap(fonts.size());
+		
+		EnterCriticalSection(&m_fontsCriticalSection);
+		
+		for(size_t i=0; i < fonts.size(); ++i) {
+			UINT fontIndex = 0xffffffff;
+			
+			for(size_t j=0; j < m_fonts.size(); ++j) {
+				const FontInfo &fontInfo = m_fonts[j];
+				
+				if(fontInfo.uniqueName == fonts[i].uniqueName) {
+					UINT64 fileHash = (fontInfo.pFontFace != NULL) ? getFontFileHash(fontInfo.pFontFace) : fontInfo.fileHash;
+					if(fileHash == fonts[i].fileHash)
+						fontIndex = static_cast<UINT>(j);
+					break;
+				}
+			}
+			
+			// Behind a font with the same name but other files the new font is never matched, and its glyphs go unused
+			if(fontIndex == 0xffffffff) {
+				fontIndex = static_cast<UINT>(m_fonts.size());
+				m_fonts.push_back(fonts[i]);
+			}
+			
+			fontRemap[i] = fontIndex;
+		}
+		
+		LeaveCriticalSection(&m_fontsCriticalSection);
+		
+		// Create the glyph-maps with the glyphs in the added sheets
+		std::vector<GlyphMap*> glyphMaps(cachedGlyphMaps.size());
+		for(size_t i=0; i < cachedGlyphMaps.size(); ++i) {
+			const GlyphCacheGlyphMap &cachedGlyphMap = cachedGlyphMaps[i];
+			
+			GlyphMap *glyphMap = new GlyphMap;
+			glyphMap->fontSize = cachedGlyphMap.fontSize;
+			glyphMap->fontFlags = cachedGlyphMap.fontFlags;
+			glyphMap->sourceGlyphMap = 0;
+			glyphMap->sourceScale = cachedGlyphMap.sourceScale;
+			glyphMap->glyphCount = cachedGlyphMap.glyphCount;
+			glyphMap->pageCount = (glyphMap->glyphCount + GlyphPageSize - 1) >> GlyphPageShift;
+			glyphMap->allocatedPageCount = 0;
+			glyphMap->pages = new GlyphPage * volatile[glyphMap->pageCount];
+			for(UINT j=0; j < glyphMap->pageCount; ++j)
+				glyphMap->pages[j] = 0;
+			
+			for(UINT j=0; j < cachedGlyphMap.entryCount; ++j) {
+				GlyphCacheEntry entry;
+				memcpy(&entry, cachedEntries[i] + j * sizeof(GlyphCacheEntry), sizeof(entry));
+				
+				UINT sheetIndex = entry.glyphAtlasId >> 16;
+				if(entry.glyphIndex >= glyphMap->glyphCount || sheetIndex >= sheets.size())
+					continue;
+				if(sheetRemap[sheetIndex] == 0xffffffff || (entry.glyphAtlasId & 0xffff) >= sheets[sheetIndex].glyphCount)
+					continue;
+				
+				UINT16 glyphIndex = static_cast<UINT16>(entry.glyphIndex);
+				GlyphPage *page = getGlyphPage(glyphMap, glyphIndex, true);
+				page->glyphs[glyphIndex & (GlyphPageSize - 1)] = (sheetRemap[sheetIndex] << 16) | (entry.glyphAtlasId & 0xffff);
+			}
+			
+			glyphMaps[i] = glyphMap;
+		}
+		
+		// Only glyph-maps drawn at their exact size can be a source
+		for(size_t i=0; i < cachedGlyphMaps.size(); ++i) {
+			UINT sourceGlyphMap = cachedGlyphMaps[i].sourceGlyphMap;
+			if(sourceGlyphMap != 0xffffffff && cachedGlyphMaps[sourceGlyphMap].sourceGlyphMap == 0xffffffff)
+				glyphMaps[i]->sourceGlyphMap = glyphMaps[sourceGlyphMap];
+		}
+		
+		// A glyph-map saved twice under one font id is dropped, and glyph-maps scaled from it use the one kept
+		for(size_t i=0; i < glyphMaps.size(); ++i) {
+			GlyphMap *glyphMap = glyphMaps[i];
+			FontId fontId = makeFontId(fontRemap[cachedGlyphMaps[i].fontIndex], glyphMap->fontFlags, glyphMap->fontSize);
+			
+			std::pair<FontMap::iterator, bool> inserted = m_fontMap.insert(std::make_pair(fontId, glyphMap));
+			if(!inserted.second) {
+				for(size_t j=0; j < glyphMaps.size(); ++j) {
+					if(glyphMaps[j]->sourceGlyphMap == glyphMap)
+						glyphMaps[j]->sourceGlyphMap = (*inserted.first).second;
+				}
+				
+				deleteGlyphMap(glyphMap);
+				glyphMaps[i] = (*inserted.first).second;
+			}
+		}
+		
+		hResult = S_OK;
+	}
+	
+	LeaveCriticalSection(&m_glyphMapsCriticalSection);
+	LeaveCriticalSection(&m_insertGlyphCriticalSection);
+	
+	return hResult;
+}
+
+
+// Append data to a glyph cache
+void CFW1GlyphProvider::writeCacheData(std::vector<UINT8> &cacheData, const void *pData, SIZE_T size) {
+	const UINT8 *bytes = static_cast<const UINT8*>(pData);
+	cacheData.insert(cacheData.end(), bytes, bytes + size);
+}
+
+
+// Get the next size bytes of glyph cache data and move past them, returns NULL if the data ends first
+const UINT8* CFW1GlyphProvider::readCacheData(const UINT8 **ppPosition, const UINT8 *pEnd, SIZE_T size) {
+	const UINT8 *pData = *ppPosition;
+	if(size > static_cast<SIZE_T>(pEnd - pData))
+		return NULL;
+	
+	*ppPosition = pData + size;
+	
+	return pData;
+}
+
+
+// Get the page holding a glyph, optionally allocating it, returns 0 if the page does not exist
+CFW1GlyphProvider::GlyphPage* CFW1GlyphProvider::getGlyphPage(GlyphMap *glyphMap, UINT16 glyphIndex, bool allocate) {
+	UINT pageIndex = glyphIndex >> GlyphPageShift;
+	if(pageIndex >= glyphMap->pageCount)
+		return 0;
+	
+	GlyphPage *page = glyphMap->pages[pageIndex];
+	if(page == 0 && allocate) {
+		EnterCriticalSection(&m_insertGlyphCriticalSection);
+		
+		page = glyphMap->pages[pageIndex];
+		if(page == 0) {
+			page = new GlyphPage;
+			for(UINT i=0; i < GlyphPageSize; ++i) {
+				page->glyphs[i] = 0xffffffff;
+				page->lastFrames[i] = 0;
+			}
+			
+			// Lookups read pages without locking, publish the page once it is filled in
+			MemoryBarrier();
+			glyphMap->pages[pageIndex] = page;
+			++glyphMap->allocatedPageCount;
+		}
+		
+		LeaveCriticalSection(&m_insertGlyphCriticalSection);
+	}
+	
+	return page;
+}
+
+
+// Get the atlas id stored for a glyph, 0xffffffff if there is none
+UINT CFW1GlyphProvider::getGlyphAtlasId(GlyphMap *glyphMap, UINT16 glyphIndex) {
+	GlyphPage *page = getGlyphPage(glyphMap, glyphIndex, false);
+	if(page == 0)
+		return 0xffffffff;
+	
+	return page->glyphs[glyphIndex & (GlyphPageSize - 1)];
+}
+
+
+// Free a glyph-map and its pages
+void CFW1GlyphProvider::deleteGlyphMap(GlyphMap *glyphMap) {
+	for(UINT i=0; i < glyphMap->pageCount; ++i)
+		delete glyphMap->pages[i];
+	
+	delete[] glyphMap->pages;
+	delete glyphMap;
+}
+
+
+// Look up a glyph-map in the cache without taking any locks, returns 0 if not cached
+CFW1GlyphProvider::GlyphMap* CFW1GlyphProvider::findCachedGlyphMap(
+	IDWriteFontFace *pFontFace,
+	FLOAT fontSize,
+	UINT relevantFlags
+) {
+	GlyphMapCache *cache = m_pGlyphMapCache;
+	if(cache == 0)
+		return 0;
+	
+	// The table is never more than half full, so the probe always reaches an empty entry
+	UINT mask = cache->capacity - 1;
+	for(UINT i = hashGlyphMapKey(pFontFace, fontSize, relevantFlags) & mask; ; i = (i + 1) & mask) {
+		const GlyphMapCacheEntry &entry = cache->entries[i];
+		
+		IDWriteFontFace *pEntryFontFace = entry.pFontFace;
+		if(pEntryFontFace == NULL)
+			return 0;
+		if(pEntryFontFace == pFontFace && entry.fontSize == fontSize && entry.fontFlags == relevantFlags)
+			return entry.glyphMap;
+	}
+}
+
+
+// Add a glyph-map to the lock-free cache
+void CFW1GlyphProvider::cacheGlyphMap(
+	IDWriteFontFace *pFontFace,
+	UINT fontIndex,
+	FLOAT fontSize,
+	UINT relevantFlags,
+	GlyphMap *glyphMap
+) {
+	if(fontSize != fontSize)
+		return;
+	
+	EnterCriticalSection(&m_fontsCriticalSection);
+	
+	// Only font-faces referenced by the font list are cached, so their address is not reused while in the table
+	if(fontIndex < m_fonts.size() && m_fonts[fontIndex].pFontFace == pFontFace) {
+		GlyphMapCache *cache = m_pGlyphMapCache;
+		
+		// Publish a larger copy when the table fills up, readers still probing the old copy are unaffected
+		if(cache == 0 || (cache->count + 1) * 2 > cache->capacity) {
+			GlyphMapCache *newCache = new GlyphMapCache;
+			newCache->capacity = (cache != 0) ? cache->capacity * 2 : 64;
+			newCache->count = 0;
+			newCache->entries = new GlyphMapCacheEntry[newCache->capacity];
+			ZeroMemory(newCache->entries, newCache->capacity * sizeof(GlyphMapCacheEntry));
+			
+			if(cache != 0) {
+				for(UINT i=0; i < cache->capacity; ++i) {
+					const GlyphMapCacheEntry &entry = cache->entries[i];
+					if(entry.pFontFace != NULL && entry.glyphMap != 0)
+						insertCacheEntry(newCache, entry.pFontFace, entry.fontSize, entry.fontFlags, entry.glyphMap);
+				}
+				
+				m_retiredGlyphMapCaches.push_back(cache);
+			}
+			
+			MemoryBarrier();
+			m_pGlyphMapCache = newCache;
+			cache = newCache;
+		}
+		
+		insertCacheEntry(cache, pFontFace, fontSize, relevantFlags, glyphMap);
+	}
+	
+	LeaveCriticalSection(&m_fontsCriticalSection);
+}
+
+
+// Clear cached glyph-maps for a font-face about to be released, as a new font-face may get the same address
+// Must be called with the fonts critical section held
+void CFW1GlyphProvider::uncacheFontFace(IDWriteFontFace *pFontFace) {
+	GlyphMapCache *currentCache = m_pGlyphMapCache;
+	if(currentCache == 0)
+		return;
+	
+	// Retired tables too, a slow reader may still be probing one
+	std::vector<GlyphMapCache*> caches(m_retiredGlyphMapCaches);
+	caches.push_back(currentCache);
+	
+	for(size_t i=0; i < caches.size(); ++i) {
+		GlyphMapCache *cache = caches[i];
+		
+		for(UINT j=0; j < cache->capacity; ++j) {
+			GlyphMapCacheEntry &entry = cache->entries[j];
+			if(entry.pFontFace == pFontFace)
+				entry.glyphMap = 0;
+		}
+	}
+}
+
+
+// Hash a glyph-map cache key
+UINT CFW1GlyphProvider::hashGlyphMapKey(IDWriteFontFace *pFontFace, FLOAT fontSize, UINT relevantFlags) {
+	UINT64 pointerBits = static_cast<UINT64>(reinterpret_cast<UINT_PTR>(pFontFace));
+	UINT sizeBits;
+	memcpy(&sizeBits, &fontSize, sizeof(sizeBits));
+	
+	UINT hash = static_cast<UINT>(pointerBits >> 4) ^ static_cast<UINT>(pointerBits >> 32);
+	hash ^= sizeBits * 0x9e3779b1 ^ relevantFlags;
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6b;
+	hash ^= hash >> 13;
+	
+	return hash;
+}
+
+
+// Insert or update an entry in a cache table, making it visible to readers last
+void CFW1GlyphProvider::insertCacheEntry(
+	GlyphMapCache *cache,
+	IDWriteFontFace *pFontFace,
+	FLOAT fontSize,
+	UINT relevantFlags,
+	GlyphMap *glyphMap
+) {
+	UINT mask = cache->capacity - 1;
+	for(UINT i = hashGlyphMapKey(pFontFace, fontSize, relevantFlags) & mask; ; i = (i + 1) & mask) {
+		GlyphMapCacheEntry &entry = cache->entries[i];
+		
+		if(entry.pFontFace == NULL) {
+			entry.fontSize = fontSize;
+			entry.fontFlags = relevantFlags;
+			entry.glyphMap = glyphMap;
+			
+			MemoryBarrier();
+			entry.pFontFace = pFontFace;
+			++cache->count;
+			return;
+		}
+		if(entry.pFontFace == pFontFace && entry.fontSize == fontSize && entry.fontFlags == relevantFlags) {
+			entry.glyphMap = glyphMap;
+			return;
+		}
+	}
+}
+
+
 }// namespace FW1FontWrapper
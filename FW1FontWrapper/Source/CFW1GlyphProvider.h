@@ -31,6 +31,34 @@ class CFW1GlyphProvider : public CFW1Object<IFW1GlyphProvider> {
 			IDWriteFontFace *pFontFace,
 			UINT FontFlags
 		);
+		
+		virtual UINT STDMETHODCALLTYPE NewFrame();
+		virtual UINT STDMETHODCALLTYPE TrimGlyphAtlas(UINT64 MemoryBudget, UINT MinFrameAge);
+		virtual UINT64 STDMETHODCALLTYPE GetGlyphMapMemoryUsage(const void *pGlyphMap);
+		virtual void STDMETHODCALLTYPE SetFontSizeStep(FLOAT FontSizeStep);
+		virtual void STDMETHODCALLTYPE GetStatistics(FW1_GLYPHPROVIDERSTATS *pStats);
+		virtual HRESULT STDMETHODCALLTYPE SetDistanceFieldSize(FLOAT FontSize);
+		virtual FLOAT STDMETHODCALLTYPE GetDistanceFieldSize();
+		virtual HRESULT STDMETHODCALLTYPE PrewarmGlyphs(
+			IDWriteFontFace *pFontFace,
+			FLOAT FontSize,
+			UINT FontFlags,
+			const WCHAR *pszCharacters,
+			UINT32 CharacterCount
+		);
+		virtual UINT STDMETHODCALLTYPE GetPendingPrewarmCount();
+		virtual void STDMETHODCALLTYPE SetGlyphBudget(UINT MaxGlyphsPerFrame, UINT MaxMicrosecondsPerFrame);
+		virtual UINT STDMETHODCALLTYPE GetAtlasIdOrPlaceholder(
+			const void *pGlyphMap,
+			UINT16 GlyphIndex,
+			IDWriteFontFace *pFontFace,
+			UINT FontFlags,
+			BOOL *pIsPlaceholder
+		);
+		virtual HRESULT STDMETHODCALLTYPE SaveGlyphCache(ID3D11DeviceContext *pContext, const WCHAR *pszFileName);
+		virtual HRESULT STDMETHODCALLTYPE LoadGlyphCache(const WCHAR *pszFileName);
+		virtual void STDMETHODCALLTYPE SetStaticGlyphAtlas(BOOL StaticAtlas);
+		virtual HRESULT STDMETHODCALLTYPE SetOutlineRasterizer(BOOL UseOutlines);
 	
 	// Public functions
 	public:
@@ -45,28 +73,132 @@ class CFW1GlyphProvider : public CFW1Object<IFW1GlyphProvider> {
 			UINT maxGlyphHeight
 		);
 	
+	// Headless tests and benchmarks, see FW1Tests
+	private:
+		friend class CFW1GlyphProviderTest;
+	
 	// Internal types
 	private:
+		static const UINT GlyphPageShift = 8;
+		static const UINT GlyphPageSize = 1 << GlyphPageShift;
+		
+		struct GlyphPage {
+			UINT							glyphs[GlyphPageSize];
+			UINT							lastFrames[GlyphPageSize];// Frame each glyph was last queried in
+		};
+		
+		// Pages are allocated when a glyph in them is first used, a missing page means no glyph in it is mapped
+		// A glyph-map with a source glyph-map scales the source glyph images instead of drawing its own
 		struct GlyphMap {
 			FLOAT							fontSize;
 			UINT							fontFlags;
 			
-			UINT							*glyphs;
+			GlyphMap						*sourceGlyphMap;
+			FLOAT							sourceScale;
+			
+			GlyphPage * volatile			*pages;
+			UINT							pageCount;
+			UINT							allocatedPageCount;
 			UINT							glyphCount;
 		};
 		
+		// A font loaded from a glyph cache has no font-face until one with the same name and file hash is used
 		struct FontInfo {
 			IDWriteFontFace					*pFontFace;
 			std::wstring					uniqueName;
+			UINT64							fileHash;
 		};
 		
 		typedef std::pair<UINT, std::pair<UINT, FLOAT> > FontId;
 		typedef std::map<FontId, GlyphMap*> FontMap;
 		
+		// Set on glyph-maps scaled from a snapped font size, so they are kept apart from exact-size glyph-maps
+		static const UINT ScaledGlyphMapFlag = 0x80000000;
+		
+		UINT getRelevantFontFlags(UINT fontFlags) {
+			return (fontFlags & (FW1_ALIASED | ScaledGlyphMapFlag));
+		}
+		
 		FontId makeFontId(UINT fontIndex, UINT fontFlags, FLOAT fontSize) {
-			UINT relevantFlags = (fontFlags & (FW1_ALIASED));
-			return std::make_pair(fontIndex, std::make_pair(relevantFlags, fontSize));
+			return std::make_pair(fontIndex, std::make_pair(getRelevantFontFlags(fontFlags), fontSize));
 		}
+		
+		// Open-addressing table from font-face pointer and size to glyph-map, read without locks
+		// An entry is visible once pFontFace is set, and a NULL glyphMap marks an entry for a released font-face
+		struct GlyphMapCacheEntry {
+			IDWriteFontFace * volatile		pFontFace;
+			FLOAT							fontSize;
+			UINT							fontFlags;
+			GlyphMap * volatile				glyphMap;
+		};
+		
+		struct GlyphMapCache {
+			GlyphMapCacheEntry				*entries;
+			UINT							capacity;
+			UINT							count;
+		};
+		
+		// Glyphs queued for drawing on a worker thread, holding references to the provider and font-face
+		struct PrewarmTask {
+			CFW1GlyphProvider				*pGlyphProvider;
+			IDWriteFontFace					*pFontFace;
+			FLOAT							fontSize;
+			UINT							fontFlags;
+			std::vector<UINT32>				codePoints;
+		};
+		
+		// Glyph left for a later frame when the glyph budget is used up, holding a reference to its font-face
+		struct DeferredGlyph {
+			GlyphMap						*glyphMap;
+			UINT16							glyphIndex;
+			IDWriteFontFace					*pFontFace;
+		};
+		
+		typedef std::pair<GlyphMap*, UINT16> DeferredGlyphKey;
+		
+		// Glyph cache file, the header is followed by the fonts, the sheets and the glyph-maps
+		// Each font is followed by its name, each sheet by its glyph coords and the pixels of its rows, each glyph-map by its entries
+		static const UINT GlyphCacheMagic = 0x43315746;// "FW1C"
+		static const UINT GlyphCacheVersion = 1;
+		
+		struct GlyphCacheHeader {
+			UINT							magic;
+			UINT							version;
+			UINT							sheetWidth;
+			UINT							sheetHeight;
+			UINT							mipLevelCount;
+			FLOAT							distanceFieldSize;
+			UINT							fontCount;
+			UINT							sheetCount;
+			UINT							glyphMapCount;
+		};
+		
+		struct GlyphCacheFont {
+			UINT64							fileHash;
+			UINT							nameLength;
+			UINT							reserved;
+		};
+		
+		struct GlyphCacheSheet {
+			UINT							glyphCount;
+			UINT							rowCount;
+		};
+		
+		// Glyph-maps are numbered in the order they are stored, 0xffffffff as source means none
+		struct GlyphCacheGlyphMap {
+			UINT							fontIndex;
+			FLOAT							fontSize;
+			UINT							fontFlags;
+			UINT							sourceGlyphMap;
+			FLOAT							sourceScale;
+			UINT							glyphCount;
+			UINT							entryCount;
+		};
+		
+		struct GlyphCacheEntry {
+			UINT							glyphIndex;
+			UINT							glyphAtlasId;
+		};
 	
 	// Internal functions
 	private:
@@ -74,8 +206,56 @@ class CFW1GlyphProvider : public CFW1Object<IFW1GlyphProvider> {
 		
 		UINT getFontIndexFromFontFace(IDWriteFontFace *pFontFace);
 		std::wstring getUniqueNameFromFontFace(IDWriteFontFace *pFontFace);
+		static UINT64 getFontFileHash(IDWriteFontFace *pFontFace);
+		static UINT64 hashBytes(UINT64 hash, const void *pData, SIZE_T size);
 		
 		UINT insertNewGlyph(GlyphMap *glyphMap, UINT16 glyphIndex, IDWriteFontFace *pFontFace);
+		UINT insertScaledGlyph(GlyphMap *glyphMap, UINT16 glyphIndex, IDWriteFontFace *pFontFace);
+		FLOAT snapFontSize(FLOAT fontSize);
+		void createDistanceField(
+			const FW1_GLYPHIMAGEDATA &glyphData,
+			std::vector<UINT8> &fieldPixels,
+			FW1_GLYPHMETRICS &fieldMetrics
+		);
+		
+		static void distanceTransform(FLOAT *grid, UINT width, UINT height);
+		static void distanceTransformLine(FLOAT *line, UINT count, UINT stride, FLOAT *f, FLOAT *z, UINT *v);
+		
+		void prewarmGlyphs(const PrewarmTask *task);
+		
+		bool isGlyphBudgetUsedUp();
+		UINT insertBudgetedGlyph(GlyphMap *glyphMap, UINT16 glyphIndex, IDWriteFontFace *pFontFace);
+		void deferGlyph(GlyphMap *glyphMap, UINT16 glyphIndex, IDWriteFontFace *pFontFace);
+		void drawDeferredGlyphs();
+		static DWORD WINAPI prewarmThreadProc(LPVOID pParam);
+		
+		void writeGlyphCache(ID3D11DeviceContext *pContext, std::vector<UINT8> &cacheData);
+		HRESULT readGlyphCache(const UINT8 *pCacheData, UINT64 cacheSize);
+		static void writeCacheData(std::vector<UINT8> &cacheData, const void *pData, SIZE_T size);
+		static const UINT8* readCacheData(const UINT8 **ppPosition, const UINT8 *pEnd, SIZE_T size);
+		
+		GlyphPage* getGlyphPage(GlyphMap *glyphMap, UINT16 glyphIndex, bool allocate);
+		UINT getGlyphAtlasId(GlyphMap *glyphMap, UINT16 glyphIndex);
+		static void deleteGlyphMap(GlyphMap *glyphMap);
+		
+		GlyphMap* findCachedGlyphMap(IDWriteFontFace *pFontFace, FLOAT fontSize, UINT relevantFlags);
+		void cacheGlyphMap(
+			IDWriteFontFace *pFontFace,
+			UINT fontIndex,
+			FLOAT fontSize,
+			UINT relevantFlags,
+			GlyphMap *glyphMap
+		);
+		void uncacheFontFace(IDWriteFontFace *pFontFace);
+		
+		static UINT hashGlyphMapKey(IDWriteFontFace *pFontFace, FLOAT fontSize, UINT relevantFlags);
+		static void insertCacheEntry(
+			GlyphMapCache *cache,
+			IDWriteFontFace *pFontFace,
+			FLOAT fontSize,
+			UINT relevantFlags,
+			GlyphMap *glyphMap
+		);
 	
 	// Internal data
 	private:
@@ -90,11 +270,38 @@ class CFW1GlyphProvider : public CFW1Object<IFW1GlyphProvider> {
 		std::vector<FontInfo>				m_fonts;
 		
 		FontMap								m_fontMap;
+		volatile LONG						m_currentFrame;
+		
+		GlyphMapCache * volatile			m_pGlyphMapCache;
+		std::vector<GlyphMapCache*>			m_retiredGlyphMapCaches;// Replaced tables, readers may still be using them
+		
+		FLOAT								m_fontSizeStep;
+		UINT								m_rasterizedGlyphCount;
+		UINT								m_scaledGlyphCount;
+		UINT64								m_scaledGlyphArea;
+		
+		FLOAT								m_distanceFieldSize;
+		UINT								m_distanceFieldSpread;// Distance in pixels mapped to the full value range
+		
+		volatile LONG						m_pendingPrewarmCount;
+		
+		UINT								m_maxGlyphsPerFrame;
+		UINT								m_maxMicrosecondsPerFrame;
+		volatile LONG						m_frameGlyphCount;
+		volatile LONGLONG					m_frameGlyphTicks;
+		LONGLONG							m_tickFrequency;
+		std::deque<DeferredGlyph>			m_deferredGlyphs;
+		std::set<DeferredGlyphKey>			m_deferredGlyphKeys;
+		volatile LONG						m_deferredDrawnCount;
+		
+		bool								m_staticGlyphAtlas;
+		bool								m_outlineRasterizer;
 		
 		CRITICAL_SECTION					m_renderTargetsCriticalSection;
 		CRITICAL_SECTION					m_glyphMapsCriticalSection;
 		CRITICAL_SECTION					m_fontsCriticalSection;
 		CRITICAL_SECTION					m_insertGlyphCriticalSection;
+		CRITICAL_SECTION					m_deferredGlyphsCriticalSection;
 };
 
 
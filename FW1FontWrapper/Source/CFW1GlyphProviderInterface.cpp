@@ -65,6 +65,23 @@ const void* STDMETHODCALLTYPE CFW1GlyphProvider::GetGlyphMapFromFont(
 	FLOAT FontSize,
 	UINT FontFlags
 ) {
+	// Glyphs of a snapped size are drawn once and scaled to every size that snaps to it
+	// Distance fields are drawn at a single size for all sizes
+	FontFlags &= ~ScaledGlyphMapFlag;
+	FLOAT snappedSize = FontSize;
+	if(m_distanceFieldSize > 0.0f)
+		snappedSize = m_distanceFieldSize;
+	else if((FontFlags & FW1_EXACTFONTSIZE) == 0)
+		snappedSize = snapFontSize(FontSize);
+	if(snappedSize != FontSize)
+		FontFlags |= ScaledGlyphMapFlag;
+	
+	// Glyph-maps already used with this font-face are found without locking
+	UINT relevantFlags = getRelevantFontFlags(FontFlags);
+	GlyphMap *cachedGlyphMap = findCachedGlyphMap(pFontFace, FontSize, relevantFlags);
+	if(cachedGlyphMap != 0)
+		return cachedGlyphMap;
+	
 	// Get font id
 	UINT fontIndex = getFontIndexFromFontFace(pFontFace);
 	FontId fontId = makeFontId(fontIndex, FontFlags, FontSize);
@@ -83,10 +100,23 @@ const void* STDMETHODCALLTYPE CFW1GlyphProvider::GetGlyphMapFromFont(
 		GlyphMap *newGlyphMap = new GlyphMap;
 		newGlyphMap->fontSize = FontSize;
 		newGlyphMap->fontFlags = FontFlags;
+		newGlyphMap->sourceGlyphMap = 0;
+		newGlyphMap->sourceScale = 1.0f;
+		if((FontFlags & ScaledGlyphMapFlag) != 0) {
+			const void *sourceGlyphMap = GetGlyphMapFromFont(
+				pFontFace,
+				snappedSize,
+				(FontFlags & ~ScaledGlyphMapFlag) | FW1_EXACTFONTSIZE
+			);
+			newGlyphMap->sourceGlyphMap = static_cast<GlyphMap*>(const_cast<void*>(sourceGlyphMap));
+			newGlyphMap->sourceScale = FontSize / snappedSize;
+		}
 		newGlyphMap->glyphCount = pFontFace->GetGlyphCount();
-		newGlyphMap->glyphs = new UINT[newGlyphMap->glyphCount];
-		for(UINT i=0; i < newGlyphMap->glyphCount; ++i)
-			newGlyphMap->glyphs[i] = 0xffffffff;
+		newGlyphMap->pageCount = (newGlyphMap->glyphCount + GlyphPageSize - 1) >> GlyphPageShift;
+		newGlyphMap->allocatedPageCount = 0;
+		newGlyphMap->pages = new GlyphPage * volatile[newGlyphMap->pageCount];
+		for(UINT i=0; i < newGlyphMap->pageCount; ++i)
+			newGlyphMap->pages[i] = 0;
 		
 		bool needless = false;
 		
@@ -106,8 +136,7 @@ const void* STDMETHODCALLTYPE CFW1GlyphProvider::GetGlyphMapFromFont(
 		LeaveCriticalSection(&m_glyphMapsCriticalSection);
 		
 		if(needless) {// Simultaneous creation on two threads
-			delete[] newGlyphMap->glyphs;
-			delete newGlyphMap;
+			deleteGlyphMap(newGlyphMap);
 		}
 		else {
 			UINT glyphAtlasId = insertNewGlyph(newGlyphMap, 0, pFontFace);
@@ -115,6 +144,9 @@ const void* STDMETHODCALLTYPE CFW1GlyphProvider::GetGlyphMapFromFont(
 		}
 	}
 	
+	if(glyphMap != 0)
+		cacheGlyphMap(pFontFace, fontIndex, FontSize, relevantFlags, static_cast<GlyphMap*>(const_cast<void*>(glyphMap)));
+	
 	return glyphMap;
 }
 
@@ -125,9 +157,24 @@ UINT STDMETHODCALLTYPE CFW1GlyphProvider::GetAtlasIdFromGlyphIndex(
 	UINT16 GlyphIndex,
 	IDWriteFontFace *pFontFace,
 	UINT FontFlags
+) {
+	return GetAtlasIdOrPlaceholder(pGlyphMap, GlyphIndex, pFontFace, FontFlags, NULL);
+}
+
+
+// Get atlas id of a glyph, or of a placeholder if the glyph budget is used up
+UINT STDMETHODCALLTYPE CFW1GlyphProvider::GetAtlasIdOrPlaceholder(
+	const void *pGlyphMap,
+	UINT16 GlyphIndex,
+	IDWriteFontFace *pFontFace,
+	UINT FontFlags,
+	BOOL *pIsPlaceholder
 ) {
 	GlyphMap *glyphMap = static_cast<GlyphMap*>(const_cast<void*>(pGlyphMap));
 	
+	if(pIsPlaceholder != NULL)
+		*pIsPlaceholder = FALSE;
+	
 	if(glyphMap == 0)
 		return 0;
 	
@@ -135,13 +182,41 @@ UINT STDMETHODCALLTYPE CFW1GlyphProvider::GetAtlasIdFromGlyphIndex(
 		return 0;
 	
 	// Get the atlas id for this glyph
-	UINT glyphAtlasId = glyphMap->glyphs[GlyphIndex];
-	if(glyphAtlasId == 0xffffffff && (FontFlags & FW1_NONEWGLYPHS) == 0)
-		glyphAtlasId = insertNewGlyph(glyphMap, GlyphIndex, pFontFace);
+	bool newGlyphs = ((FontFlags & FW1_NONEWGLYPHS) == 0);
+	GlyphPage *page = getGlyphPage(glyphMap, GlyphIndex, newGlyphs);
+	
+	UINT glyphAtlasId = 0xffffffff;
+	if(page != 0) {
+		page->lastFrames[GlyphIndex & (GlyphPageSize - 1)] = static_cast<UINT>(m_currentFrame);
+		glyphAtlasId = page->glyphs[GlyphIndex & (GlyphPageSize - 1)];
+	}
+	bool deferred = false;
+	if(glyphAtlasId == 0xffffffff && newGlyphs) {
+		// Only glyphs that have to be drawn count against the budget, not those scaled from an existing image
+		bool budgeted = ((FontFlags & FW1_NOGLYPHBUDGET) == 0);
+		if(budgeted && glyphMap->sourceGlyphMap != 0)
+			budgeted = (getGlyphAtlasId(glyphMap->sourceGlyphMap, GlyphIndex) == 0xffffffff);
+		if(budgeted && m_maxGlyphsPerFrame == 0 && m_maxMicrosecondsPerFrame == 0)
+			budgeted = false;
+		if(m_staticGlyphAtlas)
+			budgeted = false;
+		
+		if(!budgeted)
+			glyphAtlasId = insertNewGlyph(glyphMap, GlyphIndex, pFontFace);
+		else if(!isGlyphBudgetUsedUp())
+			glyphAtlasId = insertBudgetedGlyph(glyphMap, GlyphIndex, pFontFace);
+		else {
+			deferGlyph(glyphMap, GlyphIndex, pFontFace);
+			deferred = true;
+			
+			if(pIsPlaceholder != NULL)
+				*pIsPlaceholder = TRUE;
+		}
+	}
 	
-	// Fall back to the font default-glyph or the atlas default-glyph on failure
+	// Fall back to the font default-glyph or the atlas default-glyph on failure, or as a placeholder for a deferred glyph
 	if(glyphAtlasId == 0xffffffff) {
-		glyphAtlasId = glyphMap->glyphs[0];
+		glyphAtlasId = getGlyphAtlasId(glyphMap, 0);
 		
 		if((FontFlags & FW1_NONEWGLYPHS) == 0) {
 			if(glyphAtlasId == 0xffffffff) {
@@ -151,10 +226,13 @@ UINT STDMETHODCALLTYPE CFW1GlyphProvider::GetAtlasIdFromGlyphIndex(
 					glyphAtlasId = GetAtlasIdFromGlyphIndex(pGlyphMap, 0, pFontFace, FontFlags);
 			}
 			
-			EnterCriticalSection(&m_insertGlyphCriticalSection);
-			if(glyphMap->glyphs[GlyphIndex] == 0xffffffff)
-				glyphMap->glyphs[GlyphIndex] = glyphAtlasId;
-			LeaveCriticalSection(&m_insertGlyphCriticalSection);
+			// A deferred glyph keeps its empty entry so it is drawn when its turn comes
+			if(!deferred) {
+				EnterCriticalSection(&m_insertGlyphCriticalSection);
+				if(page->glyphs[GlyphIndex & (GlyphPageSize - 1)] == 0xffffffff)
+					page->glyphs[GlyphIndex & (GlyphPageSize - 1)] = glyphAtlasId;
+				LeaveCriticalSection(&m_insertGlyphCriticalSection);
+			}
 		}
 		
 		if(glyphAtlasId == 0xffffffff)
@@ -165,4 +243,361 @@ UINT STDMETHODCALLTYPE CFW1GlyphProvider::GetAtlasIdFromGlyphIndex(
 }
 
 
+// Start a new frame for glyph usage tracking, and draw glyphs deferred from earlier frames
+UINT STDMETHODCALLTYPE CFW1GlyphProvider::NewFrame() {
+	UINT currentFrame = static_cast<UINT>(InterlockedIncrement(&m_currentFrame));
+	
+	InterlockedExchange(&m_frameGlyphCount, 0);
+	InterlockedExchange64(&m_frameGlyphTicks, 0);
+	
+	drawDeferredGlyphs();
+	
+	return currentFrame;
+}
+
+
+// Evict least recently used sheets until the atlas fits in the budget
+UINT STDMETHODCALLTYPE CFW1GlyphProvider::TrimGlyphAtlas(UINT64 MemoryBudget, UINT MinFrameAge) {
+	// Texture-array atlases report the whole array as used and never remove sheets, so there is nothing to trim
+	if(m_pGlyphAtlas->GetTextureArraySize() > 0)
+		return 0;
+	
+	UINT64 memoryUsage = m_pGlyphAtlas->GetMemoryUsage();
+	if(memoryUsage <= MemoryBudget)
+		return 0;
+	
+	UINT currentFrame = static_cast<UINT>(m_currentFrame);
+	UINT removedCount = 0;
+	
+	EnterCriticalSection(&m_insertGlyphCriticalSection);
+	EnterCriticalSection(&m_glyphMapsCriticalSection);
+	
+	// A sheet was last used when its most recently used glyph was
+	UINT sheetCount = m_pGlyphAtlas->GetSheetCount();
+	std::vector<UINT> sheetLastFrames(sheetCount, 0);
+	std::vector<bool> sheetReferenced(sheetCount, false);
+	
+	for(FontMap::iterator it = m_fontMap.begin(); it != m_fontMap.end(); ++it) {
+		const GlyphMap *glyphMap = (*it).second;
+		
+		for(UINT i=0; i < glyphMap->pageCount; ++i) {
+			const GlyphPage *page = glyphMap->pages[i];
+			if(page == 0)
+				continue;
+			
+			for(UINT j=0; j < GlyphPageSize; ++j) {
+				UINT glyphAtlasId = page->glyphs[j];
+				if(glyphAtlasId == 0xffffffff)
+					continue;
+				
+				UINT sheetIndex = glyphAtlasId >> 16;
+				if(sheetIndex < sheetCount) {
+					sheetLastFrames[sheetIndex] = std::max(sheetLastFrames[sheetIndex], page->lastFrames[j]);
+					sheetReferenced[sheetIndex] = true;
+				}
+			}
+		}
+	}
+	
+	// Coldest sheets first, sheets with no glyph-map entries at all before any others
+	std::vector<UINT> candidates;
+	for(UINT i=0; i < sheetCount; ++i) {
+		if(currentFrame - sheetLastFrames[i] >= MinFrameAge)
+			candidates.push_back(i);
+	}
+	
+	struct ColderSheet {
+		const std::vector<UINT> &lastFrames;
+		const std::vector<bool> &referenced;
+		
+		bool operator()(UINT a, UINT b) const {
+			if(referenced[a] != referenced[b])
+				return !referenced[a];
+			return lastFrames[a] < lastFrames[b];
+		}
+	};
+	ColderSheet colderSheet = {sheetLastFrames, sheetReferenced};
+	std::stable_sort(candidates.begin(), candidates.end(), colderSheet);
+	
+	if(!candidates.empty()) {
+		std::vector<UINT> sheetRemap(sheetCount);
+		
+		removedCount = m_pGlyphAtlas->RemoveSheets(
+			&candidates[0],
+			static_cast<UINT>(candidates.size()),
+			memoryUsage - MemoryBudget,
+			&sheetRemap[0]
+		);
+		
+		// Point the glyph-maps at the new sheet indices, glyphs in evicted sheets are drawn again when next used
+		if(removedCount > 0) {
+			for(FontMap::iterator it = m_fontMap.begin(); it != m_fontMap.end(); ++it) {
+				GlyphMap *glyphMap = (*it).second;
+				
+				for(UINT i=0; i < glyphMap->pageCount; ++i) {
+					GlyphPage *page = glyphMap->pages[i];
+					if(page == 0)
+						continue;
+					
+					for(UINT j=0; j < GlyphPageSize; ++j) {
+						UINT glyphAtlasId = page->glyphs[j];
+						if(glyphAtlasId == 0xffffffff)
+							continue;
+						
+						UINT sheetIndex = glyphAtlasId >> 16;
+						if(sheetIndex >= sheetCount || sheetRemap[sheetIndex] == 0xffffffff)
+							page->glyphs[j] = 0xffffffff;
+						else
+							page->glyphs[j] = (sheetRemap[sheetIndex] << 16) | (glyphAtlasId & 0xffff);
+					}
+				}
+			}
+		}
+	}
+	
+	LeaveCriticalSection(&m_glyphMapsCriticalSection);
+	LeaveCriticalSection(&m_insertGlyphCriticalSection);
+	
+	return removedCount;
+}
+
+
+// Set the font size step
+void STDMETHODCALLTYPE CFW1GlyphProvider::SetFontSizeStep(FLOAT FontSizeStep) {
+	m_fontSizeStep = (FontSizeStep > 0.0f) ? FontSizeStep : 0.0f;
+}
+
+
+// Get glyph counts
+void STDMETHODCALLTYPE CFW1GlyphProvider::GetStatistics(FW1_GLYPHPROVIDERSTATS *pStats) {
+	EnterCriticalSection(&m_insertGlyphCriticalSection);
+	pStats->RasterizedGlyphCount = m_rasterizedGlyphCount;
+	pStats->ScaledGlyphCount = m_scaledGlyphCount;
+	pStats->ScaledGlyphArea = m_scaledGlyphArea;
+	LeaveCriticalSection(&m_insertGlyphCriticalSection);
+	
+	EnterCriticalSection(&m_deferredGlyphsCriticalSection);
+	pStats->DeferredGlyphCount = static_cast<UINT>(m_deferredGlyphs.size());
+	pStats->DeferredDrawnCount = static_cast<UINT>(m_deferredDrawnCount);
+	LeaveCriticalSection(&m_deferredGlyphsCriticalSection);
+}
+
+
+// Set the distance-field font size, only before any glyph-maps exist
+HRESULT STDMETHODCALLTYPE CFW1GlyphProvider::SetDistanceFieldSize(FLOAT FontSize) {
+	HRESULT hResult = E_FAIL;
+	
+	EnterCriticalSection(&m_glyphMapsCriticalSection);
+	
+	if(m_fontMap.empty()) {
+		if(FontSize > 0.0f) {
+			m_distanceFieldSize = FontSize;
+			m_distanceFieldSpread = std::max(static_cast<UINT>(ceil(FontSize / 8.0f)), 2U);
+		}
+		else {
+			m_distanceFieldSize = 0.0f;
+			m_distanceFieldSpread = 0;
+		}
+		
+		hResult = S_OK;
+	}
+	
+	LeaveCriticalSection(&m_glyphMapsCriticalSection);
+	
+	return hResult;
+}
+
+
+// Get the distance-field font size
+FLOAT STDMETHODCALLTYPE CFW1GlyphProvider::GetDistanceFieldSize() {
+	return m_distanceFieldSize;
+}
+
+
+// Queue glyphs to be drawn into the atlas on a worker thread
+HRESULT STDMETHODCALLTYPE CFW1GlyphProvider::PrewarmGlyphs(
+	IDWriteFontFace *pFontFace,
+	FLOAT FontSize,
+	UINT FontFlags,
+	const WCHAR *pszCharacters,
+	UINT32 CharacterCount
+) {
+	if(pFontFace == NULL || (pszCharacters == NULL && CharacterCount > 0))
+		return E_INVALIDARG;
+	
+	PrewarmTask *task = new PrewarmTask;
+	task->pGlyphProvider = this;
+	task->pFontFace = pFontFace;
+	task->fontSize = FontSize;
+	task->fontFlags = FontFlags & (FW1_ALIASED | FW1_EXACTFONTSIZE);
+	
+	// Decode UTF-16, including surrogate pairs
+	task->codePoints.reserve(CharacterCount);
+	for(UINT32 i=0; i < CharacterCount; ++i) {
+		UINT32 codePoint = pszCharacters[i];
+		if(codePoint >= 0xd800 && codePoint < 0xdc00 && i + 1 < CharacterCount) {
+			UINT32 lowSurrogate = pszCharacters[i+1];
+			if(lowSurrogate >= 0xdc00 && lowSurrogate < 0xe000) {
+				codePoint = 0x10000 + ((codePoint - 0xd800) << 10) + (lowSurrogate - 0xdc00);
+				++i;
+			}
+		}
+		
+		task->codePoints.push_back(codePoint);
+	}
+	
+	// The task keeps the provider and font-face alive until it has run
+	AddRef();
+	pFontFace->AddRef();
+	InterlockedIncrement(&m_pendingPrewarmCount);
+	
+	HRESULT hResult = S_OK;
+	if(!QueueUserWorkItem(prewarmThreadProc, task, WT_EXECUTELONGFUNCTION)) {
+		hResult = HRESULT_FROM_WIN32(GetLastError());
+		
+		InterlockedDecrement(&m_pendingPrewarmCount);
+		pFontFace->Release();
+		delete task;
+		Release();
+	}
+	
+	return hResult;
+}
+
+
+// Get the number of prewarm tasks not yet finished
+UINT STDMETHODCALLTYPE CFW1GlyphProvider::GetPendingPrewarmCount() {
+	return static_cast<UINT>(m_pendingPrewarmCount);
+}
+
+
+// Set the per-frame glyph budget
+void STDMETHODCALLTYPE CFW1GlyphProvider::SetGlyphBudget(UINT MaxGlyphsPerFrame, UINT MaxMicrosecondsPerFrame) {
+	m_maxGlyphsPerFrame = MaxGlyphsPerFrame;
+	m_maxMicrosecondsPerFrame = MaxMicrosecondsPerFrame;
+}
+
+
+// Save the atlas and glyph-maps to a file
+HRESULT STDMETHODCALLTYPE CFW1GlyphProvider::SaveGlyphCache(ID3D11DeviceContext *pContext, const WCHAR *pszFileName) {
+	if(pContext == NULL || pszFileName == NULL)
+		return E_INVALIDARG;
+	
+	std::vector<UINT8> cacheData;
+	writeGlyphCache(pContext, cacheData);
+	
+	// Write a temporary file and replace the old file with it once complete
+	std::wstring tempFileName = pszFileName;
+	tempFileName += L".tmp";
+	
+	HANDLE hFile = CreateFileW(tempFileName.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if(hFile == INVALID_HANDLE_VALUE)
+		return HRESULT_FROM_WIN32(GetLastError());
+	
+	HRESULT hResult = S_OK;
+	
+	DWORD bytesWritten = 0;
+	if(!WriteFile(hFile, &cacheData[0], static_cast<DWORD>(cacheData.size()), &bytesWritten, NULL))
+		hResult = HRESULT_FROM_WIN32(GetLastError());
+	else if(bytesWritten != cacheData.size())
+		hResult = E_FAIL;
+	
+	CloseHandle(hFile);
+	
+	if(SUCCEEDED(hResult) && !MoveFileExW(tempFileName.c_str(), pszFileName, MOVEFILE_REPLACE_EXISTING))
+		hResult = HRESULT_FROM_WIN32(GetLastError());
+	if(FAILED(hResult))
+		DeleteFileW(tempFileName.c_str());
+	
+	return hResult;
+}
+
+
+// Load a saved atlas and glyph-maps from a memory-mapped file
+HRESULT STDMETHODCALLTYPE CFW1GlyphProvider::LoadGlyphCache(const WCHAR *pszFileName) {
+	if(pszFileName == NULL)
+		return E_INVALIDARG;
+	
+	HANDLE hFile = CreateFileW(pszFileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if(hFile == INVALID_HANDLE_VALUE)
+		return HRESULT_FROM_WIN32(GetLastError());
+	
+	HRESULT hResult = E_FAIL;
+	
+	// An empty file can't be mapped, and holds no glyph cache anyway
+	LARGE_INTEGER fileSize;
+	if(GetFileSizeEx(hFile, &fileSize) && fileSize.QuadPart > 0) {
+		HANDLE hFileMapping = CreateFileMappingW(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+		if(hFileMapping == NULL) {
+			hResult = HRESULT_FROM_WIN32(GetLastError());
+		}
+		else {
+			const void *pFileView = MapViewOfFile(hFileMapping, FILE_MAP_READ, 0, 0, 0);
+			if(pFileView == NULL) {
+				hResult = HRESULT_FROM_WIN32(GetLastError());
+			}
+			else {
+				hResult = readGlyphCache(static_cast<const UINT8*>(pFileView), static_cast<UINT64>(fileSize.QuadPart));
+				
+				UnmapViewOfFile(pFileView);
+			}
+			
+			CloseHandle(hFileMapping);
+		}
+	}
+	
+	CloseHandle(hFile);
+	
+	return hResult;
+}
+
+
+// Stop or resume drawing glyph images
+void STDMETHODCALLTYPE CFW1GlyphProvider::SetStaticGlyphAtlas(BOOL StaticAtlas) {
+	m_staticGlyphAtlas = (StaticAtlas != FALSE);
+}
+
+
+// Select the render target glyph images are drawn with
+HRESULT STDMETHODCALLTYPE CFW1GlyphProvider::SetOutlineRasterizer(BOOL UseOutlines) {
+	HRESULT hResult = E_FAIL;
+	
+	EnterCriticalSection(&m_glyphMapsCriticalSection);
+	
+	// Render targets are pooled, and all of them have to be of the same kind
+	if(m_fontMap.empty()) {
+		m_outlineRasterizer = (UseOutlines != FALSE);
+		hResult = S_OK;
+	}
+	
+	LeaveCriticalSection(&m_glyphMapsCriticalSection);
+	
+	return hResult;
+}
+
+
+// Get memory used by glyph-maps
+UINT64 STDMETHODCALLTYPE CFW1GlyphProvider::GetGlyphMapMemoryUsage(const void *pGlyphMap) {
+	UINT64 total = 0;
+	
+	EnterCriticalSection(&m_insertGlyphCriticalSection);
+	EnterCriticalSection(&m_glyphMapsCriticalSection);
+	
+	for(FontMap::iterator it = m_fontMap.begin(); it != m_fontMap.end(); ++it) {
+		const GlyphMap *glyphMap = (*it).second;
+		if(pGlyphMap != NULL && pGlyphMap != glyphMap)
+			continue;
+		
+		total += sizeof(GlyphMap);
+		total += static_cast<UINT64>(glyphMap->pageCount) * sizeof(GlyphPage*);
+		total += static_cast<UINT64>(glyphMap->allocatedPageCount) * sizeof(GlyphPage);
+	}
+	
+	LeaveCriticalSection(&m_glyphMapsCriticalSection);
+	LeaveCriticalSection(&m_insertGlyphCriticalSection);
+	
+	return total;
+}
+
+
 }// namespace FW1FontWrapper
@@ -4,31 +4,159 @@
 
 #include "CFW1GlyphRenderStates.h"
 
+#include "FW1ShaderBytecode.h"
+
 #define SAFE_RELEASE(pObject) { if(pObject) { (pObject)->Release(); (pObject) = NULL; } }
 
 
 namespace FW1FontWrapper {
 
 
+// Passes states to a context directly, or through a state tracker that skips states already bound
+class CFW1GlyphRenderStates::StateSetter {
+	public:
+		StateSetter(ID3D11DeviceContext *pContext, IFW1StateTracker *pStateTracker) :
+			m_pContext(pContext),
+			m_pStateTracker(pStateTracker)
+		{
+		}
+		
+		void setPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology) {
+			if(m_pStateTracker != NULL)
+				m_pStateTracker->SetPrimitiveTopology(topology);
+			else
+				m_pContext->IASetPrimitiveTopology(topology);
+		}
+		
+		void setInputLayout(ID3D11InputLayout *pInputLayout) {
+			if(m_pStateTracker != NULL)
+				m_pStateTracker->SetInputLayout(pInputLayout);
+			else
+				m_pContext->IASetInputLayout(pInputLayout);
+		}
+		
+		void setVertexShader(ID3D11VertexShader *pShader) {
+			if(m_pStateTracker != NULL)
+				m_pStateTracker->SetVertexShader(pShader);
+			else
+				m_pContext->VSSetShader(pShader, NULL, 0);
+		}
+		
+		void setGeometryShader(ID3D11GeometryShader *pShader) {
+			if(m_pStateTracker != NULL)
+				m_pStateTracker->SetGeometryShader(pShader);
+			else
+				m_pContext->GSSetShader(pShader, NULL, 0);
+		}
+		
+		void setPixelShader(ID3D11PixelShader *pShader) {
+			if(m_pStateTracker != NULL)
+				m_pStateTracker->SetPixelShader(pShader);
+			else
+				m_pContext->PSSetShader(pShader, NULL, 0);
+		}
+		
+		void setHullShader(ID3D11HullShader *pShader) {
+			if(m_pStateTracker != NULL)
+				m_pStateTracker->SetHullShader(pShader);
+			else
+				m_pContext->HSSetShader(pShader, NULL, 0);
+		}
+		
+		void setDomainShader(ID3D11DomainShader *pShader) {
+			if(m_pStateTracker != NULL)
+				m_pStateTracker->SetDomainShader(pShader);
+			else
+				m_pContext->DSSetShader(pShader, NULL, 0);
+		}
+		
+		void setVertexShaderConstantBuffer(ID3D11Buffer *pBuffer) {
+			if(m_pStateTracker != NULL)
+				m_pStateTracker->SetVertexShaderConstantBuffer(pBuffer);
+			else
+				m_pContext->VSSetConstantBuffers(0, 1, &pBuffer);
+		}
+		
+		void setGeometryShaderConstantBuffer(ID3D11Buffer *pBuffer) {
+			if(m_pStateTracker != NULL)
+				m_pStateTracker->SetGeometryShaderConstantBuffer(pBuffer);
+			else
+				m_pContext->GSSetConstantBuffers(0, 1, &pBuffer);
+		}
+		
+		void setPixelShaderSampler(ID3D11SamplerState *pSamplerState) {
+			if(m_pStateTracker != NULL)
+				m_pStateTracker->SetPixelShaderSampler(pSamplerState);
+			else
+				m_pContext->PSSetSamplers(0, 1, &pSamplerState);
+		}
+		
+		void setBlendState(ID3D11BlendState *pBlendState, UINT sampleMask) {
+			if(m_pStateTracker != NULL)
+				m_pStateTracker->SetBlendState(pBlendState, sampleMask);
+			else
+				m_pContext->OMSetBlendState(pBlendState, NULL, sampleMask);
+		}
+		
+		void setDepthStencilState(ID3D11DepthStencilState *pDepthStencilState, UINT stencilRef) {
+			if(m_pStateTracker != NULL)
+				m_pStateTracker->SetDepthStencilState(pDepthStencilState, stencilRef);
+			else
+				m_pContext->OMSetDepthStencilState(pDepthStencilState, stencilRef);
+		}
+		
+		void setRasterizerState(ID3D11RasterizerState *pRasterizerState) {
+			if(m_pStateTracker != NULL)
+				m_pStateTracker->SetRasterizerState(pRasterizerState);
+			else
+				m_pContext->RSSetState(pRasterizerState);
+		}
+	
+	private:
+		StateSetter();
+		StateSetter(const StateSetter&);
+		StateSetter& operator=(const StateSetter&);
+		
+		ID3D11DeviceContext			*m_pContext;
+		IFW1StateTracker			*m_pStateTracker;
+};
+
+
 // Construct
 CFW1GlyphRenderStates::CFW1GlyphRenderStates() :
-	m_pfnD3DCompile(NULL),
-	
 	m_pDevice(NULL),
 	m_featureLevel(D3D_FEATURE_LEVEL_9_1),
 	
 	m_pVertexShaderQuad(NULL),
 	m_pVertexShaderClipQuad(NULL),
 	m_pQuadInputLayout(NULL),
+	m_pVertexShaderQuadArray(NULL),
+	m_pVertexShaderClipQuadArray(NULL),
 	
 	m_pVertexShaderPoint(NULL),
 	m_pPointInputLayout(NULL),
 	m_pGeometryShaderPoint(NULL),
 	m_pGeometryShaderClipPoint(NULL),
 	m_hasGeometryShader(false),
+	m_pGeometryShaderPointArray(NULL),
+	m_pGeometryShaderClipPointArray(NULL),
+	
+	m_pVertexShaderPull(NULL),
+	m_pVertexShaderClipPull(NULL),
+	m_pVertexShaderPullArray(NULL),
+	m_pVertexShaderClipPullArray(NULL),
+	m_hasVertexPullingShaders(false),
 	
 	m_pPixelShader(NULL),
 	m_pPixelShaderClip(NULL),
+	m_pPixelShaderArray(NULL),
+	m_pPixelShaderClipArray(NULL),
+	m_hasTextureArrayShaders(false),
+	m_pPixelShaderDistanceField(NULL),
+	m_pPixelShaderClipDistanceField(NULL),
+	m_pPixelShaderDistanceFieldArray(NULL),
+	m_pPixelShaderClipDistanceFieldArray(NULL),
+	m_hasDistanceFieldShaders(false),
 	
 	m_pConstantBuffer(NULL),
 	
@@ -47,14 +175,29 @@ CFW1GlyphRenderStates::~CFW1GlyphRenderStates() {
 	SAFE_RELEASE(m_pVertexShaderQuad);
 	SAFE_RELEASE(m_pVertexShaderClipQuad);
 	SAFE_RELEASE(m_pQuadInputLayout);
+	SAFE_RELEASE(m_pVertexShaderQuadArray);
+	SAFE_RELEASE(m_pVertexShaderClipQuadArray);
 	
 	SAFE_RELEASE(m_pVertexShaderPoint);
 	SAFE_RELEASE(m_pPointInputLayout);
 	SAFE_RELEASE(m_pGeometryShaderPoint);
 	SAFE_RELEASE(m_pGeometryShaderClipPoint);
+	SAFE_RELEASE(m_pGeometryShaderPointArray);
+	SAFE_RELEASE(m_pGeometryShaderClipPointArray);
+	
+	SAFE_RELEASE(m_pVertexShaderPull);
+	SAFE_RELEASE(m_pVertexShaderClipPull);
+	SAFE_RELEASE(m_pVertexShaderPullArray);
+	SAFE_RELEASE(m_pVertexShaderClipPullArray);
 	
 	SAFE_RELEASE(m_pPixelShader);
 	SAFE_RELEASE(m_pPixelShaderClip);
+	SAFE_RELEASE(m_pPixelShaderArray);
+	SAFE_RELEASE(m_pPixelShaderClipArray);
+	SAFE_RELEASE(m_pPixelShaderDistanceField);
+	SAFE_RELEASE(m_pPixelShaderClipDistanceField);
+	SAFE_RELEASE(m_pPixelShaderDistanceFieldArray);
+	SAFE_RELEASE(m_pPixelShaderClipDistanceFieldArray);
 	
 	SAFE_RELEASE(m_pConstantBuffer);
 	
@@ -83,32 +226,6 @@ HRESULT CFW1GlyphRenderStates::initRenderResources(
 	m_pDevice = pDevice;
 	m_featureLevel = m_pDevice->GetFeatureLevel();
 	
-	// D3DCompiler
-#ifdef FW1_DELAYLOAD_D3DCOMPILER_XX_DLL
-	HMODULE hD3DCompiler = LoadLibrary(D3DCOMPILER_DLL);
-	if(hD3DCompiler == NULL) {
-		DWORD dwErr = GetLastError();
-		dwErr;
-		m_lastError = std::wstring(L"Failed to load ") + D3DCOMPILER_DLL_W;
-		hResult = E_FAIL;
-	}
-	else {
-		m_pfnD3DCompile = reinterpret_cast<pD3DCompile>(GetProcAddress(hD3DCompiler, "D3DCompile"));
-		if(m_pfnD3DCompile == NULL) {
-			DWORD dwErr = GetLastError();
-			dwErr;
-			m_lastError = std::wstring(L"Failed to load D3DCompile from ") + D3DCOMPILER_DLL_W;
-			hResult = E_FAIL;
-		}
-		else {
-			hResult = S_OK;
-		}
-	}
-#else
-	m_pfnD3DCompile = D3DCompile;
-	hResult = S_OK;
-#endif
-	
 	// Create all needed resources
 	if(SUCCEEDED(hResult))
 		hResult = createQuadShaders();
@@ -123,606 +240,253 @@ HRESULT CFW1GlyphRenderStates::initRenderResources(
 		if(FAILED(hResult))
 			hResult = S_OK;
 	}
+	if(SUCCEEDED(hResult) && m_featureLevel >= D3D_FEATURE_LEVEL_10_0) {
+		if(SUCCEEDED(createVertexPullingShaders()))
+			m_hasVertexPullingShaders = true;
+	}
+	
+	// Texture-array atlases are only supported if every shader that may be selected has an array variant
+	if(SUCCEEDED(hResult)) {
+		m_hasTextureArrayShaders =
+			m_pVertexShaderQuadArray != NULL && m_pVertexShaderClipQuadArray != NULL &&
+			m_pPixelShaderArray != NULL && m_pPixelShaderClipArray != NULL;
+		if(m_hasGeometryShader && (m_pGeometryShaderPointArray == NULL || m_pGeometryShaderClipPointArray == NULL))
+			m_hasTextureArrayShaders = false;
+		
+		m_hasDistanceFieldShaders = (m_pPixelShaderDistanceField != NULL && m_pPixelShaderClipDistanceField != NULL);
+		if(m_hasTextureArrayShaders && (m_pPixelShaderDistanceFieldArray == NULL || m_pPixelShaderClipDistanceFieldArray == NULL))
+			m_hasDistanceFieldShaders = false;
+	}
 	
 	if(SUCCEEDED(hResult))
 		hResult = S_OK;
 	
-#ifdef FW1_DELAYLOAD_D3DCOMPILER_XX_DLL
-	FreeLibrary(hD3DCompiler);
-#endif
-	
 	return hResult;
 }
 
 
 // Create quad shaders
 HRESULT CFW1GlyphRenderStates::createQuadShaders() {
-	// Vertex shaders
-	const char vsSimpleStr[] =
-	"cbuffer ShaderConstants : register(b0) {\r\n"
-	"	float4x4 TransformMatrix : packoffset(c0);\r\n"
-	"};\r\n"
-	"\r\n"
-	"struct VSIn {\r\n"
-	"	float4 Position : POSITION;\r\n"
-	"	float4 GlyphColor : GLYPHCOLOR;\r\n"
-	"};\r\n"
-	"\r\n"
-	"struct VSOut {\r\n"
-	"	float4 Position : SV_Position;\r\n"
-	"	float4 GlyphColor : COLOR;\r\n"
-	"	float2 TexCoord : TEXCOORD;\r\n"
-	"};\r\n"
-	"\r\n"
-	"VSOut VS(VSIn Input) {\r\n"
-	"	VSOut Output;\r\n"
-	"	\r\n"
-	"	Output.Position = mul(TransformMatrix, float4(Input.Position.xy, 0.0f, 1.0f));\r\n"
-	"	Output.GlyphColor = Input.GlyphColor;\r\n"
-	"	Output.TexCoord = Input.Position.zw;\r\n"
-	"	\r\n"
-	"	return Output;\r\n"
-	"}\r\n"
-	"";
-	
-	const char vsClipStr[] =
-	"cbuffer ShaderConstants : register(b0) {\r\n"
-	"	float4x4 TransformMatrix : packoffset(c0);\r\n"
-	"	float4 ClipRect : packoffset(c4);\r\n"
-	"};\r\n"
-	"\r\n"
-	"struct VSIn {\r\n"
-	"	float4 Position : POSITION;\r\n"
-	"	float4 GlyphColor : GLYPHCOLOR;\r\n"
-	"};\r\n"
-	"\r\n"
-	"struct VSOut {\r\n"
-	"	float4 Position : SV_Position;\r\n"
-	"	float4 GlyphColor : COLOR;\r\n"
-	"	float2 TexCoord : TEXCOORD;\r\n"
-	"	float4 ClipDistance : CLIPDISTANCE;\r\n"
-	"};\r\n"
-	"\r\n"
-	"VSOut VS(VSIn Input) {\r\n"
-	"	VSOut Output;\r\n"
-	"	\r\n"
-	"	Output.Position = mul(TransformMatrix, float4(Input.Position.xy, 0.0f, 1.0f));\r\n"
-	"	Output.GlyphColor = Input.GlyphColor;\r\n"
-	"	Output.TexCoord = Input.Position.zw;\r\n"
-	"	Output.ClipDistance = ClipRect + float4(Input.Position.xy, -Input.Position.xy);\r\n"
-	"	\r\n"
-	"	return Output;\r\n"
-	"}\r\n"
-	"";
-	
-	// Shader compile profile
-	const char *vs_profile = "vs_4_0_level_9_1";
-	if(m_featureLevel >= D3D_FEATURE_LEVEL_11_0)
-		vs_profile = "vs_5_0";
-	else if(m_featureLevel >= D3D_FEATURE_LEVEL_10_0)
-		vs_profile = "vs_4_0";
-	else if(m_featureLevel >= D3D_FEATURE_LEVEL_9_3)
-		vs_profile = "vs_4_0_level_9_3";
-	
-	// Compile vertex shader
-	ID3DBlob *pVSCode;
-	
-	HRESULT hResult = m_pfnD3DCompile(
-		vsSimpleStr,
-		sizeof(vsSimpleStr),
-		NULL,
-		NULL,
-		NULL,
-		"VS",
-		vs_profile,
-		D3DCOMPILE_OPTIMIZATION_LEVEL3,
-		0,
-		&pVSCode,
-		NULL
-	);
+	// Create vertex shader
+	ID3D11VertexShader *pVS;
+	
+	HRESULT hResult = m_pDevice->CreateVertexShader(g_FW1QuadVS, sizeof(g_FW1QuadVS), NULL, &pVS);
 	if(FAILED(hResult)) {
-		m_lastError = L"Failed to compile vertex shader";
+		m_lastError = L"Failed to create vertex shader";
 	}
 	else {
-		// Create vertex shader
-		ID3D11VertexShader *pVS;
+		// Create clipping vertex shader
+		ID3D11VertexShader *pVSClip;
 		
-		hResult = m_pDevice->CreateVertexShader(pVSCode->GetBufferPointer(), pVSCode->GetBufferSize(), NULL, &pVS);
+		hResult = m_pDevice->CreateVertexShader(g_FW1QuadVSClip, sizeof(g_FW1QuadVSClip), NULL, &pVSClip);
 		if(FAILED(hResult)) {
-			m_lastError = L"Failed to create vertex shader";
+			m_lastError = L"Failed to create clipping vertex shader";
 		}
 		else {
-			// Compile clipping vertex shader
-			ID3DBlob *pVSClipCode;
+			// Create input layout
+			ID3D11InputLayout *pInputLayout;
 			
-			hResult = m_pfnD3DCompile(
-				vsClipStr,
-				sizeof(vsClipStr),
-				NULL,
-				NULL,
-				NULL,
-				"VS",
-				vs_profile,
-				D3DCOMPILE_OPTIMIZATION_LEVEL3,
-				0,
-				&pVSClipCode,
-				NULL
-			);
+			// Quad vertex input layout
+			D3D11_INPUT_ELEMENT_DESC inputElements[] = {
+				{"POSITION", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0},
+				{"GLYPHCOLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0}
+			};
+			
+			hResult = m_pDevice->CreateInputLayout(inputElements, 2, g_FW1QuadVS, sizeof(g_FW1QuadVS), &pInputLayout);
 			if(FAILED(hResult)) {
-				m_lastError = L"Failed to compile clipping vertex shader";
+				m_lastError = L"Failed to create input layout";
 			}
 			else {
-				// Create vertex shader
-				ID3D11VertexShader *pVSClip;
+				// Success
+				m_pVertexShaderQuad = pVS;
+				m_pVertexShaderClipQuad = pVSClip;
+				m_pQuadInputLayout = pInputLayout;
 				
-				hResult = m_pDevice->CreateVertexShader(
-					pVSClipCode->GetBufferPointer(),
-					pVSClipCode->GetBufferSize(),
-					NULL,
-					&pVSClip
-				);
-				if(FAILED(hResult)) {
-					m_lastError = L"Failed to create clipping vertex shader";
-				}
-				else {
-					// Create input layout
-					ID3D11InputLayout *pInputLayout;
-					
-					// Quad vertex input layout
-					D3D11_INPUT_ELEMENT_DESC inputElements[] = {
-						{"POSITION", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0},
-						{"GLYPHCOLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0}
-					};
-					
-					hResult = m_pDevice->CreateInputLayout(
-						inputElements,
-						2,
-						pVSCode->GetBufferPointer(),
-						pVSCode->GetBufferSize(),
-						&pInputLayout
-					);
-					if(FAILED(hResult)) {
-						m_lastError = L"Failed to create input layout";
-					}
-					else {
-						// Success
-						m_pVertexShaderQuad = pVS;
-						m_pVertexShaderClipQuad = pVSClip;
-						m_pQuadInputLayout = pInputLayout;
-						
-						hResult = S_OK;
-					}
-					
-					if(FAILED(hResult))
-						pVSClip->Release();
-				}
-				
-				pVSClipCode->Release();
+				hResult = S_OK;
 			}
 			
 			if(FAILED(hResult))
-				pVS->Release();
+				pVSClip->Release();
 		}
 		
-		pVSCode->Release();
+		if(FAILED(hResult))
+			pVS->Release();
+	}
+	
+	// Texture-array variants, taking the slice from the texcoord and sharing the input layout
+	if(SUCCEEDED(hResult) && m_featureLevel >= D3D_FEATURE_LEVEL_10_0) {
+		ID3D11VertexShader *pVSArray;
+		
+		if(SUCCEEDED(m_pDevice->CreateVertexShader(g_FW1QuadVSArray, sizeof(g_FW1QuadVSArray), NULL, &pVSArray)))
+			m_pVertexShaderQuadArray = pVSArray;
+		if(SUCCEEDED(m_pDevice->CreateVertexShader(g_FW1QuadVSClipArray, sizeof(g_FW1QuadVSClipArray), NULL, &pVSArray)))
+			m_pVertexShaderClipQuadArray = pVSArray;
 	}
 	
 	return hResult;
 }
 
+
 // Create point to quad geometry shader
 HRESULT CFW1GlyphRenderStates::createGlyphShaders() {
 	if(m_featureLevel < D3D_FEATURE_LEVEL_10_0)
 		return E_FAIL;
 	
-	// Geometry shader constructing glyphs from point input and texture buffer
-	const char gsSimpleStr[] =
-	"cbuffer ShaderConstants : register(b0) {\r\n"
-	"	float4x4 TransformMatrix : packoffset(c0);\r\n"
-	"};\r\n"
-	"\r\n"
-	"Buffer<float4> tex0 : register(t0);\r\n"
-	"\r\n"
-	"struct GSIn {\r\n"
-	"	float3 PositionIndex : POSITIONINDEX;\r\n"
-	"	float4 GlyphColor : GLYPHCOLOR;\r\n"
-	"};\r\n"
-	"\r\n"
-	"struct GSOut {\r\n"
-	"	float4 Position : SV_Position;\r\n"
-	"	float4 GlyphColor : COLOR;\r\n"
-	"	float2 TexCoord : TEXCOORD;\r\n"
-	"};\r\n"
-	"\r\n"
-	"[maxvertexcount(4)]\r\n"
-	"void GS(point GSIn Input[1], inout TriangleStream<GSOut> TriStream) {\r\n"
-	"	const float2 basePosition = Input[0].PositionIndex.xy;\r\n"
-	"	const uint glyphIndex = asuint(Input[0].PositionIndex.z);\r\n"
-	"	\r\n"
-	"	float4 texCoords = tex0.Load(uint2(glyphIndex*2, 0));\r\n"
-	"	float4 offsets = tex0.Load(uint2(glyphIndex*2+1, 0));\r\n"
-	"	\r\n"
-	"	GSOut Output;\r\n"
-	"	Output.GlyphColor = Input[0].GlyphColor;\r\n"
-	"	\r\n"
-	"	float4 positions = basePosition.xyxy + offsets;\r\n"
-	"	\r\n"
-	"	Output.Position = mul(TransformMatrix, float4(positions.xy, 0.0f, 1.0f));\r\n"
-	"	Output.TexCoord = texCoords.xy;\r\n"
-	"	TriStream.Append(Output);\r\n"
-	"	\r\n"
-	"	Output.Position = mul(TransformMatrix, float4(positions.zy, 0.0f, 1.0f));\r\n"
-	"	Output.TexCoord = texCoords.zy;\r\n"
-	"	TriStream.Append(Output);\r\n"
-	"	\r\n"
-	"	Output.Position = mul(TransformMatrix, float4(positions.xw, 0.0f, 1.0f));\r\n"
-	"	Output.TexCoord = texCoords.xw;\r\n"
-	"	TriStream.Append(Output);\r\n"
-	"	\r\n"
-	"	Output.Position = mul(TransformMatrix, float4(positions.zw, 0.0f, 1.0f));\r\n"
-	"	Output.TexCoord = texCoords.zw;\r\n"
-	"	TriStream.Append(Output);\r\n"
-	"	\r\n"
-	"	TriStream.RestartStrip();\r\n"
-	"}\r\n"
-	"";
-	
-	// Geometry shader with rect clipping
-	const char gsClipStr[] =
-	"cbuffer ShaderConstants : register(b0) {\r\n"
-	"	float4x4 TransformMatrix : packoffset(c0);\r\n"
-	"	float4 ClipRect : packoffset(c4);\r\n"
-	"};\r\n"
-	"\r\n"
-	"Buffer<float4> tex0 : register(t0);\r\n"
-	"\r\n"
-	"struct GSIn {\r\n"
-	"	float3 PositionIndex : POSITIONINDEX;\r\n"
-	"	float4 GlyphColor : GLYPHCOLOR;\r\n"
-	"};\r\n"
-	"\r\n"
-	"struct GSOut {\r\n"
-	"	float4 Position : SV_Position;\r\n"
-	"	float4 GlyphColor : COLOR;\r\n"
-	"	float2 TexCoord : TEXCOORD;\r\n"
-	"	float4 ClipDistance : SV_ClipDistance;\r\n"
-	"};\r\n"
-	"\r\n"
-	"[maxvertexcount(4)]\r\n"
-	"void GS(point GSIn Input[1], inout TriangleStream<GSOut> TriStream) {\r\n"
-	"	const float2 basePosition = Input[0].PositionIndex.xy;\r\n"
-	"	const uint glyphIndex = asuint(Input[0].PositionIndex.z);\r\n"
-	"	\r\n"
-	"	float4 texCoords = tex0.Load(uint2(glyphIndex*2, 0));\r\n"
-	"	float4 offsets = tex0.Load(uint2(glyphIndex*2+1, 0));\r\n"
-	"	\r\n"
-	"	GSOut Output;\r\n"
-	"	Output.GlyphColor = Input[0].GlyphColor;\r\n"
-	"	\r\n"
-	"	float4 positions = basePosition.xyxy + offsets;\r\n"
-	"	\r\n"
-	"	Output.Position = mul(TransformMatrix, float4(positions.xy, 0.0f, 1.0f));\r\n"
-	"	Output.TexCoord = texCoords.xy;\r\n"
-	"	Output.ClipDistance = ClipRect + float4(positions.xy, -positions.xy);\r\n"
-	"	TriStream.Append(Output);\r\n"
-	"	\r\n"
-	"	Output.Position = mul(TransformMatrix, float4(positions.zy, 0.0f, 1.0f));\r\n"
-	"	Output.TexCoord = texCoords.zy;\r\n"
-	"	Output.ClipDistance = ClipRect + float4(positions.zy, -positions.zy);\r\n"
-	"	TriStream.Append(Output);\r\n"
-	"	\r\n"
-	"	Output.Position = mul(TransformMatrix, float4(positions.xw, 0.0f, 1.0f));\r\n"
-	"	Output.TexCoord = texCoords.xw;\r\n"
-	"	Output.ClipDistance = ClipRect + float4(positions.xw, -positions.xw);\r\n"
-	"	TriStream.Append(Output);\r\n"
-	"	\r\n"
-	"	Output.Position = mul(TransformMatrix, float4(positions.zw, 0.0f, 1.0f));\r\n"
-	"	Output.TexCoord = texCoords.zw;\r\n"
-	"	Output.ClipDistance = ClipRect + float4(positions.zw, -positions.zw);\r\n"
-	"	TriStream.Append(Output);\r\n"
-	"	\r\n"
-	"	TriStream.RestartStrip();\r\n"
-	"}\r\n"
-	"";
-	
-	// Vertex shader
-	const char vsEmptyStr[] =
-	"struct GSIn {\r\n"
-	"	float3 PositionIndex : POSITIONINDEX;\r\n"
-	"	float4 GlyphColor : GLYPHCOLOR;\r\n"
-	"};\r\n"
-	"\r\n"
-	"GSIn VS(GSIn Input) {\r\n"
-	"	return Input;\r\n"
-	"}\r\n"
-	"";
-	
-	// Shader compile profiles
-	const char *vs_profile = "vs_4_0";
-	const char *gs_profile = "gs_4_0";
-	if(m_featureLevel >= D3D_FEATURE_LEVEL_11_0) {
-		vs_profile = "vs_5_0";
-		gs_profile = "gs_5_0";
-	}
+	// Create geometry shader
+	ID3D11GeometryShader *pGS;
 	
-	// Compile geometry shader
-	ID3DBlob *pGSCode;
-	
-	HRESULT hResult = m_pfnD3DCompile(
-		gsSimpleStr,
-		sizeof(gsSimpleStr),
-		NULL,
-		NULL,
-		NULL,
-		"GS",
-		gs_profile,
-		D3DCOMPILE_OPTIMIZATION_LEVEL3,
-		0,
-		&pGSCode,
-		NULL
-	);
+	HRESULT hResult = m_pDevice->CreateGeometryShader(g_FW1PointGS, sizeof(g_FW1PointGS), NULL, &pGS);
 	if(FAILED(hResult)) {
-		m_lastError = L"Failed to compile geometry shader";
+		m_lastError = L"Failed to create geometry shader";
 	}
 	else {
-		// Create geometry shader
-		ID3D11GeometryShader *pGS;
+		// Create clipping geometry shader
+		ID3D11GeometryShader *pGSClip;
 		
-		hResult = m_pDevice->CreateGeometryShader(pGSCode->GetBufferPointer(), pGSCode->GetBufferSize(), NULL, &pGS);
+		hResult = m_pDevice->CreateGeometryShader(g_FW1PointGSClip, sizeof(g_FW1PointGSClip), NULL, &pGSClip);
 		if(FAILED(hResult)) {
-			m_lastError = L"Failed to create geometry shader";
+			m_lastError = L"Failed to create clipping geometry shader";
 		}
 		else {
-			// Compile clipping geometry shader
-			ID3DBlob *pGSClipCode;
+			// Create vertex shader
+			ID3D11VertexShader *pVSEmpty;
 			
-			hResult = m_pfnD3DCompile(
-				gsClipStr,
-				sizeof(gsClipStr),
-				NULL,
-				NULL,
-				NULL,
-				"GS",
-				gs_profile,
-				D3DCOMPILE_OPTIMIZATION_LEVEL3,
-				0,
-				&pGSClipCode,
-				NULL
-			);
+			hResult = m_pDevice->CreateVertexShader(g_FW1PointVS, sizeof(g_FW1PointVS), NULL, &pVSEmpty);
 			if(FAILED(hResult)) {
-				m_lastError = L"Failed to compile clipping geometry shader";
+				m_lastError = L"Failed to create empty vertex shader";
 			}
 			else {
-				// Create clipping geometry shader
-				ID3D11GeometryShader *pGSClip;
+				ID3D11InputLayout *pInputLayout;
+				
+				// Input layout for geometry shader
+				D3D11_INPUT_ELEMENT_DESC inputElements[] = {
+					{"POSITIONINDEX", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0},
+					{"GLYPHCOLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0}
+				};
 				
-				hResult = m_pDevice->CreateGeometryShader(
-					pGSClipCode->GetBufferPointer(),
-					pGSClipCode->GetBufferSize(),
-					NULL,
-					&pGSClip
-				);
+				hResult = m_pDevice->CreateInputLayout(inputElements, 2, g_FW1PointVS, sizeof(g_FW1PointVS), &pInputLayout);
 				if(FAILED(hResult)) {
-					m_lastError = L"Failed to create clipping geometry shader";
+					m_lastError = L"Failed to create input layout for geometry shader";
 				}
 				else {
-					ID3DBlob *pVSEmptyCode;
-					
-					// Compile vertex shader
-					hResult = m_pfnD3DCompile(
-						vsEmptyStr,
-						sizeof(vsEmptyStr),
-						NULL,
-						NULL,
-						NULL,
-						"VS",
-						vs_profile,
-						D3DCOMPILE_OPTIMIZATION_LEVEL3,
-						0,
-						&pVSEmptyCode,
-						NULL
-					);
-					if(FAILED(hResult)) {
-						m_lastError = L"Failed to compile empty vertex shader";
-					}
-					else {
-						// Create vertex shader
-						ID3D11VertexShader *pVSEmpty;
-						
-						hResult = m_pDevice->CreateVertexShader(
-							pVSEmptyCode->GetBufferPointer(),
-							pVSEmptyCode->GetBufferSize(),
-							NULL,
-							&pVSEmpty
-						);
-						if(FAILED(hResult)) {
-							m_lastError = L"Failed to create empty vertex shader";
-						}
-						else {
-							ID3D11InputLayout *pInputLayout;
-							
-							// Input layout for geometry shader
-							D3D11_INPUT_ELEMENT_DESC inputElements[] = {
-								{"POSITIONINDEX", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0},
-								{"GLYPHCOLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0}
-							};
-							
-							hResult = m_pDevice->CreateInputLayout(
-								inputElements,
-								2,
-								pVSEmptyCode->GetBufferPointer(),
-								pVSEmptyCode->GetBufferSize(),
-								&pInputLayout
-							);
-							if(FAILED(hResult)) {
-								m_lastError = L"Failed to create input layout for geometry shader";
-							}
-							else {
-								// Success
-								m_pVertexShaderPoint = pVSEmpty;
-								m_pGeometryShaderPoint = pGS;
-								m_pGeometryShaderClipPoint = pGSClip;
-								m_pPointInputLayout = pInputLayout;
-								m_hasGeometryShader = true;
-								
-								hResult = S_OK;
-							}
-							
-							if(FAILED(hResult))
-								pVSEmpty->Release();
-						}
-						
-						pVSEmptyCode->Release();
-					}
+					// Success
+					m_pVertexShaderPoint = pVSEmpty;
+					m_pGeometryShaderPoint = pGS;
+					m_pGeometryShaderClipPoint = pGSClip;
+					m_pPointInputLayout = pInputLayout;
+					m_hasGeometryShader = true;
 					
-					if(FAILED(hResult))
-						pGSClip->Release();
+					hResult = S_OK;
 				}
 				
-				pGSClipCode->Release();
+				if(FAILED(hResult))
+					pVSEmpty->Release();
 			}
 			
 			if(FAILED(hResult))
-				pGS->Release();
+				pGSClip->Release();
 		}
 		
-		pGSCode->Release();
+		if(FAILED(hResult))
+			pGS->Release();
+	}
+	
+	// Texture-array variants, reading glyph coords from the row of the slice in the atlas coord texture
+	if(SUCCEEDED(hResult)) {
+		ID3D11GeometryShader *pGSArray;
+		
+		if(SUCCEEDED(m_pDevice->CreateGeometryShader(g_FW1PointGSArray, sizeof(g_FW1PointGSArray), NULL, &pGSArray)))
+			m_pGeometryShaderPointArray = pGSArray;
+		if(SUCCEEDED(m_pDevice->CreateGeometryShader(g_FW1PointGSClipArray, sizeof(g_FW1PointGSClipArray), NULL, &pGSArray)))
+			m_pGeometryShaderClipPointArray = pGSArray;
 	}
 	
 	return hResult;
 }
 
+
+// Create vertex shaders that build glyph quads without a geometry shader
+HRESULT CFW1GlyphRenderStates::createVertexPullingShaders() {
+	if(m_featureLevel < D3D_FEATURE_LEVEL_10_0)
+		return E_FAIL;
+	
+	// The glyph vertices come from a buffer, so there is no input layout
+	const BYTE *shaderCode[4] = {g_FW1PullVS, g_FW1PullVSClip, g_FW1PullVSArray, g_FW1PullVSClipArray};
+	const SIZE_T shaderCodeSizes[4] = {
+		sizeof(g_FW1PullVS),
+		sizeof(g_FW1PullVSClip),
+		sizeof(g_FW1PullVSArray),
+		sizeof(g_FW1PullVSClipArray)
+	};
+	ID3D11VertexShader **ppShaders[4] = {
+		&m_pVertexShaderPull,
+		&m_pVertexShaderClipPull,
+		&m_pVertexShaderPullArray,
+		&m_pVertexShaderClipPullArray
+	};
+	
+	for(UINT i=0; i < 4; ++i) {
+		HRESULT hResult = m_pDevice->CreateVertexShader(shaderCode[i], shaderCodeSizes[i], NULL, ppShaders[i]);
+		if(FAILED(hResult)) {
+			m_lastError = L"Failed to create vertex pulling shader";
+			return hResult;
+		}
+	}
+	
+	return S_OK;
+}
+
+
 // Create pixel shaders
 HRESULT CFW1GlyphRenderStates::createPixelShaders() {
-	// Pixel shader
-	const char psStr[] =
-	"SamplerState sampler0 : register(s0);\r\n"
-	"Texture2D<float> tex0 : register(t0);\r\n"
-	"\r\n"
-	"struct PSIn {\r\n"
-	"	float4 Position : SV_Position;\r\n"
-	"	float4 GlyphColor : COLOR;\r\n"
-	"	float2 TexCoord : TEXCOORD;\r\n"
-	"};\r\n"
-	"\r\n"
-	"float4 PS(PSIn Input) : SV_Target {\r\n"
-	"	float a = tex0.Sample(sampler0, Input.TexCoord);\r\n"
-	"	\r\n"
-	"	if(a == 0.0f)\r\n"
-	"		discard;\r\n"
-	"	\r\n"
-	"	return (a * Input.GlyphColor.a) * float4(Input.GlyphColor.rgb, 1.0f);\r\n"
-	"}\r\n"
-	"";
-	
-	// Clipping pixel shader
-	const char psClipStr[] =
-	"SamplerState sampler0 : register(s0);\r\n"
-	"Texture2D<float> tex0 : register(t0);\r\n"
-	"\r\n"
-	"struct PSIn {\r\n"
-	"	float4 Position : SV_Position;\r\n"
-	"	float4 GlyphColor : COLOR;\r\n"
-	"	float2 TexCoord : TEXCOORD;\r\n"
-	"	float4 ClipDistance : CLIPDISTANCE;\r\n"
-	"};\r\n"
-	"\r\n"
-	"float4 PS(PSIn Input) : SV_Target {\r\n"
-	"	clip(Input.ClipDistance);\r\n"
-	"	\r\n"
-	"	float a = tex0.Sample(sampler0, Input.TexCoord);\r\n"
-	"	\r\n"
-	"	if(a == 0.0f)\r\n"
-	"		discard;\r\n"
-	"	\r\n"
-	"	return (a * Input.GlyphColor.a) * float4(Input.GlyphColor.rgb, 1.0f);\r\n"
-	"}\r\n"
-	"";
-	
-	// Shader compile profile
-	const char *ps_profile = "ps_4_0_level_9_1";
-	if(m_featureLevel >= D3D_FEATURE_LEVEL_11_0)
-		ps_profile = "ps_5_0";
-	else if(m_featureLevel >= D3D_FEATURE_LEVEL_10_0)
-		ps_profile = "ps_4_0";
-	else if(m_featureLevel >= D3D_FEATURE_LEVEL_9_3)
-		ps_profile = "ps_4_0_level_9_3";
-	
-	// Compile pixel shader
-	ID3DBlob *pPSCode;
-	
-	HRESULT hResult = m_pfnD3DCompile(
-		psStr,
-		sizeof(psStr),
-		NULL,
-		NULL,
-		NULL,
-		"PS",
-		ps_profile,
-		D3DCOMPILE_OPTIMIZATION_LEVEL3,
-		0,
-		&pPSCode,
-		NULL
-	);
+	// Create pixel shader
+	ID3D11PixelShader *pPS;
+	
+	HRESULT hResult = m_pDevice->CreatePixelShader(g_FW1GlyphPS, sizeof(g_FW1GlyphPS), NULL, &pPS);
 	if(FAILED(hResult)) {
-		m_lastError = L"Failed to compile pixel shader";
+		m_lastError = L"Failed to create pixel shader";
 	}
 	else {
-		// Create pixel shader
-		ID3D11PixelShader *pPS;
+		// Create clipping pixel shader
+		ID3D11PixelShader *pPSClip;
 		
-		hResult = m_pDevice->CreatePixelShader(pPSCode->GetBufferPointer(), pPSCode->GetBufferSize(), NULL, &pPS);
+		hResult = m_pDevice->CreatePixelShader(g_FW1GlyphPSClip, sizeof(g_FW1GlyphPSClip), NULL, &pPSClip);
 		if(FAILED(hResult)) {
-			m_lastError = L"Failed to create pixel shader";
+			m_lastError = L"Failed to create clipping pixel shader";
 		}
 		else {
-			// Compile clipping pixel shader
-			ID3DBlob *pPSClipCode;
+			// Success
+			m_pPixelShader = pPS;
+			m_pPixelShaderClip = pPSClip;
 			
-			HRESULT hResult = m_pfnD3DCompile(
-				psClipStr,
-				sizeof(psClipStr),
-				NULL,
-				NULL,
-				NULL,
-				"PS",
-				ps_profile,
-				D3DCOMPILE_OPTIMIZATION_LEVEL3,
-				0,
-				&pPSClipCode,
-				NULL
-			);
-			if(FAILED(hResult)) {
-				m_lastError = L"Failed to compile clipping pixel shader";
-			}
-			else {
-				// Create pixel shader
-				ID3D11PixelShader *pPSClip;
-				
-				hResult = m_pDevice->CreatePixelShader(
-					pPSClipCode->GetBufferPointer(),
-					pPSClipCode->GetBufferSize(),
-					NULL, &pPSClip
-				);
-				if(FAILED(hResult)) {
-					m_lastError = L"Failed to create clipping pixel shader";
-				}
-				else {
-					// Success
-					m_pPixelShader = pPS;
-					m_pPixelShaderClip = pPSClip;
-					
-					hResult = S_OK;
-				}
-				
-				pPSClipCode->Release();
-			}
-			
-			if(FAILED(hResult))
-				pPS->Release();
+			hResult = S_OK;
 		}
 		
-		pPSCode->Release();
+		if(FAILED(hResult))
+			pPS->Release();
+	}
+	
+	// Texture-array variants
+	if(SUCCEEDED(hResult) && m_featureLevel >= D3D_FEATURE_LEVEL_10_0) {
+		m_pPixelShaderArray = createPixelShaderVariant(g_FW1GlyphPSArray, sizeof(g_FW1GlyphPSArray));
+		m_pPixelShaderClipArray = createPixelShaderVariant(g_FW1GlyphPSClipArray, sizeof(g_FW1GlyphPSClipArray));
+	}
+	
+	// Distance-field variants, antialiased using screen-space derivatives of the distance
+	if(SUCCEEDED(hResult) && m_featureLevel >= D3D_FEATURE_LEVEL_10_0) {
+		m_pPixelShaderDistanceField = createPixelShaderVariant(g_FW1GlyphPSDistanceField, sizeof(g_FW1GlyphPSDistanceField));
+		m_pPixelShaderClipDistanceField = createPixelShaderVariant(
+			g_FW1GlyphPSClipDistanceField,
+			sizeof(g_FW1GlyphPSClipDistanceField)
+		);
+		m_pPixelShaderDistanceFieldArray = createPixelShaderVariant(
+			g_FW1GlyphPSDistanceFieldArray,
+			sizeof(g_FW1GlyphPSDistanceFieldArray)
+		);
+		m_pPixelShaderClipDistanceFieldArray = createPixelShaderVariant(
+			g_FW1GlyphPSClipDistanceFieldArray,
+			sizeof(g_FW1GlyphPSClipDistanceFieldArray)
+		);
 	}
 	
 	return hResult;
@@ -751,7 +515,7 @@ HRESULT CFW1GlyphRenderStates::createConstantBuffer() {
 				
 		hResult = S_OK;
 	}
-
+	
 	return hResult;
 }
 
@@ -854,4 +618,95 @@ HRESULT CFW1GlyphRenderStates::createRenderStates(bool anisotropicFiltering) {
 }
 
 
+// Create a pixel shader variant, returns NULL on failure
+ID3D11PixelShader* CFW1GlyphRenderStates::createPixelShaderVariant(const BYTE *pShaderCode, SIZE_T shaderCodeSize) {
+	ID3D11PixelShader *pPS;
+	if(FAILED(m_pDevice->CreatePixelShader(pShaderCode, shaderCodeSize, NULL, &pPS)))
+		return NULL;
+	
+	return pPS;
+}
+
+
+// Select the pixel shader for a combination of clipping, texture-array and distance-field
+ID3D11PixelShader* CFW1GlyphRenderStates::getPixelShader(bool clip, bool textureArray, bool distanceField) {
+	if(distanceField) {
+		if(clip)
+			return textureArray ? m_pPixelShaderClipDistanceFieldArray : m_pPixelShaderClipDistanceField;
+		return textureArray ? m_pPixelShaderDistanceFieldArray : m_pPixelShaderDistanceField;
+	}
+	
+	if(clip)
+		return textureArray ? m_pPixelShaderClipArray : m_pPixelShaderClip;
+	return textureArray ? m_pPixelShaderArray : m_pPixelShader;
+}
+
+
+// Set render states for glyph drawing, on a context or through a state tracker
+void CFW1GlyphRenderStates::setStates(ID3D11DeviceContext *pContext, IFW1StateTracker *pStateTracker, UINT flags) {
+	StateSetter setter(pContext, pStateTracker);
+	
+	// Texture-array atlases are sampled with the array variants of the shaders
+	bool textureArray = (m_hasTextureArrayShaders && (flags & FW1_TEXTUREARRAY) != 0);
+	bool distanceField = (m_hasDistanceFieldShaders && (flags & FW1_DISTANCEFIELD) != 0);
+	
+	if(m_hasGeometryShader && ((flags & FW1_NOGEOMETRYSHADER) == 0)) {
+		// Point vertices with geometry shader
+		setter.setPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_POINTLIST);
+		setter.setInputLayout(m_pPointInputLayout);
+		setter.setVertexShader(m_pVertexShaderPoint);
+		if((flags & FW1_CLIPRECT) != 0)
+			setter.setGeometryShader(textureArray ? m_pGeometryShaderClipPointArray : m_pGeometryShaderClipPoint);
+		else
+			setter.setGeometryShader(textureArray ? m_pGeometryShaderPointArray : m_pGeometryShaderPoint);
+		setter.setPixelShader(getPixelShader(false, textureArray, distanceField));
+		setter.setGeometryShaderConstantBuffer(m_pConstantBuffer);
+	}
+	else if(m_hasVertexPullingShaders && ((flags & FW1_VERTEXPULLING) != 0)) {
+		// Quads expanded in the vertex shader from buffers, no vertex input
+		setter.setPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		setter.setInputLayout(NULL);
+		if((flags & FW1_CLIPRECT) != 0) {
+			setter.setVertexShader(textureArray ? m_pVertexShaderClipPullArray : m_pVertexShaderClipPull);
+			setter.setPixelShader(getPixelShader(true, textureArray, distanceField));
+		}
+		else {
+			setter.setVertexShader(textureArray ? m_pVertexShaderPullArray : m_pVertexShaderPull);
+			setter.setPixelShader(getPixelShader(false, textureArray, distanceField));
+		}
+		setter.setVertexShaderConstantBuffer(m_pConstantBuffer);
+		setter.setGeometryShader(NULL);
+	}
+	else {
+		// Quads constructed on the CPU
+		setter.setPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		setter.setInputLayout(m_pQuadInputLayout);
+		if((flags & FW1_CLIPRECT) != 0) {
+			setter.setVertexShader(textureArray ? m_pVertexShaderClipQuadArray : m_pVertexShaderClipQuad);
+			setter.setPixelShader(getPixelShader(true, textureArray, distanceField));
+		}
+		else {
+			setter.setVertexShader(textureArray ? m_pVertexShaderQuadArray : m_pVertexShaderQuad);
+			setter.setPixelShader(getPixelShader(false, textureArray, distanceField));
+		}
+		setter.setVertexShaderConstantBuffer(m_pConstantBuffer);
+		
+		if(m_featureLevel >= D3D_FEATURE_LEVEL_10_0)
+			setter.setGeometryShader(NULL);
+	}
+	
+	if(m_featureLevel >= D3D_FEATURE_LEVEL_11_0) {
+		setter.setDomainShader(NULL);
+		setter.setHullShader(NULL);
+	}
+	
+	setter.setBlendState(m_pBlendState, 0xffffffff);
+	setter.setDepthStencilState(m_pDepthStencilState, 0);
+	
+	setter.setRasterizerState(m_pRasterizerState);
+	
+	setter.setPixelShaderSampler(m_pSamplerState);
+}
+
+
 }// namespace FW1FontWrapper
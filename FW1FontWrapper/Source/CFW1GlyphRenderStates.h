@@ -25,6 +25,8 @@ class CFW1GlyphRenderStates : public CFW1Object<IFW1GlyphRenderStates> {
 			const FLOAT *pTransformMatrix
 		);
 		virtual BOOL STDMETHODCALLTYPE HasGeometryShader();
+		virtual BOOL STDMETHODCALLTYPE HasVertexPullingShader();
+		virtual void STDMETHODCALLTYPE SetTrackedStates(IFW1StateTracker *pStateTracker, UINT Flags);
 	
 	// Public functions
 	public:
@@ -43,6 +45,9 @@ class CFW1GlyphRenderStates : public CFW1Object<IFW1GlyphRenderStates> {
 			FLOAT					TransformMatrix[16];
 			FLOAT					ClipRect[4];
 		};
+		
+		// Passes states to a context directly, or through a state tracker
+		class StateSetter;
 	
 	// Internal functions
 	private:
@@ -50,31 +55,51 @@ class CFW1GlyphRenderStates : public CFW1Object<IFW1GlyphRenderStates> {
 		
 		HRESULT createQuadShaders();
 		HRESULT createGlyphShaders();
+		HRESULT createVertexPullingShaders();
 		HRESULT createPixelShaders();
 		HRESULT createConstantBuffer();
 		HRESULT createRenderStates(bool anisotropicFiltering);
+		ID3D11PixelShader* createPixelShaderVariant(const BYTE *pShaderCode, SIZE_T shaderCodeSize);
+		ID3D11PixelShader* getPixelShader(bool clip, bool textureArray, bool distanceField);
+		void setStates(ID3D11DeviceContext *pContext, IFW1StateTracker *pStateTracker, UINT flags);
 	
 	// Internal data
 	private:
 		std::wstring				m_lastError;
 		
-		pD3DCompile					m_pfnD3DCompile;
-		
 		ID3D11Device				*m_pDevice;
 		D3D_FEATURE_LEVEL			m_featureLevel;
 		
 		ID3D11VertexShader			*m_pVertexShaderQuad;
 		ID3D11VertexShader			*m_pVertexShaderClipQuad;
 		ID3D11InputLayout			*m_pQuadInputLayout;
+		ID3D11VertexShader			*m_pVertexShaderQuadArray;
+		ID3D11VertexShader			*m_pVertexShaderClipQuadArray;
 		
 		ID3D11VertexShader			*m_pVertexShaderPoint;
 		ID3D11InputLayout			*m_pPointInputLayout;
 		ID3D11GeometryShader		*m_pGeometryShaderPoint;
 		ID3D11GeometryShader		*m_pGeometryShaderClipPoint;
 		bool						m_hasGeometryShader;
+		ID3D11GeometryShader		*m_pGeometryShaderPointArray;
+		ID3D11GeometryShader		*m_pGeometryShaderClipPointArray;
+		
+		ID3D11VertexShader			*m_pVertexShaderPull;
+		ID3D11VertexShader			*m_pVertexShaderClipPull;
+		ID3D11VertexShader			*m_pVertexShaderPullArray;
+		ID3D11VertexShader			*m_pVertexShaderClipPullArray;
+		bool						m_hasVertexPullingShaders;
 		
 		ID3D11PixelShader			*m_pPixelShader;
 		ID3D11PixelShader			*m_pPixelShaderClip;
+		ID3D11PixelShader			*m_pPixelShaderArray;
+		ID3D11PixelShader			*m_pPixelShaderClipArray;
+		bool						m_hasTextureArrayShaders;
+		ID3D11PixelShader			*m_pPixelShaderDistanceField;
+		ID3D11PixelShader			*m_pPixelShaderClipDistanceField;
+		ID3D11PixelShader			*m_pPixelShaderDistanceFieldArray;
+		ID3D11PixelShader			*m_pPixelShaderClipDistanceFieldArray;
+		bool						m_hasDistanceFieldShaders;
 		
 		ID3D11Buffer				*m_pConstantBuffer;
 		
@@ -37,47 +37,7 @@ HRESULT STDMETHODCALLTYPE CFW1GlyphRenderStates::GetDevice(ID3D11Device **ppDevi
 
 // Set render states for glyph drawing
 void STDMETHODCALLTYPE CFW1GlyphRenderStates::SetStates(ID3D11DeviceContext *pContext, UINT Flags) {
-	if(m_hasGeometryShader && ((Flags & FW1_NOGEOMETRYSHADER) == 0)) {
-		// Point vertices with geometry shader
-		pContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_POINTLIST);
-		pContext->IASetInputLayout(m_pPointInputLayout);
-		pContext->VSSetShader(m_pVertexShaderPoint, NULL, 0);
-		if((Flags & FW1_CLIPRECT) != 0)
-			pContext->GSSetShader(m_pGeometryShaderClipPoint, NULL, 0);
-		else
-			pContext->GSSetShader(m_pGeometryShaderPoint, NULL, 0);
-		pContext->PSSetShader(m_pPixelShader, NULL, 0);
-		pContext->GSSetConstantBuffers(0, 1, &m_pConstantBuffer);
-	}
-	else {
-		// Quads constructed on the CPU
-		pContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-		pContext->IASetInputLayout(m_pQuadInputLayout);
-		if((Flags & FW1_CLIPRECT) != 0) {
-			pContext->VSSetShader(m_pVertexShaderClipQuad, NULL, 0);
-			pContext->PSSetShader(m_pPixelShaderClip, NULL, 0);
-		}
-		else {
-			pContext->VSSetShader(m_pVertexShaderQuad, NULL, 0);
-			pContext->PSSetShader(m_pPixelShader, NULL, 0);
-		}
-		pContext->VSSetConstantBuffers(0, 1, &m_pConstantBuffer);
-		
-		if(m_featureLevel >= D3D_FEATURE_LEVEL_10_0)
-			pContext->GSSetShader(NULL, NULL, 0);
-	}
-	
-	if(m_featureLevel >= D3D_FEATURE_LEVEL_11_0) {
-		pContext->DSSetShader(NULL, NULL, 0);
-		pContext->HSSetShader(NULL, NULL, 0);
-	}
-	
-	pContext->OMSetBlendState(m_pBlendState, NULL, 0xffffffff);
-	pContext->OMSetDepthStencilState(m_pDepthStencilState, 0);
-	
-	pContext->RSSetState(m_pRasterizerState);
-	
-	pContext->PSSetSamplers(0, 1, &m_pSamplerState);
+	setStates(pContext, NULL, Flags);
 }
 
 
@@ -148,4 +108,19 @@ BOOL STDMETHODCALLTYPE CFW1GlyphRenderStates::HasGeometryShader() {
 }
 
 
+// Check for vertex pulling shaders
+BOOL STDMETHODCALLTYPE CFW1GlyphRenderStates::HasVertexPullingShader() {
+	return (m_hasVertexPullingShaders ? TRUE : FALSE);
+}
+
+
+// Set render states for glyph drawing through a state tracker
+void STDMETHODCALLTYPE CFW1GlyphRenderStates::SetTrackedStates(IFW1StateTracker *pStateTracker, UINT Flags) {
+	if(pStateTracker == NULL)
+		return;
+	
+	setStates(NULL, pStateTracker, Flags);
+}
+
+
 }// namespace FW1FontWrapper
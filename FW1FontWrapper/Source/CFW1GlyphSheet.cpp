@@ -6,6 +6,14 @@
 
 #define SAFE_RELEASE(pObject) { if(pObject) { (pObject)->Release(); (pObject) = NULL; } }
 
+#ifndef FW1_NOSIMD
+#if defined(_M_IX86) || defined(_M_X64)
+#define FW1_SSE2
+#elif defined(_M_ARM) || defined(_M_ARM64)
+#define FW1_NEON
+#endif
+#endif
+
 
 namespace FW1FontWrapper {
 
@@ -30,15 +38,27 @@ CFW1GlyphSheet::CFW1GlyphSheet() :
 	m_pTextureSRV(NULL),
 	m_pCoordBuffer(NULL),
 	m_pCoordBufferSRV(NULL),
+	m_isArraySlice(false),
+	m_arraySlice(0),
 	
 	m_closed(false),
 	m_static(false),
 	
+	m_compress(false),
+	m_compressed(false),
+	m_compressionError(0.0f),
+	m_maxCompressionError(0),
+	
 	m_heightRange(0),
+	m_usedArea(0),
+	m_packedHeight(0),
 	
-	m_updatedGlyphCount(0)
+	m_updatedGlyphCount(0),
+	m_dirtyRectCount(0),
+	m_lastFlushBytes(0),
+	m_totalFlushBytes(0)
 {
-	ZeroMemory(&m_dirtyRect, sizeof(m_dirtyRect));
+	ZeroMemory(m_dirtyRects, sizeof(m_dirtyRects));
 	InitializeCriticalSection(&m_sheetCriticalSection);
 	InitializeCriticalSection(&m_flushCriticalSection);
 }
@@ -72,7 +92,10 @@ HRESULT CFW1GlyphSheet::initGlyphSheet(
 	bool coordBuffer,
 	bool allowOversizedGlyph,
 	UINT maxGlyphCount,
-	UINT mipLevelCount
+	UINT mipLevelCount,
+	ID3D11ShaderResourceView *pArrayTextureSRV,
+	ID3D11ShaderResourceView *pArrayCoordSRV,
+	UINT arraySlice
 ) {
 	HRESULT hResult = initBaseObject(pFW1Factory);
 	if(FAILED(hResult))
@@ -128,8 +151,11 @@ HRESULT CFW1GlyphSheet::initGlyphSheet(
 	
 	m_heightRange = new HeightRange(m_sheetWidth / m_alignWidth);
 	
-	// Device texture/coord-buffer
-	hResult = createDeviceResources();
+	// Device texture/coord-buffer, or a slice of the textures owned by a texture-array atlas
+	if(pArrayTextureSRV != NULL)
+		hResult = useArraySlice(pArrayTextureSRV, pArrayCoordSRV, arraySlice);
+	else
+		hResult = createDeviceResources();
 	
 	if(SUCCEEDED(hResult))
 		hResult = S_OK;
@@ -220,34 +246,567 @@ HRESULT CFW1GlyphSheet::createDeviceResources() {
 }
 
 
+// Use a slice of a texture array and a row of its coord texture, instead of separate device resources
+HRESULT CFW1GlyphSheet::useArraySlice(
+	ID3D11ShaderResourceView *pArrayTextureSRV,
+	ID3D11ShaderResourceView *pArrayCoordSRV,
+	UINT arraySlice
+) {
+	if(pArrayCoordSRV == NULL)
+		return E_INVALIDARG;
+	
+	pArrayTextureSRV->AddRef();
+	m_pTextureSRV = pArrayTextureSRV;
+	pArrayTextureSRV->GetResource(&m_pTexture);
+	
+	pArrayCoordSRV->AddRef();
+	m_pCoordBufferSRV = pArrayCoordSRV;
+	pArrayCoordSRV->GetResource(&m_pCoordBuffer);
+	
+	m_hardwareCoordBuffer = true;
+	m_isArraySlice = true;
+	m_arraySlice = arraySlice;
+	
+	return S_OK;
+}
+
+
+// Add a region to the dirty list, merging it with nearby regions when uploading them together wastes little
+void CFW1GlyphSheet::addDirtyRect(const RectUI &rect) {
+	RectUI newRect = rect;
+	UINT newArea = (newRect.right - newRect.left) * (newRect.bottom - newRect.top);
+	
+	// Each region costs one update per mip-level, so regions that overlap or nearly touch are uploaded as one
+	for(UINT i=0; i < m_dirtyRectCount;) {
+		const RectUI &dirtyRect = m_dirtyRects[i];
+		UINT dirtyArea = (dirtyRect.right - dirtyRect.left) * (dirtyRect.bottom - dirtyRect.top);
+		
+		RectUI unionRect;
+		unionRect.left = std::min(newRect.left, dirtyRect.left);
+		unionRect.top = std::min(newRect.top, dirtyRect.top);
+		unionRect.right = std::max(newRect.right, dirtyRect.right);
+		unionRect.bottom = std::max(newRect.bottom, dirtyRect.bottom);
+		UINT unionArea = (unionRect.right - unionRect.left) * (unionRect.bottom - unionRect.top);
+		
+		UINT separateArea = newArea + dirtyArea;
+		if(unionArea <= separateArea + separateArea / 4 + 1024) {
+			newRect = unionRect;
+			newArea = unionArea;
+			
+			// The grown region may now be close to a region already tested, start over
+			m_dirtyRects[i] = m_dirtyRects[m_dirtyRectCount-1];
+			--m_dirtyRectCount;
+			i = 0;
+		}
+		else
+			++i;
+	}
+	
+	// No room for another region, merge with the one that grows the least
+	if(m_dirtyRectCount == MaxDirtyRects) {
+		UINT bestIndex = 0;
+		UINT bestGrowth = 0xffffffff;
+		RectUI bestRect = newRect;
+		
+		for(UINT i=0; i < m_dirtyRectCount; ++i) {
+			const RectUI &dirtyRect = m_dirtyRects[i];
+			
+			RectUI unionRect;
+			unionRect.left = std::min(newRect.left, dirtyRect.left);
+			unionRect.top = std::min(newRect.top, dirtyRect.top);
+			unionRect.right = std::max(newRect.right, dirtyRect.right);
+			unionRect.bottom = std::max(newRect.bottom, dirtyRect.bottom);
+			
+			UINT growth =
+				(unionRect.right - unionRect.left) * (unionRect.bottom - unionRect.top)
+				- (dirtyRect.right - dirtyRect.left) * (dirtyRect.bottom - dirtyRect.top);
+			if(growth < bestGrowth) {
+				bestIndex = i;
+				bestGrowth = growth;
+				bestRect = unionRect;
+			}
+		}
+		
+		newRect = bestRect;
+		m_dirtyRects[bestIndex] = m_dirtyRects[m_dirtyRectCount-1];
+		--m_dirtyRectCount;
+	}
+	
+	m_dirtyRects[m_dirtyRectCount] = newRect;
+	++m_dirtyRectCount;
+}
+
+
+// Upload one dirty region to every mip-level of the texture, returns the number of bytes uploaded
+UINT CFW1GlyphSheet::updateTextureRect(ID3D11DeviceContext *pContext, const RectUI &rect) {
+	if(rect.right <= rect.left || rect.bottom <= rect.top)
+		return 0;
+	
+	UINT8 *srcMem = m_textureData;
+	UINT uploadedBytes = 0;
+	
+	D3D11_BOX dstBox;
+	ZeroMemory(&dstBox, sizeof(dstBox));
+	dstBox.left = rect.left;
+	dstBox.right = rect.right;
+	dstBox.top = rect.top;
+	dstBox.bottom = rect.bottom;
+	dstBox.front = 0;
+	dstBox.back = 1;
+	
+	// Update each mip-level
+	for(UINT i=0; i < m_mipLevelCount; ++i) {
+		if(dstBox.right <= dstBox.left || dstBox.bottom <= dstBox.top)
+			break;
+		
+		pContext->UpdateSubresource(
+			m_pTexture,
+			D3D11CalcSubresource(i, m_arraySlice, m_mipLevelCount),
+			&dstBox,
+			srcMem + dstBox.top * (m_sheetWidth >> i) + dstBox.left,
+			m_sheetWidth >> i,
+			0
+		);
+		uploadedBytes += (dstBox.right - dstBox.left) * (dstBox.bottom - dstBox.top);
+		
+		if(i+1 < m_mipLevelCount) {
+			UINT8 *nextMip = srcMem + (m_sheetWidth >> i) * (m_sheetHeight >> i);
+			
+			dstBox.left >>= 1;
+			dstBox.right >>= 1;
+			dstBox.top >>= 1;
+			dstBox.bottom >>= 1;
+			
+			// Calculate the next mip-level for the current dirty-rect
+			for(UINT j = dstBox.top; j < dstBox.bottom; ++j) {
+				const UINT8 *src0 = srcMem + j * 2 * (m_sheetWidth >> i);
+				const UINT8 *src1 = src0 + (m_sheetWidth >> i);
+				UINT8 *dst = nextMip + j * (m_sheetWidth >> (i+1));
+				
+				downsampleRow(dst + dstBox.left, src0 + dstBox.left * 2, src1 + dstBox.left * 2, dstBox.right - dstBox.left);
+			}
+			
+			srcMem = nextMip;
+		}
+	}
+	
+	return uploadedBytes;
+}
+
+
+// Read the top mip-level of the device texture back to system memory, through a staging texture
+HRESULT CFW1GlyphSheet::readBackTexture(ID3D11DeviceContext *pContext, UINT8 *pPixels) {
+	D3D11_TEXTURE2D_DESC stagingDesc;
+	ID3D11Texture2D *pStagingTexture;
+	
+	ZeroMemory(&stagingDesc, sizeof(stagingDesc));
+	stagingDesc.Width = m_sheetWidth;
+	stagingDesc.Height = m_sheetHeight;
+	stagingDesc.ArraySize = 1;
+	stagingDesc.Format = m_compressed ? DXGI_FORMAT_BC4_UNORM : DXGI_FORMAT_R8_UNORM;
+	stagingDesc.SampleDesc.Count = 1;
+	stagingDesc.Usage = D3D11_USAGE_STAGING;
+	stagingDesc.MipLevels = 1;
+	stagingDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+	
+	HRESULT hResult = m_pDevice->CreateTexture2D(&stagingDesc, NULL, &pStagingTexture);
+	if(FAILED(hResult)) {
+		m_lastError = L"Failed to create staging texture for glyph sheet read back";
+	}
+	else {
+		pContext->CopySubresourceRegion(
+			pStagingTexture,
+			0,
+			0,
+			0,
+			0,
+			m_pTexture,
+			D3D11CalcSubresource(0, m_arraySlice, m_mipLevelCount),
+			NULL
+		);
+		
+		D3D11_MAPPED_SUBRESOURCE mappedTexture;
+		hResult = pContext->Map(pStagingTexture, 0, D3D11_MAP_READ, 0, &mappedTexture);
+		if(FAILED(hResult)) {
+			m_lastError = L"Failed to map staging texture for glyph sheet read back";
+		}
+		else {
+			if(m_compressed) {
+				// Each row of the mapped texture is a row of 4x4 blocks
+				for(UINT i=0; i < m_sheetHeight / 4; ++i) {
+					const UINT8 *src = static_cast<const UINT8*>(mappedTexture.pData) + i * mappedTexture.RowPitch;
+					for(UINT j=0; j < m_sheetWidth / 4; ++j)
+						decodeBlock(pPixels + i * 4 * m_sheetWidth + j * 4, m_sheetWidth, src + j * 8);
+				}
+			}
+			else {
+				for(UINT i=0; i < m_sheetHeight; ++i) {
+					const UINT8 *src = static_cast<const UINT8*>(mappedTexture.pData) + i * mappedTexture.RowPitch;
+					memcpy(pPixels + i * m_sheetWidth, src, m_sheetWidth);
+				}
+			}
+			
+			pContext->Unmap(pStagingTexture, 0);
+			
+			hResult = S_OK;
+		}
+		
+		pStagingTexture->Release();
+	}
+	
+	return hResult;
+}
+
+
+// Replace the sheet texture with a BC4 copy of the RAM copy, returns the number of bytes uploaded
+// The old texture is kept if anything fails
+UINT CFW1GlyphSheet::compressTexture() {
+	UINT compressedSize = 0;
+	for(UINT i=0; i < m_mipLevelCount; ++i)
+		compressedSize += (m_sheetWidth >> i) * (m_sheetHeight >> i) / 2;
+	
+	std::vector<UINT8> blocks(compressedSize);
+	D3D11_SUBRESOURCE_DATA initialData[5];// See the mip limit in initGlyphSheet
+	CompressionError error = {0, 0};
+	
+	// Compress every mip-level, the error is measured on the top level only
+	const UINT8 *srcMem = m_textureData;
+	UINT8 *dstMem = &blocks[0];
+	for(UINT i=0; i < m_mipLevelCount; ++i) {
+		UINT mipWidth = m_sheetWidth >> i;
+		UINT mipHeight = m_sheetHeight >> i;
+		
+		compressMipLevel(dstMem, srcMem, mipWidth, mipHeight, (i == 0) ? &error : NULL);
+		
+		initialData[i].pSysMem = dstMem;
+		initialData[i].SysMemPitch = mipWidth / 4 * 8;
+		initialData[i].SysMemSlicePitch = 0;
+		
+		srcMem += mipWidth * mipHeight;
+		dstMem += mipWidth * mipHeight / 2;
+	}
+	
+	// Create the compressed texture
+	D3D11_TEXTURE2D_DESC textureDesc;
+	ID3D11Texture2D *pTexture;
+	
+	ZeroMemory(&textureDesc, sizeof(textureDesc));
+	textureDesc.Width = m_sheetWidth;
+	textureDesc.Height = m_sheetHeight;
+	textureDesc.ArraySize = 1;
+	textureDesc.Format = DXGI_FORMAT_BC4_UNORM;
+	textureDesc.SampleDesc.Count = 1;
+	textureDesc.Usage = D3D11_USAGE_IMMUTABLE;
+	textureDesc.MipLevels = m_mipLevelCount;
+	textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	
+	HRESULT hResult = m_pDevice->CreateTexture2D(&textureDesc, initialData, &pTexture);
+	if(FAILED(hResult)) {
+		m_lastError = L"Failed to create compressed glyph sheet texture";
+		return 0;
+	}
+	
+	ID3D11ShaderResourceView *pTextureSRV;
+	hResult = m_pDevice->CreateShaderResourceView(pTexture, NULL, &pTextureSRV);
+	if(FAILED(hResult)) {
+		m_lastError = L"Failed to create shader resource view for compressed glyph sheet texture";
+		pTexture->Release();
+		return 0;
+	}
+	
+	// Swap in the new texture, GetSheetTexture may be called from other threads
+	EnterCriticalSection(&m_sheetCriticalSection);
+	
+	ID3D11Resource *pOldTexture = m_pTexture;
+	ID3D11ShaderResourceView *pOldTextureSRV = m_pTextureSRV;
+	m_pTexture = pTexture;
+	m_pTextureSRV = pTextureSRV;
+	
+	m_compressed = true;
+	m_compressionError = static_cast<FLOAT>(sqrt(static_cast<double>(error.squaredSum) / (m_sheetWidth * m_sheetHeight)));
+	m_maxCompressionError = error.maxError;
+	
+	LeaveCriticalSection(&m_sheetCriticalSection);
+	
+	pOldTexture->Release();
+	pOldTextureSRV->Release();
+	
+	return compressedSize;
+}
+
+
+// Copy the first channel of count pixels, pixelStride bytes apart, to a row of 8-bit pixels
+void CFW1GlyphSheet::copyPixelRow(UINT8 *dst, const UINT8 *src, UINT count, UINT pixelStride) {
+	if(pixelStride == 1) {
+		memcpy(dst, src, count);
+		return;
+	}
+	
+	UINT j = 0;
+	
+	// 32-bit pixels, as rendered by GDI, are extracted 16 at a time
+	// The last pixel is left to the plain loop, so no bytes past the final pixel's first channel are read
+#if defined(FW1_SSE2)
+	if(pixelStride == 4) {
+		const __m128i channelMask = _mm_set1_epi32(0xff);
+		
+		for(; j + 16 < count; j += 16) {
+			const UINT8 *pixels = src + j*4;
+			
+			__m128i p0 = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels)), channelMask);
+			__m128i p1 = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + 16)), channelMask);
+			__m128i p2 = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + 32)), channelMask);
+			__m128i p3 = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + 48)), channelMask);
+			
+			__m128i packed = _mm_packus_epi16(_mm_packs_epi32(p0, p1), _mm_packs_epi32(p2, p3));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + j), packed);
+		}
+	}
+#elif defined(FW1_NEON)
+	if(pixelStride == 4) {
+		for(; j + 16 < count; j += 16) {
+			uint8x16x4_t pixels = vld4q_u8(src + j*4);
+			vst1q_u8(dst + j, pixels.val[0]);
+		}
+	}
+#endif
+	
+	for(; j < count; ++j)
+		dst[j] = src[j*pixelStride];
+}
+
+
+// Average 2x2 blocks from two source rows into count pixels of the next mip-level, rounding down
+void CFW1GlyphSheet::downsampleRow(UINT8 *dst, const UINT8 *src0, const UINT8 *src1, UINT count) {
+	UINT k = 0;
+	
+	// Sums are taken in 16 bits, so the result matches the plain loop exactly
+#if defined(FW1_SSE2)
+	const __m128i lowMask = _mm_set1_epi16(0xff);
+	
+	for(; k + 16 <= count; k += 16) {
+		__m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src0 + k*2));
+		__m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src0 + k*2 + 16));
+		__m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src1 + k*2));
+		__m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src1 + k*2 + 16));
+		
+		__m128i sum0 = _mm_add_epi16(
+			_mm_add_epi16(_mm_and_si128(a0, lowMask), _mm_srli_epi16(a0, 8)),
+			_mm_add_epi16(_mm_and_si128(b0, lowMask), _mm_srli_epi16(b0, 8))
+		);
+		__m128i sum1 = _mm_add_epi16(
+			_mm_add_epi16(_mm_and_si128(a1, lowMask), _mm_srli_epi16(a1, 8)),
+			_mm_add_epi16(_mm_and_si128(b1, lowMask), _mm_srli_epi16(b1, 8))
+		);
+		
+		__m128i packed = _mm_packus_epi16(_mm_srli_epi16(sum0, 2), _mm_srli_epi16(sum1, 2));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + k), packed);
+	}
+#elif defined(FW1_NEON)
+	for(; k + 16 <= count; k += 16) {
+		uint16x8_t sum0 = vpadalq_u8(vpaddlq_u8(vld1q_u8(src0 + k*2)), vld1q_u8(src1 + k*2));
+		uint16x8_t sum1 = vpadalq_u8(vpaddlq_u8(vld1q_u8(src0 + k*2 + 16)), vld1q_u8(src1 + k*2 + 16));
+		
+		vst1q_u8(dst + k, vcombine_u8(vshrn_n_u16(sum0, 2), vshrn_n_u16(sum1, 2)));
+	}
+#endif
+	
+	for(; k < count; ++k) {
+		UINT src = src0[k*2] + src0[k*2+1] + src1[k*2] + src1[k*2+1];
+		dst[k] = static_cast<UINT8>(src >> 2);
+	}
+}
+
+
+// Compress a mip-level to BC4, 8 bytes per 4x4 block in rows of blocks, and optionally measure the error
+// The width and height must be multiples of 4
+void CFW1GlyphSheet::compressMipLevel(UINT8 *dst, const UINT8 *src, UINT width, UINT height, CompressionError *pError) {
+	UINT blockRowLength = width / 4;
+	UINT8 blockMin[4];
+	UINT8 blockMax[4];
+	
+	for(UINT i=0; i < height / 4; ++i) {
+		const UINT8 *srcRow = src + i * 4 * width;
+		UINT8 *dstRow = dst + i * blockRowLength * 8;
+		
+		for(UINT j=0; j < blockRowLength; j += 4) {
+			UINT blockCount = std::min(blockRowLength - j, 4U);
+			findBlockRanges(blockMin, blockMax, srcRow + j * 4, width, blockCount);
+			
+			for(UINT k=0; k < blockCount; ++k) {
+				UINT8 *block = dstRow + (j + k) * 8;
+				
+				// Most of a sheet is empty, an all-zero block decodes to zero without looking at the pixels
+				if(blockMax[k] == 0)
+					memset(block, 0, 8);
+				else
+					encodeBlock(block, srcRow + (j + k) * 4, width, blockMin[k], blockMax[k], pError);
+			}
+		}
+	}
+}
+
+
+// Find the smallest and largest pixel in each of up to four horizontally adjacent 4x4 blocks
+void CFW1GlyphSheet::findBlockRanges(UINT8 *outMin, UINT8 *outMax, const UINT8 *src, UINT rowPitch, UINT blockCount) {
+	// Four blocks are one 16-byte load per row, reduced to one value per 32-bit lane
+#if defined(FW1_SSE2)
+	if(blockCount == 4) {
+		__m128i r0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+		__m128i r1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + rowPitch));
+		__m128i r2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + rowPitch * 2));
+		__m128i r3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + rowPitch * 3));
+		
+		__m128i minBytes = _mm_min_epu8(_mm_min_epu8(r0, r1), _mm_min_epu8(r2, r3));
+		__m128i maxBytes = _mm_max_epu8(_mm_max_epu8(r0, r1), _mm_max_epu8(r2, r3));
+		minBytes = _mm_min_epu8(minBytes, _mm_srli_epi32(minBytes, 8));
+		minBytes = _mm_min_epu8(minBytes, _mm_srli_epi32(minBytes, 16));
+		maxBytes = _mm_max_epu8(maxBytes, _mm_srli_epi32(maxBytes, 8));
+		maxBytes = _mm_max_epu8(maxBytes, _mm_srli_epi32(maxBytes, 16));
+		
+		// The low byte of each lane holds the result, the four minimums are packed before the four maximums
+		const __m128i laneMask = _mm_set1_epi32(0xff);
+		__m128i packed = _mm_packs_epi32(_mm_and_si128(minBytes, laneMask), _mm_and_si128(maxBytes, laneMask));
+		packed = _mm_packus_epi16(packed, packed);
+		
+		UINT8 ranges[8];
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(ranges), packed);
+		memcpy(outMin, ranges, 4);
+		memcpy(outMax, ranges + 4, 4);
+		return;
+	}
+#elif defined(FW1_NEON)
+	if(blockCount == 4) {
+		uint8x16_t r0 = vld1q_u8(src);
+		uint8x16_t r1 = vld1q_u8(src + rowPitch);
+		uint8x16_t r2 = vld1q_u8(src + rowPitch * 2);
+		uint8x16_t r3 = vld1q_u8(src + rowPitch * 3);
+		
+		uint8x16_t minBytes = vminq_u8(vminq_u8(r0, r1), vminq_u8(r2, r3));
+		uint8x16_t maxBytes = vmaxq_u8(vmaxq_u8(r0, r1), vmaxq_u8(r2, r3));
+		uint8x8_t minPairs = vpmin_u8(vget_low_u8(minBytes), vget_high_u8(minBytes));
+		uint8x8_t maxPairs = vpmax_u8(vget_low_u8(maxBytes), vget_high_u8(maxBytes));
+		minPairs = vpmin_u8(minPairs, minPairs);
+		maxPairs = vpmax_u8(maxPairs, maxPairs);
+		
+		UINT8 ranges[8];
+		vst1_u8(ranges, vext_u8(minPairs, maxPairs, 4));
+		memcpy(outMin, ranges, 4);
+		memcpy(outMax, ranges + 4, 4);
+		return;
+	}
+#endif
+	
+	for(UINT k=0; k < blockCount; ++k) {
+		UINT8 minValue = 255;
+		UINT8 maxValue = 0;
+		for(UINT i=0; i < 4; ++i) {
+			for(UINT j=0; j < 4; ++j) {
+				UINT8 value = src[i * rowPitch + k * 4 + j];
+				minValue = std::min(minValue, value);
+				maxValue = std::max(maxValue, value);
+			}
+		}
+		outMin[k] = minValue;
+		outMax[k] = maxValue;
+	}
+}
+
+
+// Encode one 4x4 block with the largest and smallest pixel as end points, and six values evenly spaced between them
+void CFW1GlyphSheet::encodeBlock(UINT8 *dst, const UINT8 *src, UINT rowPitch, UINT minValue, UINT maxValue, CompressionError *pError) {
+	// A first end point above the second selects the eight value palette
+	dst[0] = static_cast<UINT8>(maxValue);
+	dst[1] = static_cast<UINT8>(minValue);
+	
+	// Flat blocks are all index 0
+	UINT64 indices = 0;
+	if(maxValue > minValue) {
+		// Each pixel is rounded to the nearest seventh of the range, in 16.16 fixed point
+		UINT scale = (7 << 16) / (maxValue - minValue);
+		
+		for(UINT i=0; i < 16; ++i) {
+			UINT value = src[(i / 4) * rowPitch + (i % 4)];
+			UINT step = ((value - minValue) * scale + 0x8000) >> 16;
+			
+			// Index 0 is the maximum, 1 the minimum, and 2 to 7 step down from the maximum
+			UINT index = (step == 7) ? 0 : ((step == 0) ? 1 : 8 - step);
+			indices |= static_cast<UINT64>(index) << (i * 3);
+			
+			if(pError != NULL) {
+				UINT decoded = (step * maxValue + (7 - step) * minValue + 3) / 7;
+				UINT difference = (value > decoded) ? value - decoded : decoded - value;
+				pError->squaredSum += difference * difference;
+				pError->maxError = std::max(pError->maxError, difference);
+			}
+		}
+	}
+	
+	for(UINT i=0; i < 6; ++i)
+		dst[2 + i] = static_cast<UINT8>(indices >> (i * 8));
+}
+
+
+// Decode one BC4 block to 4x4 pixels
+void CFW1GlyphSheet::decodeBlock(UINT8 *dst, UINT dstPitch, const UINT8 *block) {
+	UINT palette[8];
+	palette[0] = block[0];
+	palette[1] = block[1];
+	if(palette[0] > palette[1]) {
+		for(UINT i=2; i < 8; ++i)
+			palette[i] = ((8 - i) * palette[0] + (i - 1) * palette[1] + 3) / 7;
+	}
+	else {
+		for(UINT i=2; i < 6; ++i)
+			palette[i] = ((6 - i) * palette[0] + (i - 1) * palette[1] + 2) / 5;
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+	
+	UINT64 indices = 0;
+	for(UINT i=0; i < 6; ++i)
+		indices |= static_cast<UINT64>(block[2 + i]) << (i * 8);
+	
+	for(UINT i=0; i < 16; ++i)
+		dst[(i / 4) * dstPitch + (i % 4)] = static_cast<UINT8>(palette[(indices >> (i * 3)) & 7]);
+}
+
+
 // Height-range helper class, used to fit glyphs in the sheet
+// The skyline is kept as a list of segments so a search only visits the steps in the skyline, not every column
 
 CFW1GlyphSheet::HeightRange::HeightRange(UINT totalWidth) : m_totalWidth(totalWidth) {
-	m_heights = new UINT[m_totalWidth];
-	ZeroMemory(m_heights, m_totalWidth * sizeof(UINT));
+	Segment segment = {0, m_totalWidth, 0};
+	m_segments.push_back(segment);
 }
 
 CFW1GlyphSheet::HeightRange::~HeightRange() {
-	delete[] m_heights;
 }
 
 UINT CFW1GlyphSheet::HeightRange::findMin(UINT width, UINT *outMin) {
 	if(width > m_totalWidth)
 		width = m_totalWidth;
 	
-	UINT currentMax = findMax(0, width);
-	UINT currentMin = currentMax;
 	UINT minX = 0;
+	UINT currentMin = UINT_MAX;
 	
-	for(UINT i=1; i < m_totalWidth-width; ++i) {
-		if(m_heights[i+width-1] >= currentMax)
-			currentMax = m_heights[i+width-1];
-		else if(m_heights[i-1] == currentMax) {
-			currentMax = findMax(i, width);
-			if(currentMax < currentMin) {
-				currentMin = currentMax;
-				minX = i;
-			}
+	// Try each segment start as the left edge, the highest segment under the span is where the glyph rests
+	for(size_t i=0; i < m_segments.size(); ++i) {
+		UINT startX = m_segments[i].x;
+		if(startX > 0 && startX + width >= m_totalWidth)
+			break;
+		
+		UINT endX = startX + width;
+		UINT currentMax = 0;
+		for(size_t j=i; j < m_segments.size() && m_segments[j].x < endX; ++j) {
+			currentMax = std::max(currentMax, m_segments[j].height);
+			if(currentMax >= currentMin)
+				break;
+		}
+		
+		if(currentMax < currentMin) {
+			currentMin = currentMax;
+			minX = startX;
 		}
 	}
 	
@@ -258,17 +817,47 @@ UINT CFW1GlyphSheet::HeightRange::findMin(UINT width, UINT *outMin) {
 void CFW1GlyphSheet::HeightRange::update(UINT startX, UINT width, UINT newHeight) {
 	if(width > m_totalWidth)
 		width = m_totalWidth;
+	UINT endX = std::min(startX + width, m_totalWidth);
 	
-	for(UINT i=0; i < width; ++i)
-		m_heights[startX+i] = newHeight;
-}
-
-UINT CFW1GlyphSheet::HeightRange::findMax(UINT startX, UINT width) {
-	UINT currentMax = m_heights[startX];
-	for(UINT i=1; i < width; ++i)
-		currentMax = std::max(currentMax, m_heights[startX+i]);
+	// Split the segment the new one starts in
+	size_t first = 0;
+	while(first < m_segments.size() && m_segments[first].x + m_segments[first].width <= startX)
+		++first;
 	
-	return currentMax;
+	if(first < m_segments.size() && m_segments[first].x < startX) {
+		Segment left = m_segments[first];
+		left.width = startX - left.x;
+		
+		m_segments[first].x = startX;
+		m_segments[first].width -= left.width;
+		m_segments.insert(m_segments.begin() + first, left);
+		++first;
+	}
+	
+	// Drop the segments that are covered and trim the one the new segment ends in
+	size_t last = first;
+	while(last < m_segments.size() && m_segments[last].x + m_segments[last].width <= endX)
+		++last;
+	
+	if(last < m_segments.size() && m_segments[last].x < endX) {
+		m_segments[last].width -= endX - m_segments[last].x;
+		m_segments[last].x = endX;
+	}
+	
+	m_segments.erase(m_segments.begin() + first, m_segments.begin() + last);
+	
+	Segment segment = {startX, endX - startX, newHeight};
+	m_segments.insert(m_segments.begin() + first, segment);
+	
+	// Merge with neighbours of the same height to keep the list short
+	if(first + 1 < m_segments.size() && m_segments[first + 1].height == newHeight) {
+		m_segments[first].width += m_segments[first + 1].width;
+		m_segments.erase(m_segments.begin() + first + 1);
+	}
+	if(first > 0 && m_segments[first - 1].height == newHeight) {
+		m_segments[first - 1].width += m_segments[first].width;
+		m_segments.erase(m_segments.begin() + first);
+	}
 }
 
 
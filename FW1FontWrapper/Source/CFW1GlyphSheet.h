@@ -33,6 +33,15 @@ class CFW1GlyphSheet : public CFW1Object<IFW1GlyphSheet> {
 		);
 		virtual void STDMETHODCALLTYPE CloseSheet();
 		virtual void STDMETHODCALLTYPE Flush(ID3D11DeviceContext *pContext);
+		virtual UINT STDMETHODCALLTYPE InsertGlyphAlias(UINT SourceGlyphIndex, FLOAT Scale);
+		virtual HRESULT STDMETHODCALLTYPE GetSheetPixels(ID3D11DeviceContext *pContext, void *pPixels);
+		virtual HRESULT STDMETHODCALLTYPE SetSheetContents(
+			const void *pPixels,
+			UINT RowCount,
+			const FW1_GLYPHCOORDS *pGlyphCoords,
+			UINT GlyphCount
+		);
+		virtual HRESULT STDMETHODCALLTYPE SetCompression(BOOL Compress);
 	
 	// Public functions
 	public:
@@ -46,9 +55,16 @@ class CFW1GlyphSheet : public CFW1Object<IFW1GlyphSheet> {
 			bool coordBuffer,
 			bool allowOversizedGlyph,
 			UINT maxGlyphCount,
-			UINT mipLevelCount
+			UINT mipLevelCount,
+			ID3D11ShaderResourceView *pArrayTextureSRV,
+			ID3D11ShaderResourceView *pArrayCoordSRV,
+			UINT arraySlice
 		);
 	
+	// Headless tests and benchmarks, see FW1Tests
+	private:
+		friend class CFW1GlyphSheetTest;
+	
 	// Internal types
 	private:
 		struct RectUI {
@@ -58,6 +74,16 @@ class CFW1GlyphSheet : public CFW1Object<IFW1GlyphSheet> {
 			UINT					bottom;
 		};
 		
+		// Difference between the compressed and original pixels of a mip-level
+		struct CompressionError {
+			UINT64					squaredSum;
+			UINT					maxError;
+		};
+		
+		// Regions kept apart in the dirty list, further regions are merged into the closest one
+		static const UINT MaxDirtyRects = 8;
+		
+		// Skyline of the filled part of the sheet, stored as segments of equal height
 		class HeightRange {
 			public:
 				HeightRange(UINT totalWidth);
@@ -71,10 +97,14 @@ class CFW1GlyphSheet : public CFW1Object<IFW1GlyphSheet> {
 				HeightRange(const HeightRange&);
 				HeightRange& operator=(const HeightRange&);
 				
-				UINT findMax(UINT startX, UINT width);
+				struct Segment {
+					UINT				x;
+					UINT				width;
+					UINT				height;
+				};
 				
-				UINT				*m_heights;
-				UINT				m_totalWidth;
+				std::vector<Segment>	m_segments;
+				UINT					m_totalWidth;
 		};
 		
 		class CriticalSectionLock {
@@ -99,6 +129,22 @@ class CFW1GlyphSheet : public CFW1Object<IFW1GlyphSheet> {
 		virtual ~CFW1GlyphSheet();
 		
 		HRESULT createDeviceResources();
+		HRESULT useArraySlice(
+			ID3D11ShaderResourceView *pArrayTextureSRV,
+			ID3D11ShaderResourceView *pArrayCoordSRV,
+			UINT arraySlice
+		);
+		void addDirtyRect(const RectUI &rect);
+		UINT updateTextureRect(ID3D11DeviceContext *pContext, const RectUI &rect);
+		HRESULT readBackTexture(ID3D11DeviceContext *pContext, UINT8 *pPixels);
+		UINT compressTexture();
+		
+		static void copyPixelRow(UINT8 *dst, const UINT8 *src, UINT count, UINT pixelStride);
+		static void downsampleRow(UINT8 *dst, const UINT8 *src0, const UINT8 *src1, UINT count);
+		static void compressMipLevel(UINT8 *dst, const UINT8 *src, UINT width, UINT height, CompressionError *pError);
+		static void findBlockRanges(UINT8 *outMin, UINT8 *outMax, const UINT8 *src, UINT rowPitch, UINT blockCount);
+		static void encodeBlock(UINT8 *dst, const UINT8 *src, UINT rowPitch, UINT minValue, UINT maxValue, CompressionError *pError);
+		static void decodeBlock(UINT8 *dst, UINT dstPitch, const UINT8 *block);
 	
 	// Internal data
 	private:
@@ -118,18 +164,30 @@ class CFW1GlyphSheet : public CFW1Object<IFW1GlyphSheet> {
 		
 		ID3D11Device				*m_pDevice;
 		
-		ID3D11Texture2D				*m_pTexture;
+		ID3D11Resource				*m_pTexture;
 		ID3D11ShaderResourceView	*m_pTextureSRV;
-		ID3D11Buffer				*m_pCoordBuffer;
+		ID3D11Resource				*m_pCoordBuffer;
 		ID3D11ShaderResourceView	*m_pCoordBufferSRV;
+		bool						m_isArraySlice;
+		UINT						m_arraySlice;
 		
 		bool						m_closed;
 		bool						m_static;
 		
+		bool						m_compress;
+		bool						m_compressed;
+		FLOAT						m_compressionError;
+		UINT						m_maxCompressionError;
+		
 		HeightRange					*m_heightRange;
+		UINT						m_usedArea;
+		UINT						m_packedHeight;
 		
 		UINT						m_updatedGlyphCount;
-		RectUI						m_dirtyRect;
+		RectUI						m_dirtyRects[MaxDirtyRects];
+		UINT						m_dirtyRectCount;
+		UINT						m_lastFlushBytes;
+		UINT64						m_totalFlushBytes;
 		CRITICAL_SECTION			m_sheetCriticalSection;
 		CRITICAL_SECTION			m_flushCriticalSection;
 };
@@ -41,6 +41,26 @@ void STDMETHODCALLTYPE CFW1GlyphSheet::GetDesc(FW1_GLYPHSHEETDESC *pDesc) {
 	pDesc->Width = m_sheetWidth;
 	pDesc->Height = m_sheetHeight;
 	pDesc->MipLevels = m_mipLevelCount;
+	
+	UINT textureBytes = 0;
+	for(UINT i=0; i < m_mipLevelCount; ++i)
+		textureBytes += (m_sheetWidth >> i) * (m_sheetHeight >> i);
+	
+	EnterCriticalSection(&m_sheetCriticalSection);
+	pDesc->UsedArea = m_usedArea;
+	pDesc->PackedHeight = m_packedHeight;
+	LeaveCriticalSection(&m_sheetCriticalSection);
+	
+	EnterCriticalSection(&m_flushCriticalSection);
+	pDesc->LastFlushBytes = m_lastFlushBytes;
+	pDesc->TotalFlushBytes = m_totalFlushBytes;
+	
+	// BC4 stores a 4x4 block in 8 bytes
+	pDesc->Compressed = m_compressed ? TRUE : FALSE;
+	pDesc->TextureBytes = m_compressed ? textureBytes / 2 : textureBytes;
+	pDesc->CompressionError = m_compressionError;
+	pDesc->MaxCompressionError = m_maxCompressionError;
+	LeaveCriticalSection(&m_flushCriticalSection);
 }
 
 
@@ -49,8 +69,11 @@ HRESULT STDMETHODCALLTYPE CFW1GlyphSheet::GetSheetTexture(ID3D11ShaderResourceVi
 	if(ppSheetTextureSRV == NULL)
 		return E_INVALIDARG;
 	
+	// Flush swaps in a new texture when compressing the sheet
+	EnterCriticalSection(&m_sheetCriticalSection);
 	m_pTextureSRV->AddRef();
 	*ppSheetTextureSRV = m_pTextureSRV;
+	LeaveCriticalSection(&m_sheetCriticalSection);
 	
 	return S_OK;
 }
@@ -80,6 +103,8 @@ HRESULT STDMETHODCALLTYPE CFW1GlyphSheet::BindSheet(ID3D11DeviceContext *pContex
 	pContext->PSSetShaderResources(0, 1, &m_pTextureSRV);
 	if((Flags & FW1_NOGEOMETRYSHADER) == 0 && m_hardwareCoordBuffer)
 		pContext->GSSetShaderResources(0, 1, &m_pCoordBufferSRV);
+	if((Flags & FW1_VERTEXPULLING) != 0 && m_hardwareCoordBuffer)
+		pContext->VSSetShaderResources(0, 1, &m_pCoordBufferSRV);
 	
 	return S_OK;
 }
@@ -143,6 +168,10 @@ UINT STDMETHODCALLTYPE CFW1GlyphSheet::InsertGlyph(
 	
 	m_heightRange->update(blockX, blockWidth, blockY + blockHeight);
 	
+	// Packing statistics
+	m_usedArea += width * height;
+	m_packedHeight = std::min(std::max(m_packedHeight, positionY + height + m_alignWidth), m_sheetHeight);
+	
 	// Store glyph coordinates
 	FLOAT coordOffset = static_cast<FLOAT>(m_alignWidth) * 0.5f;
 	
@@ -166,26 +195,21 @@ UINT STDMETHODCALLTYPE CFW1GlyphSheet::InsertGlyph(
 	m_glyphCoords[glyphIndex] = glyphCoords;
 	
 	// Glyph pixels
+	UINT rowLength = std::min(width, m_sheetWidth-positionX);
 	for(UINT i=0; i < height && i < m_sheetHeight-positionY; ++i) {
 		const UINT8 *src = static_cast<const UINT8*>(pGlyphData) + i*RowPitch;
 		UINT8 *dst = m_textureData + (positionY+i)*m_sheetWidth + positionX;
-		for(UINT j=0; j < width && j < m_sheetWidth-positionX; ++j)
-			dst[j] = src[j*PixelStride];
+		copyPixelRow(dst, src, rowLength, PixelStride);
 	}
 	
-	// Update dirty rect to be flushed to device texture
-	if(m_updatedGlyphCount == 0) {
-		m_dirtyRect.left = positionX - m_alignWidth;
-		m_dirtyRect.top = positionY - m_alignWidth;
-		m_dirtyRect.right = std::min(positionX + width + m_alignWidth, m_sheetWidth);
-		m_dirtyRect.bottom = std::min(positionY + height + m_alignWidth, m_sheetHeight);
-	}
-	else {
-		m_dirtyRect.left = std::min(m_dirtyRect.left, positionX - m_alignWidth);
-		m_dirtyRect.top = std::min(m_dirtyRect.top, positionY - m_alignWidth);
-		m_dirtyRect.right = std::min(std::max(m_dirtyRect.right, positionX + width + m_alignWidth), m_sheetWidth);
-		m_dirtyRect.bottom = std::min(std::max(m_dirtyRect.bottom, positionY + height + m_alignWidth), m_sheetHeight);
-	}
+	// Add the glyph block to the regions to be flushed to device texture
+	// The block is aligned to the mip alignment so each mip-level of the region covers it exactly
+	RectUI glyphRect;
+	glyphRect.left = positionX - m_alignWidth;
+	glyphRect.top = positionY - m_alignWidth;
+	glyphRect.right = std::min(positionX + alignedWidth + m_alignWidth, m_sheetWidth);
+	glyphRect.bottom = std::min(positionY + alignedHeight + m_alignWidth, m_sheetHeight);
+	addDirtyRect(glyphRect);
 	
 	_WriteBarrier();
 	MemoryBarrier();
@@ -208,11 +232,19 @@ void STDMETHODCALLTYPE CFW1GlyphSheet::CloseSheet() {
 // Flush any inserted glyphs
 void STDMETHODCALLTYPE CFW1GlyphSheet::Flush(ID3D11DeviceContext *pContext) {
 	EnterCriticalSection(&m_flushCriticalSection);
-	if(!m_static) {
+	m_lastFlushBytes = 0;
+	
+	// Static sheets can still get glyph aliases, which only update the coord buffer
+	if(!m_static || m_updatedGlyphCount > 0) {
 		EnterCriticalSection(&m_sheetCriticalSection);
 		
 		UINT glyphCount = m_glyphCount;
-		RectUI dirtyRect = m_dirtyRect;
+		
+		RectUI dirtyRects[MaxDirtyRects];
+		UINT dirtyRectCount = m_dirtyRectCount;
+		for(UINT i=0; i < dirtyRectCount; ++i)
+			dirtyRects[i] = m_dirtyRects[i];
+		m_dirtyRectCount = 0;
 		
 		UINT updatedGlyphCount = m_updatedGlyphCount;
 		m_updatedGlyphCount = 0;
@@ -222,6 +254,7 @@ void STDMETHODCALLTYPE CFW1GlyphSheet::Flush(ID3D11DeviceContext *pContext) {
 		
 		LeaveCriticalSection(&m_sheetCriticalSection);
 		
+		UINT flushBytes = 0;
 		if(updatedGlyphCount > 0) {
 			// Update coord buffer
 			if(m_hardwareCoordBuffer) {
@@ -230,10 +263,19 @@ void STDMETHODCALLTYPE CFW1GlyphSheet::Flush(ID3D11DeviceContext *pContext) {
 				
 				D3D11_BOX dstBox;
 				ZeroMemory(&dstBox, sizeof(dstBox));
-				dstBox.left = startIndex * sizeof(FW1_GLYPHCOORDS);
-				dstBox.right = endIndex * sizeof(FW1_GLYPHCOORDS);
-				dstBox.top = 0;
-				dstBox.bottom = 1;
+				if(m_isArraySlice) {
+					// One row of two float4 texels per glyph in the atlas coord texture
+					dstBox.left = startIndex * 2;
+					dstBox.right = endIndex * 2;
+					dstBox.top = m_arraySlice;
+					dstBox.bottom = m_arraySlice + 1;
+				}
+				else {
+					dstBox.left = startIndex * sizeof(FW1_GLYPHCOORDS);
+					dstBox.right = endIndex * sizeof(FW1_GLYPHCOORDS);
+					dstBox.top = 0;
+					dstBox.bottom = 1;
+				}
 				dstBox.front = 0;
 				dstBox.back = 1;
 				
@@ -245,58 +287,21 @@ void STDMETHODCALLTYPE CFW1GlyphSheet::Flush(ID3D11DeviceContext *pContext) {
 					0,
 					0
 				);
+				flushBytes += (endIndex - startIndex) * sizeof(FW1_GLYPHCOORDS);
 			}
 			
-			// Update texture
-			if(dirtyRect.right > dirtyRect.left && dirtyRect.bottom > dirtyRect.top) {
-				UINT8 *srcMem = m_textureData;
-				
-				D3D11_BOX dstBox;
-				ZeroMemory(&dstBox, sizeof(dstBox));
-				dstBox.left = dirtyRect.left;
-				dstBox.right = dirtyRect.right;
-				dstBox.top = dirtyRect.top;
-				dstBox.bottom = dirtyRect.bottom;
-				dstBox.front = 0;
-				dstBox.back = 1;
-				
-				// Update each mip-level
-				for(UINT i=0; i < m_mipLevelCount; ++i) {
-					pContext->UpdateSubresource(
-						m_pTexture,
-						D3D11CalcSubresource(i, 0, m_mipLevelCount),
-						&dstBox,
-						srcMem + dstBox.top * (m_sheetWidth >> i) + dstBox.left,
-						m_sheetWidth >> i,
-						0
-					);
-					
-					if(i+1 < m_mipLevelCount) {
-						UINT8 *nextMip = srcMem + (m_sheetWidth >> i) * (m_sheetHeight >> i);
-						
-						dstBox.left >>= 1;
-						dstBox.right >>= 1;
-						dstBox.top >>= 1;
-						dstBox.bottom >>= 1;
-						
-						// Calculate the next mip-level for the current dirty-rect
-						for(UINT j = dstBox.top; j < dstBox.bottom; ++j) {
-							const UINT8 *src0 = srcMem + j * 2 * (m_sheetWidth >> i);
-							const UINT8 *src1 = src0 + (m_sheetWidth >> i);
-							UINT8 *dst = nextMip + j * (m_sheetWidth >> (i+1));
-							
-							for(UINT k = dstBox.left; k < dstBox.right; ++k) {
-								UINT src = src0[k*2] + src0[k*2+1] + src1[k*2] + src1[k*2+1];
-								dst[k] = static_cast<UINT8>(src >> 2);
-							}
-						}
-						
-						srcMem = nextMip;
-					}
-				}
-			}
+			// Update texture, one region at a time
+			for(UINT i=0; i < dirtyRectCount; ++i)
+				flushBytes += updateTextureRect(pContext, dirtyRects[i]);
 		}
 		
+		// The RAM copy now holds every mip-level of the finished sheet
+		if(m_static && m_compress && !m_compressed && m_textureData != 0)
+			flushBytes += compressTexture();
+		
+		m_lastFlushBytes = flushBytes;
+		m_totalFlushBytes += flushBytes;
+		
 		// This sheet is now static, save some memory
 		if(m_static) {
 			delete[] m_textureData;
@@ -308,4 +313,124 @@ void STDMETHODCALLTYPE CFW1GlyphSheet::Flush(ID3D11DeviceContext *pContext) {
 }
 
 
+// Insert a glyph reusing the image of another glyph at a different scale
+UINT STDMETHODCALLTYPE CFW1GlyphSheet::InsertGlyphAlias(UINT SourceGlyphIndex, FLOAT Scale) {
+	CriticalSectionLock lock(&m_sheetCriticalSection);
+	
+	if(SourceGlyphIndex >= m_glyphCount)
+		return 0xffffffff;
+	if(m_glyphCount >= m_maxGlyphCount)
+		return 0xffffffff;
+	
+	// Same texels, the quad is scaled around the glyph origin
+	FW1_GLYPHCOORDS glyphCoords = m_glyphCoords[SourceGlyphIndex];
+	glyphCoords.PositionLeft *= Scale;
+	glyphCoords.PositionTop *= Scale;
+	glyphCoords.PositionRight *= Scale;
+	glyphCoords.PositionBottom *= Scale;
+	
+	UINT glyphIndex = m_glyphCount;
+	
+	m_glyphCoords[glyphIndex] = glyphCoords;
+	
+	_WriteBarrier();
+	MemoryBarrier();
+	
+	++m_glyphCount;
+	++m_updatedGlyphCount;
+	
+	return glyphIndex;
+}
+
+
+// Copy the top mip-level of the sheet texture, from the RAM copy if it has not been released
+HRESULT STDMETHODCALLTYPE CFW1GlyphSheet::GetSheetPixels(ID3D11DeviceContext *pContext, void *pPixels) {
+	if(pContext == NULL || pPixels == NULL)
+		return E_INVALIDARG;
+	
+	HRESULT hResult = S_OK;
+	
+	// Flush releases the RAM copy of a closed sheet
+	EnterCriticalSection(&m_flushCriticalSection);
+	
+	if(m_textureData != 0) {
+		EnterCriticalSection(&m_sheetCriticalSection);
+		memcpy(pPixels, m_textureData, m_sheetWidth * m_sheetHeight);
+		LeaveCriticalSection(&m_sheetCriticalSection);
+	}
+	else
+		hResult = readBackTexture(pContext, static_cast<UINT8*>(pPixels));
+	
+	LeaveCriticalSection(&m_flushCriticalSection);
+	
+	return hResult;
+}
+
+
+// Fill an empty sheet with saved glyphs and close it
+HRESULT STDMETHODCALLTYPE CFW1GlyphSheet::SetSheetContents(
+	const void *pPixels,
+	UINT RowCount,
+	const FW1_GLYPHCOORDS *pGlyphCoords,
+	UINT GlyphCount
+) {
+	if((pPixels == NULL && RowCount > 0) || (pGlyphCoords == NULL && GlyphCount > 0))
+		return E_INVALIDARG;
+	if(RowCount > m_sheetHeight || GlyphCount > m_maxGlyphCount)
+		return E_INVALIDARG;
+	
+	CriticalSectionLock lock(&m_sheetCriticalSection);
+	
+	if(m_glyphCount > 0 || m_closed || m_textureData == 0)
+		return E_FAIL;
+	
+	if(RowCount > 0)
+		memcpy(m_textureData, pPixels, m_sheetWidth * RowCount);
+	for(UINT i=0; i < GlyphCount; ++i)
+		m_glyphCoords[i] = pGlyphCoords[i];
+	
+	// Upload the filled rows rounded up to the mip alignment, so every mip-level is calculated from them
+	m_packedHeight = std::min((RowCount + m_alignWidth - 1) / m_alignWidth * m_alignWidth, m_sheetHeight);
+	if(m_packedHeight > 0) {
+		RectUI filledRect;
+		filledRect.left = 0;
+		filledRect.top = 0;
+		filledRect.right = m_sheetWidth;
+		filledRect.bottom = m_packedHeight;
+		addDirtyRect(filledRect);
+	}
+	
+	// The free space around the saved glyphs is not known, so the sheet takes no new glyphs
+	m_closed = true;
+	
+	_WriteBarrier();
+	MemoryBarrier();
+	
+	m_glyphCount = GlyphCount;
+	m_updatedGlyphCount = GlyphCount;
+	
+	return S_OK;
+}
+
+
+// Compress the sheet texture when the sheet becomes static
+HRESULT STDMETHODCALLTYPE CFW1GlyphSheet::SetCompression(BOOL Compress) {
+	// Slices share the format of the atlas texture array, and every mip-level must be whole 4x4 blocks
+	if(Compress != FALSE) {
+		if(m_isArraySlice)
+			return E_FAIL;
+		
+		UINT blockAlign = 4 << (m_mipLevelCount - 1);
+		if((m_sheetWidth % blockAlign) != 0 || (m_sheetHeight % blockAlign) != 0)
+			return E_FAIL;
+	}
+	
+	EnterCriticalSection(&m_flushCriticalSection);
+	m_compress = (Compress != FALSE);
+	LeaveCriticalSection(&m_flushCriticalSection);
+	
+	return S_OK;
+}
+
+
 }// namespace FW1FontWrapper
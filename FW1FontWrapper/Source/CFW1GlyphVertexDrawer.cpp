@@ -17,7 +17,13 @@ CFW1GlyphVertexDrawer::CFW1GlyphVertexDrawer() :
 	m_pVertexBuffer(NULL),
 	m_pIndexBuffer(NULL),
 	m_vertexBufferSize(0),
-	m_maxIndexCount(0)
+	m_maxIndexCount(0),
+	m_vertexBufferOffset(0),
+	
+	m_pGlyphBuffer(NULL),
+	m_pGlyphBufferSRV(NULL),
+	m_glyphBufferOffset(0),
+	m_glyphBufferNoOverwrite(false)
 {
 }
 
@@ -28,6 +34,9 @@ CFW1GlyphVertexDrawer::~CFW1GlyphVertexDrawer() {
 	
 	SAFE_RELEASE(m_pVertexBuffer);
 	SAFE_RELEASE(m_pIndexBuffer);
+	
+	SAFE_RELEASE(m_pGlyphBuffer);
+	SAFE_RELEASE(m_pGlyphBufferSRV);
 }
 
 
@@ -59,6 +68,10 @@ HRESULT CFW1GlyphVertexDrawer::initVertexDrawer(
 	if(m_maxIndexCount < 64)
 		m_maxIndexCount = 64;
 	
+	// Start full, so the first upload discards
+	m_vertexBufferOffset = m_vertexBufferSize;
+	m_glyphBufferOffset = m_vertexBufferSize;
+	
 	// Create device buffers
 	hResult = createBuffers();
 	
@@ -127,20 +140,115 @@ HRESULT CFW1GlyphVertexDrawer::createBuffers() {
 			pVertexBuffer->Release();
 	}
 	
+	// Create glyph buffer for vertex pulling, read as a typed buffer since structured buffers need feature level 11
+	if(SUCCEEDED(hResult) && m_pDevice->GetFeatureLevel() >= D3D_FEATURE_LEVEL_10_0) {
+		UINT glyphCount = m_vertexBufferSize / sizeof(FW1_GLYPHVERTEX);
+		
+		D3D11_BUFFER_DESC glyphBufferDesc;
+		ID3D11Buffer *pGlyphBuffer;
+		
+		ZeroMemory(&glyphBufferDesc, sizeof(glyphBufferDesc));
+		glyphBufferDesc.ByteWidth = glyphCount * sizeof(FW1_GLYPHVERTEX);
+		glyphBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+		glyphBufferDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		glyphBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		
+		hResult = m_pDevice->CreateBuffer(&glyphBufferDesc, NULL, &pGlyphBuffer);
+		if(FAILED(hResult)) {
+			m_lastError = L"Failed to create glyph buffer";
+		}
+		else {
+			D3D11_SHADER_RESOURCE_VIEW_DESC bufferSRVDesc;
+			ID3D11ShaderResourceView *pGlyphBufferSRV;
+			
+			ZeroMemory(&bufferSRVDesc, sizeof(bufferSRVDesc));
+			bufferSRVDesc.Format = DXGI_FORMAT_R32G32B32A32_UINT;
+			bufferSRVDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+			bufferSRVDesc.Buffer.ElementOffset = 0;
+			bufferSRVDesc.Buffer.ElementWidth = glyphCount;
+			
+			hResult = m_pDevice->CreateShaderResourceView(pGlyphBuffer, &bufferSRVDesc, &pGlyphBufferSRV);
+			if(FAILED(hResult)) {
+				m_lastError = L"Failed to create shader resource view for glyph buffer";
+				
+				pGlyphBuffer->Release();
+			}
+			else {
+				m_pGlyphBuffer = pGlyphBuffer;
+				m_pGlyphBufferSRV = pGlyphBufferSRV;
+				
+				// Appending to a buffer bound as a shader-resource needs the D3D11.1 runtime
+				// Headers older than the Windows 8 SDK lack the query, so the glyph buffer is always discarded there
+#ifdef D3D11_1_UAV_SLOT_COUNT
+				D3D11_FEATURE_DATA_D3D11_OPTIONS options;
+				ZeroMemory(&options, sizeof(options));
+				if(SUCCEEDED(m_pDevice->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))))
+					m_glyphBufferNoOverwrite = (options.MapNoOverwriteOnDynamicBufferSRV != FALSE);
+#endif
+			}
+		}
+	}
+	
 	return hResult;
 }
 
 
-// Draw vertices
+// Map space for elements in a dynamic buffer used as a ring, appending after earlier uploads and only discarding when full
+// A discard hands the buffer to the driver to rename, so ranges still in use by queued draws are never overwritten
+HRESULT CFW1GlyphVertexDrawer::mapBufferRange(
+	ID3D11DeviceContext *pContext,
+	ID3D11Buffer *pBuffer,
+	UINT &bufferOffset,
+	bool noOverwrite,
+	UINT elementSize,
+	UINT elementCount,
+	void **ppData,
+	UINT *pFirstElement
+) {
+	// Deferred contexts record their own buffer contents, so they always start from a discard
+	if(pContext->GetType() != D3D11_DEVICE_CONTEXT_IMMEDIATE)
+		noOverwrite = false;
+	
+	// The buffer may hold elements of another size from a different draw path, so round up to this one
+	UINT firstElement = (bufferOffset + elementSize - 1) / elementSize;
+	D3D11_MAP mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+	if(!noOverwrite || firstElement + elementCount > m_vertexBufferSize / elementSize) {
+		firstElement = 0;
+		mapType = D3D11_MAP_WRITE_DISCARD;
+	}
+	
+	D3D11_MAPPED_SUBRESOURCE msr;
+	HRESULT hResult = pContext->Map(pBuffer, 0, mapType, 0, &msr);
+	if(SUCCEEDED(hResult)) {
+		*ppData = static_cast<UINT8*>(msr.pData) + firstElement * elementSize;
+		*pFirstElement = firstElement;
+		
+		bufferOffset = (firstElement + elementCount) * elementSize;
+		if(!noOverwrite)
+			bufferOffset = m_vertexBufferSize;
+	}
+	
+	return hResult;
+}
+
+
+// Draw vertices, as points for the geometry shader or as six vertices per glyph for the vertex shader to expand
 UINT CFW1GlyphVertexDrawer::drawVertices(
 	ID3D11DeviceContext *pContext,
 	IFW1GlyphAtlas *pGlyphAtlas,
 	const FW1_VERTEXDATA *vertexData,
-	UINT preboundSheet
+	UINT preboundSheet,
+	bool vertexPulling
 ) {
 	if(vertexData->SheetCount == 0 || vertexData->TotalVertexCount == 0)
 		return preboundSheet;
 	
+	ID3D11Buffer *pBuffer = vertexPulling ? m_pGlyphBuffer : m_pVertexBuffer;
+	UINT &bufferOffset = vertexPulling ? m_glyphBufferOffset : m_vertexBufferOffset;
+	bool noOverwrite = vertexPulling ? m_glyphBufferNoOverwrite : true;
+	UINT bindFlags = vertexPulling ? (FW1_NOGEOMETRYSHADER | FW1_VERTEXPULLING) : 0;
+	UINT verticesPerGlyph = vertexPulling ? 6 : 1;
+	
 	UINT maxVertexCount = m_vertexBufferSize / sizeof(FW1_GLYPHVERTEX);
 	
 	UINT currentSheet = 0;
@@ -152,12 +260,13 @@ UINT CFW1GlyphVertexDrawer::drawVertices(
 		// Fill the vertex buffer
 		UINT vertexCount = std::min(vertexData->TotalVertexCount - currentVertex, maxVertexCount);
 		
-		D3D11_MAPPED_SUBRESOURCE msr;
-		HRESULT hResult = pContext->Map(m_pVertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &msr);
+		void *pBufferData;
+		UINT firstVertex;
+		HRESULT hResult = mapBufferRange(pContext, pBuffer, bufferOffset, noOverwrite, sizeof(FW1_GLYPHVERTEX), vertexCount, &pBufferData, &firstVertex);
 		if(SUCCEEDED(hResult)) {
-			CopyMemory(msr.pData, vertexData->pVertices + currentVertex, vertexCount * sizeof(FW1_GLYPHVERTEX));
+			CopyMemory(pBufferData, vertexData->pVertices + currentVertex, vertexCount * sizeof(FW1_GLYPHVERTEX));
 			
-			pContext->Unmap(m_pVertexBuffer, 0);
+			pContext->Unmap(pBuffer, 0);
 			
 			// Draw all glyphs in the buffer
 			UINT drawnVertices = 0;
@@ -169,12 +278,12 @@ UINT CFW1GlyphVertexDrawer::drawVertices(
 				
 				if(currentSheet != activeSheet) {
 					// Bind sheet shader resources
-					pGlyphAtlas->BindSheet(pContext, currentSheet, 0);
+					pGlyphAtlas->BindSheet(pContext, currentSheet, bindFlags);
 					activeSheet = currentSheet;
 				}
 				
 				UINT drawCount = std::min(vertexCount - drawnVertices, nextSheetStart - currentVertex);
-				pContext->Draw(drawCount, drawnVertices);
+				pContext->Draw(drawCount * verticesPerGlyph, (firstVertex + drawnVertices) * verticesPerGlyph);
 				
 				drawnVertices += drawCount;
 				currentVertex += drawCount;
@@ -216,10 +325,11 @@ UINT CFW1GlyphVertexDrawer::drawGlyphsAsQuads(
 		// Fill the vertex buffer
 		UINT vertexCount = std::min((vertexData->TotalVertexCount - currentVertex) * 4, maxVertexCount);
 		
-		D3D11_MAPPED_SUBRESOURCE msr;
-		HRESULT hResult = pContext->Map(m_pVertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &msr);
+		void *pBufferData;
+		UINT firstVertex;
+		HRESULT hResult = mapBufferRange(pContext, m_pVertexBuffer, m_vertexBufferOffset, true, sizeof(QuadVertex), vertexCount, &pBufferData, &firstVertex);
 		if(SUCCEEDED(hResult)) {
-			QuadVertex *bufferVertices = static_cast<QuadVertex*>(msr.pData);
+			QuadVertex *bufferVertices = static_cast<QuadVertex*>(pBufferData);
 			
 			// Convert to quads when filling the buffer
 			UINT savedCurrentSheet = currentSheet;
@@ -297,7 +407,7 @@ UINT CFW1GlyphVertexDrawer::drawGlyphsAsQuads(
 				}
 				
 				UINT drawCount = std::min(vertexCount - drawnVertices, (nextSheetStart - currentVertex) * 4);
-				pContext->DrawIndexed((drawCount/2)*3, 0, drawnVertices);
+				pContext->DrawIndexed((drawCount/2)*3, 0, firstVertex + drawnVertices);
 				
 				drawnVertices += drawCount;
 				currentVertex += drawCount / 4;
@@ -311,4 +421,92 @@ UINT CFW1GlyphVertexDrawer::drawGlyphsAsQuads(
 }
 
 
+// Draw vertices with full atlas IDs as quads, using a texture-array atlas
+UINT CFW1GlyphVertexDrawer::drawGlyphsAsArrayQuads(
+	ID3D11DeviceContext *pContext,
+	IFW1GlyphAtlas *pGlyphAtlas,
+	const FW1_VERTEXDATA *vertexData,
+	UINT preboundSheet
+) {
+	if(vertexData->TotalVertexCount == 0)
+		return preboundSheet;
+	
+	UINT maxVertexCount = m_vertexBufferSize / sizeof(QuadVertex);
+	if(maxVertexCount > 4 * (m_maxIndexCount / 6))
+		maxVertexCount = 4 * (m_maxIndexCount / 6);
+	if(maxVertexCount % 4 != 0)
+		maxVertexCount -= (maxVertexCount % 4);
+	
+	// All sheets share the same textures, so binding any sheet binds them all
+	if(preboundSheet == 0xffffffff) {
+		pGlyphAtlas->BindSheet(pContext, 0, FW1_NOGEOMETRYSHADER);
+		preboundSheet = 0;
+	}
+	
+	UINT coordsSheet = 0xffffffff;
+	const FW1_GLYPHCOORDS *sheetGlyphCoords = 0;
+	UINT currentVertex = 0;
+	
+	while(currentVertex < vertexData->TotalVertexCount) {
+		// Fill the vertex buffer
+		UINT vertexCount = std::min((vertexData->TotalVertexCount - currentVertex) * 4, maxVertexCount);
+		
+		void *pBufferData;
+		UINT firstVertex;
+		HRESULT hResult = mapBufferRange(pContext, m_pVertexBuffer, m_vertexBufferOffset, true, sizeof(QuadVertex), vertexCount, &pBufferData, &firstVertex);
+		if(SUCCEEDED(hResult)) {
+			QuadVertex *bufferVertices = static_cast<QuadVertex*>(pBufferData);
+			
+			for(UINT i=0; i < vertexCount/4; ++i) {
+				const FW1_GLYPHVERTEX &glyphVertex = vertexData->pVertices[currentVertex + i];
+				
+				UINT sheetIndex = glyphVertex.GlyphIndex >> 16;
+				if(sheetIndex != coordsSheet) {
+					sheetGlyphCoords = pGlyphAtlas->GetGlyphCoords(sheetIndex);
+					coordsSheet = sheetIndex;
+				}
+				
+				const FW1_GLYPHCOORDS &glyphCoords = sheetGlyphCoords[glyphVertex.GlyphIndex & 0xffff];
+				
+				// The vertex shader takes the slice from the texcoord, as texCoordY + 4 * slice
+				FLOAT sliceOffset = static_cast<FLOAT>(sheetIndex) * 4.0f;
+				
+				QuadVertex quadVertex;
+				
+				quadVertex.color = glyphVertex.GlyphColor;
+				
+				quadVertex.positionX = glyphVertex.PositionX + glyphCoords.PositionLeft;
+				quadVertex.positionY = glyphVertex.PositionY + glyphCoords.PositionTop;
+				quadVertex.texCoordX = glyphCoords.TexCoordLeft;
+				quadVertex.texCoordY = glyphCoords.TexCoordTop + sliceOffset;
+				bufferVertices[i*4 + 0] = quadVertex;
+				
+				quadVertex.positionX = glyphVertex.PositionX + glyphCoords.PositionRight;
+				quadVertex.texCoordX = glyphCoords.TexCoordRight;
+				bufferVertices[i*4 + 1] = quadVertex;
+				
+				quadVertex.positionY = glyphVertex.PositionY + glyphCoords.PositionBottom;
+				quadVertex.texCoordY = glyphCoords.TexCoordBottom + sliceOffset;
+				bufferVertices[i*4 + 3] = quadVertex;
+				
+				quadVertex.positionX = glyphVertex.PositionX + glyphCoords.PositionLeft;
+				quadVertex.texCoordX = glyphCoords.TexCoordLeft;
+				bufferVertices[i*4 + 2] = quadVertex;
+			}
+			
+			pContext->Unmap(m_pVertexBuffer, 0);
+			
+			// Draw all glyphs in the buffer
+			pContext->DrawIndexed((vertexCount/2)*3, 0, firstVertex);
+			
+			currentVertex += vertexCount / 4;
+		}
+		else
+			break;
+	}
+	
+	return preboundSheet;
+}
+
+
 }// namespace FW1FontWrapper
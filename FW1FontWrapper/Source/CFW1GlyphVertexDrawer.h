@@ -9,7 +9,7 @@
 namespace FW1FontWrapper {
 
 
-// Draws glyph-vertices from system memory using a dynamic vertex buffer
+// Draws glyph-vertices from system memory using a dynamic vertex buffer, or a dynamic buffer read by the vertex shader
 class CFW1GlyphVertexDrawer : public CFW1Object<IFW1GlyphVertexDrawer> {
 	public:
 		// IUnknown
@@ -47,12 +47,23 @@ class CFW1GlyphVertexDrawer : public CFW1Object<IFW1GlyphVertexDrawer> {
 		virtual ~CFW1GlyphVertexDrawer();
 		
 		HRESULT createBuffers();
+		HRESULT mapBufferRange(
+			ID3D11DeviceContext *pContext,
+			ID3D11Buffer *pBuffer,
+			UINT &bufferOffset,
+			bool noOverwrite,
+			UINT elementSize,
+			UINT elementCount,
+			void **ppData,
+			UINT *pFirstElement
+		);
 		
 		UINT drawVertices(
 			ID3D11DeviceContext *pContext,
 			IFW1GlyphAtlas *pGlyphAtlas,
 			const FW1_VERTEXDATA *vertexData,
-			UINT preboundSheet
+			UINT preboundSheet,
+			bool vertexPulling
 		);
 		UINT drawGlyphsAsQuads(
 			ID3D11DeviceContext *pContext,
@@ -60,6 +71,12 @@ class CFW1GlyphVertexDrawer : public CFW1Object<IFW1GlyphVertexDrawer> {
 			const FW1_VERTEXDATA *vertexData,
 			UINT preboundSheet
 		);
+		UINT drawGlyphsAsArrayQuads(
+			ID3D11DeviceContext *pContext,
+			IFW1GlyphAtlas *pGlyphAtlas,
+			const FW1_VERTEXDATA *vertexData,
+			UINT preboundSheet
+		);
 	
 	// Internal data
 	private:
@@ -71,6 +88,12 @@ class CFW1GlyphVertexDrawer : public CFW1Object<IFW1GlyphVertexDrawer> {
 		ID3D11Buffer					*m_pIndexBuffer;
 		UINT							m_vertexBufferSize;
 		UINT							m_maxIndexCount;
+		UINT							m_vertexBufferOffset;// Bytes in use since the last discard
+		
+		ID3D11Buffer					*m_pGlyphBuffer;
+		ID3D11ShaderResourceView		*m_pGlyphBufferSRV;
+		UINT							m_glyphBufferOffset;
+		bool							m_glyphBufferNoOverwrite;
 };
 
 
@@ -43,6 +43,14 @@ UINT STDMETHODCALLTYPE CFW1GlyphVertexDrawer::DrawVertices(
 	UINT Flags,
 	UINT PreboundSheet
 ) {
+	// Glyph vertices read by the vertex shader, with no vertex or index buffer
+	if((Flags & FW1_NOGEOMETRYSHADER) != 0 && (Flags & FW1_VERTEXPULLING) != 0 && m_pGlyphBufferSRV != NULL) {
+		if((Flags & FW1_BUFFERSPREPARED) == 0)
+			pContext->VSSetShaderResources(1, 1, &m_pGlyphBufferSRV);
+		
+		return drawVertices(pContext, pGlyphAtlas, pVertexData, PreboundSheet, true);
+	}
+	
 	UINT stride;
 	UINT offset = 0;
 	
@@ -56,8 +64,11 @@ UINT STDMETHODCALLTYPE CFW1GlyphVertexDrawer::DrawVertices(
 	if((Flags & FW1_BUFFERSPREPARED) == 0)
 		pContext->IASetVertexBuffers(0, 1, &m_pVertexBuffer, &stride, &offset);
 	
+	// Texture-array vertices are a single unsorted range, which drawVertices draws without rebinding
 	if((Flags & FW1_NOGEOMETRYSHADER) == 0)
-		return drawVertices(pContext, pGlyphAtlas, pVertexData, PreboundSheet);
+		return drawVertices(pContext, pGlyphAtlas, pVertexData, PreboundSheet, false);
+	else if((Flags & FW1_TEXTUREARRAY) != 0)
+		return drawGlyphsAsArrayQuads(pContext, pGlyphAtlas, pVertexData, PreboundSheet);
 	else
 		return drawGlyphsAsQuads(pContext, pGlyphAtlas, pVertexData, PreboundSheet);
 }
@@ -0,0 +1,316 @@
+// CFW1OutlineRenderTarget.cpp
+
+#include "FW1Precompiled.h"
+
+#include "CFW1OutlineRenderTarget.h"
+
+#include <D2D1.h>
+
+
+namespace FW1FontWrapper {
+
+
+// Receives the outline of a glyph run and passes its lines and beziers on to the plain outline functions
+class CFW1OutlineRenderTarget::OutlineSink : public IDWriteGeometrySink {
+	public:
+		OutlineSink(std::vector<LineSegment> &lines) : m_lines(lines) {
+			m_startPoint.x = m_startPoint.y = 0.0f;
+			m_currentPoint = m_startPoint;
+		}
+		
+		// IUnknown, the sink lives on the stack and is not reference counted
+		virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void **ppvObject) {
+			if(ppvObject == NULL)
+				return E_INVALIDARG;
+			
+			if(IsEqualIID(riid, __uuidof(IUnknown)) || IsEqualIID(riid, __uuidof(ID2D1SimplifiedGeometrySink))) {
+				*ppvObject = static_cast<IDWriteGeometrySink*>(this);
+				return S_OK;
+			}
+			
+			*ppvObject = NULL;
+			return E_NOINTERFACE;
+		}
+		virtual ULONG STDMETHODCALLTYPE AddRef() { return 1; }
+		virtual ULONG STDMETHODCALLTYPE Release() { return 1; }
+		
+		// ID2D1SimplifiedGeometrySink
+		virtual void STDMETHODCALLTYPE SetFillMode(D2D1_FILL_MODE) {}
+		virtual void STDMETHODCALLTYPE SetSegmentFlags(D2D1_PATH_SEGMENT) {}
+		
+		virtual void STDMETHODCALLTYPE BeginFigure(D2D1_POINT_2F startPoint, D2D1_FIGURE_BEGIN) {
+			m_startPoint = toOutlinePoint(startPoint);
+			m_currentPoint = m_startPoint;
+		}
+		
+		virtual void STDMETHODCALLTYPE AddLines(const D2D1_POINT_2F *points, UINT32 pointsCount) {
+			for(UINT32 i=0; i < pointsCount; ++i) {
+				OutlinePoint point = toOutlinePoint(points[i]);
+				addOutlineLine(m_lines, m_currentPoint, point);
+				m_currentPoint = point;
+			}
+		}
+		
+		virtual void STDMETHODCALLTYPE AddBeziers(const D2D1_BEZIER_SEGMENT *beziers, UINT32 beziersCount) {
+			for(UINT32 i=0; i < beziersCount; ++i) {
+				OutlinePoint point = toOutlinePoint(beziers[i].point3);
+				addOutlineBezier(
+					m_lines,
+					m_currentPoint,
+					toOutlinePoint(beziers[i].point1),
+					toOutlinePoint(beziers[i].point2),
+					point
+				);
+				m_currentPoint = point;
+			}
+		}
+		
+		// Open figures are filled as if closed
+		virtual void STDMETHODCALLTYPE EndFigure(D2D1_FIGURE_END) {
+			addOutlineLine(m_lines, m_currentPoint, m_startPoint);
+			m_currentPoint = m_startPoint;
+		}
+		
+		virtual HRESULT STDMETHODCALLTYPE Close() {
+			return S_OK;
+		}
+	
+	private:
+		OutlineSink();
+		OutlineSink(const OutlineSink&);
+		OutlineSink& operator=(const OutlineSink&);
+		
+		static OutlinePoint toOutlinePoint(const D2D1_POINT_2F &point) {
+			OutlinePoint outlinePoint;
+			outlinePoint.x = point.x;
+			outlinePoint.y = point.y;
+			return outlinePoint;
+		}
+		
+		std::vector<LineSegment>	&m_lines;
+		OutlinePoint				m_startPoint;
+		OutlinePoint				m_currentPoint;
+};
+
+
+// Construct
+CFW1OutlineRenderTarget::CFW1OutlineRenderTarget() :
+	m_renderTargetWidth(0),
+	m_renderTargetHeight(0)
+{
+}
+
+
+// Destruct
+CFW1OutlineRenderTarget::~CFW1OutlineRenderTarget() {
+}
+
+
+// Init
+HRESULT CFW1OutlineRenderTarget::initRenderTarget(
+	IFW1Factory *pFW1Factory,
+	UINT renderTargetWidth,
+	UINT renderTargetHeight
+) {
+	HRESULT hResult = initBaseObject(pFW1Factory);
+	if(FAILED(hResult))
+		return hResult;
+	
+	m_renderTargetWidth = 384;
+	if(renderTargetWidth > 0)
+		m_renderTargetWidth = renderTargetWidth;
+	
+	m_renderTargetHeight = 384;
+	if(renderTargetHeight > 0)
+		m_renderTargetHeight = renderTargetHeight;
+	
+	// One spare entry past the last row, where a line on the right edge ends its last span
+	m_accumulation.resize(m_renderTargetWidth * m_renderTargetHeight + 2);
+	m_coverage.resize(m_renderTargetWidth * m_renderTargetHeight);
+	
+	return S_OK;
+}
+
+
+// Get the outline of a glyph as lines in pixels, with the origin on the baseline and Y pointing down
+HRESULT CFW1OutlineRenderTarget::getGlyphOutline(IDWriteFontFace *pFontFace, UINT16 glyphIndex, FLOAT fontSize) {
+	m_lines.clear();
+	
+	OutlineSink sink(m_lines);
+	HRESULT hResult = pFontFace->GetGlyphRunOutline(fontSize, &glyphIndex, NULL, NULL, 1, FALSE, FALSE, &sink);
+	if(FAILED(hResult))
+		m_lastError = L"GetGlyphRunOutline failed";
+	
+	return hResult;
+}
+
+
+// Add a line to an outline
+void CFW1OutlineRenderTarget::addOutlineLine(std::vector<LineSegment> &lines, const OutlinePoint &p0, const OutlinePoint &p1) {
+	// Horizontal lines don't add coverage
+	if(p1.y == p0.y)
+		return;
+	
+	LineSegment line;
+	line.x0 = p0.x;
+	line.y0 = p0.y;
+	line.x1 = p1.x;
+	line.y1 = p1.y;
+	lines.push_back(line);
+}
+
+
+// Add a cubic bezier to an outline, flattened to lines within a quarter pixel
+void CFW1OutlineRenderTarget::addOutlineBezier(
+	std::vector<LineSegment> &lines,
+	const OutlinePoint &p0,
+	const OutlinePoint &p1,
+	const OutlinePoint &p2,
+	const OutlinePoint &p3
+) {
+	// Wang's formula for the number of lines
+	FLOAT ddx = std::max(fabs(p0.x - 2.0f * p1.x + p2.x), fabs(p1.x - 2.0f * p2.x + p3.x));
+	FLOAT ddy = std::max(fabs(p0.y - 2.0f * p1.y + p2.y), fabs(p1.y - 2.0f * p2.y + p3.y));
+	FLOAT steps = ceil(sqrt(3.0f * sqrt(ddx * ddx + ddy * ddy)));
+	UINT stepCount = static_cast<UINT>(std::min(std::max(steps, 1.0f), 64.0f));
+	
+	OutlinePoint previousPoint = p0;
+	for(UINT i=1; i < stepCount; ++i) {
+		FLOAT t = static_cast<FLOAT>(i) / static_cast<FLOAT>(stepCount);
+		FLOAT s = 1.0f - t;
+		FLOAT w0 = s * s * s;
+		FLOAT w1 = 3.0f * s * s * t;
+		FLOAT w2 = 3.0f * s * t * t;
+		FLOAT w3 = t * t * t;
+		
+		OutlinePoint point;
+		point.x = w0 * p0.x + w1 * p1.x + w2 * p2.x + w3 * p3.x;
+		point.y = w0 * p0.y + w1 * p1.y + w2 * p2.y + w3 * p3.y;
+		addOutlineLine(lines, previousPoint, point);
+		previousPoint = point;
+	}
+	addOutlineLine(lines, previousPoint, p3);
+}
+
+
+// Fill an outline into 8-bit coverage, after moving it by an offset
+// The accumulation holds width * height + 2 zeroed values, and is left zeroed
+void CFW1OutlineRenderTarget::fillOutline(
+	const std::vector<LineSegment> &lines,
+	FLOAT offsetX,
+	FLOAT offsetY,
+	UINT width,
+	UINT height,
+	bool aliased,
+	FLOAT *accumulation,
+	UINT8 *coverage
+) {
+	for(size_t i=0; i < lines.size(); ++i) {
+		LineSegment line = lines[i];
+		line.x0 += offsetX;
+		line.y0 += offsetY;
+		line.x1 += offsetX;
+		line.y1 += offsetY;
+		
+		accumulateLine(accumulation, line, width, height);
+	}
+	
+	resolveCoverage(coverage, accumulation, width, height, aliased);
+}
+
+
+// Add the signed area a line covers in each pixel it crosses
+// The area of a pixel is the difference in coverage from the previous pixel, so the running sum of a row is the coverage
+void CFW1OutlineRenderTarget::accumulateLine(FLOAT *accumulation, const LineSegment &line, UINT width, UINT height) {
+	FLOAT x0 = line.x0;
+	FLOAT y0 = line.y0;
+	FLOAT x1 = line.x1;
+	FLOAT y1 = line.y1;
+	FLOAT dir = 1.0f;
+	if(y0 > y1) {
+		std::swap(x0, x1);
+		std::swap(y0, y1);
+		dir = -1.0f;
+	}
+	
+	// Parts above and below the image are cut off, parts left and right of it are moved to the edge
+	FLOAT yStart = std::max(y0, 0.0f);
+	FLOAT yEnd = std::min(y1, static_cast<FLOAT>(height));
+	if(yStart >= yEnd)
+		return;
+	
+	FLOAT dxdy = (x1 - x0) / (y1 - y0);
+	FLOAT maxX = static_cast<FLOAT>(width);
+	FLOAT x = x0 + dxdy * (yStart - y0);
+	
+	for(UINT y = static_cast<UINT>(yStart); static_cast<FLOAT>(y) < yEnd; ++y) {
+		FLOAT *row = accumulation + y * width;
+		
+		FLOAT dy = std::min(static_cast<FLOAT>(y + 1), yEnd) - std::max(static_cast<FLOAT>(y), yStart);
+		FLOAT xNext = x + dxdy * dy;
+		FLOAT d = dy * dir;
+		
+		FLOAT xLeft = std::min(std::max(std::min(x, xNext), 0.0f), maxX);
+		FLOAT xRight = std::min(std::max(std::max(x, xNext), 0.0f), maxX);
+		FLOAT xLeftFloor = floor(xLeft);
+		UINT xLeftIndex = static_cast<UINT>(xLeftFloor);
+		FLOAT xRightCeil = ceil(xRight);
+		UINT xRightIndex = static_cast<UINT>(xRightCeil);
+		
+		if(xRightIndex <= xLeftIndex + 1) {
+			// Within one pixel, split by the line's mid point
+			FLOAT xMid = 0.5f * (xLeft + xRight) - xLeftFloor;
+			row[xLeftIndex] += d - d * xMid;
+			row[xLeftIndex + 1] += d * xMid;
+		}
+		else {
+			// Across several pixels, a triangle in the first and last and equal steps between
+			FLOAT s = 1.0f / (xRight - xLeft);
+			FLOAT xLeftFrac = xLeft - xLeftFloor;
+			FLOAT a0 = 0.5f * s * (1.0f - xLeftFrac) * (1.0f - xLeftFrac);
+			FLOAT xRightFrac = xRight - xRightCeil + 1.0f;
+			FLOAT am = 0.5f * s * xRightFrac * xRightFrac;
+			
+			row[xLeftIndex] += d * a0;
+			if(xRightIndex == xLeftIndex + 2) {
+				row[xLeftIndex + 1] += d * (1.0f - a0 - am);
+			}
+			else {
+				FLOAT a1 = s * (1.5f - xLeftFrac);
+				row[xLeftIndex + 1] += d * (a1 - a0);
+				for(UINT xi = xLeftIndex + 2; xi < xRightIndex - 1; ++xi)
+					row[xi] += d * s;
+				FLOAT a2 = a1 + static_cast<FLOAT>(xRightIndex - xLeftIndex - 3) * s;
+				row[xRightIndex - 1] += d * (1.0f - a2 - am);
+			}
+			row[xRightIndex] += d * am;
+		}
+		
+		x = xNext;
+	}
+}
+
+
+// Sum the accumulated areas into 8-bit coverage, and clear the accumulation for the next glyph
+void CFW1OutlineRenderTarget::resolveCoverage(UINT8 *coverage, FLOAT *accumulation, UINT width, UINT height, bool aliased) {
+	UINT count = width * height;
+	FLOAT sum = 0.0f;
+	
+	for(UINT i=0; i < count; ++i) {
+		sum += accumulation[i];
+		accumulation[i] = 0.0f;
+		
+		// Non-zero winding, overlapping contours don't cancel out
+		FLOAT pixelCoverage = std::min(fabs(sum), 1.0f);
+		if(aliased)
+			coverage[i] = (pixelCoverage >= 0.5f) ? 255 : 0;
+		else
+			coverage[i] = static_cast<UINT8>(pixelCoverage * 255.0f + 0.5f);
+	}
+	
+	accumulation[count] = 0.0f;
+	accumulation[count + 1] = 0.0f;
+}
+
+
+}// namespace FW1FontWrapper
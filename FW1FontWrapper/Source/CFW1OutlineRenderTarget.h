@@ -0,0 +1,103 @@
+// CFW1OutlineRenderTarget.h
+
+#ifndef IncludeGuard__FW1_CFW1OutlineRenderTarget
+#define IncludeGuard__FW1_CFW1OutlineRenderTarget
+
+#include "CFW1Object.h"
+
+
+namespace FW1FontWrapper {
+
+
+// Render target that fills glyph outlines into 8-bit coverage, without GDI
+class CFW1OutlineRenderTarget : public CFW1Object<IFW1DWriteRenderTarget> {
+	public:
+		// IUnknown
+		virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void **ppvObject);
+		
+		// IFW1DWriteRenderTarget
+		virtual HRESULT STDMETHODCALLTYPE DrawGlyphTemp(
+			IDWriteFontFace *pFontFace,
+			UINT16 GlyphIndex,
+			FLOAT FontSize,
+			DWRITE_RENDERING_MODE RenderingMode,
+			DWRITE_MEASURING_MODE MeasuringMode,
+			FW1_GLYPHIMAGEDATA *pOutData
+		);
+	
+	// Public functions
+	public:
+		CFW1OutlineRenderTarget();
+		
+		HRESULT initRenderTarget(
+			IFW1Factory *pFW1Factory,
+			UINT renderTargetWidth,
+			UINT renderTargetHeight
+		);
+	
+	// Headless tests and benchmarks, see FW1Tests
+	private:
+		friend class CFW1OutlineRenderTargetTest;
+	
+	// Internal types
+	private:
+		struct OutlinePoint {
+			FLOAT					x;
+			FLOAT					y;
+		};
+		
+		struct LineSegment {
+			FLOAT					x0;
+			FLOAT					y0;
+			FLOAT					x1;
+			FLOAT					y1;
+		};
+		
+		// Receives the outline from DirectWrite and flattens it to line segments
+		class OutlineSink;
+	
+	// Internal functions
+	private:
+		virtual ~CFW1OutlineRenderTarget();
+		
+		HRESULT getGlyphOutline(IDWriteFontFace *pFontFace, UINT16 glyphIndex, FLOAT fontSize);
+		
+		// Outline flattening and filling, plain C++ without DirectWrite
+		static void addOutlineLine(std::vector<LineSegment> &lines, const OutlinePoint &p0, const OutlinePoint &p1);
+		static void addOutlineBezier(
+			std::vector<LineSegment> &lines,
+			const OutlinePoint &p0,
+			const OutlinePoint &p1,
+			const OutlinePoint &p2,
+			const OutlinePoint &p3
+		);
+		static void fillOutline(
+			const std::vector<LineSegment> &lines,
+			FLOAT offsetX,
+			FLOAT offsetY,
+			UINT width,
+			UINT height,
+			bool aliased,
+			FLOAT *accumulation,
+			UINT8 *coverage
+		);
+		static void accumulateLine(FLOAT *accumulation, const LineSegment &line, UINT width, UINT height);
+		static void resolveCoverage(UINT8 *coverage, FLOAT *accumulation, UINT width, UINT height, bool aliased);
+	
+	// Internal data
+	private:
+		std::wstring				m_lastError;
+		
+		UINT						m_renderTargetWidth;
+		UINT						m_renderTargetHeight;
+		
+		std::vector<LineSegment>	m_lines;
+		std::vector<FLOAT>			m_accumulation;// Signed area per pixel, summed along the rows into coverage
+		std::vector<UINT8>			m_coverage;
+};
+
+
+}// namespace FW1FontWrapper
+
+
+#endif// IncludeGuard__FW1_CFW1OutlineRenderTarget
@@ -0,0 +1,85 @@
+// CFW1OutlineRenderTargetInterface.cpp
+
+#include "FW1Precompiled.h"
+
+#include "CFW1OutlineRenderTarget.h"
+
+
+namespace FW1FontWrapper {
+
+
+// Query interface
+HRESULT STDMETHODCALLTYPE CFW1OutlineRenderTarget::QueryInterface(REFIID riid, void **ppvObject) {
+	if(ppvObject == NULL)
+		return E_INVALIDARG;
+	
+	if(IsEqualIID(riid, __uuidof(IFW1DWriteRenderTarget))) {
+		*ppvObject = static_cast<IFW1DWriteRenderTarget*>(this);
+		AddRef();
+		return S_OK;
+	}
+	
+	return CFW1Object::QueryInterface(riid, ppvObject);
+}
+
+
+// Draw glyph to temporary storage
+HRESULT STDMETHODCALLTYPE CFW1OutlineRenderTarget::DrawGlyphTemp(
+	IDWriteFontFace *pFontFace,
+	UINT16 GlyphIndex,
+	FLOAT FontSize,
+	DWRITE_RENDERING_MODE RenderingMode,
+	DWRITE_MEASURING_MODE MeasuringMode,
+	FW1_GLYPHIMAGEDATA *pOutData
+) {
+	// Outlines are not hinted, so the measuring mode makes no difference
+	MeasuringMode;
+	
+	HRESULT hResult = getGlyphOutline(pFontFace, GlyphIndex, FontSize);
+	if(FAILED(hResult))
+		return hResult;
+	
+	ZeroMemory(pOutData, sizeof(*pOutData));
+	pOutData->pGlyphPixels = &m_coverage[0];
+	pOutData->PixelStride = 1;
+	
+	// Glyphs such as spaces have no image
+	if(m_lines.empty())
+		return S_OK;
+	
+	// Bounding box, on whole pixels relative to the origin
+	FLOAT minX = FLT_MAX;
+	FLOAT minY = FLT_MAX;
+	FLOAT maxX = -FLT_MAX;
+	FLOAT maxY = -FLT_MAX;
+	for(size_t i=0; i < m_lines.size(); ++i) {
+		const LineSegment &line = m_lines[i];
+		minX = std::min(minX, std::min(line.x0, line.x1));
+		minY = std::min(minY, std::min(line.y0, line.y1));
+		maxX = std::max(maxX, std::max(line.x0, line.x1));
+		maxY = std::max(maxY, std::max(line.y0, line.y1));
+	}
+	
+	FLOAT left = floor(minX);
+	FLOAT top = floor(minY);
+	
+	// Clip glyphs larger than the render target
+	UINT width = std::min(static_cast<UINT>(std::max(ceil(maxX) - left, 1.0f)), m_renderTargetWidth);
+	UINT height = std::min(static_cast<UINT>(std::max(ceil(maxY) - top, 1.0f)), m_renderTargetHeight);
+	
+	// Fill the outline
+	bool aliased = (RenderingMode == DWRITE_RENDERING_MODE_ALIASED);
+	fillOutline(m_lines, -left, -top, width, height, aliased, &m_accumulation[0], &m_coverage[0]);
+	
+	// Return glyph data
+	pOutData->Metrics.OffsetX = left;
+	pOutData->Metrics.OffsetY = top;
+	pOutData->Metrics.Width = width;
+	pOutData->Metrics.Height = height;
+	pOutData->RowPitch = width;
+	
+	return S_OK;
+}
+
+
+}// namespace FW1FontWrapper
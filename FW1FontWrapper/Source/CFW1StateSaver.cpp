@@ -53,6 +53,8 @@ CFW1StateSaver::CFW1StateSaver() :
 		m_pHSClassInstances[i] = NULL;
 		m_pDSClassInstances[i] = NULL;
 	}
+	for(int i=0; i < 2; ++i)
+		m_pVSSRVs[i] = NULL;
 }
 
 
@@ -103,6 +105,8 @@ HRESULT CFW1StateSaver::saveCurrentState(ID3D11DeviceContext *pContext) {
 		
 		m_pContext->GSGetShaderResources(0, 1, &m_pGSSRV);
 		
+		m_pContext->VSGetShaderResources(0, 2, m_pVSSRVs);
+		
 		if(m_featureLevel >= D3D_FEATURE_LEVEL_11_0) {
 			m_numHSClassInstances = 256;
 			m_pContext->HSGetShader(&m_pHS, m_pHSClassInstances, &m_numHSClassInstances);
@@ -148,6 +152,8 @@ HRESULT CFW1StateSaver::restoreSavedState() {
 		
 		m_pContext->GSSetShaderResources(0, 1, &m_pGSSRV);
 		
+		m_pContext->VSSetShaderResources(0, 2, m_pVSSRVs);
+		
 		if(m_featureLevel >= D3D_FEATURE_LEVEL_11_0) {
 			m_pContext->HSSetShader(m_pHS, m_pHSClassInstances, m_numHSClassInstances);
 			
@@ -181,6 +187,8 @@ void CFW1StateSaver::releaseSavedState() {
 		SAFE_RELEASE(m_pVSClassInstances[i]);
 	m_numVSClassInstances = 0;
 	SAFE_RELEASE(m_pVSConstantBuffer);
+	for(int i=0; i < 2; ++i)
+		SAFE_RELEASE(m_pVSSRVs[i]);
 	SAFE_RELEASE(m_pGS);
 	for(UINT i=0; i < m_numGSClassInstances; ++i)
 		SAFE_RELEASE(m_pGSClassInstances[i]);
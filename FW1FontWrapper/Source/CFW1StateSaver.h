@@ -37,6 +37,7 @@ class CFW1StateSaver {
 		ID3D11ClassInstance			*m_pVSClassInstances[256];
 		UINT						m_numVSClassInstances;
 		ID3D11Buffer				*m_pVSConstantBuffer;
+		ID3D11ShaderResourceView	*m_pVSSRVs[2];
 		ID3D11GeometryShader		*m_pGS;
 		ID3D11ClassInstance			*m_pGSClassInstances[256];
 		UINT						m_numGSClassInstances;
@@ -0,0 +1,87 @@
+// CFW1StateTracker.cpp
+
+#include "FW1Precompiled.h"
+
+#include "CFW1StateTracker.h"
+
+#define SAFE_RELEASE(pObject) { if(pObject) { (pObject)->Release(); (pObject) = NULL; } }
+
+
+namespace FW1FontWrapper {
+
+
+// Construct
+CFW1StateTracker::CFW1StateTracker() :
+	m_pContext(NULL),
+	
+	m_primitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED),
+	m_primitiveTopologyKnown(false),
+	m_sampleMask(0xffffffff),
+	m_stencilRef(0),
+	
+	m_issuedCallCount(0),
+	m_skippedCallCount(0)
+{
+	m_inputLayout.pState = NULL;
+	m_vertexShader.pState = NULL;
+	m_geometryShader.pState = NULL;
+	m_pixelShader.pState = NULL;
+	m_hullShader.pState = NULL;
+	m_domainShader.pState = NULL;
+	m_vertexShaderConstantBuffer.pState = NULL;
+	m_geometryShaderConstantBuffer.pState = NULL;
+	m_pixelShaderSampler.pState = NULL;
+	m_blendState.pState = NULL;
+	m_depthStencilState.pState = NULL;
+	m_rasterizerState.pState = NULL;
+	
+	releaseStates();
+}
+
+
+// Destruct
+CFW1StateTracker::~CFW1StateTracker() {
+	releaseStates();
+	
+	SAFE_RELEASE(m_pContext);
+}
+
+
+// Init
+HRESULT CFW1StateTracker::initStateTracker(IFW1Factory *pFW1Factory, ID3D11DeviceContext *pContext) {
+	HRESULT hResult = initBaseObject(pFW1Factory);
+	if(FAILED(hResult))
+		return hResult;
+	
+	if(pContext == NULL)
+		return E_INVALIDARG;
+	
+	pContext->AddRef();
+	m_pContext = pContext;
+	
+	return S_OK;
+}
+
+
+// Forget all states
+void CFW1StateTracker::releaseStates() {
+	m_primitiveTopology = D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED;
+	m_primitiveTopologyKnown = false;
+	releaseState(m_inputLayout);
+	releaseState(m_vertexShader);
+	releaseState(m_geometryShader);
+	releaseState(m_pixelShader);
+	releaseState(m_hullShader);
+	releaseState(m_domainShader);
+	releaseState(m_vertexShaderConstantBuffer);
+	releaseState(m_geometryShaderConstantBuffer);
+	releaseState(m_pixelShaderSampler);
+	releaseState(m_blendState);
+	m_sampleMask = 0xffffffff;
+	releaseState(m_depthStencilState);
+	m_stencilRef = 0;
+	releaseState(m_rasterizerState);
+}
+
+
+}// namespace FW1FontWrapper
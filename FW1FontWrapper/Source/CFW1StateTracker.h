@@ -0,0 +1,118 @@
+// CFW1StateTracker.h
+
+#ifndef IncludeGuard__FW1_CFW1StateTracker
+#define IncludeGuard__FW1_CFW1StateTracker
+
+#include "CFW1Object.h"
+
+
+namespace FW1FontWrapper {
+
+
+// Mirror of the pipeline states set on a device context, only passing on states that change
+class CFW1StateTracker : public CFW1Object<IFW1StateTracker> {
+	public:
+		// IUnknown
+		virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void **ppvObject);
+		
+		// IFW1StateTracker
+		virtual HRESULT STDMETHODCALLTYPE GetDeviceContext(ID3D11DeviceContext **ppContext);
+		
+		virtual void STDMETHODCALLTYPE SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY Topology);
+		virtual void STDMETHODCALLTYPE SetInputLayout(ID3D11InputLayout *pInputLayout);
+		virtual void STDMETHODCALLTYPE SetVertexShader(ID3D11VertexShader *pShader);
+		virtual void STDMETHODCALLTYPE SetGeometryShader(ID3D11GeometryShader *pShader);
+		virtual void STDMETHODCALLTYPE SetPixelShader(ID3D11PixelShader *pShader);
+		virtual void STDMETHODCALLTYPE SetHullShader(ID3D11HullShader *pShader);
+		virtual void STDMETHODCALLTYPE SetDomainShader(ID3D11DomainShader *pShader);
+		virtual void STDMETHODCALLTYPE SetVertexShaderConstantBuffer(ID3D11Buffer *pBuffer);
+		virtual void STDMETHODCALLTYPE SetGeometryShaderConstantBuffer(ID3D11Buffer *pBuffer);
+		virtual void STDMETHODCALLTYPE SetPixelShaderSampler(ID3D11SamplerState *pSamplerState);
+		virtual void STDMETHODCALLTYPE SetBlendState(ID3D11BlendState *pBlendState, UINT SampleMask);
+		virtual void STDMETHODCALLTYPE SetDepthStencilState(ID3D11DepthStencilState *pDepthStencilState, UINT StencilRef);
+		virtual void STDMETHODCALLTYPE SetRasterizerState(ID3D11RasterizerState *pRasterizerState);
+		
+		virtual void STDMETHODCALLTYPE Invalidate();
+		
+		virtual void STDMETHODCALLTYPE GetCallCounts(UINT *pIssuedCallCount, UINT *pSkippedCallCount);
+		virtual void STDMETHODCALLTYPE ResetCallCounts();
+	
+	// Public functions
+	public:
+		CFW1StateTracker();
+		
+		HRESULT initStateTracker(IFW1Factory *pFW1Factory, ID3D11DeviceContext *pContext);
+	
+	// Internal types
+	private:
+		// A bound state, referenced so that a released state can't be mistaken for a new one created at the same address
+		template<class T>
+		struct TrackedState {
+			T							*pState;
+			bool						known;
+		};
+	
+	// Internal functions
+	private:
+		virtual ~CFW1StateTracker();
+		
+		template<class T>
+		bool changeState(TrackedState<T> &trackedState, T *pState, bool sameValues) {
+			if(trackedState.known && trackedState.pState == pState && sameValues) {
+				++m_skippedCallCount;
+				return false;
+			}
+			
+			if(pState != NULL)
+				pState->AddRef();
+			if(trackedState.pState != NULL)
+				trackedState.pState->Release();
+			trackedState.pState = pState;
+			trackedState.known = true;
+			
+			++m_issuedCallCount;
+			return true;
+		}
+		
+		template<class T>
+		static void releaseState(TrackedState<T> &trackedState) {
+			if(trackedState.pState != NULL)
+				trackedState.pState->Release();
+			trackedState.pState = NULL;
+			trackedState.known = false;
+		}
+		
+		void releaseStates();
+	
+	// Internal data
+	private:
+		std::wstring								m_lastError;
+		
+		ID3D11DeviceContext							*m_pContext;
+		
+		D3D11_PRIMITIVE_TOPOLOGY					m_primitiveTopology;
+		bool										m_primitiveTopologyKnown;
+		TrackedState<ID3D11InputLayout>				m_inputLayout;
+		TrackedState<ID3D11VertexShader>			m_vertexShader;
+		TrackedState<ID3D11GeometryShader>			m_geometryShader;
+		TrackedState<ID3D11PixelShader>				m_pixelShader;
+		TrackedState<ID3D11HullShader>				m_hullShader;
+		TrackedState<ID3D11DomainShader>			m_domainShader;
+		TrackedState<ID3D11Buffer>					m_vertexShaderConstantBuffer;
+		TrackedState<ID3D11Buffer>					m_geometryShaderConstantBuffer;
+		TrackedState<ID3D11SamplerState>			m_pixelShaderSampler;
+		TrackedState<ID3D11BlendState>				m_blendState;
+		UINT										m_sampleMask;
+		TrackedState<ID3D11DepthStencilState>		m_depthStencilState;
+		UINT										m_stencilRef;
+		TrackedState<ID3D11RasterizerState>			m_rasterizerState;
+		
+		UINT										m_issuedCallCount;
+		UINT										m_skippedCallCount;
+};
+
+
+}// namespace FW1FontWrapper
+
+
+#endif// IncludeGuard__FW1_CFW1StateTracker
@@ -0,0 +1,163 @@
+// CFW1StateTrackerInterface.cpp
+
+#include "FW1Precompiled.h"
+
+#include "CFW1StateTracker.h"
+
+
+namespace FW1FontWrapper {
+
+
+// Query interface
+HRESULT STDMETHODCALLTYPE CFW1StateTracker::QueryInterface(REFIID riid, void **ppvObject) {
+	if(ppvObject == NULL)
+		return E_INVALIDARG;
+	
+	if(IsEqualIID(riid, __uuidof(IFW1StateTracker))) {
+		*ppvObject = static_cast<IFW1StateTracker*>(this);
+		AddRef();
+		return S_OK;
+	}
+	
+	return CFW1Object::QueryInterface(riid, ppvObject);
+}
+
+
+// Get the device context the states are set on
+HRESULT STDMETHODCALLTYPE CFW1StateTracker::GetDeviceContext(ID3D11DeviceContext **ppContext) {
+	if(ppContext == NULL)
+		return E_INVALIDARG;
+	
+	m_pContext->AddRef();
+	*ppContext = m_pContext;
+	
+	return S_OK;
+}
+
+
+// Set primitive topology
+void STDMETHODCALLTYPE CFW1StateTracker::SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY Topology) {
+	if(m_primitiveTopologyKnown && m_primitiveTopology == Topology) {
+		++m_skippedCallCount;
+		return;
+	}
+	
+	m_primitiveTopology = Topology;
+	m_primitiveTopologyKnown = true;
+	++m_issuedCallCount;
+	
+	m_pContext->IASetPrimitiveTopology(Topology);
+}
+
+
+// Set input layout
+void STDMETHODCALLTYPE CFW1StateTracker::SetInputLayout(ID3D11InputLayout *pInputLayout) {
+	if(changeState(m_inputLayout, pInputLayout, true))
+		m_pContext->IASetInputLayout(pInputLayout);
+}
+
+
+// Set vertex shader
+void STDMETHODCALLTYPE CFW1StateTracker::SetVertexShader(ID3D11VertexShader *pShader) {
+	if(changeState(m_vertexShader, pShader, true))
+		m_pContext->VSSetShader(pShader, NULL, 0);
+}
+
+
+// Set geometry shader
+void STDMETHODCALLTYPE CFW1StateTracker::SetGeometryShader(ID3D11GeometryShader *pShader) {
+	if(changeState(m_geometryShader, pShader, true))
+		m_pContext->GSSetShader(pShader, NULL, 0);
+}
+
+
+// Set pixel shader
+void STDMETHODCALLTYPE CFW1StateTracker::SetPixelShader(ID3D11PixelShader *pShader) {
+	if(changeState(m_pixelShader, pShader, true))
+		m_pContext->PSSetShader(pShader, NULL, 0);
+}
+
+
+// Set hull shader
+void STDMETHODCALLTYPE CFW1StateTracker::SetHullShader(ID3D11HullShader *pShader) {
+	if(changeState(m_hullShader, pShader, true))
+		m_pContext->HSSetShader(pShader, NULL, 0);
+}
+
+
+// Set domain shader
+void STDMETHODCALLTYPE CFW1StateTracker::SetDomainShader(ID3D11DomainShader *pShader) {
+	if(changeState(m_domainShader, pShader, true))
+		m_pContext->DSSetShader(pShader, NULL, 0);
+}
+
+
+// Set vertex shader constant buffer
+void STDMETHODCALLTYPE CFW1StateTracker::SetVertexShaderConstantBuffer(ID3D11Buffer *pBuffer) {
+	if(changeState(m_vertexShaderConstantBuffer, pBuffer, true))
+		m_pContext->VSSetConstantBuffers(0, 1, &pBuffer);
+}
+
+
+// Set geometry shader constant buffer
+void STDMETHODCALLTYPE CFW1StateTracker::SetGeometryShaderConstantBuffer(ID3D11Buffer *pBuffer) {
+	if(changeState(m_geometryShaderConstantBuffer, pBuffer, true))
+		m_pContext->GSSetConstantBuffers(0, 1, &pBuffer);
+}
+
+
+// Set pixel shader sampler
+void STDMETHODCALLTYPE CFW1StateTracker::SetPixelShaderSampler(ID3D11SamplerState *pSamplerState) {
+	if(changeState(m_pixelShaderSampler, pSamplerState, true))
+		m_pContext->PSSetSamplers(0, 1, &pSamplerState);
+}
+
+
+// Set blend state
+void STDMETHODCALLTYPE CFW1StateTracker::SetBlendState(ID3D11BlendState *pBlendState, UINT SampleMask) {
+	if(changeState(m_blendState, pBlendState, m_sampleMask == SampleMask)) {
+		m_sampleMask = SampleMask;
+		m_pContext->OMSetBlendState(pBlendState, NULL, SampleMask);
+	}
+}
+
+
+// Set depth-stencil state
+void STDMETHODCALLTYPE CFW1StateTracker::SetDepthStencilState(ID3D11DepthStencilState *pDepthStencilState, UINT StencilRef) {
+	if(changeState(m_depthStencilState, pDepthStencilState, m_stencilRef == StencilRef)) {
+		m_stencilRef = StencilRef;
+		m_pContext->OMSetDepthStencilState(pDepthStencilState, StencilRef);
+	}
+}
+
+
+// Set rasterizer state
+void STDMETHODCALLTYPE CFW1StateTracker::SetRasterizerState(ID3D11RasterizerState *pRasterizerState) {
+	if(changeState(m_rasterizerState, pRasterizerState, true))
+		m_pContext->RSSetState(pRasterizerState);
+}
+
+
+// Forget all states
+void STDMETHODCALLTYPE CFW1StateTracker::Invalidate() {
+	releaseStates();
+}
+
+
+// Get call counts
+void STDMETHODCALLTYPE CFW1StateTracker::GetCallCounts(UINT *pIssuedCallCount, UINT *pSkippedCallCount) {
+	if(pIssuedCallCount != NULL)
+		*pIssuedCallCount = m_issuedCallCount;
+	if(pSkippedCallCount != NULL)
+		*pSkippedCallCount = m_skippedCallCount;
+}
+
+
+// Reset call counts
+void STDMETHODCALLTYPE CFW1StateTracker::ResetCallCounts() {
+	m_issuedCallCount = 0;
+	m_skippedCallCount = 0;
+}
+
+
+}// namespace FW1FontWrapper
@@ -0,0 +1,247 @@
+// CFW1StaticGeometry.cpp
+
+#include "FW1Precompiled.h"
+
+#include "CFW1StaticGeometry.h"
+
+#define SAFE_RELEASE(pObject) { if(pObject) { (pObject)->Release(); (pObject) = NULL; } }
+
+
+namespace FW1FontWrapper {
+
+
+// Construct
+CFW1StaticGeometry::CFW1StaticGeometry() :
+	m_pDevice(NULL),
+	m_pGlyphAtlas(NULL),
+	m_flags(0),
+	m_atlasRemovalCount(0),
+	
+	m_pVertexBuffer(NULL),
+	m_pIndexBuffer(NULL),
+	m_maxGlyphsPerDraw(0)
+{
+}
+
+
+// Destruct
+CFW1StaticGeometry::~CFW1StaticGeometry() {
+	SAFE_RELEASE(m_pDevice);
+	SAFE_RELEASE(m_pGlyphAtlas);
+	
+	SAFE_RELEASE(m_pVertexBuffer);
+	SAFE_RELEASE(m_pIndexBuffer);
+	
+	for(size_t i=0; i < m_sheetRanges.size(); ++i)
+		m_sheetRanges[i].pGlyphSheet->Release();
+}
+
+
+// Init
+HRESULT CFW1StaticGeometry::initStaticGeometry(
+	IFW1Factory *pFW1Factory,
+	ID3D11Device *pDevice,
+	IFW1GlyphAtlas *pGlyphAtlas,
+	const FW1_VERTEXDATA *pVertexData,
+	UINT flags
+) {
+	HRESULT hResult = initBaseObject(pFW1Factory);
+	if(FAILED(hResult))
+		return hResult;
+	
+	if(pDevice == NULL || pGlyphAtlas == NULL || pVertexData == NULL)
+		return E_INVALIDARG;
+	
+	pDevice->AddRef();
+	m_pDevice = pDevice;
+	
+	pGlyphAtlas->AddRef();
+	m_pGlyphAtlas = pGlyphAtlas;
+	
+	m_flags = flags & (FW1_NOGEOMETRYSHADER | FW1_TEXTUREARRAY | FW1_DISTANCEFIELD);
+	m_atlasRemovalCount = m_pGlyphAtlas->GetRemovalCount();
+	
+	// Record which glyphs use which sheet, skipping unused sheets
+	UINT startGlyph = 0;
+	for(UINT i=0; i < pVertexData->SheetCount; ++i) {
+		if(pVertexData->pVertexCounts[i] > 0) {
+			IFW1GlyphSheet *pGlyphSheet;
+			hResult = m_pGlyphAtlas->GetSheet(i, &pGlyphSheet);
+			if(FAILED(hResult)) {
+				m_lastError = L"Vertices reference a sheet not in the atlas";
+				return hResult;
+			}
+			pGlyphSheet->AddRef();
+			
+			SheetRange sheetRange;
+			sheetRange.pGlyphSheet = pGlyphSheet;
+			sheetRange.sheetIndex = i;
+			sheetRange.startGlyph = startGlyph;
+			sheetRange.glyphCount = pVertexData->pVertexCounts[i];
+			m_sheetRanges.push_back(sheetRange);
+			
+			startGlyph += pVertexData->pVertexCounts[i];
+		}
+	}
+	
+	// An empty geometry is valid, and simply draws nothing
+	if(pVertexData->TotalVertexCount == 0)
+		return S_OK;
+	
+	// Create device buffers
+	if((m_flags & FW1_NOGEOMETRYSHADER) == 0)
+		hResult = createPointBuffer(pVertexData);
+	else
+		hResult = createQuadBuffers(pVertexData);
+	
+	if(SUCCEEDED(hResult))
+		hResult = S_OK;
+	
+	return hResult;
+}
+
+
+// Create vertex buffer with one point per glyph, for the geometry shader
+HRESULT CFW1StaticGeometry::createPointBuffer(const FW1_VERTEXDATA *vertexData) {
+	D3D11_BUFFER_DESC vertexBufferDesc;
+	D3D11_SUBRESOURCE_DATA initData;
+	ID3D11Buffer *pVertexBuffer;
+	
+	ZeroMemory(&vertexBufferDesc, sizeof(vertexBufferDesc));
+	vertexBufferDesc.ByteWidth = vertexData->TotalVertexCount * sizeof(FW1_GLYPHVERTEX);
+	vertexBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+	vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	
+	ZeroMemory(&initData, sizeof(initData));
+	initData.pSysMem = vertexData->pVertices;
+	
+	HRESULT hResult = m_pDevice->CreateBuffer(&vertexBufferDesc, &initData, &pVertexBuffer);
+	if(FAILED(hResult)) {
+		m_lastError = L"Failed to create vertex buffer";
+	}
+	else {
+		// Success
+		m_pVertexBuffer = pVertexBuffer;
+		m_maxGlyphsPerDraw = vertexData->TotalVertexCount;
+		
+		hResult = S_OK;
+	}
+	
+	return hResult;
+}
+
+
+// Create vertex/index buffers with the glyphs expanded to quads
+HRESULT CFW1StaticGeometry::createQuadBuffers(const FW1_VERTEXDATA *vertexData) {
+	// Expand the glyphs using the coords of their sheets, which never change once a glyph is inserted
+	std::vector<QuadVertex> quadVertices(vertexData->TotalVertexCount * 4);
+	
+	for(size_t i=0; i < m_sheetRanges.size(); ++i) {
+		const SheetRange &sheetRange = m_sheetRanges[i];
+		const FW1_GLYPHCOORDS *sheetGlyphCoords = sheetRange.pGlyphSheet->GetGlyphCoords();
+		
+		for(UINT j=sheetRange.startGlyph; j < sheetRange.startGlyph + sheetRange.glyphCount; ++j) {
+			const FW1_GLYPHVERTEX &glyphVertex = vertexData->pVertices[j];
+			
+			// Texture-array vertices keep their atlas IDs, and pass the slice in the texcoord as texCoordY + 4 * slice
+			UINT glyphIndex = glyphVertex.GlyphIndex;
+			FLOAT sliceOffset = 0.0f;
+			if((m_flags & FW1_TEXTUREARRAY) != 0) {
+				sheetGlyphCoords = m_pGlyphAtlas->GetGlyphCoords(glyphIndex >> 16);
+				sliceOffset = static_cast<FLOAT>(glyphIndex >> 16) * 4.0f;
+				glyphIndex &= 0xffff;
+			}
+			
+			const FW1_GLYPHCOORDS &glyphCoords = sheetGlyphCoords[glyphIndex];
+			
+			QuadVertex quadVertex;
+			
+			quadVertex.color = glyphVertex.GlyphColor;
+			
+			quadVertex.positionX = glyphVertex.PositionX + glyphCoords.PositionLeft;
+			quadVertex.positionY = glyphVertex.PositionY + glyphCoords.PositionTop;
+			quadVertex.texCoordX = glyphCoords.TexCoordLeft;
+			quadVertex.texCoordY = glyphCoords.TexCoordTop + sliceOffset;
+			quadVertices[j*4 + 0] = quadVertex;
+			
+			quadVertex.positionX = glyphVertex.PositionX + glyphCoords.PositionRight;
+			quadVertex.texCoordX = glyphCoords.TexCoordRight;
+			quadVertices[j*4 + 1] = quadVertex;
+			
+			quadVertex.positionY = glyphVertex.PositionY + glyphCoords.PositionBottom;
+			quadVertex.texCoordY = glyphCoords.TexCoordBottom + sliceOffset;
+			quadVertices[j*4 + 3] = quadVertex;
+			
+			quadVertex.positionX = glyphVertex.PositionX + glyphCoords.PositionLeft;
+			quadVertex.texCoordX = glyphCoords.TexCoordLeft;
+			quadVertices[j*4 + 2] = quadVertex;
+		}
+	}
+	
+	// 16-bit indices can address 16384 quads, larger geometries are drawn in chunks using a base vertex
+	m_maxGlyphsPerDraw = std::min(vertexData->TotalVertexCount, 16384U);
+	
+	D3D11_BUFFER_DESC vertexBufferDesc;
+	D3D11_SUBRESOURCE_DATA initData;
+	ID3D11Buffer *pVertexBuffer;
+	
+	ZeroMemory(&vertexBufferDesc, sizeof(vertexBufferDesc));
+	vertexBufferDesc.ByteWidth = static_cast<UINT>(quadVertices.size() * sizeof(QuadVertex));
+	vertexBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+	vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	
+	ZeroMemory(&initData, sizeof(initData));
+	initData.pSysMem = &quadVertices[0];
+	
+	HRESULT hResult = m_pDevice->CreateBuffer(&vertexBufferDesc, &initData, &pVertexBuffer);
+	if(FAILED(hResult)) {
+		m_lastError = L"Failed to create vertex buffer";
+	}
+	else {
+		// Create index buffer
+		D3D11_BUFFER_DESC indexBufferDesc;
+		ID3D11Buffer *pIndexBuffer;
+		
+		UINT indexCount = m_maxGlyphsPerDraw * 6;
+		
+		ZeroMemory(&indexBufferDesc, sizeof(indexBufferDesc));
+		indexBufferDesc.ByteWidth = sizeof(UINT16) * indexCount;
+		indexBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+		indexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+		
+		UINT16 *indices = new UINT16[indexCount];
+		for(UINT i=0; i < m_maxGlyphsPerDraw; ++i) {
+			indices[i*6] = static_cast<UINT16>(i*4);
+			indices[i*6+1] = static_cast<UINT16>(i*4+1);
+			indices[i*6+2] = static_cast<UINT16>(i*4+2);
+			indices[i*6+3] = static_cast<UINT16>(i*4+1);
+			indices[i*6+4] = static_cast<UINT16>(i*4+3);
+			indices[i*6+5] = static_cast<UINT16>(i*4+2);
+		}
+		
+		ZeroMemory(&initData, sizeof(initData));
+		initData.pSysMem = indices;
+		
+		hResult = m_pDevice->CreateBuffer(&indexBufferDesc, &initData, &pIndexBuffer);
+		if(FAILED(hResult)) {
+			m_lastError = L"Failed to create index buffer";
+		}
+		else {
+			// Success
+			m_pVertexBuffer = pVertexBuffer;
+			m_pIndexBuffer = pIndexBuffer;
+			
+			hResult = S_OK;
+		}
+		
+		delete[] indices;
+		
+		if(FAILED(hResult))
+			pVertexBuffer->Release();
+	}
+	
+	return hResult;
+}
+
+
+}// namespace FW1FontWrapper
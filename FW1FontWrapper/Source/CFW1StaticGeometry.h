@@ -0,0 +1,85 @@
+// CFW1StaticGeometry.h
+
+#ifndef IncludeGuard__FW1_CFW1StaticGeometry
+#define IncludeGuard__FW1_CFW1StaticGeometry
+
+#include "CFW1Object.h"
+
+
+namespace FW1FontWrapper {
+
+
+// Glyph vertices stored in immutable device buffers
+class CFW1StaticGeometry : public CFW1Object<IFW1StaticGeometry> {
+	public:
+		// IUnknown
+		virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void **ppvObject);
+		
+		// IFW1StaticGeometry
+		virtual HRESULT STDMETHODCALLTYPE GetDevice(ID3D11Device **ppDevice);
+		virtual HRESULT STDMETHODCALLTYPE GetGlyphAtlas(IFW1GlyphAtlas **ppGlyphAtlas);
+		
+		virtual UINT STDMETHODCALLTYPE GetFlags();
+		
+		virtual UINT STDMETHODCALLTYPE DrawGeometry(
+			ID3D11DeviceContext *pContext,
+			UINT Flags,
+			UINT PreboundSheet
+		);
+	
+	// Public functions
+	public:
+		CFW1StaticGeometry();
+		
+		HRESULT initStaticGeometry(
+			IFW1Factory *pFW1Factory,
+			ID3D11Device *pDevice,
+			IFW1GlyphAtlas *pGlyphAtlas,
+			const FW1_VERTEXDATA *pVertexData,
+			UINT flags
+		);
+	
+	// Internal types
+	private:
+		struct QuadVertex {
+			FLOAT						positionX;
+			FLOAT						positionY;
+			FLOAT						texCoordX;
+			FLOAT						texCoordY;
+			UINT32						color;
+		};
+		
+		struct SheetRange {
+			IFW1GlyphSheet				*pGlyphSheet;// Referenced so the sheet outlives its removal from the atlas
+			UINT						sheetIndex;
+			UINT						startGlyph;
+			UINT						glyphCount;
+		};
+	
+	// Internal functions
+	private:
+		virtual ~CFW1StaticGeometry();
+		
+		HRESULT createPointBuffer(const FW1_VERTEXDATA *vertexData);
+		HRESULT createQuadBuffers(const FW1_VERTEXDATA *vertexData);
+	
+	// Internal data
+	private:
+		std::wstring					m_lastError;
+		
+		ID3D11Device					*m_pDevice;
+		IFW1GlyphAtlas					*m_pGlyphAtlas;
+		UINT							m_flags;
+		UINT							m_atlasRemovalCount;
+		
+		ID3D11Buffer					*m_pVertexBuffer;
+		ID3D11Buffer					*m_pIndexBuffer;
+		UINT							m_maxGlyphsPerDraw;
+		std::vector<SheetRange>			m_sheetRanges;
+};
+
+
+}// namespace FW1FontWrapper
+
+
+#endif// IncludeGuard__FW1_CFW1StaticGeometry
@@ -0,0 +1,108 @@
+// CFW1StaticGeometryInterface.cpp
+
+#include "FW1Precompiled.h"
+
+#include "CFW1StaticGeometry.h"
+
+
+namespace FW1FontWrapper {
+
+
+// Query interface
+HRESULT STDMETHODCALLTYPE CFW1StaticGeometry::QueryInterface(REFIID riid, void **ppvObject) {
+	if(ppvObject == NULL)
+		return E_INVALIDARG;
+	
+	if(IsEqualIID(riid, __uuidof(IFW1StaticGeometry))) {
+		*ppvObject = static_cast<IFW1StaticGeometry*>(this);
+		AddRef();
+		return S_OK;
+	}
+	
+	return CFW1Object::QueryInterface(riid, ppvObject);
+}
+
+
+// Get the D3D11 device used by this static geometry
+HRESULT STDMETHODCALLTYPE CFW1StaticGeometry::GetDevice(ID3D11Device **ppDevice) {
+	if(ppDevice == NULL)
+		return E_INVALIDARG;
+	
+	m_pDevice->AddRef();
+	*ppDevice = m_pDevice;
+	
+	return S_OK;
+}
+
+
+// Get the glyph atlas referenced by this static geometry
+HRESULT STDMETHODCALLTYPE CFW1StaticGeometry::GetGlyphAtlas(IFW1GlyphAtlas **ppGlyphAtlas) {
+	if(ppGlyphAtlas == NULL)
+		return E_INVALIDARG;
+	
+	m_pGlyphAtlas->AddRef();
+	*ppGlyphAtlas = m_pGlyphAtlas;
+	
+	return S_OK;
+}
+
+
+// Get creation flags
+UINT STDMETHODCALLTYPE CFW1StaticGeometry::GetFlags() {
+	return m_flags;
+}
+
+
+// Draw the geometry
+UINT STDMETHODCALLTYPE CFW1StaticGeometry::DrawGeometry(
+	ID3D11DeviceContext *pContext,
+	UINT Flags,
+	UINT PreboundSheet
+) {
+	if(m_pVertexBuffer == NULL)
+		return PreboundSheet;
+	
+	UINT stride;
+	UINT offset = 0;
+	
+	if((m_flags & FW1_NOGEOMETRYSHADER) == 0)
+		stride = sizeof(FW1_GLYPHVERTEX);
+	else {
+		stride = sizeof(QuadVertex);
+		if((Flags & FW1_BUFFERSPREPARED) == 0)
+			pContext->IASetIndexBuffer(m_pIndexBuffer, DXGI_FORMAT_R16_UINT, 0);
+	}
+	if((Flags & FW1_BUFFERSPREPARED) == 0)
+		pContext->IASetVertexBuffers(0, 1, &m_pVertexBuffer, &stride, &offset);
+	
+	// Once sheets have been removed from the atlas the stored indices no longer match the atlas, so nothing can be assumed bound
+	bool sheetIndicesValid = (m_pGlyphAtlas->GetRemovalCount() == m_atlasRemovalCount);
+	UINT activeSheet = sheetIndicesValid ? PreboundSheet : 0xffffffff;
+	
+	for(size_t i=0; i < m_sheetRanges.size(); ++i) {
+		const SheetRange &sheetRange = m_sheetRanges[i];
+		
+		if(sheetRange.sheetIndex != activeSheet || !sheetIndicesValid) {
+			// Bind sheet shader resources
+			sheetRange.pGlyphSheet->BindSheet(pContext, m_flags);
+			activeSheet = sheetRange.sheetIndex;
+		}
+		
+		if((m_flags & FW1_NOGEOMETRYSHADER) == 0)
+			pContext->Draw(sheetRange.glyphCount, sheetRange.startGlyph);
+		else {
+			UINT drawnGlyphs = 0;
+			while(drawnGlyphs < sheetRange.glyphCount) {
+				UINT drawCount = std::min(sheetRange.glyphCount - drawnGlyphs, m_maxGlyphsPerDraw);
+				pContext->DrawIndexed(drawCount * 6, 0, (sheetRange.startGlyph + drawnGlyphs) * 4);
+				
+				drawnGlyphs += drawCount;
+			}
+		}
+	}
+	
+	return sheetIndicesValid ? activeSheet : 0xffffffff;
+}
+
+
+}// namespace FW1FontWrapper
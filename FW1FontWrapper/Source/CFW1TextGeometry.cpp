@@ -11,7 +11,10 @@ namespace FW1FontWrapper {
 // Construct
 CFW1TextGeometry::CFW1TextGeometry() :
 	m_maxSheetIndex(0),
-	m_sorted(false)
+	m_sorted(false),
+	
+	m_unsortedVertexCount(0),
+	m_placeholderCount(0)
 {
 }
 
@@ -20,6 +20,11 @@ class CFW1TextGeometry : public CFW1Object<IFW1TextGeometry> {
 		virtual void STDMETHODCALLTYPE AddGlyphVertex(const FW1_GLYPHVERTEX *pVertex);
 		
 		virtual FW1_VERTEXDATA STDMETHODCALLTYPE GetGlyphVerticesTemp();
+		virtual FW1_VERTEXDATA STDMETHODCALLTYPE GetGlyphVerticesUnsortedTemp();
+		
+		virtual void STDMETHODCALLTYPE AddPlaceholderGlyphs(UINT Count);
+		virtual UINT STDMETHODCALLTYPE GetPlaceholderGlyphCount();
+		virtual void STDMETHODCALLTYPE AddGlyphVertices(const FW1_GLYPHVERTEX *pVertices, UINT VertexCount);
 	
 	// Public functions
 	public:
@@ -40,6 +45,9 @@ class CFW1TextGeometry : public CFW1Object<IFW1TextGeometry> {
 		std::vector<UINT>				m_vertexCounts;
 		std::vector<UINT>				m_vertexStartIndices;
 		bool							m_sorted;
+		
+		UINT							m_unsortedVertexCount;
+		UINT							m_placeholderCount;
 };
 
 
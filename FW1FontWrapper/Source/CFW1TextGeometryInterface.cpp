@@ -29,6 +29,7 @@ void STDMETHODCALLTYPE CFW1TextGeometry::Clear() {
 	m_maxSheetIndex = 0;
 	
 	m_sorted = false;
+	m_placeholderCount = 0;
 }
 
 
@@ -47,7 +48,17 @@ void STDMETHODCALLTYPE CFW1TextGeometry::AddGlyphVertex(const FW1_GLYPHVERTEX *p
 FW1_VERTEXDATA STDMETHODCALLTYPE CFW1TextGeometry::GetGlyphVerticesTemp() {
 	FW1_VERTEXDATA vertexData;
 	
-	if(!m_vertices.empty()) {
+	if(!m_vertices.empty() && m_maxSheetIndex == 0) {
+		// All glyphs are in the first sheet, so the atlas IDs already are sheet indices and there is nothing to sort
+		m_vertexCounts.resize(1);
+		m_vertexCounts[0] = static_cast<UINT>(m_vertices.size());
+		
+		vertexData.SheetCount = 1;
+		vertexData.pVertexCounts = &m_vertexCounts[0];
+		vertexData.TotalVertexCount = m_vertexCounts[0];
+		vertexData.pVertices = &m_vertices[0];
+	}
+	else if(!m_vertices.empty()) {
 		UINT32 sheetCount = m_maxSheetIndex + 1;
 		
 		// Sort and prepare vertices
@@ -110,4 +121,60 @@ FW1_VERTEXDATA STDMETHODCALLTYPE CFW1TextGeometry::GetGlyphVerticesTemp() {
 }
 
 
+// Get current glyph vertices in insertion order, with full atlas IDs
+FW1_VERTEXDATA STDMETHODCALLTYPE CFW1TextGeometry::GetGlyphVerticesUnsortedTemp() {
+	FW1_VERTEXDATA vertexData;
+	
+	if(!m_vertices.empty()) {
+		m_unsortedVertexCount = static_cast<UINT>(m_vertices.size());
+		
+		vertexData.SheetCount = 1;
+		vertexData.pVertexCounts = &m_unsortedVertexCount;
+		vertexData.TotalVertexCount = m_unsortedVertexCount;
+		vertexData.pVertices = &m_vertices[0];
+	}
+	else {
+		vertexData.SheetCount = 0;
+		vertexData.pVertexCounts = 0;
+		vertexData.TotalVertexCount = 0;
+		vertexData.pVertices = 0;
+	}
+	
+	return vertexData;
+}
+
+
+// Record placeholder glyphs
+void STDMETHODCALLTYPE CFW1TextGeometry::AddPlaceholderGlyphs(UINT Count) {
+	m_placeholderCount += Count;
+}
+
+
+// Get the number of placeholder glyphs
+UINT STDMETHODCALLTYPE CFW1TextGeometry::GetPlaceholderGlyphCount() {
+	return m_placeholderCount;
+}
+
+
+// Add an array of vertices
+void STDMETHODCALLTYPE CFW1TextGeometry::AddGlyphVertices(const FW1_GLYPHVERTEX *pVertices, UINT VertexCount) {
+	if(VertexCount == 0)
+		return;
+	
+	// Grow geometrically, so many small runs don't each reallocate
+	size_t newSize = m_vertices.size() + VertexCount;
+	if(newSize > m_vertices.capacity())
+		m_vertices.reserve(std::max(newSize, m_vertices.capacity() * 2));
+	
+	m_vertices.insert(m_vertices.end(), pVertices, pVertices + VertexCount);
+	
+	UINT maxSheetIndex = m_maxSheetIndex;
+	for(UINT i=0; i < VertexCount; ++i)
+		maxSheetIndex = std::max(maxSheetIndex, pVertices[i].GlyphIndex >> 16);
+	m_maxSheetIndex = maxSheetIndex;
+	
+	m_sorted = false;
+}
+
+
 }// namespace FW1FontWrapper
@@ -89,6 +89,8 @@ class CFW1TextRenderer : public CFW1Object<IFW1TextRenderer> {
 		const void					*m_cachedGlyphMap;
 		IDWriteFontFace				*m_pCachedGlyphMapFontFace;
 		FLOAT						m_cachedGlyphMapFontSize;
+		
+		std::vector<FW1_GLYPHVERTEX>	m_runVertices;
 	
 	
 	// Proxy for IDWriteTextRenderer interface
@@ -140,23 +140,39 @@ HRESULT CFW1TextRenderer::DrawGlyphRun(
 		// Add a vertex for each glyph in the run
 		IFW1TextGeometry *pTextGeometry = static_cast<IFW1TextGeometry*>(clientDrawingContext);
 		if(pTextGeometry != NULL) {
+			UINT placeholderCount = 0;
+			
+			// The vertices of the run are collected and added to the geometry in one call
+			m_runVertices.resize(glyphRun->glyphCount);
+			
 			for(UINT i=0; i < glyphRun->glyphCount; ++i) {
-				glyphVertex.GlyphIndex = m_pGlyphProvider->GetAtlasIdFromGlyphIndex(
+				BOOL isPlaceholder;
+				glyphVertex.GlyphIndex = m_pGlyphProvider->GetAtlasIdOrPlaceholder(
 					glyphMap,
 					glyphRun->glyphIndices[i],
 					glyphRun->fontFace,
-					flags
+					flags,
+					&isPlaceholder
 				);
+				if(isPlaceholder)
+					++placeholderCount;
 				
 				if((glyphRun->bidiLevel & 0x1) != 0)
 					positionX -= glyphRun->glyphAdvances[i];
 				
 				glyphVertex.PositionX = floor(positionX + 0.5f);
-				pTextGeometry->AddGlyphVertex(&glyphVertex);
+				m_runVertices[i] = glyphVertex;
 				
 				if((glyphRun->bidiLevel & 0x1) == 0)
 					positionX += glyphRun->glyphAdvances[i];
 			}
+			
+			if(glyphRun->glyphCount > 0)
+				pTextGeometry->AddGlyphVertices(&m_runVertices[0], glyphRun->glyphCount);
+			
+			// Let the owner of the geometry know to lay it out again once the deferred glyphs are drawn
+			if(placeholderCount > 0)
+				pTextGeometry->AddPlaceholderGlyphs(placeholderCount);
 		}
 	}
 	
@@ -9,7 +9,9 @@
 
 // Define to use LoadLibrary instead of linking to DLLs
 #define FW1_DELAYLOAD_DWRITE_DLL
-#define FW1_DELAYLOAD_D3DCOMPILER_XX_DLL
+
+// Define to use plain loops instead of SSE2/NEON when copying glyph pixels and building mip-levels
+//#define FW1_NOSIMD
 
 
 #endif// IncludeGuard__FW1_FW1CompileSettings_h
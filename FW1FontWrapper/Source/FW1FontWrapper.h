@@ -12,7 +12,7 @@
 
 /// <summary>The current FW1 version.</summary>
 /// <remarks>This constant should be used when calling FW1CreateFactory to make sure the library version matches the headers.</remarks>
-#define FW1_VERSION 0x110f
+#define FW1_VERSION 0x1110
 
 #define FW1_DLL_W L"FW1FontWrapper.dll"
 #define FW1_DLL_A "FW1FontWrapper.dll"
@@ -85,6 +85,27 @@ enum FW1_TEXT_FLAG {
 	/// <summary>A text-layout will be run through DirectWrite and new fonts will be prepared, but no actual drawing will take place, and no additional glyphs will be cached.</summary>
 	FW1_ANALYZEONLY = 0x8000,
 	
+	/// <summary>The glyph atlas stores its sheets as slices of a single texture array, and vertices are drawn in one pass without being sorted by sheet.
+	/// This flag is set internally by the font-wrapper when its atlas was created with IFW1Factory::CreateTextureArrayGlyphAtlas, and is ignored if passed to its methods.</summary>
+	FW1_TEXTUREARRAY = 0x10000,
+	
+	/// <summary>Glyphs are drawn into the atlas at the exact font size, even if the glyph provider snaps font sizes to buckets. See IFW1GlyphProvider::SetFontSizeStep.
+	/// Use this for text that is laid out once and drawn many times, where a scaled glyph image would be noticeable.</summary>
+	FW1_EXACTFONTSIZE = 0x20000,
+	
+	/// <summary>The glyph atlas holds signed distance fields instead of coverage images, and glyphs are drawn with the distance-field pixel shaders.
+	/// This flag is set internally by the font-wrapper when its glyph provider has a distance-field size, and is ignored if passed to its methods. See IFW1GlyphProvider::SetDistanceFieldSize.</summary>
+	FW1_DISTANCEFIELD = 0x40000,
+	
+	/// <summary>Glyphs missing from the atlas are drawn immediately, even if the glyph provider has used up its glyph budget for the frame. See IFW1GlyphProvider::SetGlyphBudget.
+	/// Use this for text that is laid out once and kept, where a placeholder glyph would never be replaced.</summary>
+	FW1_NOGLYPHBUDGET = 0x80000,
+	
+	/// <summary>Glyph quads are expanded in the vertex shader, which reads the glyph vertices and the sheet coord buffers as shader-resources, instead of being built on the CPU.
+	/// Only applies together with FW1_NOGEOMETRYSHADER, and requires feature level 10.0 and an atlas with coord buffers. See IFW1GlyphRenderStates::HasVertexPullingShader and IFW1GlyphAtlas::HasCoordBuffers.
+	/// This flag is set internally by the font-wrapper when it draws without a geometry shader, and is ignored if passed to its methods.</summary>
+	FW1_VERTEXPULLING = 0x100000,
+	
 	/// <summary>Don't use.</summary>
 	FW1_UNUSED = 0xffffffff
 };
@@ -131,6 +152,51 @@ struct FW1_GLYPHSHEETDESC {
 	
 	/// <summary>The number of mip-levels for this sheet's texture.</summary>
 	UINT MipLevels;
+	
+	/// <summary>The number of pixels covered by glyph images, not counting padding. Divide by Width * Height for the sheet utilisation.</summary>
+	UINT UsedArea;
+	
+	/// <summary>The height of the filled part of the sheet, in pixels. Divide UsedArea by Width * PackedHeight for the packing density.</summary>
+	UINT PackedHeight;
+	
+	/// <summary>The number of bytes of texture and coord data sent to the device by the most recent call to IFW1GlyphSheet::Flush, including all mip-levels.</summary>
+	UINT LastFlushBytes;
+	
+	/// <summary>The total number of bytes of texture and coord data sent to the device by this sheet.</summary>
+	UINT64 TotalFlushBytes;
+	
+	/// <summary>TRUE if the sheet texture has been replaced by a BC4 compressed copy. See IFW1GlyphSheet::SetCompression.</summary>
+	BOOL Compressed;
+	
+	/// <summary>The size of this sheet's texture in device memory, including all mip-levels, in bytes.</summary>
+	UINT TextureBytes;
+	
+	/// <summary>The root-mean-square difference between the compressed and the original pixels of the top mip-level, in 8-bit pixel values. 0 if the sheet is not compressed.</summary>
+	FLOAT CompressionError;
+	
+	/// <summary>The largest difference between a compressed and an original pixel of the top mip-level, in 8-bit pixel values. 0 if the sheet is not compressed.</summary>
+	UINT MaxCompressionError;
+};
+
+/// <summary>Counts of the glyphs a glyph provider has added to its atlas.</summary>
+/// <remarks>This structure is filled in by IFW1GlyphProvider::GetStatistics.</remarks>
+struct FW1_GLYPHPROVIDERSTATS {
+	/// <summary>The number of glyph images drawn and inserted into the atlas.</summary>
+	UINT RasterizedGlyphCount;
+	
+	/// <summary>The number of glyphs added by scaling the image of the same glyph at a bucket font size. See IFW1GlyphProvider::SetFontSizeStep.</summary>
+	UINT ScaledGlyphCount;
+	
+	/// <summary>The area in pixels, including padding, that the scaled glyphs would have used in the atlas if drawn at their exact size.
+	/// This is roughly the number of atlas bytes saved at the top mip-level.</summary>
+	UINT64 ScaledGlyphArea;
+	
+	/// <summary>The number of glyphs queued for a later frame because the glyph budget was used up. See IFW1GlyphProvider::SetGlyphBudget.</summary>
+	UINT DeferredGlyphCount;
+	
+	/// <summary>The total number of queued glyphs that have since been drawn.
+	/// When this changes, geometry holding placeholder glyphs can be laid out again to pick up the real glyphs. See IFW1TextGeometry::GetPlaceholderGlyphCount.</summary>
+	UINT DeferredDrawnCount;
 };
 
 /// <summary>Metrics for a glyph image.</summary>
@@ -267,7 +333,8 @@ struct FW1_FONTWRAPPERCREATEPARAMS {
 	/// 0 defaults to 384.</summary>
 	UINT MaxGlyphHeight;
 	
-	/// <summary>If set to TRUE, no geometry shader is used.</summary>
+	/// <summary>If set to TRUE, no geometry shader is used.
+	/// On feature level 10.0 and above glyph quads are then expanded in the vertex shader, see FW1_VERTEXPULLING.</summary>
 	BOOL DisableGeometryShader;
 	
 	/// <summary>The size in bytes of the dynamic vertex buffer to upload glyph vertices to when drawing a string. 0 defaults to 4096 * 16.<br/>
@@ -276,6 +343,24 @@ struct FW1_FONTWRAPPERCREATEPARAMS {
 	
 	/// <summary>Description of the default font. See FW1_DWRITEFONTPARAMS.</summary>
 	FW1_DWRITEFONTPARAMS DefaultFontParams;
+	
+	/// <summary>If non-zero, the glyph sheets are allocated up front as this many slices of one texture array, and all text is drawn without rebinding textures between sheets.
+	/// Requires feature level 10.0. See IFW1Factory::CreateTextureArrayGlyphAtlas. 0 uses one texture per sheet.</summary>
+	UINT TextureArraySize;
+	
+	/// <summary>The font size step glyph images are snapped to. See IFW1GlyphProvider::SetFontSizeStep. 0 draws every font size exactly.</summary>
+	FLOAT FontSizeStep;
+	
+	/// <summary>If non-zero, glyphs are stored as signed distance fields drawn at this font size, and scaled to every other size. See IFW1GlyphProvider::SetDistanceFieldSize.
+	/// Requires feature level 10.0. 0 stores coverage images.</summary>
+	FLOAT DistanceFieldSize;
+	
+	/// <summary>If set to TRUE, glyph images are drawn by filling glyph outlines instead of through a GDI render target. See IFW1GlyphProvider::SetOutlineRasterizer.</summary>
+	BOOL OutlineRasterizer;
+	
+	/// <summary>If set to TRUE, full glyph sheets are compressed to BC4 to halve their memory. See IFW1GlyphAtlas::SetSheetCompression.
+	/// Ignored when TextureArraySize is non-zero.</summary>
+	BOOL CompressGlyphSheets;
 };
 
 interface IFW1Factory;
@@ -337,11 +422,12 @@ MIDL_INTERFACE("60CAB266-C805-461d-82C0-392472EECEFA") IFW1GlyphSheet : public I
 		) = 0;
 		
 		/// <summary>Set the sheet shader resources on the provided context.</summary>
-		/// <remarks>This method sets the sheet texture as a pixelshader resource for slot 0, and optionally the coord buffer as geometryshader resource for slot 0.</remarks>
+		/// <remarks>This method sets the sheet texture as a pixelshader resource for slot 0, and optionally the coord buffer as geometryshader or vertexshader resource for slot 0.</remarks>
 		/// <returns>Standard HRESULT error code.</returns>
 		/// <param name="pContext">The context to set the sheet shader resources on.</param>
 		/// <param name="Flags">This parameter can include zero or more of the following values, ORd together. Any additional values are ignored.<br/>
-		/// FW1_NOGEOMETRYSHADER: don't bind the coord buffer as a shader-resource for the geometry shader, even if it's available.
+		/// FW1_NOGEOMETRYSHADER: don't bind the coord buffer as a shader-resource for the geometry shader, even if it's available.<br/>
+		/// FW1_VERTEXPULLING: bind the coord buffer as a shader-resource for the vertex shader, if it's available.
 		/// </param>
 		virtual HRESULT STDMETHODCALLTYPE BindSheet(
 			__in ID3D11DeviceContext *pContext,
@@ -372,12 +458,61 @@ MIDL_INTERFACE("60CAB266-C805-461d-82C0-392472EECEFA") IFW1GlyphSheet : public I
 		
 		/// <summary>Flush any new glyphs to the internal D3D11 buffers.</summary>
 		/// <remarks>When glyphs are inserted into the sheet only the CPU-memory resources are updated.
-		/// In order for these to be available for use by the GPU, they must be flushed to the device using a device-context.</remarks>
+		/// In order for these to be available for use by the GPU, they must be flushed to the device using a device-context.
+		/// Only the regions of the texture touched since the previous flush are uploaded, see FW1_GLYPHSHEETDESC::LastFlushBytes.</remarks>
 		/// <returns>No return value.</returns>
 		/// <param name="pContext">The context to use when updating device resources.</param>
 		virtual void STDMETHODCALLTYPE Flush(
 			__in ID3D11DeviceContext *pContext
 		) = 0;
+		
+		/// <summary>Insert a glyph that reuses the image of a glyph already in the sheet, drawn at a different scale.</summary>
+		/// <remarks>The new glyph has the same texture coordinates as the source glyph, and its position coordinates are scaled around the glyph origin.
+		/// No texture space is used, so this works even after the sheet is closed, as long as the sheet has room for more glyph coordinates.</remarks>
+		/// <returns>The index of the new glyph in the sheet, or 0xFFFFFFFF on failure.</returns>
+		/// <param name="SourceGlyphIndex">The index in the sheet of the glyph whose image is reused.</param>
+		/// <param name="Scale">The factor to scale the glyph's quad by.</param>
+		virtual UINT STDMETHODCALLTYPE InsertGlyphAlias(
+			__in UINT SourceGlyphIndex,
+			__in FLOAT Scale
+		) = 0;
+		
+		/// <summary>Copy the top mip-level of the sheet texture to system memory.</summary>
+		/// <remarks>The pixels are copied from the RAM copy of the texture while the sheet has one.
+		/// A closed sheet releases its RAM copy when flushed, and the texture is then read back from the device through a staging texture, which waits for the device to finish with it.
+		/// This is meant for saving the sheet, not for use every frame.</remarks>
+		/// <returns>Standard HRESULT error code.</returns>
+		/// <param name="pContext">The context used to read back the device texture when there is no RAM copy.</param>
+		/// <param name="pPixels">Address of a buffer of at least Width * Height bytes that receives the 8-bit pixels, row by row. See IFW1GlyphSheet::GetDesc.</param>
+		virtual HRESULT STDMETHODCALLTYPE GetSheetPixels(
+			__in ID3D11DeviceContext *pContext,
+			__out void *pPixels
+		) = 0;
+		
+		/// <summary>Fill an empty sheet with glyphs saved from another sheet of the same size.</summary>
+		/// <remarks>The sheet is closed afterwards, so no new glyphs can be inserted, though glyph aliases can still be added.
+		/// The mip-levels are calculated from the pixels, and the sheet is uploaded by the next call to IFW1GlyphSheet::Flush.</remarks>
+		/// <returns>Standard HRESULT error code. Fails with E_FAIL if the sheet already holds glyphs.</returns>
+		/// <param name="pPixels">The 8-bit pixels of the top rows of the sheet, as obtained by IFW1GlyphSheet::GetSheetPixels.</param>
+		/// <param name="RowCount">The number of rows in pPixels. The rows below are left empty. See FW1_GLYPHSHEETDESC::PackedHeight.</param>
+		/// <param name="pGlyphCoords">The coordinates of the glyphs, as obtained by IFW1GlyphSheet::GetGlyphCoords.</param>
+		/// <param name="GlyphCount">The number of glyphs in pGlyphCoords.</param>
+		virtual HRESULT STDMETHODCALLTYPE SetSheetContents(
+			__in const void *pPixels,
+			__in UINT RowCount,
+			__in const FW1_GLYPHCOORDS *pGlyphCoords,
+			__in UINT GlyphCount
+		) = 0;
+		
+		/// <summary>Set whether the sheet texture is compressed once the sheet is closed.</summary>
+		/// <remarks>When set, the flush that makes a closed sheet static compresses every mip-level of the RAM copy to BC4 on the CPU, and replaces the 8-bit texture with an immutable BC4 texture of half the size.
+		/// Sheets that take new glyphs keep their 8-bit texture, so glyphs can still be uploaded to them. Coverage is stored with up to 8 levels per 4x4 block, see FW1_GLYPHSHEETDESC::CompressionError for the quality of a compressed sheet.<br/>
+		/// A sheet that is already static, or whose RAM copy has been released, is not compressed. GetSheetPixels reads back and decodes the compressed texture.</remarks>
+		/// <returns>Standard HRESULT error code. Fails with E_FAIL when enabling compression on a texture-array slice, or on a sheet whose mip-levels are not all multiples of 4 pixels in width and height.</returns>
+		/// <param name="Compress">TRUE to compress the sheet, FALSE to keep it uncompressed.</param>
+		virtual HRESULT STDMETHODCALLTYPE SetCompression(
+			__in BOOL Compress
+		) = 0;
 };
 
 /// <summary>A glyph-atlas is a collection of glyph-sheets.</summary>
@@ -464,6 +599,93 @@ MIDL_INTERFACE("A31EB6A2-7458-4e24-82B3-945A95623B1F") IFW1GlyphAtlas : public I
 	virtual void STDMETHODCALLTYPE Flush(
 		__in ID3D11DeviceContext *pContext
 	) = 0;
+	
+	/// <summary>Get the amount of device memory used by the sheet textures in the atlas.</summary>
+	/// <remarks></remarks>
+	/// <returns>The size of all sheet textures including their mip-levels, in bytes.</returns>
+	virtual UINT64 STDMETHODCALLTYPE GetMemoryUsage(
+	) = 0;
+	
+	/// <summary>Remove sheets from the atlas and compact the remaining sheets.</summary>
+	/// <remarks>Sheets are removed in the order they are listed until at least BytesToFree bytes have been released.
+	/// The first sheet, which holds the atlas default-glyph, and sheets that are still open for insertion or waiting for their last flush are never removed.<br/>
+	/// Removing sheets changes the index of the sheets after them, so all atlas IDs must be remapped using pSheetRemap.
+	/// This method must not be called while glyphs are being inserted or geometry referencing the atlas is being drawn.</remarks>
+	/// <returns>The number of sheets removed.</returns>
+	/// <param name="pSheetIndices">Array of indices of the sheets to remove, in order of preference.</param>
+	/// <param name="IndexCount">The number of indices in pSheetIndices.</param>
+	/// <param name="BytesToFree">The amount of memory to release. Pass 0xFFFFFFFFFFFFFFFF to remove every listed sheet.</param>
+	/// <param name="pSheetRemap">Array of at least GetSheetCount() entries, that receives the new index of each sheet, or 0xFFFFFFFF for removed sheets.</param>
+	virtual UINT STDMETHODCALLTYPE RemoveSheets(
+		__in const UINT *pSheetIndices,
+		__in UINT IndexCount,
+		__in UINT64 BytesToFree,
+		__out UINT *pSheetRemap
+	) = 0;
+	
+	/// <summary>Get the number of times sheets have been removed from the atlas.</summary>
+	/// <remarks>Atlas IDs stored outside the glyph-provider are invalid once this value changes, and text laid out earlier must be laid out again.
+	/// Static geometry keeps its sheets alive and is not affected.</remarks>
+	/// <returns>The number of calls to RemoveSheets that removed at least one sheet.</returns>
+	virtual UINT STDMETHODCALLTYPE GetRemovalCount(
+	) = 0;
+	
+	/// <summary>Get the number of slices in the texture array holding the sheets.</summary>
+	/// <remarks>Sheets in a texture-array atlas share one texture and one coordinate texture, and binding any sheet binds all of them.
+	/// The sheet index in an atlas ID is the slice index, so vertices can be drawn without sorting them by sheet. See FW1_TEXTUREARRAY.<br/>
+	/// Slices are fixed once allocated, so RemoveSheets never removes sheets from a texture-array atlas, and InsertSheet always fails as the atlas creates its sheets itself.</remarks>
+	/// <returns>The number of slices, or 0 if each sheet has its own texture.</returns>
+	virtual UINT STDMETHODCALLTYPE GetTextureArraySize(
+	) = 0;
+	
+	/// <summary>Get the amount of data uploaded to the device when flushing the atlas.</summary>
+	/// <remarks>Each sheet uploads only the regions touched by glyphs inserted since its last flush. See FW1_GLYPHSHEETDESC::LastFlushBytes.</remarks>
+	/// <returns>The total number of bytes uploaded by all calls to Flush.</returns>
+	/// <param name="pLastFlushBytes">Optional address of a variable that receives the number of bytes uploaded by the most recent call to Flush.</param>
+	virtual UINT64 STDMETHODCALLTYPE GetFlushBytes(
+		__out_opt UINT64 *pLastFlushBytes
+	) = 0;
+	
+	/// <summary>Insert a glyph that reuses the image of a glyph already in the atlas, drawn at a different scale.</summary>
+	/// <remarks>The new glyph is placed in the same sheet as the source glyph. See IFW1GlyphSheet::InsertGlyphAlias.</remarks>
+	/// <returns>The atlas ID of the new glyph, or 0xFFFFFFFF on failure.</returns>
+	/// <param name="GlyphAtlasId">The atlas ID of the glyph whose image is reused.</param>
+	/// <param name="Scale">The factor to scale the glyph's quad by.</param>
+	virtual UINT STDMETHODCALLTYPE InsertGlyphAlias(
+		__in UINT GlyphAtlasId,
+		__in FLOAT Scale
+	) = 0;
+	
+	/// <summary>Add a new sheet to the atlas, filled with saved glyphs.</summary>
+	/// <remarks>The sheet is created the same way as a sheet for new glyphs, so this also works with a texture-array atlas. It is then filled by IFW1GlyphSheet::SetSheetContents.
+	/// The saved atlas IDs of the glyphs must be remapped to the new sheet index.</remarks>
+	/// <returns>The index of the new sheet in the atlas, or 0xFFFFFFFF on failure.</returns>
+	/// <param name="pPixels">The 8-bit pixels of the top rows of the sheet.</param>
+	/// <param name="RowCount">The number of rows in pPixels.</param>
+	/// <param name="pGlyphCoords">The coordinates of the glyphs.</param>
+	/// <param name="GlyphCount">The number of glyphs in pGlyphCoords.</param>
+	virtual UINT STDMETHODCALLTYPE InsertSheetContents(
+		__in const void *pPixels,
+		__in UINT RowCount,
+		__in const FW1_GLYPHCOORDS *pGlyphCoords,
+		__in UINT GlyphCount
+	) = 0;
+	
+	/// <summary>Set whether sheets are compressed once they are closed.</summary>
+	/// <remarks>The setting applies to the sheets in the atlas and to sheets created later. See IFW1GlyphSheet::SetCompression.
+	/// Compressed sheets count at their compressed size in GetMemoryUsage.</remarks>
+	/// <returns>Standard HRESULT error code. Fails with E_FAIL for a texture-array atlas, whose slices share one 8-bit texture.</returns>
+	/// <param name="Compress">TRUE to compress closed sheets, FALSE to keep new sheets uncompressed.</param>
+	virtual HRESULT STDMETHODCALLTYPE SetSheetCompression(
+		__in BOOL Compress
+	) = 0;
+	
+	/// <summary>Returns whether the sheets in the atlas have coord buffers that shaders can read.</summary>
+	/// <remarks>Coord buffers are needed to expand glyph quads on the GPU, either in the geometry shader or with FW1_VERTEXPULLING.
+	/// They are available if the atlas was created with hardware coord buffers on feature level 10.0 or above, and always for a texture-array atlas.</remarks>
+	/// <returns>Returns TRUE if the sheets have coord buffers, and otherwise returns FALSE.</returns>
+	virtual BOOL STDMETHODCALLTYPE HasCoordBuffers(
+	) = 0;
 };
 
 /// <summary>Collection of glyph-maps, mapping font/size/glyph information to an ID in a glyph atlas.</summary>
@@ -531,6 +753,175 @@ MIDL_INTERFACE("F8360043-329D-4EC9-B0F8-ACB00FA77420") IFW1GlyphProvider : publi
 		__in IDWriteFontFace *pFontFace,
 		__in UINT FontFlags
 	) = 0;
+	
+	/// <summary>Advance the frame counter used to track when each glyph was last used.</summary>
+	/// <remarks>Every glyph queried with IFW1GlyphProvider::GetAtlasIdFromGlyphIndex is marked with the current frame.</remarks>
+	/// <returns>The new frame number.</returns>
+	virtual UINT STDMETHODCALLTYPE NewFrame(
+	) = 0;
+	
+	/// <summary>Evict the least recently used sheets from the glyph-atlas until it fits in a memory budget.</summary>
+	/// <remarks>Only sheets where no glyph has been used for at least MinFrameAge frames are evicted, so glyphs referenced by geometry of the current frame are never affected.
+	/// Glyph-map entries in evicted sheets are cleared and the glyphs are drawn again on demand, entries in the remaining sheets are remapped to their new atlas IDs.<br/>
+	/// Call this between frames, it must not run concurrently with text layout or drawing. See IFW1GlyphAtlas::RemoveSheets.<br/>
+	/// Atlases backed by a texture array never evict sheets, see IFW1GlyphAtlas::GetTextureArraySize, so the method returns 0 without scanning the glyph-maps.</remarks>
+	/// <returns>The number of sheets evicted.</returns>
+	/// <param name="MemoryBudget">The maximum memory the atlas sheets should use, in bytes. See IFW1GlyphAtlas::GetMemoryUsage.</param>
+	/// <param name="MinFrameAge">The number of frames a sheet must have been unused for before it can be evicted.</param>
+	virtual UINT STDMETHODCALLTYPE TrimGlyphAtlas(
+		__in UINT64 MemoryBudget,
+		__in UINT MinFrameAge
+	) = 0;
+	
+	/// <summary>Get the system memory used by glyph-maps.</summary>
+	/// <remarks>Glyph-maps store glyphs in pages of 256 consecutive glyph indices, and a page is only allocated when a glyph in it is first used.
+	/// A glyph-map for a large font where few glyphs are drawn therefore stays small.</remarks>
+	/// <returns>The number of bytes used by the glyph-map, or by all glyph-maps if pGlyphMap is NULL.</returns>
+	/// <param name="pGlyphMap">A pointer identifying a glyph-map, previously obtained using IFW1GlyphProvider::GetGlyphMapFromFont, or NULL.</param>
+	virtual UINT64 STDMETHODCALLTYPE GetGlyphMapMemoryUsage(
+		__in_opt const void *pGlyphMap
+	) = 0;
+	
+	/// <summary>Set the step that font sizes are snapped to before glyphs are drawn.</summary>
+	/// <remarks>With a non-zero step, a font size that is not a multiple of the step gets glyphs drawn at the nearest multiple, and scaled to the requested size when drawn.
+	/// Text animated through many sizes then shares one set of glyph images per step instead of drawing new glyphs for every size.
+	/// Text laid out with FW1_EXACTFONTSIZE is always drawn at its exact size.<br/>
+	/// Glyph-maps already created keep the size they were created with. Call this before laying out text, not concurrently with it.</remarks>
+	/// <returns>No return value.</returns>
+	/// <param name="FontSizeStep">The size step, for example 1.0 to snap to whole sizes. 0 disables snapping.</param>
+	virtual void STDMETHODCALLTYPE SetFontSizeStep(
+		__in FLOAT FontSizeStep
+	) = 0;
+	
+	/// <summary>Get counts of the glyphs drawn into the atlas and the glyphs scaled from another font size.</summary>
+	/// <remarks>Compare the counts with and without a font size step to see how many glyphs and atlas bytes snapping saves.</remarks>
+	/// <returns>No return value.</returns>
+	/// <param name="pStats">Pointer to an FW1_GLYPHPROVIDERSTATS structure to fill in.</param>
+	virtual void STDMETHODCALLTYPE GetStatistics(
+		__out FW1_GLYPHPROVIDERSTATS *pStats
+	) = 0;
+	
+	/// <summary>Store glyphs as signed distance fields drawn at one font size.</summary>
+	/// <remarks>Each glyph is drawn once at the distance-field size, converted to a distance field padded by a spread of about an eighth of the size, and every other font size uses a scaled alias of that image.
+	/// One atlas entry then serves all sizes, and text stays sharp when scaled up. The font size step and FW1_EXACTFONTSIZE are ignored in this mode.<br/>
+	/// The atlas must be drawn with the distance-field pixel shaders, see FW1_DISTANCEFIELD. Fine detail of small text is softer than with coverage images, so pick a size around the largest commonly drawn size.<br/>
+	/// This can only be set before the first glyph-map is created.</remarks>
+	/// <returns>Standard HRESULT error code. Fails with E_FAIL if glyph-maps have already been created.</returns>
+	/// <param name="FontSize">The font size to draw glyphs at, for example 48.0. 0 stores coverage images.</param>
+	virtual HRESULT STDMETHODCALLTYPE SetDistanceFieldSize(
+		__in FLOAT FontSize
+	) = 0;
+	
+	/// <summary>Get the font size glyphs are drawn at as distance fields.</summary>
+	/// <remarks>See IFW1GlyphProvider::SetDistanceFieldSize.</remarks>
+	/// <returns>The distance-field font size, or 0 if the atlas stores coverage images.</returns>
+	virtual FLOAT STDMETHODCALLTYPE GetDistanceFieldSize(
+	) = 0;
+	
+	/// <summary>Draw glyphs into the atlas on a worker thread, before they are needed by text.</summary>
+	/// <remarks>The characters are mapped to glyphs in the font-face, and any glyphs not already in the glyph-map for the font size are drawn and inserted on the system thread pool, using the same render targets as glyphs drawn on demand.
+	/// This moves the cost of drawing new glyphs off the thread that lays out text. The glyphs are uploaded to the device by the next call to IFW1GlyphAtlas::Flush after they are inserted.<br/>
+	/// Text laid out while a prewarm task runs draws any missing glyphs itself as usual. Don't call IFW1GlyphProvider::TrimGlyphAtlas while tasks are pending, see IFW1GlyphProvider::GetPendingPrewarmCount.</remarks>
+	/// <returns>Standard HRESULT error code. Success means the task was queued.</returns>
+	/// <param name="pFontFace">The DirectWrite font face to draw glyphs from.</param>
+	/// <param name="FontSize">The font size the glyphs will be drawn at.</param>
+	/// <param name="FontFlags">Can include zero or more of the following values, ORd together. Any additional values are ignored.<br/>
+	/// FW1_ALIASED - The glyphs are drawn aliased, for text drawn with that flag.<br/>
+	/// FW1_EXACTFONTSIZE - The glyphs are drawn at the exact size even if a font size step is set.
+	/// </param>
+	/// <param name="pszCharacters">The characters to draw glyphs for, as UTF-16. Does not need to be NULL-terminated.</param>
+	/// <param name="CharacterCount">The number of WCHARs in the string.</param>
+	virtual HRESULT STDMETHODCALLTYPE PrewarmGlyphs(
+		__in IDWriteFontFace *pFontFace,
+		__in FLOAT FontSize,
+		__in UINT FontFlags,
+		__in const WCHAR *pszCharacters,
+		__in UINT32 CharacterCount
+	) = 0;
+	
+	/// <summary>Get the number of prewarm tasks queued or running.</summary>
+	/// <remarks>See IFW1GlyphProvider::PrewarmGlyphs.</remarks>
+	/// <returns>The number of unfinished prewarm tasks.</returns>
+	virtual UINT STDMETHODCALLTYPE GetPendingPrewarmCount(
+	) = 0;
+	
+	/// <summary>Limit how many glyphs are drawn per frame.</summary>
+	/// <remarks>Once either limit is reached in a frame, further glyphs missing from the atlas are queued instead of drawn, and the font's default glyph is returned in their place.
+	/// Queued glyphs are drawn by IFW1GlyphProvider::NewFrame, within the budget of the new frame.
+	/// Glyphs scaled from an existing image and text laid out with FW1_NOGLYPHBUDGET are not limited.<br/>
+	/// Call this before laying out text, not concurrently with it.</remarks>
+	/// <returns>No return value.</returns>
+	/// <param name="MaxGlyphsPerFrame">The number of glyphs that can be drawn per frame. 0 means no limit.</param>
+	/// <param name="MaxMicrosecondsPerFrame">The time that can be spent drawing glyphs per frame, in microseconds. 0 means no limit.</param>
+	virtual void STDMETHODCALLTYPE SetGlyphBudget(
+		__in UINT MaxGlyphsPerFrame,
+		__in UINT MaxMicrosecondsPerFrame
+	) = 0;
+	
+	/// <summary>Get the ID of the specified glyph in the glyph-atlas, and whether a placeholder was returned in its place.</summary>
+	/// <remarks>Identical to IFW1GlyphProvider::GetAtlasIdFromGlyphIndex, except that it reports when the glyph was deferred because the glyph budget was used up. See IFW1GlyphProvider::SetGlyphBudget.</remarks>
+	/// <returns>The ID of the specified glyph in the glyph-atlas, or of the placeholder glyph.</returns>
+	/// <param name="pGlyphMap">A pointer identifying a glyph-map, previously obtained using IFW1GlyphProvider::GetGlyphMapFromFont.</param>
+	/// <param name="GlyphIndex">The index of the glyph in the DirectWrite font face.</param>
+	/// <param name="pFontFace">The DirectWrite font face that contains the glyph referenced by GlyphIndex.</param>
+	/// <param name="FontFlags">Can include zero or more of the following values, ORd together. Any additional values are ignored.<br/>
+	/// FW1_NONEWGLYPHS - No new glyphs are inserted.<br/>
+	/// FW1_NOGLYPHBUDGET - The glyph is drawn immediately even if the glyph budget is used up.</param>
+	/// <param name="pIsPlaceholder">Address of a BOOL set to TRUE if the glyph was deferred and a placeholder returned, and FALSE otherwise. Can be NULL.</param>
+	virtual UINT STDMETHODCALLTYPE GetAtlasIdOrPlaceholder(
+		__in const void *pGlyphMap,
+		__in UINT16 GlyphIndex,
+		__in IDWriteFontFace *pFontFace,
+		__in UINT FontFlags,
+		__out_opt BOOL *pIsPlaceholder
+	) = 0;
+	
+	/// <summary>Save the glyph-atlas and glyph-maps to a file, so a later run can load them with IFW1GlyphProvider::LoadGlyphCache.</summary>
+	/// <remarks>The file holds the pixels and glyph coordinates of every sheet, and the glyphs of every glyph-map, keyed by font unique name, size and flags.
+	/// Each font is stored with a hash of its font files' keys, sizes and last write times. Glyphs are then not reused if a font file has changed.
+	/// The file is written under a temporary name and then renamed, so an interrupted save leaves the previous file intact.<br/>
+	/// Closed sheets that have been flushed are read back from the device, see IFW1GlyphSheet::GetSheetPixels.
+	/// Call this between frames, typically at shutdown. It must not run concurrently with text layout.</remarks>
+	/// <returns>Standard HRESULT error code.</returns>
+	/// <param name="pContext">The context used to read back sheet textures.</param>
+	/// <param name="pszFileName">The name of the file to write.</param>
+	virtual HRESULT STDMETHODCALLTYPE SaveGlyphCache(
+		__in ID3D11DeviceContext *pContext,
+		__in const WCHAR *pszFileName
+	) = 0;
+	
+	/// <summary>Load glyphs saved by IFW1GlyphProvider::SaveGlyphCache, so that they don't have to be drawn again.</summary>
+	/// <remarks>The file is memory-mapped. Its sheets are added to the atlas as closed sheets and uploaded by the next flush, and its glyph-maps are restored.
+	/// A font-face is matched to a saved font by unique name when first used. A saved font whose file hash differs from the font-face's is ignored, and its glyphs are drawn again.<br/>
+	/// The file must have been saved with the same sheet size, mip-level count and distance-field size.
+	/// This can only be called before the first glyph-map is created.</remarks>
+	/// <returns>Standard HRESULT error code. Fails with E_FAIL if glyph-maps have already been created, or if the file does not match the atlas or is damaged.</returns>
+	/// <param name="pszFileName">The name of the file to load.</param>
+	virtual HRESULT STDMETHODCALLTYPE LoadGlyphCache(
+		__in const WCHAR *pszFileName
+	) = 0;
+	
+	/// <summary>Stop drawing glyph images, so that only the glyphs already in the atlas are used.</summary>
+	/// <remarks>Intended for an atlas baked offline and loaded with IFW1GlyphProvider::LoadGlyphCache, after which no glyph is rasterized at runtime.
+	/// Glyph-maps can still be created, and glyphs scaled from an image in the atlas are still added as aliases, see IFW1GlyphProvider::SetFontSizeStep.
+	/// Any other glyph missing from the atlas is replaced by the font's default glyph, or by the atlas default glyph if that is missing too.
+	/// Glyphs are not queued against the glyph budget while the atlas is static.<br/>
+	/// Call this before laying out text, not concurrently with it.</remarks>
+	/// <returns>No return value.</returns>
+	/// <param name="StaticAtlas">TRUE to stop drawing glyph images, FALSE to draw missing glyphs again.</param>
+	virtual void STDMETHODCALLTYPE SetStaticGlyphAtlas(
+		__in BOOL StaticAtlas
+	) = 0;
+	
+	/// <summary>Draw glyph images by filling glyph outlines, instead of through a DirectWrite GDI render target.</summary>
+	/// <remarks>The outline of each glyph is read from its font-face and filled directly into 8-bit coverage, with no GDI bitmap to clear and no 32-bit pixels to convert.
+	/// Outlines are not hinted, so small text is softer than with the default render target, and FW1_ALIASED glyphs are thresholded coverage. See IFW1Factory::CreateOutlineRenderTarget.<br/>
+	/// This can only be set before the first glyph-map is created.</remarks>
+	/// <returns>Standard HRESULT error code. Fails with E_FAIL if glyph-maps have already been created.</returns>
+	/// <param name="UseOutlines">TRUE to fill glyph outlines, FALSE to use the DirectWrite render target.</param>
+	virtual HRESULT STDMETHODCALLTYPE SetOutlineRasterizer(
+		__in BOOL UseOutlines
+	) = 0;
 };
 
 /// <summary>Container for a DirectWrite render-target, used to draw glyph images that are to be inserted in a glyph atlas.</summary>
@@ -634,6 +1025,43 @@ MIDL_INTERFACE("51E05736-6AFF-44A8-9745-77605C99E8F2") IFW1TextGeometry : public
 	/// They are valid until the next call to a method in the IFW1TextGeometry.</returns>
 	virtual FW1_VERTEXDATA STDMETHODCALLTYPE GetGlyphVerticesTemp(
 	) = 0;
+	
+	/// <summary>Get the vertices in the geometry, in the order they were added.</summary>
+	/// <remarks>The returned FW1_VERTEXDATA has a single sheet count covering all vertices, and each vertex keeps its full atlas ID.
+	/// This is the format used with texture-array atlases, where no sorting is needed. See IFW1GlyphAtlas::GetTextureArraySize.<br/>
+	/// This method is not thread-safe.</remarks>
+	/// <returns>An FW1_VERTEXDATA structure containing the glyph vertices.
+	/// The pointers in this structure are owned by the geometry object and should not be modified.
+	/// They are valid until the next call to a method in the IFW1TextGeometry.</returns>
+	virtual FW1_VERTEXDATA STDMETHODCALLTYPE GetGlyphVerticesUnsortedTemp(
+	) = 0;
+	
+	/// <summary>Record that vertices in the geometry reference placeholder glyphs.</summary>
+	/// <remarks>The text-renderer calls this when the glyph provider returns a placeholder for a glyph it deferred to a later frame. The count is reset by IFW1TextGeometry::Clear.<br/>
+	/// This method is not thread-safe.</remarks>
+	/// <returns>No return value.</returns>
+	/// <param name="Count">The number of placeholder vertices added.</param>
+	virtual void STDMETHODCALLTYPE AddPlaceholderGlyphs(
+		__in UINT Count
+	) = 0;
+	
+	/// <summary>Get the number of vertices in the geometry that reference placeholder glyphs.</summary>
+	/// <remarks>Geometry that is kept between frames and has placeholder glyphs should be laid out again once the glyph provider has drawn its deferred glyphs. See FW1_GLYPHPROVIDERSTATS.<br/>
+	/// This method is not thread-safe.</remarks>
+	/// <returns>The number of placeholder vertices.</returns>
+	virtual UINT STDMETHODCALLTYPE GetPlaceholderGlyphCount(
+	) = 0;
+	
+	/// <summary>Adds an array of vertices to the geometry.</summary>
+	/// <remarks>This is the same as calling IFW1TextGeometry::AddGlyphVertex for each vertex, but the storage grows at most once.<br/>
+	/// This method is not thread-safe.</remarks>
+	/// <returns>No return value.</returns>
+	/// <param name="pVertices">Pointer to an array of FW1_GLYPHVERTEX structures describing the vertices.</param>
+	/// <param name="VertexCount">The number of vertices in pVertices.</param>
+	virtual void STDMETHODCALLTYPE AddGlyphVertices(
+		__in const FW1_GLYPHVERTEX *pVertices,
+		__in UINT VertexCount
+	) = 0;
 };
 
 /// <summary>A text-renderer converts DirectWrite text layouts into glyph-vertices.</summary>
@@ -672,6 +1100,151 @@ MIDL_INTERFACE("51E05736-6AFF-44A8-9745-77605C99E8F2") IFW1TextRenderer : public
 	) = 0;
 };
 
+/// <summary>Keeps track of pipeline states bound on a device context, so that a state which is already bound is not set again.</summary>
+/// <remarks>The tracker knows only the states set through it, and the first time each state is set it is always passed on to the context.
+/// If any tracked state is set on the context directly, call IFW1StateTracker::Invalidate before using the tracker again.
+/// Vertex and index buffers and shader-resources are not tracked.<br/>
+/// Create a state tracker using IFW1Factory::CreateStateTracker, and attach it to a font-wrapper with IFW1FontWrapper::SetStateTracker.</remarks>
+MIDL_INTERFACE("083CCA7D-A45F-41E5-B2F4-E4315935032B") IFW1StateTracker : public IFW1Object {
+	/// <summary>Get the device context that the tracker sets states on.</summary>
+	/// <remarks></remarks>
+	/// <returns>Standard HRESULT error code.</returns>
+	/// <param name="ppContext">Address of a pointer to an ID3D11DeviceContext.</param>
+	virtual HRESULT STDMETHODCALLTYPE GetDeviceContext(
+		__out ID3D11DeviceContext **ppContext
+	) = 0;
+	
+	/// <summary>Set the primitive topology, unless it is already set.</summary>
+	/// <remarks></remarks>
+	/// <returns>No return value.</returns>
+	/// <param name="Topology">The primitive topology.</param>
+	virtual void STDMETHODCALLTYPE SetPrimitiveTopology(
+		__in D3D11_PRIMITIVE_TOPOLOGY Topology
+	) = 0;
+	
+	/// <summary>Set the input layout, unless it is already set.</summary>
+	/// <remarks></remarks>
+	/// <returns>No return value.</returns>
+	/// <param name="pInputLayout">The input layout, or NULL.</param>
+	virtual void STDMETHODCALLTYPE SetInputLayout(
+		__in ID3D11InputLayout *pInputLayout
+	) = 0;
+	
+	/// <summary>Set the vertex shader, without class instances, unless it is already set.</summary>
+	/// <remarks></remarks>
+	/// <returns>No return value.</returns>
+	/// <param name="pShader">The vertex shader, or NULL.</param>
+	virtual void STDMETHODCALLTYPE SetVertexShader(
+		__in ID3D11VertexShader *pShader
+	) = 0;
+	
+	/// <summary>Set the geometry shader, without class instances, unless it is already set.</summary>
+	/// <remarks>Requires feature level 10.0.</remarks>
+	/// <returns>No return value.</returns>
+	/// <param name="pShader">The geometry shader, or NULL.</param>
+	virtual void STDMETHODCALLTYPE SetGeometryShader(
+		__in ID3D11GeometryShader *pShader
+	) = 0;
+	
+	/// <summary>Set the pixel shader, without class instances, unless it is already set.</summary>
+	/// <remarks></remarks>
+	/// <returns>No return value.</returns>
+	/// <param name="pShader">The pixel shader, or NULL.</param>
+	virtual void STDMETHODCALLTYPE SetPixelShader(
+		__in ID3D11PixelShader *pShader
+	) = 0;
+	
+	/// <summary>Set the hull shader, without class instances, unless it is already set.</summary>
+	/// <remarks>Requires feature level 11.0.</remarks>
+	/// <returns>No return value.</returns>
+	/// <param name="pShader">The hull shader, or NULL.</param>
+	virtual void STDMETHODCALLTYPE SetHullShader(
+		__in ID3D11HullShader *pShader
+	) = 0;
+	
+	/// <summary>Set the domain shader, without class instances, unless it is already set.</summary>
+	/// <remarks>Requires feature level 11.0.</remarks>
+	/// <returns>No return value.</returns>
+	/// <param name="pShader">The domain shader, or NULL.</param>
+	virtual void STDMETHODCALLTYPE SetDomainShader(
+		__in ID3D11DomainShader *pShader
+	) = 0;
+	
+	/// <summary>Set the vertex shader constant buffer in slot 0, unless it is already set.</summary>
+	/// <remarks></remarks>
+	/// <returns>No return value.</returns>
+	/// <param name="pBuffer">The constant buffer, or NULL.</param>
+	virtual void STDMETHODCALLTYPE SetVertexShaderConstantBuffer(
+		__in ID3D11Buffer *pBuffer
+	) = 0;
+	
+	/// <summary>Set the geometry shader constant buffer in slot 0, unless it is already set.</summary>
+	/// <remarks>Requires feature level 10.0.</remarks>
+	/// <returns>No return value.</returns>
+	/// <param name="pBuffer">The constant buffer, or NULL.</param>
+	virtual void STDMETHODCALLTYPE SetGeometryShaderConstantBuffer(
+		__in ID3D11Buffer *pBuffer
+	) = 0;
+	
+	/// <summary>Set the pixel shader sampler in slot 0, unless it is already set.</summary>
+	/// <remarks></remarks>
+	/// <returns>No return value.</returns>
+	/// <param name="pSamplerState">The sampler state, or NULL.</param>
+	virtual void STDMETHODCALLTYPE SetPixelShaderSampler(
+		__in ID3D11SamplerState *pSamplerState
+	) = 0;
+	
+	/// <summary>Set the blend state with the default blend factor, unless it is already set.</summary>
+	/// <remarks></remarks>
+	/// <returns>No return value.</returns>
+	/// <param name="pBlendState">The blend state, or NULL.</param>
+	/// <param name="SampleMask">The sample mask.</param>
+	virtual void STDMETHODCALLTYPE SetBlendState(
+		__in ID3D11BlendState *pBlendState,
+		__in UINT SampleMask
+	) = 0;
+	
+	/// <summary>Set the depth-stencil state, unless it is already set.</summary>
+	/// <remarks></remarks>
+	/// <returns>No return value.</returns>
+	/// <param name="pDepthStencilState">The depth-stencil state, or NULL.</param>
+	/// <param name="StencilRef">The stencil reference value.</param>
+	virtual void STDMETHODCALLTYPE SetDepthStencilState(
+		__in ID3D11DepthStencilState *pDepthStencilState,
+		__in UINT StencilRef
+	) = 0;
+	
+	/// <summary>Set the rasterizer state, unless it is already set.</summary>
+	/// <remarks></remarks>
+	/// <returns>No return value.</returns>
+	/// <param name="pRasterizerState">The rasterizer state, or NULL.</param>
+	virtual void STDMETHODCALLTYPE SetRasterizerState(
+		__in ID3D11RasterizerState *pRasterizerState
+	) = 0;
+	
+	/// <summary>Forget all tracked states, so the next call for each state is passed on to the context.</summary>
+	/// <remarks>Call this after states have been set on the context without the tracker, for example by IFW1GlyphRenderStates::SetStates.</remarks>
+	/// <returns>No return value.</returns>
+	virtual void STDMETHODCALLTYPE Invalidate(
+	) = 0;
+	
+	/// <summary>Get the number of calls passed on to the context and the number skipped because the state was already set.</summary>
+	/// <remarks>The counts start at zero and keep adding up until IFW1StateTracker::ResetCallCounts is called.</remarks>
+	/// <returns>No return value.</returns>
+	/// <param name="pIssuedCallCount">Address of a variable to receive the number of calls passed on to the context, or NULL.</param>
+	/// <param name="pSkippedCallCount">Address of a variable to receive the number of calls skipped, or NULL.</param>
+	virtual void STDMETHODCALLTYPE GetCallCounts(
+		__out_opt UINT *pIssuedCallCount,
+		__out_opt UINT *pSkippedCallCount
+	) = 0;
+	
+	/// <summary>Reset the call counts to zero.</summary>
+	/// <remarks></remarks>
+	/// <returns>No return value.</returns>
+	virtual void STDMETHODCALLTYPE ResetCallCounts(
+	) = 0;
+};
+
 /// <summary>This interface contains all render states and shaders needed to draw glyphs.</summary>
 /// <remarks></remarks>
 MIDL_INTERFACE("906928B6-79D8-4b42-8CE4-DC7D7046F206") IFW1GlyphRenderStates : public IFW1Object {
@@ -689,7 +1262,9 @@ MIDL_INTERFACE("906928B6-79D8-4b42-8CE4-DC7D7046F206") IFW1GlyphRenderStates : p
 	/// <param name="pContext">The context to set the states on.</param>
 	/// <param name="Flags">Can include zero or more of the following values, ORd together. Any additional values are ignored.<br/>
 	/// FW1_NOGEOMETRYSHADER - States are set up to draw indexed quads instead of constructing quads in the geometry shader.<br/>
-	/// FW1_CLIPRECT - Shaders will be set up to clip any drawn glyphs to the clip-rect set in IFW1GlyphRenderStates::UpdateShaderConstants.
+	/// FW1_VERTEXPULLING - Together with FW1_NOGEOMETRYSHADER, states are set up to expand quads in the vertex shader, if vertex pulling shaders are available.<br/>
+	/// FW1_CLIPRECT - Shaders will be set up to clip any drawn glyphs to the clip-rect set in IFW1GlyphRenderStates::UpdateShaderConstants.<br/>
+	/// FW1_DISTANCEFIELD - The atlas holds signed distance fields, and the pixel shader reconstructs the glyph edges from them.
 	/// </param>
 	virtual void STDMETHODCALLTYPE SetStates(
 		__in ID3D11DeviceContext *pContext,
@@ -714,10 +1289,26 @@ MIDL_INTERFACE("906928B6-79D8-4b42-8CE4-DC7D7046F206") IFW1GlyphRenderStates : p
 	/// <returns>Returns TRUE if a geometry shader is available, and otherwise returns FALSE.</returns>
 	virtual BOOL STDMETHODCALLTYPE HasGeometryShader(
 	) = 0;
+	
+	/// <summary>Returns whether vertex shaders that expand glyph quads without a geometry shader are available.</summary>
+	/// <remarks>Vertex pulling shaders are created on feature level 10.0 and above. See FW1_VERTEXPULLING.</remarks>
+	/// <returns>Returns TRUE if vertex pulling shaders are available, and otherwise returns FALSE.</returns>
+	virtual BOOL STDMETHODCALLTYPE HasVertexPullingShader(
+	) = 0;
+	
+	/// <summary>Set the internal states through a state tracker, skipping states that are already bound.</summary>
+	/// <remarks>The states are the same as set by IFW1GlyphRenderStates::SetStates.</remarks>
+	/// <returns>No return value.</returns>
+	/// <param name="pStateTracker">The state tracker of the context to set the states on.</param>
+	/// <param name="Flags">The same flags as for IFW1GlyphRenderStates::SetStates.</param>
+	virtual void STDMETHODCALLTYPE SetTrackedStates(
+		__in IFW1StateTracker *pStateTracker,
+		__in UINT Flags
+	) = 0;
 };
 
 /// <summary>A container for a dynamic vertex and index buffer, used to draw glyph vertices.</summary>
-/// <remarks></remarks>
+/// <remarks>Vertices from consecutive draws on the immediate context are appended to the dynamic buffers, which are only discarded when they are full.</remarks>
 MIDL_INTERFACE("E6CD7A32-5B59-463c-9B1B-D44074FF655B") IFW1GlyphVertexDrawer : public IFW1Object {
 	/// <summary>Get the ID3D11Device that the buffers are created on.</summary>
 	/// <remarks></remarks>
@@ -736,6 +1327,7 @@ MIDL_INTERFACE("E6CD7A32-5B59-463c-9B1B-D44074FF655B") IFW1GlyphVertexDrawer : p
 	/// These are easiest obtained from an IFW1TextGeometry object.</param>
 	/// <param name="Flags">Can include zero or more of the following values, ORd together. Any additional values are ignored.<br/>
 	/// FW1_NOGEOMETRYSHADER - Vertices are converted to quads on the fly on the CPU, instead of being sent directly to the device for the geometry shader.<br/>
+	/// FW1_VERTEXPULLING - Together with FW1_NOGEOMETRYSHADER, vertices are uploaded to a buffer shader-resource and drawn as six vertices per glyph, which the vertex shader expands to quads.<br/>
 	/// FW1_BUFFERSPREPARED - The internal buffers are assumed to already be set on the device context from a previous call. (Avoids redundant state changes when drawing multiple times).
 	/// </param>
 	/// <param name="PreboundSheet">If a sheet in the atlas is known to already be correctly set on the device context, specify its index in the atlas with this parameter, to avoid redundant state changes.
@@ -750,6 +1342,51 @@ MIDL_INTERFACE("E6CD7A32-5B59-463c-9B1B-D44074FF655B") IFW1GlyphVertexDrawer : p
 	) = 0;
 };
 
+/// <summary>Glyph vertices stored in immutable device buffers, for text that does not change between frames.</summary>
+/// <remarks>A static geometry is created once from the contents of an IFW1TextGeometry, and can then be drawn any number of times without uploading any vertices.
+/// Create a static geometry using IFW1FontWrapper::CreateStaticGeometry or IFW1Factory::CreateStaticGeometry, and draw it with IFW1FontWrapper::DrawStaticGeometry.<br/>
+/// The geometry holds a reference to each glyph sheet it uses, so it stays drawable when those sheets are evicted from the atlas with IFW1GlyphAtlas::RemoveSheets or IFW1GlyphProvider::TrimGlyphAtlas.
+/// The memory of an evicted sheet is only freed once every static geometry using it has been released. See IFW1GlyphAtlas::GetRemovalCount.</remarks>
+MIDL_INTERFACE("EF645C11-4FA8-427A-AE6A-575746A3C7E2") IFW1StaticGeometry : public IFW1Object {
+	/// <summary>Get the ID3D11Device that the buffers are created on.</summary>
+	/// <remarks></remarks>
+	/// <returns>Standard HRESULT error code.</returns>
+	/// <param name="ppDevice">Address of a pointer to an ID3D11Device.</param>
+	virtual HRESULT STDMETHODCALLTYPE GetDevice(
+		__out ID3D11Device **ppDevice
+	) = 0;
+	
+	/// <summary>Get the IFW1GlyphAtlas containing the glyphs referenced by the geometry.</summary>
+	/// <remarks></remarks>
+	/// <returns>Standard HRESULT error code.</returns>
+	/// <param name="ppGlyphAtlas">Address of a pointer to an IFW1GlyphAtlas.</param>
+	virtual HRESULT STDMETHODCALLTYPE GetGlyphAtlas(
+		__out IFW1GlyphAtlas **ppGlyphAtlas
+	) = 0;
+	
+	/// <summary>Get the flags the geometry was created with.</summary>
+	/// <remarks>If the returned value includes FW1_NOGEOMETRYSHADER, the geometry is stored as indexed quads and must be drawn with states set up for drawing without the geometry shader.
+	/// If it includes FW1_TEXTUREARRAY, the geometry references a texture-array atlas and must be drawn with the texture-array shaders.
+	/// If it includes FW1_DISTANCEFIELD, the atlas holds distance fields and must be drawn with the distance-field shaders.</remarks>
+	/// <returns>The creation flags.</returns>
+	virtual UINT STDMETHODCALLTYPE GetFlags(
+	) = 0;
+	
+	/// <summary>Draw the geometry.</summary>
+	/// <remarks>The glyph render states and shader constants are assumed to already be set on the context. See IFW1GlyphRenderStates.</remarks>
+	/// <returns>Returns the index of the sheet in the atlas that was last bound to the device context during the operation.</returns>
+	/// <param name="pContext">The context to draw on.</param>
+	/// <param name="Flags">Can include zero or more of the following values, ORd together. Any additional values are ignored.<br/>
+	/// FW1_BUFFERSPREPARED - The geometry's buffers are assumed to already be set on the device context from a previous call.
+	/// </param>
+	/// <param name="PreboundSheet">The index of a sheet known to already be set on the context, or 0xFFFFFFFF. See IFW1GlyphVertexDrawer::DrawVertices.</param>
+	virtual UINT STDMETHODCALLTYPE DrawGeometry(
+		__in ID3D11DeviceContext *pContext,
+		__in UINT Flags,
+		__in UINT PreboundSheet
+	) = 0;
+};
+
 /// <summary>The IFW1FontWrapper interface is the main interface used to draw text.
 /// It holds references to all objects needed to format and convert text to vertices, as well as the D3D11 states and buffers needed to draw them.</summary>
 /// <remarks>Create a font-wrapper using IFW1Factory::CreateFontWrapper</remarks>
@@ -995,6 +1632,86 @@ MIDL_INTERFACE("83347A5C-B0B1-460e-A35C-427E8B85F9F4") IFW1FontWrapper : public
 	virtual void STDMETHODCALLTYPE Flush(
 		__in ID3D11DeviceContext *pContext
 	) = 0;
+	
+	/// <summary>Create a static geometry from the current contents of a text geometry.</summary>
+	/// <remarks>The vertices are copied into immutable device buffers, and the text geometry can be cleared or reused afterwards.
+	/// The static geometry is stored in the format matching how the font-wrapper draws, with or without the geometry shader.<br/>
+	/// Any new glyphs referenced by the geometry must be flushed before the static geometry is drawn. See IFW1FontWrapper::Flush.</remarks>
+	/// <returns>Standard HRESULT error code.</returns>
+	/// <param name="pGeometry">The text geometry to copy vertices from.</param>
+	/// <param name="ppStaticGeometry">Address of a pointer to an IFW1StaticGeometry.</param>
+	virtual HRESULT STDMETHODCALLTYPE CreateStaticGeometry(
+		__in IFW1TextGeometry *pGeometry,
+		__out IFW1StaticGeometry **ppStaticGeometry
+	) = 0;
+	
+	/// <summary>Draw static geometry.</summary>
+	/// <remarks>No vertices are uploaded, so drawing a static geometry only costs setting states, the shader constants, and one draw call per glyph sheet used.
+	/// FW1_STATEPREPARED is honored when the states left by DrawGeometry match the stored format. Without a geometry shader DrawGeometry binds the vertex pulling shaders, which static quads can not use, so the states are set regardless.</remarks>
+	/// <returns>No return value.</returns>
+	/// <param name="pContext">The device context to draw on.</param>
+	/// <param name="pStaticGeometry">The static geometry to draw.</param>
+	/// <param name="pClipRect">A pointer to a rectangle to clip the text to if also using the FW1_CLIPRECT flag, or NULL to not clip. This rect is in text-space, and clipping is performed prior to any transformation.</param>
+	/// <param name="pTransformMatrix">An array of 16 floats, representing a matrix which the text will be transformed by, or NULL to draw in screen-space.</param>
+	/// <param name="Flags">See the FW1_TEXT_FLAG enumeration.</param>
+	virtual void STDMETHODCALLTYPE DrawStaticGeometry(
+		__in ID3D11DeviceContext *pContext,
+		__in IFW1StaticGeometry *pStaticGeometry,
+		__in const FW1_RECTF *pClipRect,
+		__in const FLOAT *pTransformMatrix,
+		__in UINT Flags
+	) = 0;	
+	/// <summary>Set a state tracker to set the glyph render states through.</summary>
+	/// <remarks>When a string or geometry is drawn on the tracker's device context without FW1_RESTORESTATE, render states that are already bound are skipped, and the tracker is left knowing the glyph states.
+	/// Drawing with FW1_RESTORESTATE restores the states the tracker knew, so the tracker is not used.<br/>
+	/// Shader-resources and vertex and index buffers are still set directly on the context. This method is not safe to call while other threads are drawing with the font-wrapper.</remarks>
+	/// <returns>Standard HRESULT error code.</returns>
+	/// <param name="pStateTracker">The state tracker, or NULL to set states directly on the context.</param>
+	virtual HRESULT STDMETHODCALLTYPE SetStateTracker(
+		__in IFW1StateTracker *pStateTracker
+	) = 0;
+	
+	/// <summary>Measure a string of known length.</summary>
+	/// <remarks>Identical to the NULL-terminated MeasureString, except that the string does not need to be NULL-terminated and is not scanned for its length.</remarks>
+	/// <returns>The smallest rectangle that completely contains the string if drawn with DrawString and the same parameters as used with MeasureString.</returns>
+	/// <param name="pString">The string to measure.</param>
+	/// <param name="StringLength">The number of characters in the string, not including any NULL-terminator.</param>
+	/// <param name="pszFontFamily">The font family to use, such as Arial or Courier New.</param>
+	/// <param name="FontSize">The size of the font.</param>
+	/// <param name="pLayoutRect">A pointer to a rectangle to format the text in.</param>
+	/// <param name="Flags">See the FW1_TEXT_FLAG enumeration.</param>
+	virtual FW1_RECTF STDMETHODCALLTYPE MeasureStringN(
+		__in const WCHAR *pString,
+		__in UINT32 StringLength,
+		__in const WCHAR *pszFontFamily,
+		__in FLOAT FontSize,
+		__in const FW1_RECTF *pLayoutRect,
+		__in UINT Flags
+	) = 0;
+	
+	/// <summary>Analyze a string of known length and generate geometry to draw it.</summary>
+	/// <remarks>Identical to the NULL-terminated AnalyzeString, except that the string does not need to be NULL-terminated and is not scanned for its length.</remarks>
+	/// <returns>No return value.</returns>
+	/// <param name="pContext">A device context to use to update device buffers when new glyphs are added to the glyph-atlas.</param>
+	/// <param name="pString">The string to create geometry from.</param>
+	/// <param name="StringLength">The number of characters in the string, not including any NULL-terminator.</param>
+	/// <param name="pszFontFamily">The font family to use, such as Arial or Courier New.</param>
+	/// <param name="FontSize">The size of the font.</param>
+	/// <param name="pLayoutRect">A pointer to a rectangle to format the text in.</param>
+	/// <param name="Color">The color of the text, as 0xAaBbGgRr.</param>
+	/// <param name="Flags">See the FW1_TEXT_FLAG enumeration.</param>
+	/// <param name="pTextGeometry">An IFW1TextGeometry object that the output vertices will be appended to.</param>
+	virtual void STDMETHODCALLTYPE AnalyzeStringN(
+		__in ID3D11DeviceContext *pContext,
+		__in const WCHAR *pString,
+		__in UINT32 StringLength,
+		__in const WCHAR *pszFontFamily,
+		__in FLOAT FontSize,
+		__in const FW1_RECTF *pLayoutRect,
+		__in UINT32 Color,
+		__in UINT Flags,
+		__in IFW1TextGeometry *pTextGeometry
+	) = 0;
 };
 
 /// <summary>
@@ -1189,6 +1906,66 @@ MIDL_INTERFACE("8004DB2B-B5F9-4420-A6A2-E17E15E4C336") IFW1Factory : public IUnk
 			__in UINT32 Color,
 			__out IFW1ColorRGBA **ppColor
 		) = 0;
+		
+		/// <summary>Create an IFW1StaticGeometry object.</summary>
+		/// <remarks>The vertex data is copied, and need not remain valid after the method returns.</remarks>
+		/// <returns>Standard HRESULT error code.</returns>
+		/// <param name="pDevice">A D3D11 device used to create the immutable buffers.</param>
+		/// <param name="pGlyphAtlas">The glyph atlas containing the glyphs referenced by the vertices.</param>
+		/// <param name="pVertexData">Pointer to an FW1_VERTEXDATA structure, containing vertices sorted by glyph sheet. See IFW1TextGeometry::GetGlyphVerticesTemp.</param>
+		/// <param name="Flags">If FW1_NOGEOMETRYSHADER is specified, the vertices are expanded to indexed quads, otherwise they are stored as points for the geometry shader.
+		/// If FW1_TEXTUREARRAY is specified, the vertex data must come from IFW1TextGeometry::GetGlyphVerticesUnsortedTemp and the atlas must be a texture-array atlas.</param>
+		/// <param name="ppStaticGeometry">Address of a pointer to an IFW1StaticGeometry.</param>
+		virtual HRESULT STDMETHODCALLTYPE CreateStaticGeometry(
+			__in ID3D11Device *pDevice,
+			__in IFW1GlyphAtlas *pGlyphAtlas,
+			__in const FW1_VERTEXDATA *pVertexData,
+			__in UINT Flags,
+			__out IFW1StaticGeometry **ppStaticGeometry
+		) = 0;
+		
+		/// <summary>Create an IFW1GlyphAtlas object that stores its sheets as slices of one texture array.</summary>
+		/// <remarks>The texture array and a matching coordinate texture are allocated when the atlas is created, so the atlas never grows past SliceCount sheets.
+		/// Glyphs larger than a sheet are rejected. Requires feature level 10.0. See IFW1GlyphAtlas::GetTextureArraySize.</remarks>
+		/// <returns>Standard HRESULT error code.</returns>
+		/// <param name="pDevice">A D3D11 device used to create device resources.</param>
+		/// <param name="GlyphSheetWidth">Width of each slice. 0 defaults to 512.</param>
+		/// <param name="GlyphSheetHeight">Height of each slice. 0 defaults to 512.</param>
+		/// <param name="MaxGlyphCountPerSheet">The maximum number of glyphs in a single slice. 0 defaults to 2048, and the value is limited to 4096.</param>
+		/// <param name="MipLevels">The number of mip levels for the texture array.</param>
+		/// <param name="SliceCount">The number of slices in the texture array, limited to 2048.</param>
+		/// <param name="ppGlyphAtlas">Address of a pointer to an IFW1GlyphAtlas.</param>
+		virtual HRESULT STDMETHODCALLTYPE CreateTextureArrayGlyphAtlas(
+			__in ID3D11Device *pDevice,
+			__in UINT GlyphSheetWidth,
+			__in UINT GlyphSheetHeight,
+			__in UINT MaxGlyphCountPerSheet,
+			__in UINT MipLevels,
+			__in UINT SliceCount,
+			__out IFW1GlyphAtlas **ppGlyphAtlas
+		) = 0;
+		
+		/// <summary>Create an IFW1DWriteRenderTarget object that fills glyph outlines into 8-bit coverage, without GDI.</summary>
+		/// <remarks>Glyph images have a pixel stride of 1. The rendering mode only selects between anti-aliased and aliased coverage, and the measuring mode is ignored.</remarks>
+		/// <returns>Standard HRESULT error code.</returns>
+		/// <param name="RenderTargetWidth">The maximum width of a glyph image. Larger glyphs are clipped.</param>
+		/// <param name="RenderTargetHeight">The maximum height of a glyph image. Larger glyphs are clipped.</param>
+		/// <param name="ppRenderTarget">Address of a pointer to an IFW1DWriteRenderTarget.</param>
+		virtual HRESULT STDMETHODCALLTYPE CreateOutlineRenderTarget(
+			__in UINT RenderTargetWidth,
+			__in UINT RenderTargetHeight,
+			__out IFW1DWriteRenderTarget **ppRenderTarget
+		) = 0;
+		
+		/// <summary>Create an IFW1StateTracker object for a device context.</summary>
+		/// <remarks>The tracker starts out knowing no states, so the first call for each state is always passed on to the context.</remarks>
+		/// <returns>Standard HRESULT error code.</returns>
+		/// <param name="pContext">The device context to set states on.</param>
+		/// <param name="ppStateTracker">Address of a pointer to an IFW1StateTracker.</param>
+		virtual HRESULT STDMETHODCALLTYPE CreateStateTracker(
+			__in ID3D11DeviceContext *pContext,
+			__out IFW1StateTracker **ppStateTracker
+		) = 0;
 };
 
 #ifdef FW1_COMPILETODLL
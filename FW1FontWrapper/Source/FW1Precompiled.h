@@ -6,13 +6,17 @@
 
 #define NOMINMAX
 #include <D3D11.h>
-#include <D3DCompiler.h>
 #include <DWrite.h>
 #include <intrin.h>
+#if defined(_M_ARM) || defined(_M_ARM64)
+#include <arm_neon.h>
+#endif
 #include <string>
 #include <vector>
 #include <map>
 #include <stack>
+#include <deque>
+#include <set>
 #include <cfloat>
 #include <cmath>
 #include <algorithm>
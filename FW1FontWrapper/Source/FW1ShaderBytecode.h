@@ -0,0 +1,45 @@
+// FW1ShaderBytecode.h
+
+#ifndef IncludeGuard__FW1_FW1ShaderBytecode_h
+#define IncludeGuard__FW1_FW1ShaderBytecode_h
+
+
+// Shader bytecode compiled from Shaders\*.hlsl by fxc at build time, see the custom build steps in the project
+// The headers are generated in $(IntDir)Shaders, one per variant
+namespace FW1FontWrapper {
+
+
+// Quad vertex shaders, the simple and clipping variants are compiled for vs_4_0_level_9_1 to run on every feature level
+#include "FW1QuadVS.h"
+#include "FW1QuadVSClip.h"
+#include "FW1QuadVSArray.h"
+#include "FW1QuadVSClipArray.h"
+
+// Point to quad geometry shaders and their pass-through vertex shader
+#include "FW1PointVS.h"
+#include "FW1PointGS.h"
+#include "FW1PointGSClip.h"
+#include "FW1PointGSArray.h"
+#include "FW1PointGSClipArray.h"
+
+// Vertex pulling shaders
+#include "FW1PullVS.h"
+#include "FW1PullVSClip.h"
+#include "FW1PullVSArray.h"
+#include "FW1PullVSClipArray.h"
+
+// Pixel shaders, the simple and clipping variants are compiled for ps_4_0_level_9_1 to run on every feature level
+#include "FW1GlyphPS.h"
+#include "FW1GlyphPSClip.h"
+#include "FW1GlyphPSArray.h"
+#include "FW1GlyphPSClipArray.h"
+#include "FW1GlyphPSDistanceField.h"
+#include "FW1GlyphPSClipDistanceField.h"
+#include "FW1GlyphPSDistanceFieldArray.h"
+#include "FW1GlyphPSClipDistanceFieldArray.h"
+
+
+}// namespace FW1FontWrapper
+
+
+#endif// IncludeGuard__FW1_FW1ShaderBytecode_h
@@ -0,0 +1,2157 @@
+// FW1Tests.cpp
+
+// Headless tests and benchmarks for the glyph-sheet and glyph-provider internals.
+// The font-wrapper sources are compiled into this program, so private parts of CFW1GlyphSheet, CFW1GlyphProvider and CFW1OutlineRenderTarget are reached through the test classes below.
+// Returns non-zero if any test fails.
+
+#include "FW1Precompiled.h"
+
+#include "CFW1GlyphSheet.h"
+#include "CFW1GlyphProvider.h"
+#include "CFW1OutlineRenderTarget.h"
+
+#include <cstdio>
+#include <cstddef>
+#include <limits>
+
+#pragma comment(lib, "d3d11.lib")
+#pragma comment(lib, "dwrite.lib")
+
+
+#define SAFE_RELEASE(pObject) { if(pObject) { (pObject)->Release(); (pObject) = NULL; } }
+
+
+namespace FW1FontWrapper {
+
+
+// Exposes the private parts of CFW1GlyphSheet used by the tests
+class CFW1GlyphSheetTest {
+	public:
+		typedef CFW1GlyphSheet::HeightRange HeightRange;
+		
+		static void copyPixelRow(UINT8 *dst, const UINT8 *src, UINT count, UINT pixelStride) {
+			CFW1GlyphSheet::copyPixelRow(dst, src, count, pixelStride);
+		}
+		static void downsampleRow(UINT8 *dst, const UINT8 *src0, const UINT8 *src1, UINT count) {
+			CFW1GlyphSheet::downsampleRow(dst, src0, src1, count);
+		}
+		
+		static void compressMipLevel(UINT8 *dst, const UINT8 *src, UINT width, UINT height, UINT64 *pSquaredSum, UINT *pMaxError) {
+			CFW1GlyphSheet::CompressionError error = {0, 0};
+			CFW1GlyphSheet::compressMipLevel(dst, src, width, height, &error);
+			
+			*pSquaredSum = error.squaredSum;
+			*pMaxError = error.maxError;
+		}
+		static void findBlockRanges(UINT8 *outMin, UINT8 *outMax, const UINT8 *src, UINT rowPitch, UINT blockCount) {
+			CFW1GlyphSheet::findBlockRanges(outMin, outMax, src, rowPitch, blockCount);
+		}
+		static void decodeBlock(UINT8 *dst, UINT dstPitch, const UINT8 *block) {
+			CFW1GlyphSheet::decodeBlock(dst, dstPitch, block);
+		}
+};
+
+
+// Exposes the private parts of CFW1GlyphProvider used by the tests
+class CFW1GlyphProviderTest {
+	public:
+		typedef CFW1GlyphProvider::GlyphCacheHeader GlyphCacheHeader;
+		typedef CFW1GlyphProvider::GlyphCacheFont GlyphCacheFont;
+		typedef CFW1GlyphProvider::GlyphCacheSheet GlyphCacheSheet;
+		typedef CFW1GlyphProvider::GlyphCacheGlyphMap GlyphCacheGlyphMap;
+		
+		static const void* findCachedGlyphMap(IFW1GlyphProvider *pGlyphProvider, IDWriteFontFace *pFontFace, FLOAT fontSize, UINT fontFlags) {
+			CFW1GlyphProvider *pProvider = static_cast<CFW1GlyphProvider*>(pGlyphProvider);
+			
+			return pProvider->findCachedGlyphMap(pFontFace, fontSize, pProvider->getRelevantFontFlags(fontFlags));
+		}
+		
+		// Clear the cache entries of a font-face, as the provider does when the font-face is replaced
+		static void uncacheFontFace(IFW1GlyphProvider *pGlyphProvider, IDWriteFontFace *pFontFace) {
+			CFW1GlyphProvider *pProvider = static_cast<CFW1GlyphProvider*>(pGlyphProvider);
+			
+			EnterCriticalSection(&pProvider->m_fontsCriticalSection);
+			pProvider->uncacheFontFace(pFontFace);
+			LeaveCriticalSection(&pProvider->m_fontsCriticalSection);
+		}
+		
+		static UINT getGlyphMapCacheCapacity(IFW1GlyphProvider *pGlyphProvider) {
+			CFW1GlyphProvider *pProvider = static_cast<CFW1GlyphProvider*>(pGlyphProvider);
+			
+			CFW1GlyphProvider::GlyphMapCache *cache = pProvider->m_pGlyphMapCache;
+			return (cache != 0) ? cache->capacity : 0;
+		}
+		
+		static UINT getGlyphMapCount(IFW1GlyphProvider *pGlyphProvider) {
+			CFW1GlyphProvider *pProvider = static_cast<CFW1GlyphProvider*>(pGlyphProvider);
+			
+			EnterCriticalSection(&pProvider->m_glyphMapsCriticalSection);
+			UINT glyphMapCount = static_cast<UINT>(pProvider->m_fontMap.size());
+			LeaveCriticalSection(&pProvider->m_glyphMapsCriticalSection);
+			
+			return glyphMapCount;
+		}
+		
+		static UINT getGlyphPageSize() {
+			return CFW1GlyphProvider::GlyphPageSize;
+		}
+		
+		static UINT getPageCount(const void *pGlyphMap) {
+			return static_cast<const CFW1GlyphProvider::GlyphMap*>(pGlyphMap)->pageCount;
+		}
+		
+		static UINT getAllocatedPageCount(const void *pGlyphMap) {
+			return static_cast<const CFW1GlyphProvider::GlyphMap*>(pGlyphMap)->allocatedPageCount;
+		}
+		
+		static bool isPageAllocated(const void *pGlyphMap, UINT pageIndex) {
+			return (static_cast<const CFW1GlyphProvider::GlyphMap*>(pGlyphMap)->pages[pageIndex] != 0);
+		}
+		
+		// Memory a glyph-map should report, see IFW1GlyphProvider::GetGlyphMapMemoryUsage
+		static UINT64 getGlyphMapBytes(UINT pageCount, UINT allocatedPageCount) {
+			return
+				sizeof(CFW1GlyphProvider::GlyphMap)
+				+ static_cast<UINT64>(pageCount) * sizeof(CFW1GlyphProvider::GlyphPage*)
+				+ static_cast<UINT64>(allocatedPageCount) * sizeof(CFW1GlyphProvider::GlyphPage);
+		}
+		
+		// Atlas id stored in a glyph-map, 0xffffffff if the glyph has none
+		static UINT getGlyphAtlasId(IFW1GlyphProvider *pGlyphProvider, const void *pGlyphMap, UINT16 glyphIndex) {
+			CFW1GlyphProvider::GlyphMap *glyphMap = static_cast<CFW1GlyphProvider::GlyphMap*>(const_cast<void*>(pGlyphMap));
+			
+			return static_cast<CFW1GlyphProvider*>(pGlyphProvider)->getGlyphAtlasId(glyphMap, glyphIndex);
+		}
+		
+		static void distanceTransform(FLOAT *grid, UINT width, UINT height) {
+			CFW1GlyphProvider::distanceTransform(grid, width, height);
+		}
+		static void createDistanceField(
+			IFW1GlyphProvider *pGlyphProvider,
+			const FW1_GLYPHIMAGEDATA &glyphData,
+			std::vector<UINT8> &fieldPixels,
+			FW1_GLYPHMETRICS &fieldMetrics
+		) {
+			static_cast<CFW1GlyphProvider*>(pGlyphProvider)->createDistanceField(glyphData, fieldPixels, fieldMetrics);
+		}
+		
+		static void writeGlyphCache(IFW1GlyphProvider *pGlyphProvider, ID3D11DeviceContext *pContext, std::vector<UINT8> &cacheData) {
+			static_cast<CFW1GlyphProvider*>(pGlyphProvider)->writeGlyphCache(pContext, cacheData);
+		}
+		static HRESULT readGlyphCache(IFW1GlyphProvider *pGlyphProvider, const UINT8 *pCacheData, UINT64 cacheSize) {
+			return static_cast<CFW1GlyphProvider*>(pGlyphProvider)->readGlyphCache(pCacheData, cacheSize);
+		}
+};
+
+
+// Exposes the plain outline functions of CFW1OutlineRenderTarget used by the tests
+class CFW1OutlineRenderTargetTest {
+	public:
+		typedef CFW1OutlineRenderTarget::OutlinePoint OutlinePoint;
+		typedef CFW1OutlineRenderTarget::LineSegment LineSegment;
+		
+		static void addOutlineLine(std::vector<LineSegment> &lines, const OutlinePoint &p0, const OutlinePoint &p1) {
+			CFW1OutlineRenderTarget::addOutlineLine(lines, p0, p1);
+		}
+		static void addOutlineBezier(
+			std::vector<LineSegment> &lines,
+			const OutlinePoint &p0,
+			const OutlinePoint &p1,
+			const OutlinePoint &p2,
+			const OutlinePoint &p3
+		) {
+			CFW1OutlineRenderTarget::addOutlineBezier(lines, p0, p1, p2, p3);
+		}
+		static void fillOutline(
+			const std::vector<LineSegment> &lines,
+			FLOAT offsetX,
+			FLOAT offsetY,
+			UINT width,
+			UINT height,
+			bool aliased,
+			FLOAT *accumulation,
+			UINT8 *coverage
+		) {
+			CFW1OutlineRenderTarget::fillOutline(lines, offsetX, offsetY, width, height, aliased, accumulation, coverage);
+		}
+};
+
+
+}// namespace FW1FontWrapper
+
+
+namespace {
+
+
+using namespace FW1FontWrapper;
+
+
+// Device and factory shared by the tests that need them
+ID3D11Device *g_pDevice = NULL;
+ID3D11DeviceContext *g_pContext = NULL;
+IFW1Factory *g_pFW1Factory = NULL;
+
+// Font used by the glyph-provider tests
+IDWriteFactory *g_pDWriteFactory = NULL;
+IDWriteFontCollection *g_pFontCollection = NULL;
+IDWriteFontFace *g_pFontFace = NULL;
+
+// Number of failed checks in the running test
+UINT g_failedChecks = 0;
+
+// Number of tests with failed checks
+UINT g_failedTests = 0;
+
+
+// Record a check, printing it if it failed
+bool check(bool condition, const char *pszDescription) {
+	if(!condition) {
+		printf("  failed: %s\n", pszDescription);
+		++g_failedChecks;
+	}
+	
+	return condition;
+}
+
+
+// Run a test and print whether all its checks passed
+void runTest(void (*pTest)(), const char *pszName) {
+	printf("%s\n", pszName);
+	
+	g_failedChecks = 0;
+	pTest();
+	
+	if(g_failedChecks > 0) {
+		printf("FAIL %s\n", pszName);
+		++g_failedTests;
+	}
+	else
+		printf("PASS %s\n", pszName);
+}
+
+
+// Deterministic pseudo-random numbers, so every run tests the same data
+class Random {
+	public:
+		Random(UINT seed) : m_state(seed) {}
+		
+		UINT next(UINT range) {
+			m_state = m_state * 1664525 + 1013904223;
+			return (m_state >> 8) % range;
+		}
+	
+	private:
+		UINT	m_state;
+};
+
+
+// Measures elapsed time
+class Timer {
+	public:
+		Timer() {
+			QueryPerformanceFrequency(&m_frequency);
+			QueryPerformanceCounter(&m_start);
+		}
+		
+		double milliseconds() const {
+			LARGE_INTEGER now;
+			QueryPerformanceCounter(&now);
+			
+			return static_cast<double>(now.QuadPart - m_start.QuadPart) * 1000.0 / static_cast<double>(m_frequency.QuadPart);
+		}
+	
+	private:
+		LARGE_INTEGER	m_frequency;
+		LARGE_INTEGER	m_start;
+};
+
+
+// The skyline as one height per column, as sheets stored it before HeightRange kept segments
+class ColumnHeightRange {
+	public:
+		ColumnHeightRange(UINT totalWidth) : m_heights(totalWidth, 0), m_totalWidth(totalWidth) {}
+		
+		UINT findMin(UINT width, UINT *outMin) {
+			if(width > m_totalWidth)
+				width = m_totalWidth;
+			
+			UINT currentMax = findMax(0, width);
+			UINT currentMin = currentMax;
+			UINT minX = 0;
+			
+			for(UINT i=1; i < m_totalWidth-width; ++i) {
+				if(m_heights[i+width-1] >= currentMax)
+					currentMax = m_heights[i+width-1];
+				else if(m_heights[i-1] == currentMax) {
+					currentMax = findMax(i, width);
+					if(currentMax < currentMin) {
+						currentMin = currentMax;
+						minX = i;
+					}
+				}
+			}
+			
+			*outMin = currentMin;
+			return minX;
+		}
+		
+		void update(UINT startX, UINT width, UINT newHeight) {
+			if(width > m_totalWidth)
+				width = m_totalWidth;
+			
+			for(UINT i=0; i < width; ++i)
+				m_heights[startX+i] = newHeight;
+		}
+	
+	private:
+		UINT findMax(UINT startX, UINT width) {
+			UINT currentMax = m_heights[startX];
+			for(UINT i=1; i < width; ++i)
+				currentMax = std::max(currentMax, m_heights[startX+i]);
+			
+			return currentMax;
+		}
+		
+		std::vector<UINT>	m_heights;
+		UINT				m_totalWidth;
+};
+
+
+// Size of a rectangle to pack
+struct PackRect {
+	UINT	width;
+	UINT	height;
+};
+
+
+// Outcome of packing a list of rectangles
+struct PackResult {
+	double				milliseconds;
+	UINT				sheetCount;
+	double				utilisation;
+	std::vector<UINT>	positions;
+};
+
+
+// Mostly glyph-sized rectangles, with an occasional large one
+void makePackRects(UINT seed, UINT count, std::vector<PackRect> &rects) {
+	Random random(seed);
+	
+	rects.resize(count);
+	for(UINT i=0; i < count; ++i) {
+		if(random.next(32) == 0) {
+			rects[i].width = 48 + random.next(80);
+			rects[i].height = 48 + random.next(80);
+		}
+		else {
+			rects[i].width = 3 + random.next(30);
+			rects[i].height = 6 + random.next(34);
+		}
+	}
+}
+
+
+// Pack rectangles into square sheets the way CFW1GlyphSheet::InsertGlyph does with one mip-level, starting a new sheet when one is full
+// Utilisation is the rectangle area over the sheet area used, counting only the packed height of the last sheet
+template<class HeightRangeType>
+void packRects(const std::vector<PackRect> &rects, UINT sheetSize, PackResult &result) {
+	result.positions.resize(rects.size() * 2);
+	
+	Timer timer;
+	
+	HeightRangeType *pHeightRange = new HeightRangeType(sheetSize);
+	UINT sheetCount = 1;
+	UINT packedHeight = 0;
+	UINT64 rectArea = 0;
+	UINT64 sheetArea = 0;
+	
+	for(size_t i=0; i < rects.size(); ++i) {
+		UINT blockWidth = rects[i].width + 1;
+		UINT blockHeight = rects[i].height + 1;
+		
+		UINT blockY;
+		UINT blockX = pHeightRange->findMin(blockWidth, &blockY);
+		if(1 + blockY + rects[i].height + 1 > sheetSize) {
+			sheetArea += static_cast<UINT64>(sheetSize) * sheetSize;
+			
+			delete pHeightRange;
+			pHeightRange = new HeightRangeType(sheetSize);
+			++sheetCount;
+			packedHeight = 0;
+			
+			blockX = pHeightRange->findMin(blockWidth, &blockY);
+		}
+		
+		pHeightRange->update(blockX, blockWidth, blockY + blockHeight);
+		
+		rectArea += rects[i].width * rects[i].height;
+		packedHeight = std::max(packedHeight, 1 + blockY + rects[i].height + 1);
+		
+		result.positions[i*2] = blockX;
+		result.positions[i*2+1] = blockY;
+	}
+	
+	delete pHeightRange;
+	sheetArea += static_cast<UINT64>(sheetSize) * packedHeight;
+	
+	result.milliseconds = timer.milliseconds();
+	result.sheetCount = sheetCount;
+	result.utilisation = static_cast<double>(rectArea) / static_cast<double>(sheetArea);
+}
+
+
+// The segment skyline must place every rectangle where the per-column skyline did, only faster
+void testHeightRangePacking() {
+	const UINT rectCount = 10000;
+	const UINT runCount = 5;
+	const UINT sheetSizes[] = {512, 1024};
+	
+	std::vector<PackRect> rects;
+	makePackRects(1, rectCount, rects);
+	
+	for(UINT i=0; i < sizeof(sheetSizes) / sizeof(sheetSizes[0]); ++i) {
+		PackResult columnResult;
+		PackResult segmentResult;
+		double columnTime = DBL_MAX;
+		double segmentTime = DBL_MAX;
+		
+		// Best of several runs, to keep other processes out of the timing
+		for(UINT j=0; j < runCount; ++j) {
+			packRects<ColumnHeightRange>(rects, sheetSizes[i], columnResult);
+			packRects<CFW1GlyphSheetTest::HeightRange>(rects, sheetSizes[i], segmentResult);
+			
+			columnTime = std::min(columnTime, columnResult.milliseconds);
+			segmentTime = std::min(segmentTime, segmentResult.milliseconds);
+		}
+		
+		printf(
+			"  %u rectangles in %ux%u sheets: columns %.2f ms, segments %.2f ms, %u sheets, %.1f%% / %.1f%% used\n",
+			rectCount,
+			sheetSizes[i],
+			sheetSizes[i],
+			columnTime,
+			segmentTime,
+			segmentResult.sheetCount,
+			columnResult.utilisation * 100.0,
+			segmentResult.utilisation * 100.0
+		);
+		
+		check(segmentResult.positions == columnResult.positions, "segment skyline places rectangles like the column skyline");
+		check(segmentResult.sheetCount == columnResult.sheetCount, "same number of sheets");
+		check(segmentResult.utilisation >= columnResult.utilisation, "utilisation is not worse");
+	}
+}
+
+
+// The plain loop copyPixelRow must match
+void copyPixelRowReference(UINT8 *dst, const UINT8 *src, UINT count, UINT pixelStride) {
+	for(UINT j=0; j < count; ++j)
+		dst[j] = src[j*pixelStride];
+}
+
+
+// The plain loop downsampleRow must match
+void downsampleRowReference(UINT8 *dst, const UINT8 *src0, const UINT8 *src1, UINT count) {
+	for(UINT k=0; k < count; ++k) {
+		UINT src = src0[k*2] + src0[k*2+1] + src1[k*2] + src1[k*2+1];
+		dst[k] = static_cast<UINT8>(src >> 2);
+	}
+}
+
+
+// The pixel kernels must give the same bytes as the plain loops for every row length, including the tails the SIMD loops leave over
+// Source rows end at the last byte read, and bytes after the destination row are checked, so reads or writes past the row would show
+void testPixelKernels() {
+	const UINT maxCount = 64;
+	const UINT guardSize = 16;
+	
+	Random random(4);
+	
+	// Rows start one byte into the buffers, so the loads are unaligned
+	for(UINT count=1; count <= maxCount; ++count) {
+		for(UINT pixelStride=1; pixelStride <= 4; ++pixelStride) {
+			std::vector<UINT8> src(1 + (count - 1) * pixelStride + 1);
+			for(size_t i=0; i < src.size(); ++i)
+				src[i] = static_cast<UINT8>(random.next(256));
+			
+			std::vector<UINT8> dst(1 + count + guardSize, 0xcd);
+			std::vector<UINT8> expected(dst);
+			CFW1GlyphSheetTest::copyPixelRow(&dst[1], &src[1], count, pixelStride);
+			copyPixelRowReference(&expected[1], &src[1], count, pixelStride);
+			
+			if(!check(memcmp(&dst[0], &expected[0], dst.size()) == 0, "copyPixelRow matches the plain loop")) {
+				printf("  %u pixels, stride %u\n", count, pixelStride);
+				return;
+			}
+		}
+		
+		std::vector<UINT8> src0(1 + count * 2);
+		std::vector<UINT8> src1(1 + count * 2);
+		for(UINT i=0; i < 1 + count * 2; ++i) {
+			src0[i] = static_cast<UINT8>(random.next(256));
+			src1[i] = static_cast<UINT8>(random.next(256));
+		}
+		
+		std::vector<UINT8> dst(1 + count + guardSize, 0xcd);
+		std::vector<UINT8> expected(dst);
+		CFW1GlyphSheetTest::downsampleRow(&dst[1], &src0[1], &src1[1], count);
+		downsampleRowReference(&expected[1], &src0[1], &src1[1], count);
+		
+		if(!check(memcmp(&dst[0], &expected[0], dst.size()) == 0, "downsampleRow matches the plain loop")) {
+			printf("  %u pixels\n", count);
+			return;
+		}
+	}
+}
+
+
+// Time the pixel kernels against the plain loops on a 512x512 sheet
+// Copies extract the first channel of 32-bit pixels, as glyphs rendered by GDI are inserted
+void benchmarkPixelKernels() {
+	const UINT sheetSize = 512;
+	const UINT runCount = 20;
+	
+	Random random(5);
+	
+	std::vector<UINT8> pixels(sheetSize * sheetSize * 4);
+	for(size_t i=0; i < pixels.size(); ++i)
+		pixels[i] = static_cast<UINT8>(random.next(256));
+	
+	std::vector<UINT8> sheet(sheetSize * sheetSize);
+	std::vector<UINT8> expectedSheet(sheetSize * sheetSize);
+	std::vector<UINT8> mip(sheetSize * sheetSize / 4);
+	std::vector<UINT8> expectedMip(sheetSize * sheetSize / 4);
+	
+	double copyTime = DBL_MAX;
+	double copyReferenceTime = DBL_MAX;
+	double downsampleTime = DBL_MAX;
+	double downsampleReferenceTime = DBL_MAX;
+	
+	for(UINT i=0; i < runCount; ++i) {
+		Timer copyTimer;
+		for(UINT j=0; j < sheetSize; ++j)
+			CFW1GlyphSheetTest::copyPixelRow(&sheet[j * sheetSize], &pixels[j * sheetSize * 4], sheetSize, 4);
+		copyTime = std::min(copyTime, copyTimer.milliseconds());
+		
+		Timer copyReferenceTimer;
+		for(UINT j=0; j < sheetSize; ++j)
+			copyPixelRowReference(&expectedSheet[j * sheetSize], &pixels[j * sheetSize * 4], sheetSize, 4);
+		copyReferenceTime = std::min(copyReferenceTime, copyReferenceTimer.milliseconds());
+		
+		Timer downsampleTimer;
+		for(UINT j=0; j < sheetSize / 2; ++j) {
+			const UINT8 *src0 = &sheet[j * 2 * sheetSize];
+			CFW1GlyphSheetTest::downsampleRow(&mip[j * sheetSize / 2], src0, src0 + sheetSize, sheetSize / 2);
+		}
+		downsampleTime = std::min(downsampleTime, downsampleTimer.milliseconds());
+		
+		Timer downsampleReferenceTimer;
+		for(UINT j=0; j < sheetSize / 2; ++j) {
+			const UINT8 *src0 = &expectedSheet[j * 2 * sheetSize];
+			downsampleRowReference(&expectedMip[j * sheetSize / 2], src0, src0 + sheetSize, sheetSize / 2);
+		}
+		downsampleReferenceTime = std::min(downsampleReferenceTime, downsampleReferenceTimer.milliseconds());
+	}
+	
+	printf("  copyPixelRow, %ux%u 32-bit pixels: %.3f ms, plain loop %.3f ms\n", sheetSize, sheetSize, copyTime, copyReferenceTime);
+	printf("  downsampleRow, %ux%u to %ux%u: %.3f ms, plain loop %.3f ms\n", sheetSize, sheetSize, sheetSize / 2, sheetSize / 2, downsampleTime, downsampleReferenceTime);
+	
+	check(sheet == expectedSheet && mip == expectedMip, "kernels match the plain loops");
+}
+
+
+// Insert a glyph of random pixels, and return its index in the sheet
+UINT insertRandomGlyph(IFW1GlyphSheet *pGlyphSheet, UINT width, UINT height, Random &random) {
+	std::vector<UINT8> pixels(width * height);
+	for(size_t i=0; i < pixels.size(); ++i)
+		pixels[i] = static_cast<UINT8>(1 + random.next(255));
+	
+	FW1_GLYPHMETRICS glyphMetrics;
+	glyphMetrics.OffsetX = 0.0f;
+	glyphMetrics.OffsetY = 0.0f;
+	glyphMetrics.Width = width;
+	glyphMetrics.Height = height;
+	
+	return pGlyphSheet->InsertGlyph(&glyphMetrics, &pixels[0], width, 1);
+}
+
+
+// The sheet region uploaded for a glyph, recovered from its texture coordinates
+// Glyphs are uploaded with a border of one mip alignment, half of which is inside the texture coordinates
+void getGlyphRect(const FW1_GLYPHCOORDS &glyphCoords, UINT sheetSize, UINT alignWidth, RECT &rect) {
+	FLOAT size = static_cast<FLOAT>(sheetSize);
+	FLOAT border = static_cast<FLOAT>(alignWidth) * 0.5f;
+	
+	rect.left = static_cast<LONG>(floor(glyphCoords.TexCoordLeft * size - border + 0.5f));
+	rect.top = static_cast<LONG>(floor(glyphCoords.TexCoordTop * size - border + 0.5f));
+	rect.right = std::min(static_cast<LONG>(floor(glyphCoords.TexCoordRight * size + border + 0.5f)), static_cast<LONG>(sheetSize));
+	rect.bottom = std::min(static_cast<LONG>(floor(glyphCoords.TexCoordBottom * size + border + 0.5f)), static_cast<LONG>(sheetSize));
+}
+
+
+// Bytes uploaded for a region of the top mip-level and the matching regions of the levels below it
+UINT64 getMipBytes(UINT64 area, UINT mipLevels) {
+	UINT64 bytes = 0;
+	for(UINT i=0; i < mipLevels; ++i)
+		bytes += area >> (i * 2);
+	
+	return bytes;
+}
+
+
+// Flushing a single glyph uploads its aligned region on each mip-level, plus its coordinates when the sheet has a coord buffer
+void testFlushBytesSingleGlyph() {
+	struct SheetCase {
+		BOOL	coordBuffer;
+		UINT	mipLevels;
+		UINT	expectedBytes;
+	};
+	
+	// A 10x10 glyph is uploaded with a border of the mip alignment on each side
+	const SheetCase sheetCases[] = {
+		{FALSE, 1, 12 * 12},
+		{FALSE, 2, 14 * 14 + 7 * 7},
+		{TRUE, 1, 12 * 12 + static_cast<UINT>(sizeof(FW1_GLYPHCOORDS))}
+	};
+	
+	Random random(2);
+	
+	for(UINT i=0; i < sizeof(sheetCases) / sizeof(sheetCases[0]); ++i) {
+		IFW1GlyphSheet *pGlyphSheet;
+		HRESULT hResult = g_pFW1Factory->CreateGlyphSheet(
+			g_pDevice,
+			256,
+			256,
+			sheetCases[i].coordBuffer,
+			FALSE,
+			0,
+			sheetCases[i].mipLevels,
+			&pGlyphSheet
+		);
+		if(!check(SUCCEEDED(hResult), "CreateGlyphSheet"))
+			continue;
+		
+		insertRandomGlyph(pGlyphSheet, 10, 10, random);
+		pGlyphSheet->Flush(g_pContext);
+		
+		FW1_GLYPHSHEETDESC sheetDesc;
+		pGlyphSheet->GetDesc(&sheetDesc);
+		check(sheetDesc.LastFlushBytes == sheetCases[i].expectedBytes, "LastFlushBytes of one glyph");
+		check(sheetDesc.TotalFlushBytes == sheetCases[i].expectedBytes, "TotalFlushBytes of one glyph");
+		
+		// Nothing new to upload
+		pGlyphSheet->Flush(g_pContext);
+		
+		pGlyphSheet->GetDesc(&sheetDesc);
+		check(sheetDesc.LastFlushBytes == 0, "LastFlushBytes of an empty flush");
+		check(sheetDesc.TotalFlushBytes == sheetCases[i].expectedBytes, "TotalFlushBytes after an empty flush");
+		
+		pGlyphSheet->Release();
+	}
+}
+
+
+// Replay frames of glyph insertions, each followed by a flush
+// Every flush must upload each pixel touched since the previous one, and no more than one bounding region of them would
+void testFlushBytesTrace() {
+	const UINT sheetSize = 512;
+	const UINT frameCount = 60;
+	const UINT mipLevelCases[] = {1, 3};
+	
+	for(UINT i=0; i < sizeof(mipLevelCases) / sizeof(mipLevelCases[0]); ++i) {
+		const UINT mipLevels = mipLevelCases[i];
+		const UINT alignWidth = 1 << (mipLevels - 1);
+		
+		IFW1GlyphSheet *pGlyphSheet;
+		HRESULT hResult = g_pFW1Factory->CreateGlyphSheet(g_pDevice, sheetSize, sheetSize, FALSE, FALSE, 0, mipLevels, &pGlyphSheet);
+		if(!check(SUCCEEDED(hResult), "CreateGlyphSheet"))
+			continue;
+		
+		Random random(3);
+		std::vector<UINT8> touched(sheetSize * sheetSize);
+		UINT64 flushedBytes = 0;
+		UINT64 boundingBytes = 0;
+		UINT glyphCount = 0;
+		
+		for(UINT j=0; j < frameCount; ++j) {
+			// A burst of glyphs when text first shows up, then a few new glyphs per frame
+			UINT frameGlyphCount = (j == 0) ? 200 : random.next(7);
+			for(UINT k=0; k < frameGlyphCount; ++k) {
+				UINT width = 4 + random.next(17);
+				UINT height = 8 + random.next(17);
+				if(insertRandomGlyph(pGlyphSheet, width, height, random) == 0xffffffff)
+					break;
+			}
+			
+			pGlyphSheet->Flush(g_pContext);
+			
+			FW1_GLYPHSHEETDESC sheetDesc;
+			pGlyphSheet->GetDesc(&sheetDesc);
+			
+			// Pixels touched by this frame's glyphs, and their bounding region
+			std::fill(touched.begin(), touched.end(), static_cast<UINT8>(0));
+			UINT64 touchedArea = 0;
+			RECT bounds = {static_cast<LONG>(sheetSize), static_cast<LONG>(sheetSize), 0, 0};
+			
+			const FW1_GLYPHCOORDS *pGlyphCoords = pGlyphSheet->GetGlyphCoords();
+			for(UINT k=glyphCount; k < sheetDesc.GlyphCount; ++k) {
+				RECT rect;
+				getGlyphRect(pGlyphCoords[k], sheetSize, alignWidth, rect);
+				
+				for(LONG y=rect.top; y < rect.bottom; ++y) {
+					for(LONG x=rect.left; x < rect.right; ++x) {
+						if(touched[y * sheetSize + x] == 0) {
+							touched[y * sheetSize + x] = 1;
+							++touchedArea;
+						}
+					}
+				}
+				
+				bounds.left = std::min(bounds.left, rect.left);
+				bounds.top = std::min(bounds.top, rect.top);
+				bounds.right = std::max(bounds.right, rect.right);
+				bounds.bottom = std::max(bounds.bottom, rect.bottom);
+			}
+			glyphCount = sheetDesc.GlyphCount;
+			
+			UINT64 boundingArea = 0;
+			if(bounds.right > bounds.left)
+				boundingArea = static_cast<UINT64>(bounds.right - bounds.left) * (bounds.bottom - bounds.top);
+			
+			bool uploadedAll = check(sheetDesc.LastFlushBytes >= getMipBytes(touchedArea, mipLevels), "flush uploads every touched pixel");
+			bool uploadedLess = check(sheetDesc.LastFlushBytes <= getMipBytes(boundingArea, mipLevels), "flush uploads no more than the bounding region");
+			if(!uploadedAll || !uploadedLess)
+				break;
+			
+			flushedBytes += sheetDesc.LastFlushBytes;
+			boundingBytes += getMipBytes(boundingArea, mipLevels);
+		}
+		
+		FW1_GLYPHSHEETDESC sheetDesc;
+		pGlyphSheet->GetDesc(&sheetDesc);
+		check(sheetDesc.TotalFlushBytes == flushedBytes, "TotalFlushBytes is the sum of LastFlushBytes");
+		
+		printf(
+			"  %u glyphs over %u flushes with %u mip-levels: %u bytes uploaded, %u with one bounding region per flush\n",
+			sheetDesc.GlyphCount,
+			frameCount,
+			mipLevels,
+			static_cast<UINT>(flushedBytes),
+			static_cast<UINT>(boundingBytes)
+		);
+		
+		pGlyphSheet->Release();
+	}
+}
+
+
+// Fill an image with glyph-like shapes on an empty background, solid inside with anti-aliased edges
+void makeGlyphImage(UINT width, UINT height, UINT shapeCount, UINT seed, std::vector<UINT8> &pixels) {
+	Random random(seed);
+	
+	pixels.assign(width * height, 0);
+	for(UINT i=0; i < shapeCount; ++i) {
+		UINT shapeWidth = std::min(4 + random.next(21), width);
+		UINT shapeHeight = std::min(8 + random.next(21), height);
+		UINT left = random.next(width - shapeWidth + 1);
+		UINT top = random.next(height - shapeHeight + 1);
+		
+		for(UINT y=0; y < shapeHeight; ++y) {
+			for(UINT x=0; x < shapeWidth; ++x) {
+				bool edge = (x == 0 || y == 0 || x == shapeWidth - 1 || y == shapeHeight - 1);
+				pixels[(top + y) * width + left + x] = static_cast<UINT8>(edge ? random.next(256) : 200 + random.next(56));
+			}
+		}
+	}
+}
+
+
+// Decoding the compressed blocks must give back the image within the error compressMipLevel measured, and exactly that error
+// The narrow image has a row of blocks that is not a multiple of four, which findBlockRanges handles without SIMD
+void testBlockCompression() {
+	struct ImageCase {
+		UINT	width;
+		UINT	height;
+		UINT	shapeCount;
+	};
+	
+	const ImageCase imageCases[] = {
+		{256, 256, 150},
+		{68, 12, 4}
+	};
+	
+	for(UINT i=0; i < sizeof(imageCases) / sizeof(imageCases[0]); ++i) {
+		const UINT width = imageCases[i].width;
+		const UINT height = imageCases[i].height;
+		
+		std::vector<UINT8> pixels;
+		makeGlyphImage(width, height, imageCases[i].shapeCount, 6 + i, pixels);
+		
+		std::vector<UINT8> blocks(width * height / 2);
+		UINT64 squaredSum;
+		UINT maxError;
+		CFW1GlyphSheetTest::compressMipLevel(&blocks[0], &pixels[0], width, height, &squaredSum, &maxError);
+		
+		std::vector<UINT8> decoded(width * height);
+		for(UINT y=0; y < height / 4; ++y) {
+			for(UINT x=0; x < width / 4; ++x)
+				CFW1GlyphSheetTest::decodeBlock(&decoded[y * 4 * width + x * 4], width, &blocks[(y * (width / 4) + x) * 8]);
+		}
+		
+		UINT64 decodedSquaredSum = 0;
+		UINT decodedMaxError = 0;
+		for(UINT j=0; j < width * height; ++j) {
+			UINT difference = (pixels[j] > decoded[j]) ? pixels[j] - decoded[j] : decoded[j] - pixels[j];
+			decodedSquaredSum += difference * difference;
+			decodedMaxError = std::max(decodedMaxError, difference);
+		}
+		
+		printf("  %ux%u: max error %u, RMS error %.2f\n", width, height, decodedMaxError, sqrt(static_cast<double>(decodedSquaredSum) / (width * height)));
+		
+		check(decodedMaxError == maxError, "decoded max error matches the measured max error");
+		check(decodedSquaredSum == squaredSum, "decoded squared error matches the measured squared error");
+	}
+}
+
+
+// Time the BC4 encoder on a 1024x1024 sheet of glyphs, and the block range search on its own
+void benchmarkBlockCompression() {
+	const UINT sheetSize = 1024;
+	const UINT runCount = 5;
+	
+	std::vector<UINT8> pixels;
+	makeGlyphImage(sheetSize, sheetSize, 2500, 7, pixels);
+	
+	std::vector<UINT8> blocks(sheetSize * sheetSize / 2);
+	double compressTime = DBL_MAX;
+	double rangeTime = DBL_MAX;
+	UINT rangeSum = 0;
+	
+	for(UINT i=0; i < runCount; ++i) {
+		Timer compressTimer;
+		UINT64 squaredSum;
+		UINT maxError;
+		CFW1GlyphSheetTest::compressMipLevel(&blocks[0], &pixels[0], sheetSize, sheetSize, &squaredSum, &maxError);
+		compressTime = std::min(compressTime, compressTimer.milliseconds());
+		
+		Timer rangeTimer;
+		for(UINT y=0; y < sheetSize; y += 4) {
+			for(UINT x=0; x < sheetSize; x += 16) {
+				UINT8 blockMin[4];
+				UINT8 blockMax[4];
+				CFW1GlyphSheetTest::findBlockRanges(blockMin, blockMax, &pixels[y * sheetSize + x], sheetSize, 4);
+				rangeSum += blockMax[0] - blockMin[0];
+			}
+		}
+		rangeTime = std::min(rangeTime, rangeTimer.milliseconds());
+	}
+	
+	printf(
+		"  %ux%u: compressMipLevel %.2f ms (%.0f MB/s), findBlockRanges %.2f ms\n",
+		sheetSize,
+		sheetSize,
+		compressTime,
+		static_cast<double>(sheetSize * sheetSize) / (compressTime * 1000.0),
+		rangeTime
+	);
+	
+	// Keeps the range search from being optimized away
+	check(rangeSum > 0, "the sheet has blocks with a range");
+}
+
+
+// A compressed sheet read back through GetSheetPixels must match the pixels before compression within the reported error
+void testCompressedSheetRoundTrip() {
+	const UINT sheetSize = 256;
+	const UINT mipLevels = 3;
+	
+	IFW1GlyphSheet *pGlyphSheet;
+	HRESULT hResult = g_pFW1Factory->CreateGlyphSheet(g_pDevice, sheetSize, sheetSize, FALSE, FALSE, 0, mipLevels, &pGlyphSheet);
+	if(!check(SUCCEEDED(hResult), "CreateGlyphSheet"))
+		return;
+	
+	check(SUCCEEDED(pGlyphSheet->SetCompression(TRUE)), "SetCompression");
+	
+	Random random(8);
+	for(UINT i=0; i < 150; ++i) {
+		UINT width = 4 + random.next(17);
+		UINT height = 8 + random.next(17);
+		if(insertRandomGlyph(pGlyphSheet, width, height, random) == 0xffffffff)
+			break;
+	}
+	pGlyphSheet->Flush(g_pContext);
+	
+	// The RAM copy is released once the closed sheet is compressed, so read the original pixels first
+	std::vector<UINT8> original(sheetSize * sheetSize);
+	check(SUCCEEDED(pGlyphSheet->GetSheetPixels(g_pContext, &original[0])), "GetSheetPixels before compression");
+	
+	pGlyphSheet->CloseSheet();
+	pGlyphSheet->Flush(g_pContext);
+	
+	FW1_GLYPHSHEETDESC sheetDesc;
+	pGlyphSheet->GetDesc(&sheetDesc);
+	check(sheetDesc.Compressed != FALSE, "the closed sheet is compressed");
+	check(sheetDesc.TextureBytes == getMipBytes(sheetSize * sheetSize, mipLevels) / 2, "BC4 halves the texture size");
+	
+	std::vector<UINT8> decoded(sheetSize * sheetSize);
+	check(SUCCEEDED(pGlyphSheet->GetSheetPixels(g_pContext, &decoded[0])), "GetSheetPixels after compression");
+	
+	UINT maxError = 0;
+	for(UINT i=0; i < sheetSize * sheetSize; ++i) {
+		UINT difference = (original[i] > decoded[i]) ? original[i] - decoded[i] : decoded[i] - original[i];
+		maxError = std::max(maxError, difference);
+	}
+	
+	printf(
+		"  %u glyphs: max error %u, reported max error %u, RMS error %.2f\n",
+		sheetDesc.GlyphCount,
+		maxError,
+		sheetDesc.MaxCompressionError,
+		sheetDesc.CompressionError
+	);
+	
+	check(maxError <= sheetDesc.MaxCompressionError, "read back pixels are within the reported max error");
+	
+	pGlyphSheet->Release();
+}
+
+
+// Create a glyph provider with an atlas of its own, so every test starts without glyph-maps
+HRESULT createGlyphProvider(UINT sheetSize, IFW1GlyphProvider **ppGlyphProvider) {
+	IFW1GlyphAtlas *pGlyphAtlas;
+	
+	HRESULT hResult = g_pFW1Factory->CreateGlyphAtlas(g_pDevice, sheetSize, sheetSize, FALSE, TRUE, 4096, 1, 4096, &pGlyphAtlas);
+	if(FAILED(hResult))
+		return hResult;
+	
+	hResult = g_pFW1Factory->CreateGlyphProvider(pGlyphAtlas, g_pDWriteFactory, g_pFontCollection, 0, 0, ppGlyphProvider);
+	
+	pGlyphAtlas->Release();
+	
+	return hResult;
+}
+
+
+// Font size and flags of a glyph-map cache test key, two flag sets per size
+void getCacheTestKey(UINT key, FLOAT *pFontSize, UINT *pFontFlags) {
+	*pFontSize = 8.0f + 0.25f * static_cast<FLOAT>(key / 2);
+	*pFontFlags = FW1_EXACTFONTSIZE | (((key & 1) != 0) ? FW1_ALIASED : 0);
+}
+
+
+// Glyph-maps seen by one thread of the glyph-map cache test
+struct GlyphMapCacheThread {
+	IFW1GlyphProvider			*pGlyphProvider;
+	UINT						keyCount;
+	UINT						roundCount;
+	UINT						seed;
+	bool						uncache;
+	
+	std::vector<const void*>	glyphMaps;// The glyph-map first returned for each key
+	UINT						mismatchCount;
+};
+
+
+// Look up every key in a shuffled order a number of times, optionally clearing the font-face from the cache as it goes
+DWORD WINAPI glyphMapCacheThreadProc(LPVOID pParam) {
+	GlyphMapCacheThread *thread = static_cast<GlyphMapCacheThread*>(pParam);
+	Random random(thread->seed);
+	
+	for(UINT i=0; i < thread->roundCount; ++i) {
+		// An odd stride visits every key once, as the key count is a power of two
+		UINT start = random.next(thread->keyCount);
+		UINT stride = random.next(thread->keyCount) | 1;
+		
+		for(UINT j=0; j < thread->keyCount; ++j) {
+			UINT key = (start + j * stride) & (thread->keyCount - 1);
+			
+			FLOAT fontSize;
+			UINT fontFlags;
+			getCacheTestKey(key, &fontSize, &fontFlags);
+			
+			const void *glyphMap = thread->pGlyphProvider->GetGlyphMapFromFont(g_pFontFace, fontSize, fontFlags);
+			if(thread->glyphMaps[key] == NULL)
+				thread->glyphMaps[key] = glyphMap;
+			else if(thread->glyphMaps[key] != glyphMap)
+				++thread->mismatchCount;
+			
+			if(thread->uncache && (j % 16) == 0)
+				CFW1GlyphProviderTest::uncacheFontFace(thread->pGlyphProvider, g_pFontFace);
+		}
+	}
+	
+	return 0;
+}
+
+
+// Threads creating and looking up glyph-maps while the cache table grows and is cleared must all get the same glyph-map per key
+void testGlyphMapCacheThreads() {
+	const UINT threadCount = 8;
+	const UINT uncacheThreadCount = 2;
+	const UINT keyCount = 512;
+	const UINT grownKeyCount = 4 * keyCount;
+	
+	IFW1GlyphProvider *pGlyphProvider;
+	HRESULT hResult = createGlyphProvider(256, &pGlyphProvider);
+	if(!check(SUCCEEDED(hResult), "createGlyphProvider"))
+		return;
+	
+	// Only the glyph-maps are under test, so no glyph images are drawn
+	pGlyphProvider->SetStaticGlyphAtlas(TRUE);
+	
+	GlyphMapCacheThread threads[threadCount];
+	HANDLE threadHandles[threadCount];
+	UINT startedCount = 0;
+	
+	Timer timer;
+	
+	for(UINT i=0; i < threadCount; ++i) {
+		threads[i].pGlyphProvider = pGlyphProvider;
+		threads[i].keyCount = keyCount;
+		threads[i].roundCount = 4;
+		threads[i].seed = i + 1;
+		threads[i].uncache = (i < uncacheThreadCount);
+		threads[i].glyphMaps.assign(keyCount, NULL);
+		threads[i].mismatchCount = 0;
+		
+		threadHandles[i] = CreateThread(NULL, 0, glyphMapCacheThreadProc, &threads[i], 0, NULL);
+		if(!check(threadHandles[i] != NULL, "CreateThread"))
+			break;
+		++startedCount;
+	}
+	
+	if(startedCount > 0)
+		WaitForMultipleObjects(startedCount, threadHandles, TRUE, INFINITE);
+	for(UINT i=0; i < startedCount; ++i)
+		CloseHandle(threadHandles[i]);
+	
+	double threadTime = timer.milliseconds();
+	
+	// Every thread must have got the same glyph-map for a key every time
+	UINT mismatchCount = 0;
+	for(UINT i=0; i < startedCount; ++i) {
+		mismatchCount += threads[i].mismatchCount;
+		
+		for(UINT j=0; j < keyCount; ++j) {
+			if(threads[i].glyphMaps[j] != threads[0].glyphMaps[j])
+				++mismatchCount;
+		}
+	}
+	check(mismatchCount == 0, "a key always gets the same glyph-map");
+	
+	std::set<const void*> distinctGlyphMaps(threads[0].glyphMaps.begin(), threads[0].glyphMaps.end());
+	check(distinctGlyphMaps.count(NULL) == 0, "every key gets a glyph-map");
+	check(distinctGlyphMaps.size() == keyCount, "every key gets a glyph-map of its own");
+	check(CFW1GlyphProviderTest::getGlyphMapCount(pGlyphProvider) == keyCount, "no glyph-map is created twice");
+	
+	// Once looked up again after the last clear, every key must stay in the table while new keys make it grow
+	std::vector<const void*> expectedGlyphMaps(threads[0].glyphMaps);
+	for(UINT i=0; i < grownKeyCount; ++i) {
+		FLOAT fontSize;
+		UINT fontFlags;
+		getCacheTestKey(i, &fontSize, &fontFlags);
+		
+		const void *glyphMap = pGlyphProvider->GetGlyphMapFromFont(g_pFontFace, fontSize, fontFlags);
+		if(i >= keyCount)
+			expectedGlyphMaps.push_back(glyphMap);
+	}
+	
+	UINT lostCount = 0;
+	for(UINT i=0; i < grownKeyCount; ++i) {
+		FLOAT fontSize;
+		UINT fontFlags;
+		getCacheTestKey(i, &fontSize, &fontFlags);
+		
+		if(CFW1GlyphProviderTest::findCachedGlyphMap(pGlyphProvider, g_pFontFace, fontSize, fontFlags) != expectedGlyphMaps[i])
+			++lostCount;
+	}
+	check(lostCount == 0, "no cache entry is lost when the table grows");
+	
+	UINT capacity = CFW1GlyphProviderTest::getGlyphMapCacheCapacity(pGlyphProvider);
+	check(capacity >= 2 * grownKeyCount, "the table grew to hold every key");
+	
+	printf(
+		"  %u threads, %u glyph-maps, table capacity %u, %.2f ms\n",
+		startedCount,
+		grownKeyCount,
+		capacity,
+		threadTime
+	);
+	
+	pGlyphProvider->Release();
+}
+
+
+// A glyph-map allocates the page of a glyph when the glyph is first inserted, and lookups without new glyphs allocate nothing
+void testLazyGlyphPages() {
+	IFW1GlyphProvider *pGlyphProvider;
+	HRESULT hResult = createGlyphProvider(512, &pGlyphProvider);
+	if(!check(SUCCEEDED(hResult), "createGlyphProvider"))
+		return;
+	
+	const UINT pageSize = CFW1GlyphProviderTest::getGlyphPageSize();
+	const UINT glyphCount = g_pFontFace->GetGlyphCount();
+	const UINT lastGlyph = glyphCount - 1;
+	
+	// The font default-glyph is inserted with the glyph-map, so only its page exists
+	const void *pGlyphMap = pGlyphProvider->GetGlyphMapFromFont(g_pFontFace, 16.0f, FW1_EXACTFONTSIZE);
+	if(!check(pGlyphMap != NULL, "GetGlyphMapFromFont"))
+		return;
+	
+	UINT pageCount = CFW1GlyphProviderTest::getPageCount(pGlyphMap);
+	check(pageCount == (glyphCount + pageSize - 1) / pageSize, "one page pointer per page of glyphs");
+	check(pageCount >= 3, "the test font has glyphs in at least three pages");
+	check(CFW1GlyphProviderTest::getAllocatedPageCount(pGlyphMap) == 1, "a new glyph-map only has the default-glyph page");
+	check(CFW1GlyphProviderTest::isPageAllocated(pGlyphMap, 0), "the default-glyph page is allocated");
+	
+	UINT defaultGlyphId = pGlyphProvider->GetAtlasIdFromGlyphIndex(pGlyphMap, 0, g_pFontFace, FW1_NONEWGLYPHS);
+	
+	// A lookup without new glyphs leaves a missing page missing, and gets the default-glyph
+	UINT middleGlyph = pageSize + 1;
+	UINT glyphAtlasId = pGlyphProvider->GetAtlasIdFromGlyphIndex(pGlyphMap, static_cast<UINT16>(middleGlyph), g_pFontFace, FW1_NONEWGLYPHS);
+	check(glyphAtlasId == defaultGlyphId, "a glyph in a missing page gets the default-glyph");
+	check(!CFW1GlyphProviderTest::isPageAllocated(pGlyphMap, 1), "FW1_NONEWGLYPHS allocates no page");
+	
+	// Inserting glyphs allocates their page once
+	pGlyphProvider->GetAtlasIdFromGlyphIndex(pGlyphMap, static_cast<UINT16>(lastGlyph), g_pFontFace, 0);
+	pGlyphProvider->GetAtlasIdFromGlyphIndex(pGlyphMap, static_cast<UINT16>(lastGlyph - 1), g_pFontFace, 0);
+	check(CFW1GlyphProviderTest::getAllocatedPageCount(pGlyphMap) == 2, "two glyphs in one page allocate it once");
+	check(CFW1GlyphProviderTest::isPageAllocated(pGlyphMap, lastGlyph / pageSize), "the page of the inserted glyphs is allocated");
+	check(!CFW1GlyphProviderTest::isPageAllocated(pGlyphMap, 1), "pages between stay missing");
+	
+	// Glyphs past the end of the font get the fallback without touching any page
+	glyphAtlasId = pGlyphProvider->GetAtlasIdFromGlyphIndex(pGlyphMap, static_cast<UINT16>(glyphCount), g_pFontFace, 0);
+	check(glyphAtlasId == 0, "a glyph index past the font gets the atlas default-glyph");
+	check(CFW1GlyphProviderTest::getAllocatedPageCount(pGlyphMap) == 2, "a glyph index past the font allocates no page");
+	
+	UINT64 memoryUsage = pGlyphProvider->GetGlyphMapMemoryUsage(pGlyphMap);
+	UINT64 fullMemoryUsage = CFW1GlyphProviderTest::getGlyphMapBytes(pageCount, pageCount);
+	check(memoryUsage == CFW1GlyphProviderTest::getGlyphMapBytes(pageCount, 2), "the memory usage counts the allocated pages");
+	
+	printf(
+		"  %u glyphs in %u pages: %u bytes with 2 pages allocated, %u bytes with all\n",
+		glyphCount,
+		pageCount,
+		static_cast<UINT>(memoryUsage),
+		static_cast<UINT>(fullMemoryUsage)
+	);
+	
+	pGlyphProvider->Release();
+}
+
+
+// Lay out a line of text at every size from 12.0 to 24.0 in steps of 0.1, as a zooming view would
+// Returns the number of distinct glyphs per size, counting the font default-glyph
+UINT runZoomSweep(FLOAT fontSizeStep, UINT fontFlags, FW1_GLYPHPROVIDERSTATS *pStats, UINT64 *pMemoryUsage, double *pTime) {
+	const WCHAR text[] = L"The quick brown fox jumps over the lazy dog";
+	const UINT32 textLength = sizeof(text) / sizeof(text[0]) - 1;
+	
+	std::vector<UINT32> codePoints(text, text + textLength);
+	std::vector<UINT16> glyphIndices(textLength);
+	if(!check(SUCCEEDED(g_pFontFace->GetGlyphIndices(&codePoints[0], textLength, &glyphIndices[0])), "GetGlyphIndices"))
+		return 0;
+	
+	std::set<UINT16> distinctGlyphs(glyphIndices.begin(), glyphIndices.end());
+	distinctGlyphs.insert(0);
+	
+	IFW1GlyphProvider *pGlyphProvider;
+	HRESULT hResult = createGlyphProvider(512, &pGlyphProvider);
+	if(!check(SUCCEEDED(hResult), "createGlyphProvider"))
+		return 0;
+	
+	pGlyphProvider->SetFontSizeStep(fontSizeStep);
+	
+	Timer timer;
+	
+	// Sizes are made from whole tenths, so the sizes on a step are exact
+	for(UINT i=120; i <= 240; ++i) {
+		FLOAT fontSize = static_cast<FLOAT>(i) / 10.0f;
+		
+		const void *pGlyphMap = pGlyphProvider->GetGlyphMapFromFont(g_pFontFace, fontSize, fontFlags);
+		for(UINT32 j=0; j < textLength; ++j)
+			pGlyphProvider->GetAtlasIdFromGlyphIndex(pGlyphMap, glyphIndices[j], g_pFontFace, fontFlags);
+	}
+	
+	*pTime = timer.milliseconds();
+	
+	pGlyphProvider->GetStatistics(pStats);
+	
+	IFW1GlyphAtlas *pGlyphAtlas;
+	pGlyphProvider->GetGlyphAtlas(&pGlyphAtlas);
+	*pMemoryUsage = pGlyphAtlas->GetMemoryUsage();
+	pGlyphAtlas->Release();
+	
+	pGlyphProvider->Release();
+	
+	return static_cast<UINT>(distinctGlyphs.size());
+}
+
+
+// Print the results of a zoom sweep
+void printZoomSweep(const char *pszName, const FW1_GLYPHPROVIDERSTATS &stats, UINT64 memoryUsage, double time) {
+	printf(
+		"  %s: %u rasterized, %u scaled covering %u pixels, atlas %u KB, %.1f ms\n",
+		pszName,
+		stats.RasterizedGlyphCount,
+		stats.ScaledGlyphCount,
+		static_cast<UINT>(stats.ScaledGlyphArea),
+		static_cast<UINT>(memoryUsage / 1024),
+		time
+	);
+}
+
+
+// Snapping to a font size step must draw glyphs for far fewer sizes than a zoom goes through, and take less atlas memory
+void benchmarkZoomSweep() {
+	FW1_GLYPHPROVIDERSTATS snappedStats;
+	UINT64 snappedMemory;
+	double snappedTime;
+	UINT glyphCount = runZoomSweep(1.0f, 0, &snappedStats, &snappedMemory, &snappedTime);
+	if(glyphCount == 0)
+		return;
+	
+	FW1_GLYPHPROVIDERSTATS exactStats;
+	UINT64 exactMemory;
+	double exactTime;
+	if(runZoomSweep(1.0f, FW1_EXACTFONTSIZE, &exactStats, &exactMemory, &exactTime) == 0)
+		return;
+	
+	printZoomSweep("step 1.0", snappedStats, snappedMemory, snappedTime);
+	printZoomSweep("FW1_EXACTFONTSIZE", exactStats, exactMemory, exactTime);
+	
+	check(snappedStats.ScaledGlyphCount > 0, "sizes between steps are scaled");
+	check(exactStats.ScaledGlyphCount == 0, "FW1_EXACTFONTSIZE scales nothing");
+	check(snappedStats.RasterizedGlyphCount < exactStats.RasterizedGlyphCount, "snapping rasterizes fewer glyphs");
+	check(snappedMemory <= exactMemory, "snapping takes no more atlas memory");
+	
+	// Only the 13 whole sizes are drawn
+	check(snappedStats.RasterizedGlyphCount <= 13 * glyphCount, "only the whole sizes are rasterized");
+}
+
+
+// The distance transform must give the exact squared distance to the nearest seed, as found by trying every seed
+void testDistanceTransform() {
+	const UINT gridSizes[][2] = {
+		{1, 1}, {1, 9}, {9, 1}, {2, 2}, {5, 7}, {16, 16}, {31, 17}, {40, 64}
+	};
+	const FLOAT farAway = 1e20f;
+	
+	Random random(9);
+	UINT wrongCount = 0;
+	
+	for(UINT i=0; i < sizeof(gridSizes) / sizeof(gridSizes[0]); ++i) {
+		const UINT width = gridSizes[i][0];
+		const UINT height = gridSizes[i][1];
+		
+		for(UINT j=0; j < 20; ++j) {
+			// From a single seed up to about half the grid
+			std::vector<FLOAT> grid(width * height, farAway);
+			std::vector<UINT> seeds;
+			UINT seedCount = 1 + random.next(std::max(width * height / 2, 1U));
+			for(UINT k=0; k < seedCount; ++k) {
+				UINT seed = random.next(width * height);
+				grid[seed] = 0.0f;
+				seeds.push_back(seed);
+			}
+			
+			CFW1GlyphProviderTest::distanceTransform(&grid[0], width, height);
+			
+			for(UINT y=0; y < height; ++y) {
+				for(UINT x=0; x < width; ++x) {
+					UINT nearest = UINT_MAX;
+					for(size_t k=0; k < seeds.size(); ++k) {
+						INT dx = static_cast<INT>(x) - static_cast<INT>(seeds[k] % width);
+						INT dy = static_cast<INT>(y) - static_cast<INT>(seeds[k] / width);
+						nearest = std::min(nearest, static_cast<UINT>(dx * dx + dy * dy));
+					}
+					
+					if(grid[y * width + x] != static_cast<FLOAT>(nearest))
+						++wrongCount;
+				}
+			}
+		}
+	}
+	
+	check(wrongCount == 0, "every squared distance matches the nearest seed");
+}
+
+
+// A distance field of a square must be padded by the spread, be 0.5 on the edge, and rise steadily towards the center
+void testDistanceField() {
+	IFW1GlyphProvider *pGlyphProvider;
+	HRESULT hResult = createGlyphProvider(256, &pGlyphProvider);
+	if(!check(SUCCEEDED(hResult), "createGlyphProvider"))
+		return;
+	
+	// A spread of 4 pixels, an eighth of the size
+	check(SUCCEEDED(pGlyphProvider->SetDistanceFieldSize(32.0f)), "SetDistanceFieldSize");
+	const UINT spread = 4;
+	
+	// A 20x20 square with a half-covered right column
+	const UINT size = 20;
+	std::vector<UINT8> coverage(size * size, 255);
+	for(UINT y=0; y < size; ++y)
+		coverage[y * size + size - 1] = 128;
+	
+	FW1_GLYPHIMAGEDATA glyphData;
+	glyphData.Metrics.OffsetX = 1.0f;
+	glyphData.Metrics.OffsetY = -20.0f;
+	glyphData.Metrics.Width = size;
+	glyphData.Metrics.Height = size;
+	glyphData.pGlyphPixels = &coverage[0];
+	glyphData.RowPitch = size;
+	glyphData.PixelStride = 1;
+	
+	std::vector<UINT8> field;
+	FW1_GLYPHMETRICS fieldMetrics;
+	CFW1GlyphProviderTest::createDistanceField(pGlyphProvider, glyphData, field, fieldMetrics);
+	
+	const UINT width = size + 2 * spread;
+	check(fieldMetrics.Width == width && fieldMetrics.Height == width, "the field is padded by the spread");
+	check(fieldMetrics.OffsetX == 1.0f - spread && fieldMetrics.OffsetY == -20.0f - spread, "the offsets move by the spread");
+	if(field.size() != width * width)
+		return;
+	
+	const UINT centerY = width / 2;
+	const UINT8 *row = &field[centerY * width];
+	
+	check(field[0] == 0 && field[width * width - 1] == 0, "corners a spread away are empty");
+	check(row[width / 2] == 255, "the center is full");
+	check(row[spread - 1] < 128 && row[spread] >= 128, "the left edge crosses 0.5");
+	check(abs(static_cast<INT>(row[spread + size - 1]) - 128) <= 1, "a half-covered pixel is on the edge");
+	
+	// Steadily rising towards the center from both sides, and symmetric from top to bottom
+	UINT unevenCount = 0;
+	for(UINT x=1; x <= width / 2; ++x) {
+		if(row[x] < row[x - 1])
+			++unevenCount;
+	}
+	for(UINT x = spread + size - 1; x + 1 < width; ++x) {
+		if(row[x + 1] > row[x])
+			++unevenCount;
+	}
+	for(UINT y=0; y < width; ++y) {
+		for(UINT x=0; x < width; ++x) {
+			if(field[y * width + x] != field[(width - 1 - y) * width + x])
+				++unevenCount;
+		}
+	}
+	check(unevenCount == 0, "the field rises towards the center and is symmetric");
+	
+	pGlyphProvider->Release();
+}
+
+
+// With a budget of two glyphs per frame, later glyphs get the default-glyph as a placeholder and are drawn in later frames, oldest first
+void testGlyphBudget() {
+	const UINT32 codePoints[] = {'A', 'B', 'C', 'D', 'E', 'F', 'G'};
+	const UINT32 glyphCount = sizeof(codePoints) / sizeof(codePoints[0]);
+	UINT16 glyphs[glyphCount];
+	if(!check(SUCCEEDED(g_pFontFace->GetGlyphIndices(codePoints, glyphCount, glyphs)), "GetGlyphIndices"))
+		return;
+	
+	IFW1GlyphProvider *pGlyphProvider;
+	HRESULT hResult = createGlyphProvider(512, &pGlyphProvider);
+	if(!check(SUCCEEDED(hResult), "createGlyphProvider"))
+		return;
+	
+	pGlyphProvider->SetGlyphBudget(2, 0);
+	
+	// The default-glyph is drawn with the glyph-map, outside the budget
+	const void *pGlyphMap = pGlyphProvider->GetGlyphMapFromFont(g_pFontFace, 20.0f, FW1_EXACTFONTSIZE);
+	UINT placeholderId = pGlyphProvider->GetAtlasIdFromGlyphIndex(pGlyphMap, 0, g_pFontFace, FW1_NONEWGLYPHS);
+	pGlyphProvider->NewFrame();
+	
+	// Frame 1: A and B are drawn, C, D and E wait
+	BOOL isPlaceholder[glyphCount];
+	UINT glyphIds[glyphCount];
+	for(UINT i=0; i < 5; ++i)
+		glyphIds[i] = pGlyphProvider->GetAtlasIdOrPlaceholder(pGlyphMap, glyphs[i], g_pFontFace, 0, &isPlaceholder[i]);
+	
+	check(!isPlaceholder[0] && !isPlaceholder[1], "glyphs within the budget are drawn");
+	check(glyphIds[0] != placeholderId && glyphIds[1] != placeholderId, "drawn glyphs get their own image");
+	check(isPlaceholder[2] && isPlaceholder[3] && isPlaceholder[4], "glyphs over the budget are placeholders");
+	check(glyphIds[2] == placeholderId && glyphIds[4] == placeholderId, "placeholders use the default-glyph");
+	check(
+		CFW1GlyphProviderTest::getGlyphAtlasId(pGlyphProvider, pGlyphMap, glyphs[2]) == 0xffffffff,
+		"a deferred glyph keeps its empty entry"
+	);
+	
+	// Asking again does not queue a glyph twice, and glyphs outside the budget are drawn anyway
+	BOOL placeholderAgain;
+	pGlyphProvider->GetAtlasIdOrPlaceholder(pGlyphMap, glyphs[2], g_pFontFace, 0, &placeholderAgain);
+	check(placeholderAgain != FALSE, "a deferred glyph stays a placeholder in its frame");
+	
+	BOOL unbudgetedPlaceholder;
+	pGlyphProvider->GetAtlasIdOrPlaceholder(pGlyphMap, glyphs[5], g_pFontFace, FW1_NOGLYPHBUDGET, &unbudgetedPlaceholder);
+	check(unbudgetedPlaceholder == FALSE, "FW1_NOGLYPHBUDGET draws past the budget");
+	
+	FW1_GLYPHPROVIDERSTATS stats;
+	pGlyphProvider->GetStatistics(&stats);
+	check(stats.DeferredGlyphCount == 3 && stats.DeferredDrawnCount == 0, "three glyphs are queued once each");
+	
+	// Frame 2: the oldest two, C and D, use up the budget, so E waits on and the new G queues behind it
+	pGlyphProvider->NewFrame();
+	
+	check(CFW1GlyphProviderTest::getGlyphAtlasId(pGlyphProvider, pGlyphMap, glyphs[2]) != 0xffffffff, "C is drawn first");
+	check(CFW1GlyphProviderTest::getGlyphAtlasId(pGlyphProvider, pGlyphMap, glyphs[3]) != 0xffffffff, "D is drawn second");
+	check(CFW1GlyphProviderTest::getGlyphAtlasId(pGlyphProvider, pGlyphMap, glyphs[4]) == 0xffffffff, "E waits for the next frame");
+	
+	BOOL drawnPlaceholder;
+	UINT drawnId = pGlyphProvider->GetAtlasIdOrPlaceholder(pGlyphMap, glyphs[2], g_pFontFace, 0, &drawnPlaceholder);
+	check(drawnPlaceholder == FALSE && drawnId != placeholderId, "a drawn deferred glyph replaces its placeholder");
+	
+	BOOL newPlaceholder;
+	pGlyphProvider->GetAtlasIdOrPlaceholder(pGlyphMap, glyphs[6], g_pFontFace, 0, &newPlaceholder);
+	check(newPlaceholder != FALSE, "deferred glyphs count against the budget of their frame");
+	
+	pGlyphProvider->GetStatistics(&stats);
+	check(stats.DeferredGlyphCount == 2 && stats.DeferredDrawnCount == 2, "E and G are queued after two were drawn");
+	
+	// Frame 3: E and G
+	pGlyphProvider->NewFrame();
+	
+	check(CFW1GlyphProviderTest::getGlyphAtlasId(pGlyphProvider, pGlyphMap, glyphs[4]) != 0xffffffff, "E is drawn");
+	check(CFW1GlyphProviderTest::getGlyphAtlasId(pGlyphProvider, pGlyphMap, glyphs[6]) != 0xffffffff, "G is drawn");
+	
+	pGlyphProvider->GetStatistics(&stats);
+	check(stats.DeferredGlyphCount == 0 && stats.DeferredDrawnCount == 4, "the queue is empty");
+	
+	pGlyphProvider->Release();
+}
+
+
+// Coords of a glyph in the atlas of a glyph provider, and the sheet pixels inside them
+void getGlyphImage(IFW1GlyphProvider *pGlyphProvider, UINT glyphAtlasId, FW1_GLYPHCOORDS *pCoords, std::vector<UINT8> &pixels) {
+	ZeroMemory(pCoords, sizeof(*pCoords));
+	pixels.clear();
+	
+	IFW1GlyphAtlas *pGlyphAtlas;
+	pGlyphProvider->GetGlyphAtlas(&pGlyphAtlas);
+	
+	IFW1GlyphSheet *pGlyphSheet;
+	if(SUCCEEDED(pGlyphAtlas->GetSheet(glyphAtlasId >> 16, &pGlyphSheet))) {
+		FW1_GLYPHSHEETDESC desc;
+		pGlyphSheet->GetDesc(&desc);
+		
+		if((glyphAtlasId & 0xffff) < desc.GlyphCount) {
+			*pCoords = pGlyphSheet->GetGlyphCoords()[glyphAtlasId & 0xffff];
+			
+			std::vector<UINT8> sheetPixels(desc.Width * desc.Height);
+			if(SUCCEEDED(pGlyphSheet->GetSheetPixels(g_pContext, &sheetPixels[0]))) {
+				UINT left = static_cast<UINT>(std::max(pCoords->TexCoordLeft * desc.Width, 0.0f));
+				UINT top = static_cast<UINT>(std::max(pCoords->TexCoordTop * desc.Height, 0.0f));
+				UINT right = std::min(static_cast<UINT>(ceil(pCoords->TexCoordRight * static_cast<FLOAT>(desc.Width))), desc.Width);
+				UINT bottom = std::min(static_cast<UINT>(ceil(pCoords->TexCoordBottom * static_cast<FLOAT>(desc.Height))), desc.Height);
+				
+				for(UINT y=top; y < bottom; ++y) {
+					for(UINT x=left; x < right; ++x)
+						pixels.push_back(sheetPixels[y * desc.Width + x]);
+				}
+			}
+		}
+	}
+	
+	pGlyphAtlas->Release();
+}
+
+
+// Draw a few glyphs at a whole font size and at one scaled from it, for a glyph cache to hold
+HRESULT createGlyphCacheSource(const UINT16 *pGlyphs, UINT glyphCount, UINT *pGlyphAtlasIds, IFW1GlyphProvider **ppGlyphProvider) {
+	HRESULT hResult = createGlyphProvider(512, ppGlyphProvider);
+	if(FAILED(hResult))
+		return hResult;
+	
+	IFW1GlyphProvider *pGlyphProvider = *ppGlyphProvider;
+	pGlyphProvider->SetFontSizeStep(1.0f);
+	
+	const FLOAT fontSizes[] = {16.0f, 16.5f};
+	for(UINT i=0; i < 2; ++i) {
+		const void *pGlyphMap = pGlyphProvider->GetGlyphMapFromFont(g_pFontFace, fontSizes[i], 0);
+		for(UINT j=0; j < glyphCount; ++j)
+			pGlyphAtlasIds[i * glyphCount + j] = pGlyphProvider->GetAtlasIdFromGlyphIndex(pGlyphMap, pGlyphs[j], g_pFontFace, 0);
+	}
+	
+	return S_OK;
+}
+
+
+// A glyph cache saved by one glyph provider must give a new provider the same glyph images, without drawing any
+void testGlyphCacheRoundTrip() {
+	const UINT32 codePoints[] = {'H', 'e', 'l', 'o', ',', 'w', 'r', 'd', '!'};
+	const UINT32 glyphCount = sizeof(codePoints) / sizeof(codePoints[0]);
+	UINT16 glyphs[glyphCount];
+	if(!check(SUCCEEDED(g_pFontFace->GetGlyphIndices(codePoints, glyphCount, glyphs)), "GetGlyphIndices"))
+		return;
+	
+	WCHAR tempPath[MAX_PATH];
+	if(!check(GetTempPathW(MAX_PATH, tempPath) > 0, "GetTempPathW"))
+		return;
+	std::wstring fileName = tempPath;
+	fileName += L"FW1TestsGlyphCache.bin";
+	
+	IFW1GlyphProvider *pSavedProvider;
+	UINT savedIds[2 * glyphCount];
+	HRESULT hResult = createGlyphCacheSource(glyphs, glyphCount, savedIds, &pSavedProvider);
+	if(!check(SUCCEEDED(hResult), "createGlyphCacheSource"))
+		return;
+	
+	FW1_GLYPHPROVIDERSTATS stats;
+	pSavedProvider->GetStatistics(&stats);
+	check(stats.ScaledGlyphCount > 0, "the half size is scaled");
+	
+	hResult = pSavedProvider->SaveGlyphCache(g_pContext, fileName.c_str());
+	if(!check(SUCCEEDED(hResult), "SaveGlyphCache")) {
+		pSavedProvider->Release();
+		return;
+	}
+	
+	IFW1GlyphProvider *pLoadedProvider;
+	hResult = createGlyphProvider(512, &pLoadedProvider);
+	if(!check(SUCCEEDED(hResult), "createGlyphProvider")) {
+		pSavedProvider->Release();
+		return;
+	}
+	
+	pLoadedProvider->SetFontSizeStep(1.0f);
+	check(SUCCEEDED(pLoadedProvider->LoadGlyphCache(fileName.c_str())), "LoadGlyphCache");
+	check(
+		CFW1GlyphProviderTest::getGlyphMapCount(pLoadedProvider) == CFW1GlyphProviderTest::getGlyphMapCount(pSavedProvider),
+		"every glyph-map is restored"
+	);
+	
+	// Atlas IDs differ, as the loaded sheets follow the sheet of the new atlas
+	pLoadedProvider->SetStaticGlyphAtlas(TRUE);
+	
+	const FLOAT fontSizes[] = {16.0f, 16.5f};
+	UINT coordMismatches = 0;
+	UINT pixelMismatches = 0;
+	for(UINT i=0; i < 2; ++i) {
+		const void *pGlyphMap = pLoadedProvider->GetGlyphMapFromFont(g_pFontFace, fontSizes[i], 0);
+		
+		for(UINT j=0; j < glyphCount; ++j) {
+			UINT loadedId = pLoadedProvider->GetAtlasIdFromGlyphIndex(pGlyphMap, glyphs[j], g_pFontFace, 0);
+			
+			FW1_GLYPHCOORDS savedCoords, loadedCoords;
+			std::vector<UINT8> savedPixels, loadedPixels;
+			getGlyphImage(pSavedProvider, savedIds[i * glyphCount + j], &savedCoords, savedPixels);
+			getGlyphImage(pLoadedProvider, loadedId, &loadedCoords, loadedPixels);
+			
+			if(memcmp(&savedCoords, &loadedCoords, sizeof(savedCoords)) != 0)
+				++coordMismatches;
+			if(savedPixels != loadedPixels)
+				++pixelMismatches;
+		}
+	}
+	check(coordMismatches == 0, "loaded glyphs have the saved coords");
+	check(pixelMismatches == 0, "loaded glyphs have the saved pixels");
+	
+	pLoadedProvider->GetStatistics(&stats);
+	check(stats.RasterizedGlyphCount == 0 && stats.ScaledGlyphCount == 0, "no glyph is drawn after loading");
+	
+	check(FAILED(pLoadedProvider->LoadGlyphCache(fileName.c_str())), "a provider with glyph-maps does not load a cache");
+	
+	DeleteFileW(fileName.c_str());
+	
+	pLoadedProvider->Release();
+	pSavedProvider->Release();
+}
+
+
+// Overwrite a field in a copy of a glyph cache, and read the copy into a glyph provider
+template<typename T>
+HRESULT readDamagedGlyphCache(IFW1GlyphProvider *pGlyphProvider, std::vector<UINT8> cacheData, size_t offset, T value) {
+	memcpy(&cacheData[offset], &value, sizeof(value));
+	
+	return CFW1GlyphProviderTest::readGlyphCache(pGlyphProvider, &cacheData[0], cacheData.size());
+}
+
+
+// A truncated or damaged glyph cache must be rejected as a whole, leaving the glyph provider without glyph-maps or new sheets
+void testGlyphCacheRejection() {
+	typedef CFW1GlyphProviderTest::GlyphCacheHeader GlyphCacheHeader;
+	typedef CFW1GlyphProviderTest::GlyphCacheFont GlyphCacheFont;
+	typedef CFW1GlyphProviderTest::GlyphCacheSheet GlyphCacheSheet;
+	typedef CFW1GlyphProviderTest::GlyphCacheGlyphMap GlyphCacheGlyphMap;
+	
+	const UINT32 codePoints[] = {'A', 'B', 'C', 'D', 'E'};
+	const UINT32 glyphCount = sizeof(codePoints) / sizeof(codePoints[0]);
+	UINT16 glyphs[glyphCount];
+	if(!check(SUCCEEDED(g_pFontFace->GetGlyphIndices(codePoints, glyphCount, glyphs)), "GetGlyphIndices"))
+		return;
+	
+	IFW1GlyphProvider *pSourceProvider;
+	UINT glyphAtlasIds[2 * glyphCount];
+	HRESULT hResult = createGlyphCacheSource(glyphs, glyphCount, glyphAtlasIds, &pSourceProvider);
+	if(!check(SUCCEEDED(hResult), "createGlyphCacheSource"))
+		return;
+	
+	std::vector<UINT8> cacheData;
+	CFW1GlyphProviderTest::writeGlyphCache(pSourceProvider, g_pContext, cacheData);
+	pSourceProvider->Release();
+	
+	// Find the first sheet, its first glyph coords and the first glyph-map
+	GlyphCacheHeader header;
+	memcpy(&header, &cacheData[0], sizeof(header));
+	
+	size_t position = sizeof(header);
+	for(UINT i=0; i < header.fontCount; ++i) {
+		GlyphCacheFont font;
+		memcpy(&font, &cacheData[position], sizeof(font));
+		position += sizeof(font) + font.nameLength * sizeof(WCHAR);
+	}
+	
+	const size_t sheetOffset = position;
+	const size_t coordsOffset = sheetOffset + sizeof(GlyphCacheSheet);
+	GlyphCacheSheet firstSheet;
+	memcpy(&firstSheet, &cacheData[sheetOffset], sizeof(firstSheet));
+	FW1_GLYPHCOORDS firstCoords;
+	memcpy(&firstCoords, &cacheData[coordsOffset], sizeof(firstCoords));
+	
+	for(UINT i=0; i < header.sheetCount; ++i) {
+		GlyphCacheSheet sheet;
+		memcpy(&sheet, &cacheData[position], sizeof(sheet));
+		position += sizeof(sheet) + sheet.glyphCount * sizeof(FW1_GLYPHCOORDS) + sheet.rowCount * header.sheetWidth;
+	}
+	
+	const size_t glyphMapOffset = position;
+	GlyphCacheGlyphMap firstGlyphMap;
+	memcpy(&firstGlyphMap, &cacheData[glyphMapOffset], sizeof(firstGlyphMap));
+	
+	if(!check(header.sheetCount > 0 && header.glyphMapCount > 1 && firstSheet.glyphCount > 0, "the cache holds sheets and glyph-maps"))
+		return;
+	
+	IFW1GlyphProvider *pGlyphProvider;
+	hResult = createGlyphProvider(512, &pGlyphProvider);
+	if(!check(SUCCEEDED(hResult), "createGlyphProvider"))
+		return;
+	
+	IFW1GlyphAtlas *pGlyphAtlas;
+	pGlyphProvider->GetGlyphAtlas(&pGlyphAtlas);
+	UINT sheetCount = pGlyphAtlas->GetSheetCount();
+	
+	// Every cut through the header, fonts and first sheet, and a spread of cuts after it
+	UINT truncationCount = 0;
+	UINT acceptedTruncations = 0;
+	for(size_t size=0; size < cacheData.size(); size += (size < coordsOffset + 4 * sizeof(FW1_GLYPHCOORDS)) ? 1 : 61) {
+		++truncationCount;
+		if(SUCCEEDED(CFW1GlyphProviderTest::readGlyphCache(pGlyphProvider, &cacheData[0], size)))
+			++acceptedTruncations;
+	}
+	++truncationCount;
+	if(SUCCEEDED(CFW1GlyphProviderTest::readGlyphCache(pGlyphProvider, &cacheData[0], cacheData.size() - 1)))
+		++acceptedTruncations;
+	printf("  %u bytes, %u truncations\n", static_cast<UINT>(cacheData.size()), truncationCount);
+	check(acceptedTruncations == 0, "truncated caches are rejected");
+	
+	// Header
+	check(FAILED(readDamagedGlyphCache(pGlyphProvider, cacheData, offsetof(GlyphCacheHeader, magic), 0x12345678u)), "bad magic");
+	check(FAILED(readDamagedGlyphCache(pGlyphProvider, cacheData, offsetof(GlyphCacheHeader, version), header.version + 1)), "bad version");
+	check(FAILED(readDamagedGlyphCache(pGlyphProvider, cacheData, offsetof(GlyphCacheHeader, sheetCount), 0xffffffffu)), "huge sheet count");
+	check(
+		FAILED(readDamagedGlyphCache(pGlyphProvider, cacheData, offsetof(GlyphCacheHeader, glyphMapCount), header.glyphMapCount + 1)),
+		"glyph-map count past the end"
+	);
+	
+	// Sheet
+	size_t sheetField = sheetOffset + offsetof(GlyphCacheSheet, glyphCount);
+	check(FAILED(readDamagedGlyphCache(pGlyphProvider, cacheData, sheetField, 0x10000u)), "sheet glyph count over 0xffff");
+	sheetField = sheetOffset + offsetof(GlyphCacheSheet, rowCount);
+	check(FAILED(readDamagedGlyphCache(pGlyphProvider, cacheData, sheetField, header.sheetHeight + 1)), "row count over the sheet height");
+	
+	// Glyph coords, a glyph must start in the saved rows with its edges in order
+	FLOAT savedRowsEnd = static_cast<FLOAT>(firstSheet.rowCount) / static_cast<FLOAT>(header.sheetHeight);
+	
+	FW1_GLYPHCOORDS badCoords = firstCoords;
+	badCoords.TexCoordTop = savedRowsEnd;
+	badCoords.TexCoordBottom = savedRowsEnd + 0.01f;
+	check(FAILED(readDamagedGlyphCache(pGlyphProvider, cacheData, coordsOffset, badCoords)), "glyph below the saved rows");
+	
+	badCoords = firstCoords;
+	badCoords.TexCoordLeft = -0.25f;
+	check(FAILED(readDamagedGlyphCache(pGlyphProvider, cacheData, coordsOffset, badCoords)), "glyph left of the sheet");
+	
+	badCoords = firstCoords;
+	badCoords.TexCoordLeft = 1.0f;
+	badCoords.TexCoordRight = 1.25f;
+	check(FAILED(readDamagedGlyphCache(pGlyphProvider, cacheData, coordsOffset, badCoords)), "glyph right of the sheet");
+	
+	badCoords = firstCoords;
+	std::swap(badCoords.TexCoordLeft, badCoords.TexCoordRight);
+	std::swap(badCoords.TexCoordTop, badCoords.TexCoordBottom);
+	check(
+		firstCoords.TexCoordLeft < firstCoords.TexCoordRight
+		&& FAILED(readDamagedGlyphCache(pGlyphProvider, cacheData, coordsOffset, badCoords)),
+		"inverted glyph coords"
+	);
+	
+	badCoords = firstCoords;
+	badCoords.TexCoordTop = std::numeric_limits<FLOAT>::quiet_NaN();
+	check(FAILED(readDamagedGlyphCache(pGlyphProvider, cacheData, coordsOffset, badCoords)), "NaN glyph coords");
+	
+	// Glyph-map
+	size_t glyphMapField = glyphMapOffset + offsetof(GlyphCacheGlyphMap, fontIndex);
+	check(FAILED(readDamagedGlyphCache(pGlyphProvider, cacheData, glyphMapField, header.fontCount)), "font index out of range");
+	glyphMapField = glyphMapOffset + offsetof(GlyphCacheGlyphMap, fontSize);
+	check(FAILED(readDamagedGlyphCache(pGlyphProvider, cacheData, glyphMapField, 0.0f)), "zero font size");
+	glyphMapField = glyphMapOffset + offsetof(GlyphCacheGlyphMap, glyphCount);
+	check(FAILED(readDamagedGlyphCache(pGlyphProvider, cacheData, glyphMapField, 0x10001u)), "glyph count over 0x10000");
+	
+	// Fewer glyphs than entries, the entries stay where they are
+	glyphMapField = glyphMapOffset + offsetof(GlyphCacheGlyphMap, glyphCount);
+	check(
+		firstGlyphMap.entryCount > 0
+		&& FAILED(readDamagedGlyphCache(pGlyphProvider, cacheData, glyphMapField, firstGlyphMap.entryCount - 1)),
+		"more entries than glyphs"
+	);
+	
+	glyphMapField = glyphMapOffset + offsetof(GlyphCacheGlyphMap, sourceGlyphMap);
+	check(FAILED(readDamagedGlyphCache(pGlyphProvider, cacheData, glyphMapField, header.glyphMapCount)), "source glyph-map out of range");
+	
+	// Nothing is left behind, so the undamaged cache can still be read
+	check(CFW1GlyphProviderTest::getGlyphMapCount(pGlyphProvider) == 0, "rejected caches add no glyph-maps");
+	check(pGlyphAtlas->GetSheetCount() == sheetCount, "rejected caches add no sheets");
+	check(
+		SUCCEEDED(CFW1GlyphProviderTest::readGlyphCache(pGlyphProvider, &cacheData[0], cacheData.size())),
+		"the undamaged cache is read after the rejections"
+	);
+	check(CFW1GlyphProviderTest::getGlyphMapCount(pGlyphProvider) == header.glyphMapCount, "the undamaged cache adds its glyph-maps");
+	
+	pGlyphAtlas->Release();
+	pGlyphProvider->Release();
+}
+
+
+// Point of a test outline
+CFW1OutlineRenderTargetTest::OutlinePoint makeOutlinePoint(FLOAT x, FLOAT y) {
+	CFW1OutlineRenderTargetTest::OutlinePoint point;
+	point.x = x;
+	point.y = y;
+	return point;
+}
+
+
+// Add a rectangle to a test outline, clockwise or counter-clockwise
+void addOutlineRectangle(
+	std::vector<CFW1OutlineRenderTargetTest::LineSegment> &lines,
+	FLOAT left,
+	FLOAT top,
+	FLOAT right,
+	FLOAT bottom,
+	bool clockwise
+) {
+	CFW1OutlineRenderTargetTest::OutlinePoint corners[4] = {
+		makeOutlinePoint(left, top),
+		makeOutlinePoint(right, top),
+		makeOutlinePoint(right, bottom),
+		makeOutlinePoint(left, bottom)
+	};
+	if(!clockwise)
+		std::swap(corners[1], corners[3]);
+	
+	for(UINT i=0; i < 4; ++i)
+		CFW1OutlineRenderTargetTest::addOutlineLine(lines, corners[i], corners[(i + 1) % 4]);
+}
+
+
+// Fill a test outline, and check that the accumulation is left zeroed for the next one
+void fillTestOutline(
+	const std::vector<CFW1OutlineRenderTargetTest::LineSegment> &lines,
+	FLOAT offsetX,
+	FLOAT offsetY,
+	UINT width,
+	UINT height,
+	bool aliased,
+	std::vector<UINT8> &coverage
+) {
+	std::vector<FLOAT> accumulation(width * height + 2, 0.0f);
+	coverage.assign(width * height, 0);
+	
+	CFW1OutlineRenderTargetTest::fillOutline(lines, offsetX, offsetY, width, height, aliased, &accumulation[0], &coverage[0]);
+	
+	check(std::count(accumulation.begin(), accumulation.end(), 0.0f) == static_cast<ptrdiff_t>(accumulation.size()), "the accumulation is cleared");
+}
+
+
+// Area of a pixel inside a rectangle
+FLOAT getRectangleCoverage(UINT x, UINT y, FLOAT left, FLOAT top, FLOAT right, FLOAT bottom) {
+	FLOAT width = std::min(static_cast<FLOAT>(x + 1), right) - std::max(static_cast<FLOAT>(x), left);
+	FLOAT height = std::min(static_cast<FLOAT>(y + 1), bottom) - std::max(static_cast<FLOAT>(y), top);
+	
+	return std::max(width, 0.0f) * std::max(height, 0.0f);
+}
+
+
+// Each pixel of a filled rectangle must hold the area of the rectangle inside it, whichever way the outline runs
+void testOutlineRectangle() {
+	const UINT size = 16;
+	const FLOAT left = 2.25f;
+	const FLOAT top = 3.75f;
+	const FLOAT right = 12.625f;
+	const FLOAT bottom = 11.375f;
+	
+	std::vector<UINT8> clockwiseCoverage;
+	std::vector<CFW1OutlineRenderTargetTest::LineSegment> lines;
+	addOutlineRectangle(lines, left, top, right, bottom, true);
+	fillTestOutline(lines, 0.0f, 0.0f, size, size, false, clockwiseCoverage);
+	
+	UINT maxError = 0;
+	UINT64 coverageSum = 0;
+	for(UINT y=0; y < size; ++y) {
+		for(UINT x=0; x < size; ++x) {
+			UINT expected = static_cast<UINT>(getRectangleCoverage(x, y, left, top, right, bottom) * 255.0f + 0.5f);
+			UINT coverage = clockwiseCoverage[y * size + x];
+			
+			maxError = std::max(maxError, static_cast<UINT>(abs(static_cast<int>(coverage) - static_cast<int>(expected))));
+			coverageSum += coverage;
+		}
+	}
+	printf("  area %.3f filled as %.3f, max pixel error %u\n", (right - left) * (bottom - top), coverageSum / 255.0, maxError);
+	check(maxError <= 1, "each pixel holds the area inside it");
+	
+	std::vector<UINT8> coverage;
+	lines.clear();
+	addOutlineRectangle(lines, left, top, right, bottom, false);
+	fillTestOutline(lines, 0.0f, 0.0f, size, size, false, coverage);
+	check(coverage == clockwiseCoverage, "a counter-clockwise outline fills the same");
+	
+	// A contour running the other way inside the first cuts a hole
+	lines.clear();
+	addOutlineRectangle(lines, left, top, right, bottom, true);
+	addOutlineRectangle(lines, 5.0f, 6.5f, 9.75f, 9.0f, false);
+	fillTestOutline(lines, 0.0f, 0.0f, size, size, false, coverage);
+	
+	UINT holeError = 0;
+	for(UINT y=0; y < size; ++y) {
+		for(UINT x=0; x < size; ++x) {
+			FLOAT area = getRectangleCoverage(x, y, left, top, right, bottom) - getRectangleCoverage(x, y, 5.0f, 6.5f, 9.75f, 9.0f);
+			UINT expected = static_cast<UINT>(area * 255.0f + 0.5f);
+			
+			holeError = std::max(holeError, static_cast<UINT>(abs(static_cast<int>(coverage[y * size + x]) - static_cast<int>(expected))));
+		}
+	}
+	check(holeError <= 1, "an inner contour running the other way cuts a hole");
+	
+	// Aliased pixels are in if at least half covered
+	lines.clear();
+	addOutlineRectangle(lines, left, top, right, bottom, true);
+	fillTestOutline(lines, 0.0f, 0.0f, size, size, true, coverage);
+	
+	UINT aliasedMismatches = 0;
+	for(UINT y=0; y < size; ++y) {
+		for(UINT x=0; x < size; ++x) {
+			UINT8 expected = (getRectangleCoverage(x, y, left, top, right, bottom) >= 0.5f) ? 255 : 0;
+			if(coverage[y * size + x] != expected)
+				++aliasedMismatches;
+		}
+	}
+	check(aliasedMismatches == 0, "aliased pixels are the ones at least half covered");
+	
+	// Parts above and below the image are cut off, and parts left and right of it moved to the edge
+	lines.clear();
+	addOutlineRectangle(lines, -3.5f, -2.0f, 20.25f, 19.0f, true);
+	fillTestOutline(lines, 0.0f, 0.0f, size, size, false, coverage);
+	check(std::count(coverage.begin(), coverage.end(), 255) == static_cast<ptrdiff_t>(coverage.size()), "a rectangle over the whole image covers all of it");
+}
+
+
+// A circle of four beziers must be flattened to within a quarter pixel, and filled to the area of the flattened outline
+void testOutlineCircle() {
+	const UINT size = 40;
+	const FLOAT centerX = 20.3f;
+	const FLOAT centerY = 19.6f;
+	const FLOAT radius = 15.0f;
+	const FLOAT pi = 3.14159265f;
+	
+	// Control points a quarter circle apart, the beziers stray at most 0.03% of the radius from the circle
+	const FLOAT k = 0.5522847f * radius;
+	const FLOAT cx[4][4] = {
+		{radius, radius, k, 0.0f},
+		{0.0f, -k, -radius, -radius},
+		{-radius, -radius, -k, 0.0f},
+		{0.0f, k, radius, radius}
+	};
+	const FLOAT cy[4][4] = {
+		{0.0f, k, radius, radius},
+		{radius, radius, k, 0.0f},
+		{0.0f, -k, -radius, -radius},
+		{-radius, -radius, -k, 0.0f}
+	};
+	
+	// The circle is centered on the origin, and moved into the image when filled
+	std::vector<CFW1OutlineRenderTargetTest::LineSegment> lines;
+	for(UINT i=0; i < 4; ++i) {
+		CFW1OutlineRenderTargetTest::addOutlineBezier(
+			lines,
+			makeOutlinePoint(cx[i][0], cy[i][0]),
+			makeOutlinePoint(cx[i][1], cy[i][1]),
+			makeOutlinePoint(cx[i][2], cy[i][2]),
+			makeOutlinePoint(cx[i][3], cy[i][3])
+		);
+	}
+	
+	// Line ends lie on the circle, and line middles within a quarter pixel inside it
+	// The area is summed in trapezoids, as horizontal lines are left out of the outline
+	FLOAT maxEndError = 0.0f;
+	FLOAT maxMiddleError = 0.0f;
+	double outlineArea = 0.0;
+	for(size_t i=0; i < lines.size(); ++i) {
+		const CFW1OutlineRenderTargetTest::LineSegment &line = lines[i];
+		
+		maxEndError = std::max(maxEndError, fabs(sqrt(line.x1 * line.x1 + line.y1 * line.y1) - radius));
+		FLOAT middleX = 0.5f * (line.x0 + line.x1);
+		FLOAT middleY = 0.5f * (line.y0 + line.y1);
+		maxMiddleError = std::max(maxMiddleError, radius - sqrt(middleX * middleX + middleY * middleY));
+		
+		outlineArea += 0.5 * (line.x0 + line.x1) * (line.y1 - line.y0);
+	}
+	outlineArea = fabs(outlineArea);
+	
+	check(maxEndError < 0.01f, "line ends lie on the circle");
+	check(maxMiddleError <= 0.25f, "lines stay within a quarter pixel of the circle");
+	
+	std::vector<UINT8> coverage;
+	fillTestOutline(lines, centerX, centerY, size, size, false, coverage);
+	
+	// Pixels clear of the edge are fully in or out
+	UINT64 coverageSum = 0;
+	UINT edgeMismatches = 0;
+	for(UINT y=0; y < size; ++y) {
+		for(UINT x=0; x < size; ++x) {
+			FLOAT dx = static_cast<FLOAT>(x) + 0.5f - centerX;
+			FLOAT dy = static_cast<FLOAT>(y) + 0.5f - centerY;
+			FLOAT distance = sqrt(dx * dx + dy * dy);
+			UINT8 pixel = coverage[y * size + x];
+			
+			if(distance < radius - 1.0f && pixel < 254)
+				++edgeMismatches;
+			if(distance > radius + 1.0f && pixel != 0)
+				++edgeMismatches;
+			
+			coverageSum += pixel;
+		}
+	}
+	
+	double circleArea = pi * radius * radius;
+	double filledArea = coverageSum / 255.0;
+	printf(
+		"  %u lines, circle area %.2f, outline area %.2f, filled %.2f\n",
+		static_cast<UINT>(lines.size()),
+		circleArea,
+		outlineArea,
+		filledArea
+	);
+	
+	check(edgeMismatches == 0, "pixels away from the edge are fully in or out");
+	check(fabs(filledArea - outlineArea) < 0.25, "the filled area is the outline area");
+	check(fabs(outlineArea - circleArea) < 0.02 * circleArea, "the outline area is near the circle area");
+}
+
+
+// Time the outline render target against the DirectWrite DIB render target on a line of text at several sizes
+void benchmarkOutlineRasterizer() {
+	const WCHAR text[] = L"The quick brown fox jumps over the lazy dog";
+	const UINT32 textLength = sizeof(text) / sizeof(text[0]) - 1;
+	const FLOAT fontSizes[] = {12.0f, 16.0f, 24.0f, 48.0f};
+	const UINT fontSizeCount = sizeof(fontSizes) / sizeof(fontSizes[0]);
+	
+	std::vector<UINT32> codePoints(text, text + textLength);
+	std::vector<UINT16> glyphIndices(textLength);
+	if(!check(SUCCEEDED(g_pFontFace->GetGlyphIndices(&codePoints[0], textLength, &glyphIndices[0])), "GetGlyphIndices"))
+		return;
+	
+	IFW1DWriteRenderTarget *pRenderTargets[2] = {NULL, NULL};
+	HRESULT hResult = g_pFW1Factory->CreateDWriteRenderTarget(g_pDWriteFactory, 384, 384, &pRenderTargets[0]);
+	if(SUCCEEDED(hResult))
+		hResult = g_pFW1Factory->CreateOutlineRenderTarget(384, 384, &pRenderTargets[1]);
+	if(!check(SUCCEEDED(hResult), "create the render targets")) {
+		SAFE_RELEASE(pRenderTargets[0]);
+		return;
+	}
+	
+	// Best of five runs, and the ink of the last, as the sum of coverage over all glyphs
+	double times[2];
+	double ink[2];
+	UINT failedCount = 0;
+	UINT emptyCount = 0;
+	for(UINT i=0; i < 2; ++i) {
+		times[i] = 1e9;
+		
+		for(UINT run=0; run < 5; ++run) {
+			ink[i] = 0.0;
+			
+			Timer timer;
+			for(UINT j=0; j < fontSizeCount; ++j) {
+				for(UINT32 k=0; k < textLength; ++k) {
+					FW1_GLYPHIMAGEDATA glyphData;
+					hResult = pRenderTargets[i]->DrawGlyphTemp(
+						g_pFontFace,
+						glyphIndices[k],
+						fontSizes[j],
+						DWRITE_RENDERING_MODE_DEFAULT,
+						DWRITE_MEASURING_MODE_NATURAL,
+						&glyphData
+					);
+					if(FAILED(hResult)) {
+						++failedCount;
+						continue;
+					}
+					
+					// Every glyph but the space has ink
+					if(text[k] != L' ' && (glyphData.Metrics.Width == 0 || glyphData.Metrics.Height == 0))
+						++emptyCount;
+					
+					const UINT8 *pPixels = static_cast<const UINT8*>(glyphData.pGlyphPixels);
+					for(UINT y=0; y < glyphData.Metrics.Height; ++y) {
+						for(UINT x=0; x < glyphData.Metrics.Width; ++x)
+							ink[i] += pPixels[y * glyphData.RowPitch + x * glyphData.PixelStride];
+					}
+				}
+			}
+			times[i] = std::min(times[i], timer.milliseconds());
+		}
+	}
+	
+	UINT glyphCount = fontSizeCount * textLength;
+	printf(
+		"  %u glyphs: DIB %.2f ms, outline %.2f ms (%.1fx), outline ink %.0f%% of DIB\n",
+		glyphCount,
+		times[0],
+		times[1],
+		times[0] / std::max(times[1], 0.001),
+		(ink[0] > 0.0) ? 100.0 * ink[1] / ink[0] : 0.0
+	);
+	
+	check(failedCount == 0, "DrawGlyphTemp succeeds");
+	check(emptyCount == 0, "glyphs other than the space have images");
+	
+	pRenderTargets[1]->Release();
+	pRenderTargets[0]->Release();
+}
+
+
+// Create a font-face from the system font collection
+HRESULT createFontFace(const WCHAR *pszFamilyName, IDWriteFontFace **ppFontFace) {
+	UINT32 familyIndex;
+	BOOL exists;
+	
+	HRESULT hResult = g_pFontCollection->FindFamilyName(pszFamilyName, &familyIndex, &exists);
+	if(FAILED(hResult)) {
+	}
+	else if(!exists) {
+		hResult = E_FAIL;
+	}
+	else {
+		IDWriteFontFamily *pFontFamily;
+		
+		hResult = g_pFontCollection->GetFontFamily(familyIndex, &pFontFamily);
+		if(FAILED(hResult)) {
+		}
+		else {
+			IDWriteFont *pFont;
+			
+			hResult = pFontFamily->GetFirstMatchingFont(
+				DWRITE_FONT_WEIGHT_NORMAL,
+				DWRITE_FONT_STRETCH_NORMAL,
+				DWRITE_FONT_STYLE_NORMAL,
+				&pFont
+			);
+			if(FAILED(hResult)) {
+			}
+			else {
+				hResult = pFont->CreateFontFace(ppFontFace);
+				
+				pFont->Release();
+			}
+			
+			pFontFamily->Release();
+		}
+	}
+	
+	return hResult;
+}
+
+
+// Create the device and factory for the tests, on WARP so results do not depend on the GPU
+HRESULT createTestDevice() {
+	HRESULT hResult = D3D11CreateDevice(
+		NULL,
+		D3D_DRIVER_TYPE_WARP,
+		NULL,
+		0,
+		NULL,
+		0,
+		D3D11_SDK_VERSION,
+		&g_pDevice,
+		NULL,
+		&g_pContext
+	);
+	if(FAILED(hResult))
+		return hResult;
+	
+	hResult = FW1CreateFactory(FW1_VERSION, &g_pFW1Factory);
+	if(FAILED(hResult))
+		return hResult;
+	
+	hResult = DWriteCreateFactory(
+		DWRITE_FACTORY_TYPE_SHARED,
+		__uuidof(IDWriteFactory),
+		reinterpret_cast<IUnknown**>(&g_pDWriteFactory)
+	);
+	if(FAILED(hResult))
+		return hResult;
+	
+	hResult = g_pDWriteFactory->GetSystemFontCollection(&g_pFontCollection, FALSE);
+	if(FAILED(hResult))
+		return hResult;
+	
+	return createFontFace(L"Arial", &g_pFontFace);
+}
+
+
+}// namespace
+
+
+// Entry point
+int main() {
+	HRESULT hResult = createTestDevice();
+	if(FAILED(hResult)) {
+		printf("Failed to create the WARP device, FW1 factory and test font\n");
+		return 1;
+	}
+	
+	runTest(testHeightRangePacking, "HeightRange packing");
+	runTest(testPixelKernels, "Pixel kernels");
+	runTest(benchmarkPixelKernels, "Pixel kernel speed");
+	runTest(testFlushBytesSingleGlyph, "Flush bytes of a single glyph");
+	runTest(testFlushBytesTrace, "Flush bytes of an insertion trace");
+	runTest(testBlockCompression, "BC4 block compression");
+	runTest(benchmarkBlockCompression, "BC4 encoder speed");
+	runTest(testCompressedSheetRoundTrip, "Compressed sheet round trip");
+	runTest(testGlyphMapCacheThreads, "Glyph-map cache on eight threads");
+	runTest(testLazyGlyphPages, "Lazy glyph pages");
+	runTest(benchmarkZoomSweep, "Zoom sweep with and without a font size step");
+	runTest(testDistanceTransform, "Distance transform");
+	runTest(testDistanceField, "Distance field of a square");
+	runTest(testGlyphBudget, "Glyph budget placeholders and deferral order");
+	runTest(testGlyphCacheRoundTrip, "Glyph cache round trip");
+	runTest(testGlyphCacheRejection, "Rejection of damaged glyph caches");
+	runTest(testOutlineRectangle, "Outline fill of a rectangle");
+	runTest(testOutlineCircle, "Outline fill of a circle");
+	runTest(benchmarkOutlineRasterizer, "Outline and DIB render target speed");
+	
+	SAFE_RELEASE(g_pFontFace);
+	SAFE_RELEASE(g_pFontCollection);
+	SAFE_RELEASE(g_pDWriteFactory);
+	SAFE_RELEASE(g_pFW1Factory);
+	SAFE_RELEASE(g_pContext);
+	SAFE_RELEASE(g_pDevice);
+	
+	if(g_failedTests > 0) {
+		printf("%u tests failed\n", g_failedTests);
+		return 1;
+	}
+	
+	printf("All tests passed\n");
+	return 0;
+}
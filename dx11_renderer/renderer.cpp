@@ -20,7 +20,6 @@ void renderer::initialize(HWND hwnd, const color& render_target_color, const std
 	//setup_rasterizer_state();
 	setup_font_renderer(font);
 	setup_screen_projection();
-	setup_font_renderer(font);
 	this->render_target_color = render_target_color;
 
 	initialized = true;
@@ -49,17 +48,40 @@ void renderer::draw()
 		size_t buffer_index = 0;
 		for (auto& batch : default_draw_list.batch_list)
 		{
-			p_device_context->IASetPrimitiveTopology(batch.type);
+			p_state_tracker->SetPrimitiveTopology(batch.type);
 			p_device_context->Draw(static_cast<UINT>(batch.vertex_count), static_cast<UINT>(buffer_index));
 			buffer_index += batch.vertex_count;
 		}
 	}
 	
+	resolve_text_commands();
+
 	p_font_wrapper->Flush(p_device_context);
-	p_font_wrapper->DrawGeometry(p_device_context, default_draw_list.p_text_geometry, nullptr, nullptr, FW1_RESTORESTATE);
+	p_font_wrapper->DrawGeometry(p_device_context, default_draw_list.p_text_geometry, nullptr, nullptr, 0);
+
+	// the text states are already set, static text only needs its transform updated
+	for (const auto& [p_geometry, offset] : default_draw_list.static_texts)
+	{
+		DirectX::XMFLOAT4X4 transform;
+		DirectX::XMStoreFloat4x4(&transform, DirectX::XMMatrixTranslation(offset.x, offset.y, 0.f) * screen_projection);
+		p_font_wrapper->DrawStaticGeometry(p_device_context, p_geometry, nullptr, &transform._11, FW1_STATEPREPARED);
+	}
+
+	// the font wrapper sets its states through the same tracker, so only the states it changed are rebound here
+	bind_pipeline_state();
+	p_state_tracker->GetCallCounts(nullptr, &state_calls_saved);
+	p_state_tracker->ResetCallCounts();
 
 	default_draw_list.clear();
 
+	// nothing references the glyph atlas between frames, so this is where cold sheets can be evicted
+	// a trim that found nothing old enough to evict walks every glyph map for nothing, so wait a while before the next one
+	p_glyph_provider->NewFrame();
+	// prewarm tasks insert glyphs from worker threads, so eviction waits until none are running
+	// evicted glyphs of a static atlas could never be drawn again, so it is never trimmed
+	if (glyph_memory_budget && !static_glyph_atlas && p_glyph_provider->GetPendingPrewarmCount() == 0 && frames_until_trim-- == 0)
+		frames_until_trim = p_glyph_provider->TrimGlyphAtlas(glyph_memory_budget, glyph_min_frame_age) ? 0 : TRIM_RETRY_FRAMES;
+
 	p_swapchain->Present(1, 0);
 }
 
@@ -68,8 +90,94 @@ void renderer::set_render_target_color(const color& new_color)
 	render_target_color = new_color;
 }
 
+uint32_t renderer::get_state_calls_saved() const
+{
+	return state_calls_saved;
+}
+
+void renderer::set_deferred_text(bool enabled)
+{
+	deferred_text = enabled;
+}
+
+void renderer::set_glyph_memory_budget(uint64_t budget_bytes, uint32_t min_frame_age)
+{
+	glyph_memory_budget = budget_bytes;
+	glyph_min_frame_age = min_frame_age;
+	frames_until_trim = 0;
+}
+
+void renderer::set_font_size_step(float step)
+{
+	font_size_step = step;
+	if (p_glyph_provider)
+		p_glyph_provider->SetFontSizeStep(step);
+}
+
+void renderer::set_glyph_budget(uint32_t max_glyphs, uint32_t max_microseconds)
+{
+	glyph_budget_count = max_glyphs;
+	glyph_budget_microseconds = max_microseconds;
+	if (p_glyph_provider)
+		p_glyph_provider->SetGlyphBudget(max_glyphs, max_microseconds);
+}
+
+void renderer::set_glyph_cache_file(const std::wstring& path)
+{
+	glyph_cache_file = path;
+	static_glyph_atlas = false;
+}
+
+void renderer::set_static_glyph_atlas(const std::wstring& path)
+{
+	glyph_cache_file = path;
+	static_glyph_atlas = true;
+}
+
+void renderer::set_outline_rasterizer(bool enabled)
+{
+	outline_rasterizer = enabled;
+}
+
+void renderer::set_glyph_sheet_compression(bool enabled)
+{
+	glyph_sheet_compression = enabled;
+	if (p_glyph_atlas)
+		p_glyph_atlas->SetSheetCompression(enabled ? TRUE : FALSE);
+}
+
+void renderer::prewarm_glyphs(std::wstring_view characters, float font_size)
+{
+	IDWriteFontCollection* p_collection = nullptr;
+	IDWriteFontFamily* p_family = nullptr;
+	IDWriteFont* p_dwrite_font = nullptr;
+	IDWriteFontFace* p_font_face = nullptr;
+	UINT32 family_index = 0;
+	BOOL family_exists = FALSE;
+
+	if (FAILED(p_glyph_provider->GetDWriteFontCollection(&p_collection)))
+		handle_error("prewarm_glyphs - failed to get font collection");
+	else if (FAILED(p_collection->FindFamilyName(font.c_str(), &family_index, &family_exists)) || !family_exists)
+		handle_error("prewarm_glyphs - font family not found");
+	else if (FAILED(p_collection->GetFontFamily(family_index, &p_family)) ||
+		FAILED(p_family->GetFirstMatchingFont(DWRITE_FONT_WEIGHT_NORMAL, DWRITE_FONT_STRETCH_NORMAL, DWRITE_FONT_STYLE_NORMAL, &p_dwrite_font)) ||
+		FAILED(p_dwrite_font->CreateFontFace(&p_font_face)))
+		handle_error("prewarm_glyphs - failed to create font face");
+	else if (FAILED(p_glyph_provider->PrewarmGlyphs(p_font_face, font_size, 0, characters.data(), static_cast<UINT32>(characters.size()))))
+		handle_error("prewarm_glyphs - failed to queue glyphs");
+
+	// the queued task holds its own reference to the font face
+	safe_release(p_font_face);
+	safe_release(p_dwrite_font);
+	safe_release(p_family);
+	safe_release(p_collection);
+}
+
 void renderer::cleanup()
 {
+	if (!glyph_cache_file.empty() && !static_glyph_atlas && FAILED(p_glyph_provider->SaveGlyphCache(p_device_context, glyph_cache_file.c_str())))
+		handle_error("cleanup - failed to save glyph cache");
+
 	p_device_context->ClearRenderTargetView(p_backbuffer, &render_target_color.r);
 	p_swapchain->Present(1, 0);
 	initialized = false;
@@ -369,7 +477,7 @@ void renderer::add_circle_filled(const vec2& middle, float radius, const color&
 // [public] intermediate shapes and model functions
 //
 
-void renderer::add_text(const vec2& top_left, const vec2& size, const std::wstring& text, const color& color, float font_size, text_align text_flags)
+void renderer::add_text(const vec2& top_left, const vec2& size, std::wstring_view text, const color& color, float font_size, text_align text_flags)
 {
 	if (text.empty())
 		return;
@@ -377,10 +485,14 @@ void renderer::add_text(const vec2& top_left, const vec2& size, const std::wstri
 	auto final_flags = static_cast<uint32_t>(text_flags) | FW1_NOFLUSH | FW1_NOWORDWRAP;
 
 	FW1_RECTF rect{ top_left.x, top_left.y, top_left.x + size.x, top_left.y + size.y };
-	p_font_wrapper->AnalyzeString(nullptr, text.c_str(), font.c_str(), font_size, &rect, color.to_hex_abgr(), final_flags, default_draw_list.p_text_geometry);
+
+	if (deferred_text)
+		return record_text_command(text, nullptr, rect, color.to_hex_abgr(), final_flags, font_size);
+
+	p_font_wrapper->AnalyzeStringN(nullptr, text.data(), static_cast<UINT32>(text.size()), font.c_str(), font_size, &rect, color.to_hex_abgr(), final_flags, default_draw_list.p_text_geometry);
 }
 
-void renderer::add_text_with_bg(const vec2& top_left, const vec2& size, const std::wstring& text, const color& text_color, const color& bg_color, float font_size, text_align text_flags)
+void renderer::add_text_with_bg(const vec2& top_left, const vec2& size, std::wstring_view text, const color& text_color, const color& bg_color, float font_size, text_align text_flags)
 {
 	if (text.empty())
 		return;
@@ -392,14 +504,14 @@ void renderer::add_text_with_bg(const vec2& top_left, const vec2& size, const st
 
 	// rect for drawing background behind text
 	FW1_RECTF text_box_rect{ top_left.x, top_left.y, top_left.x, top_left.y };
-	FW1_RECTF text_box = p_font_wrapper->MeasureString(text.c_str(), font.c_str(), font_size, &text_box_rect, final_flags);
+	FW1_RECTF text_box = p_font_wrapper->MeasureStringN(text.data(), static_cast<UINT32>(text.size()), font.c_str(), font_size, &text_box_rect, final_flags);
 
 	add_rect_filled({text_box.Left - 1.f, text_box.Top}, { text_box.Right - text_box.Left + 1.f, text_box.Bottom - text_box.Top }, bg_color);
 
-	p_font_wrapper->AnalyzeString(nullptr, text.c_str(), font.c_str(), font_size, &rect, text_color.to_hex_abgr(), final_flags, default_draw_list.p_text_geometry);
+	add_text(top_left, size, text, text_color, font_size, text_flags);
 }
 
-void renderer::add_outlined_text(const vec2& top_left, const vec2& size, const std::wstring& text, const color& text_color, const color& outline_color, float font_size, float outline_size, text_align flags)
+void renderer::add_outlined_text(const vec2& top_left, const vec2& size, std::wstring_view text, const color& text_color, const color& outline_color, float font_size, float outline_size, text_align flags)
 {
 	// add shadows
 	// -1,-1
@@ -423,7 +535,7 @@ void renderer::add_outlined_text(const vec2& top_left, const vec2& size, const s
 	add_text(top_left, size, text, text_color, font_size, flags);
 }
 
-void renderer::add_outlined_text_with_bg(const vec2& top_left, const vec2& size, const std::wstring& text, const color& text_color, const color& outline_color, const color& bg_color, float font_size, float outline_size, text_align text_flags)
+void renderer::add_outlined_text_with_bg(const vec2& top_left, const vec2& size, std::wstring_view text, const color& text_color, const color& outline_color, const color& bg_color, float font_size, float outline_size, text_align text_flags)
 {
 	if (text.empty())
 		return;
@@ -435,7 +547,7 @@ void renderer::add_outlined_text_with_bg(const vec2& top_left, const vec2& size,
 
 	// rect for drawing background behind text
 	FW1_RECTF text_box_rect{ top_left.x, top_left.y, top_left.x, top_left.y };
-	FW1_RECTF text_box = p_font_wrapper->MeasureString(text.c_str(), font.c_str(), font_size, &text_box_rect, final_flags);
+	FW1_RECTF text_box = p_font_wrapper->MeasureStringN(text.data(), static_cast<UINT32>(text.size()), font.c_str(), font_size, &text_box_rect, final_flags);
 
 	add_rect_filled({ text_box.Left - outline_size, text_box.Top }, { text_box.Right - text_box.Left + outline_size + 1.f, text_box.Bottom - text_box.Top }, bg_color);
 
@@ -550,18 +662,340 @@ void renderer::add_outlined_frame(const vec2& top_left, const vec2& size, float
 	add_frame(top_left, size, thickness, frame_color);
 }
 
-vec2 renderer::measure_text(const std::wstring& text, float text_size)
+void renderer::add_wrapped_text(const vec2& top_left, const vec2& size, std::wstring_view text, const color& color, float font_size, text_align text_flags)
+{
+	if (text.empty())
+		return;
+
+	auto final_flags = static_cast<uint32_t>(text_flags) | FW1_NOFLUSH;
+
+	FW1_RECTF rect{ top_left.x, top_left.y, top_left.x + size.x, top_left.y + size.y };
+
+	if (deferred_text)
+		return record_text_command(text, nullptr, rect, color.to_hex_abgr(), final_flags, font_size);
+
+	p_font_wrapper->AnalyzeStringN(nullptr, text.data(), static_cast<UINT32>(text.size()), font.c_str(), font_size, &rect, color.to_hex_abgr(), final_flags, default_draw_list.p_text_geometry);
+}
+
+void renderer::add_text_block(text_block& block, const vec2& top_left)
+{
+	layout_text_block(block);
+
+	const auto text_color = block.text_color.to_hex_abgr();
+	const auto origin_x = std::round(top_left.x);
+
+	// paragraphs start on whole pixels so moving their cached vertices does not change how glyphs are rounded
+	auto paragraph_top = std::round(top_left.y);
+	for (const auto& paragraph : block.paragraphs)
+	{
+		if (paragraph_top >= screen_size.y)
+			break;
+
+		if (paragraph_top + paragraph.height > 0.f)
+		{
+			for (const auto& line : paragraph.lines)
+			{
+				if (paragraph_top + line.top >= screen_size.y)
+					break;
+
+				if (paragraph_top + line.top + line.height <= 0.f)
+					continue;
+
+				glyph_vertex_scratch.assign(line.vertices.begin(), line.vertices.end());
+				for (auto& glyph_vertex : glyph_vertex_scratch)
+				{
+					glyph_vertex.PositionX += origin_x;
+					glyph_vertex.PositionY += paragraph_top;
+					glyph_vertex.GlyphColor = text_color;
+				}
+				if (!glyph_vertex_scratch.empty())
+					default_draw_list.p_text_geometry->AddGlyphVertices(glyph_vertex_scratch.data(), static_cast<UINT>(glyph_vertex_scratch.size()));
+			}
+		}
+
+		paragraph_top = std::round(paragraph_top + paragraph.height);
+	}
+}
+
+vec2 renderer::measure_text_block(text_block& block)
+{
+	layout_text_block(block);
+
+	float height = 0.f;
+	for (const auto& paragraph : block.paragraphs)
+		height = std::round(height + paragraph.height);
+
+	return { block.width, height };
+}
+
+void renderer::add_texts(std::span<const text_item> items)
+{
+	if (items.empty())
+		return;
+
+	if (deferred_text)
+	{
+		for (const auto& item : items)
+		{
+			if (item.text.empty())
+				continue;
+
+			FW1_RECTF rect{ item.top_left.x, item.top_left.y, item.top_left.x + item.size.x, item.top_left.y + item.size.y };
+			record_text_command(item.text, item.font_family, rect, item.text_color.to_hex_abgr(), static_cast<uint32_t>(item.flags) | FW1_NOFLUSH | FW1_NOWORDWRAP, item.font_size);
+		}
+
+		return;
+	}
+
+	const size_t max_workers = (std::max)(1u, std::thread::hardware_concurrency());
+	const size_t chunk_size = (std::max<size_t>)(MIN_TEXT_ITEMS_PER_WORKER, (items.size() + max_workers - 1) / max_workers);
+	const size_t worker_count = (items.size() + chunk_size - 1) / chunk_size;
+
+	// small batches are not worth handing off to other threads
+	if (worker_count <= 1)
+	{
+		for (const auto& item : items)
+			analyze_text_item(item, default_draw_list.p_text_geometry);
+
+		return;
+	}
+
+	while (worker_text_geometries.size() < worker_count)
+	{
+		IFW1TextGeometry* p_geometry = nullptr;
+		if (FAILED(p_font_factory->CreateTextGeometry(&p_geometry)))
+			handle_error("add_texts - failed to create worker text geometry");
+
+		worker_text_geometries.push_back(p_geometry);
+	}
+
+	// each worker gets a contiguous chunk so merging the geometries in worker order keeps submission order,
+	// std::async is backed by the system thread pool so this does not create threads every call
+	std::vector<std::future<void>> workers;
+	workers.reserve(worker_count);
+
+	for (size_t i = 0; i < worker_count; ++i)
+	{
+		const auto chunk = items.subspan(i * chunk_size, (std::min)(chunk_size, items.size() - i * chunk_size));
+		const auto p_geometry = worker_text_geometries[i];
+
+		workers.push_back(std::async(std::launch::async, [this, chunk, p_geometry]()
+		{
+			for (const auto& item : chunk)
+				analyze_text_item(item, p_geometry);
+		}));
+	}
+
+	for (size_t i = 0; i < worker_count; ++i)
+	{
+		workers[i].wait();
+		append_text_geometry(worker_text_geometries[i]);
+	}
+}
+
+static_text renderer::create_static_text(const vec2& top_left, const vec2& size, std::wstring_view text, const color& color, float font_size, text_align text_flags)
+{
+	static_text result;
+	if (text.empty())
+		return result;
+
+	IFW1TextGeometry* p_geometry = nullptr;
+	if (FAILED(p_font_factory->CreateTextGeometry(&p_geometry)))
+		handle_error("create_static_text - failed to create text geometry");
+
+	// new glyphs are flushed right away so the static text can be drawn without waiting for the next frame,
+	// it is drawn many times so its glyphs are rasterized at the exact size even when sizes are snapped,
+	// and never left as placeholders since the geometry is not laid out again
+	auto final_flags = static_cast<uint32_t>(text_flags) | FW1_NOWORDWRAP | FW1_EXACTFONTSIZE | FW1_NOGLYPHBUDGET;
+
+	FW1_RECTF rect{ top_left.x, top_left.y, top_left.x + size.x, top_left.y + size.y };
+	p_font_wrapper->AnalyzeStringN(p_device_context, text.data(), static_cast<UINT32>(text.size()), font.c_str(), font_size, &rect, color.to_hex_abgr(), final_flags, p_geometry);
+
+	if (FAILED(p_font_wrapper->CreateStaticGeometry(p_geometry, &result.p_geometry)))
+		handle_error("create_static_text - failed to create static geometry");
+
+	safe_release(p_geometry);
+	return result;
+}
+
+void renderer::add_static_text(const static_text& text, const vec2& offset)
+{
+	if (!text.p_geometry)
+		return;
+
+	text.p_geometry->AddRef();
+	default_draw_list.static_texts.emplace_back(text.p_geometry, offset);
+}
+
+vec2 renderer::measure_text(std::wstring_view text, float text_size)
 {
 	FW1_RECTF in{};
-	auto rect = p_font_wrapper->MeasureString(text.c_str(), font.c_str(), text_size, &in, FW1_LEFT | FW1_NOWORDWRAP);
+	auto rect = p_font_wrapper->MeasureStringN(text.data(), static_cast<UINT32>(text.size()), font.c_str(), text_size, &in, FW1_LEFT | FW1_NOWORDWRAP);
 	return { rect.Right - rect.Left, rect.Bottom - rect.Top };
 }
 
+void renderer::add_text(const vec2& top_left, const vec2& size, std::string_view text, const color& color, float font_size, text_align text_flags)
+{
+	add_text(top_left, size, to_utf16(text), color, font_size, text_flags);
+}
+
+void renderer::add_text(const vec2& top_left, const vec2& size, std::u8string_view text, const color& color, float font_size, text_align text_flags)
+{
+	add_text(top_left, size, to_utf16({ reinterpret_cast<const char*>(text.data()), text.size() }), color, font_size, text_flags);
+}
+
+void renderer::add_text_with_bg(const vec2& top_left, const vec2& size, std::string_view text, const color& text_color, const color& bg_color, float font_size, text_align text_flags)
+{
+	add_text_with_bg(top_left, size, to_utf16(text), text_color, bg_color, font_size, text_flags);
+}
+
+void renderer::add_text_with_bg(const vec2& top_left, const vec2& size, std::u8string_view text, const color& text_color, const color& bg_color, float font_size, text_align text_flags)
+{
+	add_text_with_bg(top_left, size, to_utf16({ reinterpret_cast<const char*>(text.data()), text.size() }), text_color, bg_color, font_size, text_flags);
+}
+
+void renderer::add_outlined_text(const vec2& top_left, const vec2& size, std::string_view text, const color& text_color, const color& outline_color, float font_size, float outline_size, text_align text_flags)
+{
+	add_outlined_text(top_left, size, to_utf16(text), text_color, outline_color, font_size, outline_size, text_flags);
+}
+
+void renderer::add_outlined_text(const vec2& top_left, const vec2& size, std::u8string_view text, const color& text_color, const color& outline_color, float font_size, float outline_size, text_align text_flags)
+{
+	add_outlined_text(top_left, size, to_utf16({ reinterpret_cast<const char*>(text.data()), text.size() }), text_color, outline_color, font_size, outline_size, text_flags);
+}
+
+void renderer::add_outlined_text_with_bg(const vec2& top_left, const vec2& size, std::string_view text, const color& text_color, const color& outline_color, const color& bg_color, float font_size, float outline_size, text_align text_flags)
+{
+	add_outlined_text_with_bg(top_left, size, to_utf16(text), text_color, outline_color, bg_color, font_size, outline_size, text_flags);
+}
+
+void renderer::add_outlined_text_with_bg(const vec2& top_left, const vec2& size, std::u8string_view text, const color& text_color, const color& outline_color, const color& bg_color, float font_size, float outline_size, text_align text_flags)
+{
+	add_outlined_text_with_bg(top_left, size, to_utf16({ reinterpret_cast<const char*>(text.data()), text.size() }), text_color, outline_color, bg_color, font_size, outline_size, text_flags);
+}
+
+void renderer::add_wrapped_text(const vec2& top_left, const vec2& size, std::string_view text, const color& color, float font_size, text_align text_flags)
+{
+	add_wrapped_text(top_left, size, to_utf16(text), color, font_size, text_flags);
+}
+
+void renderer::add_wrapped_text(const vec2& top_left, const vec2& size, std::u8string_view text, const color& color, float font_size, text_align text_flags)
+{
+	add_wrapped_text(top_left, size, to_utf16({ reinterpret_cast<const char*>(text.data()), text.size() }), color, font_size, text_flags);
+}
+
+vec2 renderer::measure_text(std::string_view text, float text_size)
+{
+	return measure_text(to_utf16(text), text_size);
+}
+
+vec2 renderer::measure_text(std::u8string_view text, float text_size)
+{
+	return measure_text(to_utf16({ reinterpret_cast<const char*>(text.data()), text.size() }), text_size);
+}
+
 void renderer::set_font(const std::wstring& new_font)
 {
 	font = new_font;
 }
 
+//
+// [public] text block
+//
+
+void text_block::append(std::wstring_view text)
+{
+	if (paragraphs.empty())
+		paragraphs.emplace_back();
+
+	size_t begin = 0;
+	while (true)
+	{
+		const auto end = text.find(L'\n', begin);
+		auto piece = text.substr(begin, end == std::wstring_view::npos ? std::wstring_view::npos : end - begin);
+		if (!piece.empty() && piece.back() == L'\r')
+			piece.remove_suffix(1);
+
+		// only the lines from the old end of the paragraph onwards need a new layout
+		auto& last = paragraphs.back();
+		if (!piece.empty())
+		{
+			last.dirty_from = (std::min)(last.dirty_from, static_cast<uint32_t>(last.text.size()));
+			last.text.append(piece);
+		}
+
+		if (end == std::wstring_view::npos)
+			break;
+
+		paragraphs.emplace_back();
+		begin = end + 1;
+	}
+}
+
+void text_block::append(std::string_view text)
+{
+	std::wstring wide(text.size(), L'\0');
+	wide.resize(utf8_to_utf16(text, wide.data()));
+	append(std::wstring_view{ wide });
+}
+
+void text_block::set_paragraph(size_t index, std::wstring_view text)
+{
+	assert(index < paragraphs.size());
+
+	auto& paragraph = paragraphs[index];
+	const auto prefix = static_cast<uint32_t>(std::mismatch(paragraph.text.begin(), paragraph.text.end(), text.begin(), text.end()).first - paragraph.text.begin());
+	if (prefix == paragraph.text.size() && prefix == text.size())
+		return;
+
+	paragraph.text.assign(text);
+	paragraph.dirty_from = (std::min)(paragraph.dirty_from, prefix);
+}
+
+void text_block::erase_front(size_t count)
+{
+	paragraphs.erase(paragraphs.begin(), paragraphs.begin() + (std::min)(count, paragraphs.size()));
+}
+
+void text_block::clear()
+{
+	paragraphs.clear();
+}
+
+void text_block::set_width(float new_width)
+{
+	if (new_width == width)
+		return;
+
+	width = new_width;
+	mark_all_dirty();
+}
+
+void text_block::set_font_size(float new_size)
+{
+	if (new_size == font_size)
+		return;
+
+	font_size = new_size;
+	mark_all_dirty();
+}
+
+void text_block::set_color(const color& new_color)
+{
+	text_color = new_color;
+}
+
+size_t text_block::paragraph_count() const
+{
+	return paragraphs.size();
+}
+
+void text_block::mark_all_dirty()
+{
+	for (auto& paragraph : paragraphs)
+		paragraph.dirty_from = 0;
+}
+
 //
 // [public] constructors
 //
@@ -581,9 +1015,27 @@ renderer::renderer() :
 	p_screen_projection_buffer(nullptr),
 	p_font_factory(nullptr),
 	p_font_wrapper(nullptr),
+	p_glyph_provider(nullptr),
+	p_glyph_atlas(nullptr),
+	p_state_tracker(nullptr),
 	default_draw_list(),
 	screen_projection(),
-	render_target_color()
+	render_target_color(),
+	deferred_text(false),
+	screen_size(),
+	p_scratch_geometry(nullptr),
+	p_dwrite_factory(nullptr),
+	p_text_format(nullptr),
+	glyph_memory_budget(0),
+	glyph_min_frame_age(0),
+	frames_until_trim(0),
+	font_size_step(0.0f),
+	glyph_budget_count(0),
+	glyph_budget_microseconds(0),
+	static_glyph_atlas(false),
+	outline_rasterizer(false),
+	glyph_sheet_compression(false),
+	state_calls_saved(0)
 { }
 
 // 
@@ -648,6 +1100,7 @@ void renderer::setup_viewport(HWND hwnd)
 	viewport.MinDepth = 0.f;
 	viewport.MaxDepth = 1.f;
 
+	screen_size = { viewport.Width, viewport.Height };
 	p_device_context->RSSetViewports(1, &viewport);
 }
 
@@ -799,6 +1252,38 @@ void renderer::setup_font_renderer(std::wstring font)
 	if (FAILED(p_font_factory->CreateFontWrapper(p_device, font.c_str(), &p_font_wrapper)))
 		handle_error("renderer - failed to create font wrapper");
 
+	safe_release(p_glyph_provider);
+	if (FAILED(p_font_wrapper->GetGlyphProvider(&p_glyph_provider)))
+		handle_error("renderer - failed to get glyph provider");
+	p_glyph_provider->SetFontSizeStep(font_size_step);
+	p_glyph_provider->SetGlyphBudget(glyph_budget_count, glyph_budget_microseconds);
+	// the rasterizer can only be picked before any glyph maps exist, which loading a cache creates
+	if (outline_rasterizer && FAILED(p_glyph_provider->SetOutlineRasterizer(TRUE)))
+		handle_error("renderer - failed to enable outline rasterizer");
+
+	safe_release(p_glyph_atlas);
+	if (FAILED(p_font_wrapper->GetGlyphAtlas(&p_glyph_atlas)))
+		handle_error("renderer - failed to get glyph atlas");
+	// set before loading the cache so the loaded sheets are compressed too
+	if (glyph_sheet_compression && FAILED(p_glyph_atlas->SetSheetCompression(TRUE)))
+		handle_error("renderer - failed to enable glyph sheet compression");
+
+	// a missing or outdated cache file only means glyphs are rasterized as they are first used
+	if (static_glyph_atlas)
+	{
+		if (FAILED(p_glyph_provider->LoadGlyphCache(glyph_cache_file.c_str())))
+			handle_error("renderer - failed to load baked glyph atlas");
+		p_glyph_provider->SetStaticGlyphAtlas(TRUE);
+	}
+	else if (!glyph_cache_file.empty())
+		p_glyph_provider->LoadGlyphCache(glyph_cache_file.c_str());
+
+	// the tracker starts out knowing no states, so the states set directly during setup are bound again on first use
+	safe_release(p_state_tracker);
+	if (FAILED(p_font_factory->CreateStateTracker(p_device_context, &p_state_tracker)))
+		handle_error("renderer - failed to create state tracker");
+	p_font_wrapper->SetStateTracker(p_state_tracker);
+
 	p_font_wrapper->DrawString(p_device_context, L"", 0.0f, 0.0f, 0.0f, 0xff000000, FW1_RESTORESTATE | FW1_NOFLUSH);
 }
 
@@ -852,6 +1337,314 @@ void renderer::add_vertices(vertex* p_vertices, const size_t vertex_count, const
 		add_vertex({}, D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED);
 }
 
+void renderer::analyze_text_item(const text_item& item, IFW1TextGeometry* p_geometry) const
+{
+	if (item.text.empty())
+		return;
+
+	auto final_flags = static_cast<uint32_t>(item.flags) | FW1_NOFLUSH | FW1_NOWORDWRAP;
+	auto font_family = item.font_family ? item.font_family : font.c_str();
+
+	FW1_RECTF rect{ item.top_left.x, item.top_left.y, item.top_left.x + item.size.x, item.top_left.y + item.size.y };
+	p_font_wrapper->AnalyzeStringN(nullptr, item.text.data(), static_cast<UINT32>(item.text.size()), font_family, item.font_size, &rect, item.text_color.to_hex_abgr(), final_flags, p_geometry);
+}
+
+void renderer::append_text_geometry(IFW1TextGeometry* p_geometry)
+{
+	// vertices come back sorted by sheet with sheet local glyph indices, turn them back into atlas ids
+	const auto vertex_data = p_geometry->GetGlyphVerticesTemp();
+	auto p_vertex = vertex_data.pVertices;
+
+	for (UINT sheet_index = 0; sheet_index < vertex_data.SheetCount; ++sheet_index)
+	{
+		const auto count = vertex_data.pVertexCounts[sheet_index];
+		auto p_sheet_vertices = p_vertex;
+		p_vertex += count;
+
+		// sheet local indices in the first sheet are already atlas ids
+		if (sheet_index != 0)
+		{
+			glyph_vertex_scratch.assign(p_sheet_vertices, p_vertex);
+			for (auto& glyph_vertex : glyph_vertex_scratch)
+				glyph_vertex.GlyphIndex |= sheet_index << 16;
+			p_sheet_vertices = glyph_vertex_scratch.data();
+		}
+
+		if (count > 0)
+			default_draw_list.p_text_geometry->AddGlyphVertices(p_sheet_vertices, count);
+	}
+
+	p_geometry->Clear();
+}
+
+void renderer::record_text_command(std::wstring_view text, const wchar_t* font_family, const FW1_RECTF& rect, uint32_t color, uint32_t flags, float font_size)
+{
+	auto& list = default_draw_list;
+
+	// fonts are looked up by name, there are only ever a handful so a linear search is fine
+	uint32_t font_index = 0;
+	const auto font_name = font_family ? std::wstring_view{ font_family } : std::wstring_view{ font };
+	while (font_index < list.text_fonts.size() && list.text_fonts[font_index] != font_name)
+		++font_index;
+
+	if (font_index == list.text_fonts.size())
+		list.text_fonts.emplace_back(font_name);
+
+	text_command command{};
+	command.text_offset = static_cast<uint32_t>(list.text_chars.size());
+	command.text_length = static_cast<uint32_t>(text.size());
+	command.font_index = font_index;
+	command.color = color;
+	command.flags = flags;
+	command.font_size = font_size;
+	command.rect = rect;
+
+	list.text_chars.insert(list.text_chars.end(), text.begin(), text.end());
+	list.text_commands.push_back(command);
+}
+
+void renderer::resolve_text_commands()
+{
+	auto& list = default_draw_list;
+	if (list.text_commands.empty())
+		return;
+
+	if (!p_scratch_geometry && FAILED(p_font_factory->CreateTextGeometry(&p_scratch_geometry)))
+		handle_error("resolve_text_commands - failed to create text geometry");
+
+	// two commands share a layout when everything but the integer part of their position and the color match,
+	// glyph positions are floored when laid out so an integer offset moves every glyph by exactly that amount
+	struct layout_key
+	{
+		std::wstring_view text;
+		uint32_t font_index;
+		uint32_t flags;
+		float font_size, width, height, fraction_x, fraction_y;
+
+		bool operator==(const layout_key& other) const = default;
+	};
+
+	struct layout_key_hash
+	{
+		size_t operator()(const layout_key& key) const
+		{
+			size_t hash = std::hash<std::wstring_view>{}(key.text);
+			for (const auto value : { std::hash<uint32_t>{}(key.font_index), std::hash<uint32_t>{}(key.flags), std::hash<float>{}(key.font_size),
+									  std::hash<float>{}(key.width), std::hash<float>{}(key.height), std::hash<float>{}(key.fraction_x), std::hash<float>{}(key.fraction_y) })
+				hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+			return hash;
+		}
+	};
+
+	// first vertex and vertex count in resolved_vertices, and the position the layout was made at
+	struct layout
+	{
+		size_t first_vertex, vertex_count;
+		float x, y;
+	};
+
+	std::unordered_map<layout_key, layout, layout_key_hash> layouts;
+	layouts.reserve(list.text_commands.size());
+	resolved_vertices.clear();
+
+	for (const auto& command : list.text_commands)
+	{
+		const auto& rect = command.rect;
+
+		// cull text that can only extend away from the screen given its alignment
+		const auto horizontal = command.flags & (FW1_CENTER | FW1_RIGHT);
+		const auto vertical = command.flags & (FW1_VCENTER | FW1_BOTTOM);
+		if ((horizontal == FW1_LEFT && rect.Left >= screen_size.x) || ((command.flags & FW1_RIGHT) && rect.Right <= 0.f) ||
+			(vertical == FW1_TOP && rect.Top >= screen_size.y) || ((command.flags & FW1_BOTTOM) && rect.Bottom <= 0.f))
+			continue;
+
+		const std::wstring_view text{ list.text_chars.data() + command.text_offset, command.text_length };
+		const layout_key key{ text, command.font_index, command.flags, command.font_size, rect.Right - rect.Left, rect.Bottom - rect.Top,
+							  rect.Left - std::floor(rect.Left), rect.Top - std::floor(rect.Top) };
+
+		auto it = layouts.find(key);
+		if (it == layouts.end())
+		{
+			// no new glyphs are flushed here, draw() flushes the atlas once after every command is resolved
+			p_font_wrapper->AnalyzeStringN(nullptr, text.data(), command.text_length, list.text_fonts[command.font_index].c_str(), command.font_size, &rect, command.color, command.flags, p_scratch_geometry);
+
+			layout new_layout{ resolved_vertices.size(), 0, rect.Left, rect.Top };
+
+			const auto vertex_data = p_scratch_geometry->GetGlyphVerticesTemp();
+			auto p_vertex = vertex_data.pVertices;
+			for (UINT sheet_index = 0; sheet_index < vertex_data.SheetCount; ++sheet_index)
+			{
+				for (UINT i = 0; i < vertex_data.pVertexCounts[sheet_index]; ++i, ++p_vertex)
+				{
+					resolved_vertices.push_back(*p_vertex);
+					resolved_vertices.back().GlyphIndex |= sheet_index << 16;
+				}
+			}
+
+			p_scratch_geometry->Clear();
+
+			new_layout.vertex_count = resolved_vertices.size() - new_layout.first_vertex;
+			it = layouts.emplace(key, new_layout).first;
+		}
+
+		const auto& shared_layout = it->second;
+		const auto offset_x = rect.Left - shared_layout.x;
+		const auto offset_y = rect.Top - shared_layout.y;
+
+		const auto first = resolved_vertices.begin() + shared_layout.first_vertex;
+		glyph_vertex_scratch.assign(first, first + shared_layout.vertex_count);
+		for (auto& glyph_vertex : glyph_vertex_scratch)
+		{
+			glyph_vertex.PositionX += offset_x;
+			glyph_vertex.PositionY += offset_y;
+			glyph_vertex.GlyphColor = command.color;
+		}
+		if (!glyph_vertex_scratch.empty())
+			list.p_text_geometry->AddGlyphVertices(glyph_vertex_scratch.data(), static_cast<UINT>(glyph_vertex_scratch.size()));
+	}
+}
+
+IDWriteTextLayout* renderer::create_text_layout(std::wstring_view text, float width, float font_size, uint32_t flags, bool word_wrap)
+{
+	if (!p_text_format)
+	{
+		if (FAILED(p_font_wrapper->GetDWriteFactory(&p_dwrite_factory)))
+			handle_error("create_text_layout - failed to get dwrite factory");
+
+		if (FAILED(p_dwrite_factory->CreateTextFormat(font.c_str(), NULL, DWRITE_FONT_WEIGHT_NORMAL, DWRITE_FONT_STYLE_NORMAL, DWRITE_FONT_STRETCH_NORMAL, 32.f, L"", &p_text_format)))
+			handle_error("create_text_layout - failed to create text format");
+	}
+
+	IDWriteTextLayout* p_text_layout = nullptr;
+	if (FAILED(p_dwrite_factory->CreateTextLayout(text.data(), static_cast<UINT32>(text.size()), p_text_format, width, 0.f, &p_text_layout)))
+		handle_error("create_text_layout - failed to create text layout");
+
+	DWRITE_TEXT_RANGE all_text{ 0, static_cast<UINT32>(text.size()) };
+	p_text_layout->SetFontSize(font_size, all_text);
+	p_text_layout->SetFontFamilyName(font.c_str(), all_text);
+
+	if (!word_wrap)
+		p_text_layout->SetWordWrapping(DWRITE_WORD_WRAPPING_NO_WRAP);
+
+	if (flags & FW1_RIGHT)
+		p_text_layout->SetTextAlignment(DWRITE_TEXT_ALIGNMENT_TRAILING);
+	else if (flags & FW1_CENTER)
+		p_text_layout->SetTextAlignment(DWRITE_TEXT_ALIGNMENT_CENTER);
+
+	return p_text_layout;
+}
+
+void renderer::layout_text_block(text_block& block)
+{
+	// cached vertices hold atlas ids, which are remapped whenever the atlas evicts sheets
+	const auto atlas_removals = p_glyph_atlas->GetRemovalCount();
+	if (block.layout_font != font || block.atlas_removals != atlas_removals)
+	{
+		block.layout_font = font;
+		block.atlas_removals = atlas_removals;
+		block.mark_all_dirty();
+	}
+
+	// lines showing placeholder glyphs are laid out again once the glyph provider has drawn some deferred glyphs
+	FW1_GLYPHPROVIDERSTATS glyph_stats;
+	p_glyph_provider->GetStatistics(&glyph_stats);
+	if (block.deferred_drawn != glyph_stats.DeferredDrawnCount)
+	{
+		block.deferred_drawn = glyph_stats.DeferredDrawnCount;
+		for (auto& paragraph : block.paragraphs)
+		{
+			for (const auto& line : paragraph.lines)
+			{
+				if (line.has_placeholders)
+				{
+					paragraph.dirty_from = (std::min)(paragraph.dirty_from, line.start);
+					break;
+				}
+			}
+		}
+	}
+
+	for (auto& paragraph : block.paragraphs)
+	{
+		if (paragraph.dirty_from != text_block::not_dirty)
+			layout_paragraph(block, paragraph);
+	}
+}
+
+void renderer::layout_paragraph(const text_block& block, text_block::paragraph& paragraph)
+{
+	if (!p_scratch_geometry && FAILED(p_font_factory->CreateTextGeometry(&p_scratch_geometry)))
+		handle_error("layout_paragraph - failed to create text geometry");
+
+	// find the line holding the first dirty character, the line in front of it is laid out again as well
+	// because a shorter first word can move back up onto it
+	size_t first_line = 0;
+	while (first_line + 1 < paragraph.lines.size() && paragraph.lines[first_line + 1].start <= paragraph.dirty_from)
+		++first_line;
+
+	if (first_line > 0)
+		--first_line;
+
+	const auto restart = first_line < paragraph.lines.size() ? paragraph.lines[first_line].start : 0u;
+	auto top = first_line < paragraph.lines.size() ? paragraph.lines[first_line].top : 0.f;
+	paragraph.lines.resize(first_line);
+
+	// the wrapped layout only provides the line breaks, glyphs are analyzed one line at a time so every
+	// line owns its vertices and later edits can drop them without touching the lines above
+	const auto tail = std::wstring_view{ paragraph.text }.substr(restart);
+	auto p_wrapped_layout = create_text_layout(tail, block.width, block.font_size, block.flags, true);
+
+	UINT32 line_count = 0;
+	p_wrapped_layout->GetLineMetrics(nullptr, 0, &line_count);
+	line_metrics.resize(line_count);
+	p_wrapped_layout->GetLineMetrics(line_metrics.data(), line_count, &line_count);
+	safe_release(p_wrapped_layout);
+
+	auto start = restart;
+	for (const auto& metrics : line_metrics)
+	{
+		text_block::line new_line{ start, metrics.length, top, metrics.height };
+
+		const auto visible_length = metrics.length - metrics.trailingWhitespaceLength;
+		if (visible_length > 0)
+		{
+			auto p_line_layout = create_text_layout(tail.substr(start - restart, visible_length), block.width, block.font_size, block.flags, false);
+			p_font_wrapper->AnalyzeTextLayout(nullptr, p_line_layout, 0.f, top, 0xffffffff, FW1_NOFLUSH, p_scratch_geometry);
+			safe_release(p_line_layout);
+			new_line.has_placeholders = p_scratch_geometry->GetPlaceholderGlyphCount() > 0;
+
+			const auto vertex_data = p_scratch_geometry->GetGlyphVerticesTemp();
+			auto p_vertex = vertex_data.pVertices;
+			for (UINT sheet_index = 0; sheet_index < vertex_data.SheetCount; ++sheet_index)
+			{
+				for (UINT i = 0; i < vertex_data.pVertexCounts[sheet_index]; ++i, ++p_vertex)
+				{
+					new_line.vertices.push_back(*p_vertex);
+					new_line.vertices.back().GlyphIndex |= sheet_index << 16;
+				}
+			}
+
+			p_scratch_geometry->Clear();
+		}
+
+		top += metrics.height;
+		start += metrics.length;
+		paragraph.lines.push_back(std::move(new_line));
+	}
+
+	paragraph.height = top;
+	paragraph.dirty_from = text_block::not_dirty;
+}
+
+std::wstring_view renderer::to_utf16(std::string_view text)
+{
+	// utf-8 never takes fewer code units than utf-16 so the input size is always enough
+	if (text_scratch.size() < text.size())
+		text_scratch.resize(text.size());
+
+	return { text_scratch.data(), utf8_to_utf16(text, text_scratch.data()) };
+}
+
 renderer::~renderer()
 {
 	if (p_swapchain)
@@ -868,7 +1661,33 @@ renderer::~renderer()
 	safe_release(p_vertex_buffer);
 	safe_release(p_screen_projection_buffer);
 	safe_release(p_font_factory);
+	safe_release(p_glyph_provider);
+	safe_release(p_glyph_atlas);
+	safe_release(p_state_tracker);
 	safe_release(p_font_wrapper);
+	safe_release(p_scratch_geometry);
+	safe_release(p_text_format);
+	safe_release(p_dwrite_factory);
+
+	for (auto p_geometry : worker_text_geometries)
+		safe_release(p_geometry);
+}
+
+void renderer::bind_pipeline_state()
+{
+	UINT stride = sizeof(vertex);
+	UINT offset = 0;
+
+	// the font wrapper binds its own vertex buffer directly, so ours is not tracked
+	p_device_context->IASetVertexBuffers(0, 1, &p_vertex_buffer, &stride, &offset);
+	p_state_tracker->SetInputLayout(p_layout);
+	p_state_tracker->SetVertexShader(p_vertex_shader);
+	p_state_tracker->SetVertexShaderConstantBuffer(p_screen_projection_buffer);
+	p_state_tracker->SetGeometryShader(nullptr);
+	p_state_tracker->SetPixelShader(p_pixel_shader);
+	p_state_tracker->SetBlendState(p_blend_state, 0xFFFFFFFF);
+	p_state_tracker->SetDepthStencilState(nullptr, 0);
+	p_state_tracker->SetRasterizerState(nullptr);
 }
 
 void renderer::handle_error(const char* message)
@@ -8,7 +8,13 @@
 #include <cstddef>
 #include <cmath>
 #include <vector>
+#include <deque>
 #include <string>
+#include <string_view>
+#include <span>
+#include <future>
+#include <thread>
+#include <algorithm>
 #include <unordered_map>
 #include <cassert>
 #include <d3dx11.h>
@@ -18,6 +24,107 @@
 
 #include "renderer_utils.h"
 
+// text laid out once into immutable gpu buffers, for labels that never change
+class static_text
+{
+	friend class renderer;
+public:
+	static_text() :
+		p_geometry(nullptr)
+	{}
+
+	static_text(static_text&& other) noexcept :
+		p_geometry(other.p_geometry)
+	{
+		other.p_geometry = nullptr;
+	}
+
+	static_text& operator=(static_text&& other) noexcept
+	{
+		std::swap(p_geometry, other.p_geometry);
+		return *this;
+	}
+
+	static_text(const static_text&) = delete;
+	static_text& operator=(const static_text&) = delete;
+
+	~static_text()
+	{
+		safe_release(p_geometry);
+	}
+
+private:
+	IFW1StaticGeometry* p_geometry;
+};
+
+// wrapped multi-line text that keeps its layout between frames. paragraphs are split on '\n' and cache their
+// line breaks, so appending or editing only lays out the lines from the edit onwards
+class text_block
+{
+	friend class renderer;
+public:
+	text_block(float width, float font_size, const color& text_color, text_align flags = text_align::left) :
+		width(width),
+		font_size(font_size),
+		text_color(text_color),
+		flags(static_cast<uint32_t>(flags) & (FW1_CENTER | FW1_RIGHT)),
+		paragraphs(),
+		layout_font(),
+		atlas_removals(0),
+		deferred_drawn(0)
+	{}
+
+	// append text to the last paragraph, every '\n' starts a new paragraph
+	void append(std::wstring_view text);
+	void append(std::string_view text);
+
+	// replace the text of a paragraph, lines in front of the first changed character keep their layout
+	void set_paragraph(size_t index, std::wstring_view text);
+
+	// drop paragraphs from the front, used to cap the history of log views
+	void erase_front(size_t count);
+
+	void clear();
+
+	// changing the width or font size lays out every paragraph again, the color is only applied when drawing
+	void set_width(float new_width);
+	void set_font_size(float new_size);
+	void set_color(const color& new_color);
+
+	size_t paragraph_count() const;
+
+private:
+	static constexpr uint32_t not_dirty = UINT32_MAX;
+
+	// a wrapped line, vertices are laid out relative to the paragraph and hold atlas ids
+	struct line
+	{
+		uint32_t start, length;
+		float top, height;
+		std::vector<FW1_GLYPHVERTEX> vertices;
+		bool has_placeholders = false; // some glyphs were over the glyph budget and are drawn with the default glyph
+	};
+
+	struct paragraph
+	{
+		std::wstring text;
+		std::vector<line> lines;
+		uint32_t dirty_from = 0; // first character whose line has to be laid out again
+		float height = 0.f;
+	};
+
+	float width;
+	float font_size;
+	color text_color;
+	uint32_t flags;
+	std::deque<paragraph> paragraphs;
+	std::wstring layout_font; // font the cached lines were laid out with
+	uint32_t atlas_removals;  // glyph atlas removal count the cached lines were laid out at
+	uint32_t deferred_drawn;  // deferred glyph count of the glyph provider the cached lines were laid out at
+
+	void mark_all_dirty();
+};
+
 // holds a vertex buffer and a batch list that our renderer will use
 class draw_list
 {
@@ -33,7 +140,13 @@ public:
 	{
 		vertices.clear();
 		batch_list.clear();
+		text_commands.clear();
+		text_chars.clear();
 		p_text_geometry->Clear();
+
+		for (auto& [p_geometry, offset] : static_texts)
+			safe_release(p_geometry);
+		static_texts.clear();
 	}
 
 	HRESULT init_text_geometry(IFW1Factory* font_factory)
@@ -44,11 +157,18 @@ public:
 	~draw_list()
 	{
 		safe_release(p_text_geometry);
+
+		for (auto& [p_geometry, offset] : static_texts)
+			safe_release(p_geometry);
 	}
 
 private:
 	std::vector<vertex> vertices;
 	std::vector<batch> batch_list;
+	std::vector<text_command> text_commands;
+	std::vector<wchar_t> text_chars;
+	std::vector<std::wstring> text_fonts; // fonts referenced by text commands, kept across frames
+	std::vector<std::pair<IFW1StaticGeometry*, vec2>> static_texts; // referenced until the list is cleared
 	IFW1TextGeometry* p_text_geometry;
 };
 
@@ -62,6 +182,9 @@ public:
 	// submits the draw list to the gpu for rendering
 	void draw();
 
+	// number of pipeline state calls the last draw() skipped because the state was already bound
+	uint32_t get_state_calls_saved() const;
+
 	// initialize renderer onto a window 
 	void initialize(HWND hwnd, const color& render_target_color = {}, const std::wstring& font_family = L"Consolas");
 
@@ -71,6 +194,38 @@ public:
 	// cleanup renderer
 	void cleanup();
 
+	// when enabled text calls only record a command, all text is then laid out together in draw()
+	void set_deferred_text(bool enabled);
+
+	// evict glyph sheets unused for min_frame_age frames once the glyph atlas grows past budget_bytes, 0 disables eviction
+	void set_glyph_memory_budget(uint64_t budget_bytes, uint32_t min_frame_age = 120);
+
+	// rasterize glyphs at font sizes snapped to multiples of step and scale them to the requested size, 0 uses exact sizes
+	void set_font_size_step(float step);
+
+	// rasterize at most max_glyphs new glyphs or for max_microseconds per frame, text over the budget shows the font's
+	// default glyph until the glyph is drawn in a later frame, 0 removes the limit
+	void set_glyph_budget(uint32_t max_glyphs, uint32_t max_microseconds = 0);
+
+	// keep the glyph atlas in a file between runs, it is loaded by initialize() and written back by cleanup()
+	// so glyphs rasterized in earlier runs are ready from the first frame, call this before initialize()
+	void set_glyph_cache_file(const std::wstring& path);
+
+	// load a glyph atlas baked offline by FW1AtlasBaker and never rasterize glyphs at runtime, characters or sizes
+	// missing from the file show the font's default glyph, call this before initialize()
+	void set_static_glyph_atlas(const std::wstring& path);
+
+	// fill glyph outlines into the atlas instead of drawing glyphs through gdi, unhinted so small text is a little softer
+	// call this before initialize()
+	void set_outline_rasterizer(bool enabled);
+
+	// compress full glyph sheets to bc4, halving their video memory at a small loss in edge quality, sheets still taking
+	// new glyphs stay uncompressed
+	void set_glyph_sheet_compression(bool enabled);
+
+	// rasterize the glyphs of characters in the current font on worker threads, so text using them later doesn't stall a frame
+	void prewarm_glyphs(std::wstring_view characters, float font_size);
+
 	// adds a colored line from start to end
 	void add_line(const vec2& start, const vec2& end, const color& color);
 	
@@ -117,19 +272,49 @@ public:
 	void add_outlined_frame(const vec2& top_left, const vec2& size, float thickness, float outline_thickness, const color& color_, const color& outline_color);
 
 	// add text, top_left and size are for the text bounding box, see text_flags enum for flags
-	void add_text(const vec2& top_left, const vec2& size, const std::wstring& text, const color& color, float font_size, text_align flags = text_align::left_top);
+	void add_text(const vec2& top_left, const vec2& size, std::wstring_view text, const color& color, float font_size, text_align flags = text_align::left_top);
+	void add_text(const vec2& top_left, const vec2& size, std::string_view text, const color& color, float font_size, text_align flags = text_align::left_top);
+	void add_text(const vec2& top_left, const vec2& size, std::u8string_view text, const color& color, float font_size, text_align flags = text_align::left_top);
 
 	// add text with background around the smallest rect containing the text
-	void add_text_with_bg(const vec2& top_left, const vec2& size, const std::wstring& text, const color& text_color, const color& bg_color, float font_size, text_align text_flags = text_align::left_top);
+	void add_text_with_bg(const vec2& top_left, const vec2& size, std::wstring_view text, const color& text_color, const color& bg_color, float font_size, text_align text_flags = text_align::left_top);
+	void add_text_with_bg(const vec2& top_left, const vec2& size, std::string_view text, const color& text_color, const color& bg_color, float font_size, text_align text_flags = text_align::left_top);
+	void add_text_with_bg(const vec2& top_left, const vec2& size, std::u8string_view text, const color& text_color, const color& bg_color, float font_size, text_align text_flags = text_align::left_top);
 
 	// add outlined text, this is not done in a good way so it could affect performance
-	void add_outlined_text(const vec2& top_left, const vec2& size, const std::wstring& text, const color& text_color, const color& outline_color, float font_size, float outline_size = 1.f, text_align text_flags = text_align::left_top);
+	void add_outlined_text(const vec2& top_left, const vec2& size, std::wstring_view text, const color& text_color, const color& outline_color, float font_size, float outline_size = 1.f, text_align text_flags = text_align::left_top);
+	void add_outlined_text(const vec2& top_left, const vec2& size, std::string_view text, const color& text_color, const color& outline_color, float font_size, float outline_size = 1.f, text_align text_flags = text_align::left_top);
+	void add_outlined_text(const vec2& top_left, const vec2& size, std::u8string_view text, const color& text_color, const color& outline_color, float font_size, float outline_size = 1.f, text_align text_flags = text_align::left_top);
 
 	// add outlined text with a background, this is not done in a good way so it could affect performance
-	void add_outlined_text_with_bg(const vec2& top_left, const vec2& size, const std::wstring& text, const color& text_color, const color& outline_color, const color& bg_color, float font_size, float shadow_size = 1.f, text_align text_flags = text_align::left_top);
+	void add_outlined_text_with_bg(const vec2& top_left, const vec2& size, std::wstring_view text, const color& text_color, const color& outline_color, const color& bg_color, float font_size, float shadow_size = 1.f, text_align text_flags = text_align::left_top);
+	void add_outlined_text_with_bg(const vec2& top_left, const vec2& size, std::string_view text, const color& text_color, const color& outline_color, const color& bg_color, float font_size, float shadow_size = 1.f, text_align text_flags = text_align::left_top);
+	void add_outlined_text_with_bg(const vec2& top_left, const vec2& size, std::u8string_view text, const color& text_color, const color& outline_color, const color& bg_color, float font_size, float shadow_size = 1.f, text_align text_flags = text_align::left_top);
+
+	// add text that wraps at the width of its bounding box
+	void add_wrapped_text(const vec2& top_left, const vec2& size, std::wstring_view text, const color& color, float font_size, text_align flags = text_align::left_top);
+	void add_wrapped_text(const vec2& top_left, const vec2& size, std::string_view text, const color& color, float font_size, text_align flags = text_align::left_top);
+	void add_wrapped_text(const vec2& top_left, const vec2& size, std::u8string_view text, const color& color, float font_size, text_align flags = text_align::left_top);
+
+	// add a text block, paragraphs changed since the last call are laid out again and lines off screen are skipped
+	void add_text_block(text_block& block, const vec2& top_left);
+
+	// lay out changed paragraphs and return the width and height of the whole block
+	vec2 measure_text_block(text_block& block);
+
+	// add many labels at once, large batches are laid out in parallel and merged in submission order
+	void add_texts(std::span<const text_item> items);
+
+	// lay out text once into gpu buffers, the result can be drawn every frame with add_static_text
+	static_text create_static_text(const vec2& top_left, const vec2& size, std::wstring_view text, const color& color, float font_size, text_align flags = text_align::left_top);
+
+	// draw static text moved by offset, this uploads nothing and costs a bind and a draw per glyph sheet
+	void add_static_text(const static_text& text, const vec2& offset = {});
 
 	// see how much space text will take up, returns the height and width text will take up
-	vec2 measure_text(const std::wstring& text, float text_size);
+	vec2 measure_text(std::wstring_view text, float text_size);
+	vec2 measure_text(std::string_view text, float text_size);
+	vec2 measure_text(std::u8string_view text, float text_size);
 
 	void set_font(const std::wstring& new_font);
 
@@ -150,11 +335,38 @@ private:
 							 
 	IFW1Factory*			 p_font_factory;   // font factory ptr
 	IFW1FontWrapper*		 p_font_wrapper;   // font wrapper ptr
+	IFW1GlyphProvider*		 p_glyph_provider; // glyph provider of the font wrapper ptr
+	IFW1GlyphAtlas*			 p_glyph_atlas;    // glyph atlas of the font wrapper ptr
+	IFW1StateTracker*		 p_state_tracker;  // pipeline states bound on the device context, shared with the font wrapper
 
 	draw_list default_draw_list; // default draw list, we should only need 1 draw list. In the future we could add more
 	DirectX::XMMATRIX screen_projection;
 	color render_target_color;
 	std::wstring font;
+	std::wstring text_scratch; // reused utf-16 buffer for utf-8 text, only grows
+	std::vector<IFW1TextGeometry*> worker_text_geometries; // one geometry per add_texts worker
+
+	bool deferred_text;
+	vec2 screen_size;
+	IFW1TextGeometry* p_scratch_geometry;       // scratch geometry used when laying out text outside the draw list
+	std::vector<FW1_GLYPHVERTEX> resolved_vertices; // laid out vertices of unique text commands
+	std::vector<FW1_GLYPHVERTEX> glyph_vertex_scratch; // moved or recolored copies of cached vertices, added to a geometry in one call
+
+	IDWriteFactory*    p_dwrite_factory; // dwrite factory of the font wrapper, used for text block layouts
+	IDWriteTextFormat* p_text_format;    // base format of text block layouts, font and size are set per layout
+	std::vector<DWRITE_LINE_METRICS> line_metrics;
+
+	uint64_t glyph_memory_budget;
+	uint32_t glyph_min_frame_age;
+	uint32_t frames_until_trim;
+	float    font_size_step;
+	uint32_t glyph_budget_count;
+	uint32_t glyph_budget_microseconds;
+	std::wstring glyph_cache_file;
+	bool     static_glyph_atlas;
+	bool     outline_rasterizer;
+	bool     glyph_sheet_compression;
+	uint32_t state_calls_saved;
 
 	// add a vertex to the draw list
 	void add_vertex(const vertex& vertex, const D3D_PRIMITIVE_TOPOLOGY type);
@@ -162,6 +374,33 @@ private:
 	// adds multiple vertices of the same typr to the defualt draw list
 	void add_vertices(vertex* p_vertices, const size_t vertex_count, const D3D_PRIMITIVE_TOPOLOGY type);
 
+	// lay out a single text item into a text geometry, safe to call from worker threads
+	void analyze_text_item(const text_item& item, IFW1TextGeometry* p_geometry) const;
+
+	// append the vertices of a worker geometry to the default draw list and clear it
+	void append_text_geometry(IFW1TextGeometry* p_geometry);
+
+	// record a deferred text command into the default draw list
+	void record_text_command(std::wstring_view text, const wchar_t* font_family, const FW1_RECTF& rect, uint32_t color, uint32_t flags, float font_size);
+
+	// lay out all recorded text commands, strings that share a layout are only analyzed once
+	void resolve_text_commands();
+
+	// create a dwrite layout with the renderer font, only horizontal alignment flags are used
+	IDWriteTextLayout* create_text_layout(std::wstring_view text, float width, float font_size, uint32_t flags, bool word_wrap);
+
+	// lay out every paragraph of a block that changed since it was last laid out
+	void layout_text_block(text_block& block);
+
+	// lay out the lines of a paragraph from the line in front of its first dirty character
+	void layout_paragraph(const text_block& block, text_block::paragraph& paragraph);
+
+	// transcode utf-8 text into the scratch buffer, the view is valid until the next call
+	std::wstring_view to_utf16(std::string_view text);
+
+	// rebind the renderer pipeline state after the font wrapper has set its own, only states that differ reach the context
+	void bind_pipeline_state();
+
 	// process errors coming from the renderer
 	void handle_error(const char* );
 
@@ -1,5 +1,7 @@
 #include "renderer_utils.h"
 
+#include <emmintrin.h>
+
 //
 // vec2 definitions
 //
@@ -199,4 +201,98 @@ void vertex::operator+=(const vec2& add)
 batch::batch(D3D_PRIMITIVE_TOPOLOGY type, size_t vertex_count) :
 	type(type),
 	vertex_count(vertex_count)
-{ }
\ No newline at end of file
+{ }
+
+//
+// text utilities
+//
+
+size_t utf8_to_utf16(std::string_view text, wchar_t* p_out)
+{
+	static_assert(sizeof(wchar_t) == 2, "utf8_to_utf16 - wchar_t is expected to be utf-16");
+
+	auto in = reinterpret_cast<const uint8_t*>(text.data());
+	const auto end = in + text.size();
+	const auto out_start = p_out;
+
+	while (in < end)
+	{
+		// ascii fast path, widen 16 bytes at a time until a byte with the high bit set shows up
+		while (end - in >= 16)
+		{
+			const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+			if (_mm_movemask_epi8(chunk) != 0)
+				break;
+
+			const auto zero = _mm_setzero_si128();
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(p_out), _mm_unpacklo_epi8(chunk, zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(p_out + 8), _mm_unpackhi_epi8(chunk, zero));
+			in += 16;
+			p_out += 16;
+		}
+
+		if (in >= end)
+			break;
+
+		const uint8_t lead = *in;
+		if (lead < 0x80)
+		{
+			*p_out++ = static_cast<wchar_t>(lead);
+			++in;
+			continue;
+		}
+
+		uint32_t code_point = 0;
+		uint32_t min_code_point = 0;
+		ptrdiff_t sequence_length = 0;
+
+		if ((lead & 0xE0) == 0xC0)
+		{
+			code_point = lead & 0x1F;
+			min_code_point = 0x80;
+			sequence_length = 2;
+		}
+		else if ((lead & 0xF0) == 0xE0)
+		{
+			code_point = lead & 0x0F;
+			min_code_point = 0x800;
+			sequence_length = 3;
+		}
+		else if ((lead & 0xF8) == 0xF0)
+		{
+			code_point = lead & 0x07;
+			min_code_point = 0x10000;
+			sequence_length = 4;
+		}
+
+		bool valid = sequence_length != 0 && end - in >= sequence_length;
+		for (ptrdiff_t i = 1; valid && i < sequence_length; ++i)
+		{
+			if ((in[i] & 0xC0) != 0x80)
+				valid = false;
+			else
+				code_point = (code_point << 6) | (in[i] & 0x3F);
+		}
+
+		// reject overlong encodings, surrogate halves and anything past the unicode range
+		if (!valid || code_point < min_code_point || code_point > 0x10FFFF || (code_point >= 0xD800 && code_point <= 0xDFFF))
+		{
+			*p_out++ = static_cast<wchar_t>(0xFFFD);
+			++in;
+			continue;
+		}
+
+		if (code_point >= 0x10000)
+		{
+			code_point -= 0x10000;
+			*p_out++ = static_cast<wchar_t>(0xD800 | (code_point >> 10));
+			*p_out++ = static_cast<wchar_t>(0xDC00 | (code_point & 0x3FF));
+		}
+		else
+			*p_out++ = static_cast<wchar_t>(code_point);
+
+		in += sequence_length;
+	}
+
+	return static_cast<size_t>(p_out - out_start);
+}
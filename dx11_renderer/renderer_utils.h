@@ -1,11 +1,14 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 
 #include "../FW1FontWrapper/Source/FW1FontWrapper.h"
 
 #define PI 3.141592654f
 #define MAX_DRAW_LIST_VERTICES 0x10000
+#define MIN_TEXT_ITEMS_PER_WORKER 32
+#define TRIM_RETRY_FRAMES 30
 
 // struct for 2d position
 struct vec2
@@ -100,6 +103,30 @@ enum class text_align : uint32_t
 	right_bottom	= right  | bottom,
 };
 
+// a single label for batched text submission, the string must stay alive until the submission returns
+struct text_item
+{
+	vec2 top_left;
+	vec2 size;
+	std::wstring_view text;
+	color text_color;
+	float font_size;
+	const wchar_t* font_family; // nullptr uses the renderer font
+	text_align flags;
+};
+
+// a recorded text call for deferred text, the string lives in the draw list's character arena
+struct text_command
+{
+	uint32_t text_offset;
+	uint32_t text_length;
+	uint32_t font_index;
+	uint32_t color;
+	uint32_t flags;
+	float font_size;
+	FW1_RECTF rect;
+};
+
 // a struct that contains position and color information that the gpu will process
 struct vertex
 {
@@ -153,6 +180,10 @@ inline float calc_theta(size_t vertex_index, size_t total_points)
 	return 2.f * PI * static_cast<float>(vertex_index) / static_cast<float>(total_points);
 }
 
+// transcodes utf-8 to utf-16, p_out must have room for at least text.size() characters
+// invalid or truncated sequences are replaced with U+FFFD, returns the amount of characters written
+size_t utf8_to_utf16(std::string_view text, wchar_t* p_out);
+
 namespace shaders
 {
 	inline uint8_t vertex[] = {